@@ -9,23 +9,36 @@ layout(location = 2) in vec4 vert_color;
 
 out vec2 vert_to_frag_uv;
 out vec4 vert_to_frag_color;
+out vec2 vert_to_frag_world;
 
 void main() {
     gl_Position = mat_view_proj * vec4(vert_position, 1.0);
     vert_to_frag_uv = vert_uv;
     vert_to_frag_color = vert_color;
+    vert_to_frag_world = vert_position.xy;
 }
 
 #elif COMPILE_FRAGMENT_SHADER == 1
 
 layout(binding = 0) uniform sampler2D uColorTexture;
+// A texel per map tile, how much of its colour anything over that tile keeps. See fog_renderer.h.
+layout(binding = 1) uniform sampler2D uFogTexture;
+
+// Off for anything not in world space.
+uniform int fog_enabled;
+uniform vec2 fog_origin;
+uniform vec2 fog_inv_size;
 
 in vec2 vert_to_frag_uv;
 in vec4 vert_to_frag_color;
+in vec2 vert_to_frag_world;
 
 out vec4 frag_color;
 
 void main() {
     frag_color = texture(uColorTexture, vert_to_frag_uv) * vert_to_frag_color;
+
+    if (fog_enabled != 0)
+        frag_color.rgb *= texture(uFogTexture, (vert_to_frag_world - fog_origin) * fog_inv_size).r;
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+#include "../src/engine/memory.h"
+#include "../src/app.h"
+#include "../src/options.h"
+
+uint8_t bench_enabled(const bench_runner_t *runner, const char *name)
+{
+    return !runner->filter || strstr(name, runner->filter) != 0;
+}
+
+static double bench_seconds_since(uint64_t start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+void bench_run(bench_runner_t *runner,
+               const char *name,
+               bench_fn_t fn,
+               void *user_data,
+               uint64_t ops_per_iteration,
+               uint64_t max_iterations_per_sample)
+{
+    if (!bench_enabled(runner, name))
+        return;
+
+    // Calibrate, double the iterations until a batch takes a meaningful amount of time.
+    uint64_t num_iterations = 1;
+    double elapsed;
+    for (;;)
+    {
+        uint64_t start = SDL_GetPerformanceCounter();
+        fn(user_data, num_iterations);
+        elapsed = bench_seconds_since(start);
+
+        if (elapsed >= runner->sample_seconds / 8 || (max_iterations_per_sample && num_iterations >= max_iterations_per_sample))
+            break;
+
+        num_iterations *= 2;
+    }
+
+    uint64_t iterations_per_sample = (uint64_t)((double)num_iterations * runner->sample_seconds / (elapsed > 0 ? elapsed : 1e-9));
+    if (iterations_per_sample == 0)
+        iterations_per_sample = 1;
+    if (max_iterations_per_sample && iterations_per_sample > max_iterations_per_sample)
+        iterations_per_sample = max_iterations_per_sample;
+
+    // Warm caches, branch predictors and CPU clocks before anything is recorded.
+    uint64_t warmup_start = SDL_GetPerformanceCounter();
+    while (bench_seconds_since(warmup_start) < runner->warmup_seconds)
+    {
+        fn(user_data, iterations_per_sample);
+    }
+
+    double *samples = calloc(runner->num_samples, sizeof(double));
+    for (uint32_t i = 0; i < runner->num_samples; i++)
+    {
+        uint64_t start = SDL_GetPerformanceCounter();
+        fn(user_data, iterations_per_sample);
+        samples[i] = bench_seconds_since(start) * 1e9 / (double)(iterations_per_sample * ops_per_iteration);
+    }
+
+    qsort(samples, runner->num_samples, sizeof(double), compare_doubles);
+
+    bench_result_t result = {0};
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.ops_per_iteration = ops_per_iteration;
+    result.iterations_per_sample = iterations_per_sample;
+    result.num_samples = runner->num_samples;
+
+    double total = 0;
+    for (uint32_t i = 0; i < runner->num_samples; i++)
+        total += samples[i];
+    result.mean_ns = total / runner->num_samples;
+
+    double variance = 0;
+    for (uint32_t i = 0; i < runner->num_samples; i++)
+        variance += (samples[i] - result.mean_ns) * (samples[i] - result.mean_ns);
+    result.stddev_ns = runner->num_samples > 1 ? sqrt(variance / (runner->num_samples - 1)) : 0;
+
+    result.min_ns = samples[0];
+    result.max_ns = samples[runner->num_samples - 1];
+    result.median_ns = samples[runner->num_samples / 2];
+    result.p95_ns = samples[(size_t)((runner->num_samples - 1) * 0.95 + 0.5)];
+
+    free(samples);
+
+    printf("%-52s %12.2f ns/op  median %12.2f  min %12.2f  p95 %12.2f  stddev %6.2f%%\n",
+           result.name,
+           result.mean_ns,
+           result.median_ns,
+           result.min_ns,
+           result.p95_ns,
+           result.mean_ns > 0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0);
+    fflush(stdout);
+
+    arrput(runner->arr_results, result);
+}
+
+static void bench_write_json(const bench_runner_t *runner, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Failed to open %s for writing\n", path);
+        return;
+    }
+
+    fputs("{\"benchmarks\":[\n", file);
+    for (size_t i = 0; i < arrlenu(runner->arr_results); i++)
+    {
+        const bench_result_t *result = &runner->arr_results[i];
+        fprintf(file,
+                "%s{\"name\":\"%s\",\"ops_per_iteration\":%llu,\"iterations_per_sample\":%llu,\"samples\":%u,"
+                "\"ns_per_op\":{\"mean\":%.4f,\"median\":%.4f,\"min\":%.4f,\"max\":%.4f,\"stddev\":%.4f,\"p95\":%.4f}}",
+                i ? ",\n" : "",
+                result->name,
+                (unsigned long long)result->ops_per_iteration,
+                (unsigned long long)result->iterations_per_sample,
+                result->num_samples,
+                result->mean_ns,
+                result->median_ns,
+                result->min_ns,
+                result->max_ns,
+                result->stddev_ns,
+                result->p95_ns);
+    }
+    fputs("\n]}\n", file);
+
+    fclose(file);
+    printf("Wrote %s\n", path);
+}
+
+static void bench_usage(const char *program)
+{
+    printf("Usage: %s [--filter NAME] [--json PATH] [--samples N] [--sample-ms MS] [--warmup-ms MS] [--max-entities N] [--no-gl]\n", program);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    bench_runner_t runner = {0};
+    runner.warmup_seconds = 0.2;
+    runner.sample_seconds = 0.02;
+    runner.num_samples = 30;
+    runner.max_entities = 1000000;
+
+    const char *json_path = 0;
+    uint8_t use_gl = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+
+        if (strcmp(argv[i], "--no-gl") == 0)
+            use_gl = 0;
+        else if (strcmp(argv[i], "--filter") == 0 && value)
+            runner.filter = argv[++i];
+        else if (strcmp(argv[i], "--json") == 0 && value)
+            json_path = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0 && value)
+            runner.num_samples = (uint32_t)strtoul(argv[++i], 0, 10);
+        else if (strcmp(argv[i], "--sample-ms") == 0 && value)
+            runner.sample_seconds = strtod(argv[++i], 0) / 1000.0;
+        else if (strcmp(argv[i], "--warmup-ms") == 0 && value)
+            runner.warmup_seconds = strtod(argv[++i], 0) / 1000.0;
+        else if (strcmp(argv[i], "--max-entities") == 0 && value)
+            runner.max_entities = strtoull(argv[++i], 0, 10);
+        else
+            bench_usage(argv[0]);
+    }
+
+    if (runner.num_samples == 0)
+        bench_usage(argv[0]);
+
+    if (use_gl)
+    {
+        char *app_argv[] = {argv[0], "--headless"};
+        app_options_t options = app_options_parse(2, app_argv);
+        runner.app = app_new(&options);
+    }
+
+    bench_sprite_batch(&runner);
+    bench_entities(&runner);
+    bench_assets(&runner);
+    bench_tilemap(&runner);
+    bench_pathfinding(&runner);
+    bench_fov(&runner);
+    bench_turn(&runner);
+    bench_world_snapshot(&runner);
+    bench_replication(&runner);
+
+    if (json_path)
+        bench_write_json(&runner, json_path);
+
+    arrfree(runner.arr_results);
+
+    if (runner.app)
+        app_free(runner.app);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct app_t app_t;
+
+/// @brief Runs num_iterations iterations of the benchmark.
+typedef void (*bench_fn_t)(void *user_data, uint64_t num_iterations);
+
+typedef struct bench_result_t
+{
+    char name[128];
+    uint64_t ops_per_iteration;
+    uint64_t iterations_per_sample;
+    uint32_t num_samples;
+
+    // Per op, over all samples.
+    double mean_ns, median_ns, min_ns, max_ns, stddev_ns, p95_ns;
+} bench_result_t;
+
+typedef struct bench_runner_t
+{
+    // Only benchmarks whose name contains this run, all when null.
+    const char *filter;
+
+    double warmup_seconds;
+    double sample_seconds;
+    uint32_t num_samples;
+
+    // Largest entity count the entity benchmarks go up to.
+    size_t max_entities;
+
+    // Headless app with a GL context for benchmarks that need one, null with --no-gl.
+    app_t *app;
+
+    bench_result_t *arr_results;
+} bench_runner_t;
+
+/// @brief Whether a benchmark with this name passes the filter, check before any expensive setup.
+uint8_t bench_enabled(const bench_runner_t *runner, const char *name);
+
+/// @brief Warm up, calibrate the number of iterations to fill sample_seconds, then time num_samples samples.
+/// @param ops_per_iteration Operations one iteration performs, results are reported per operation.
+/// @param max_iterations_per_sample Caps calibration for benchmarks that grow state as they run, 0 for no cap.
+void bench_run(bench_runner_t *runner,
+               const char *name,
+               bench_fn_t fn,
+               void *user_data,
+               uint64_t ops_per_iteration,
+               uint64_t max_iterations_per_sample);
+
+/// @brief Stop the compiler from optimising away a result.
+static inline void bench_do_not_optimise(const void *value)
+{
+    __asm__ volatile("" : : "g"(value) : "memory");
+}
+
+// Suites, each runs every benchmark it owns that passes the filter.
+void bench_sprite_batch(bench_runner_t *runner);
+void bench_entities(bench_runner_t *runner);
+void bench_assets(bench_runner_t *runner);
+void bench_tilemap(bench_runner_t *runner);
+void bench_pathfinding(bench_runner_t *runner);
+void bench_fov(bench_runner_t *runner);
+void bench_turn(bench_runner_t *runner);
+void bench_world_snapshot(bench_runner_t *runner);
+void bench_replication(bench_runner_t *runner);
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/app.h"
+#include "../src/font.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_MISSING_KEYS 1024
+
+typedef struct asset_cache_bench_t
+{
+    asset_cache_t cache;
+    // Copies of the keys at different addresses, lookups hash the string rather than match the pointer.
+    char (*lookup_keys)[48];
+    char (*missing_keys)[48];
+    size_t num_keys;
+    uint64_t rng;
+} asset_cache_bench_t;
+
+typedef struct font_bench_t
+{
+    font_t *font;
+    float size;
+} font_bench_t;
+
+static void bench_asset_cache_hit(void *user_data, uint64_t num_iterations)
+{
+    asset_cache_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        const char *key = bench->lookup_keys[rng_next(&bench->rng) % bench->num_keys];
+        bench_do_not_optimise(&shget(bench->cache.sh_textures, key));
+    }
+}
+
+static void bench_asset_cache_miss(void *user_data, uint64_t num_iterations)
+{
+    asset_cache_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        const char *key = bench->missing_keys[rng_next(&bench->rng) % BENCH_NUM_MISSING_KEYS];
+        bench_do_not_optimise((void *)(intptr_t)shgeti(bench->cache.sh_textures, key));
+    }
+}
+
+static void bench_font_hit(void *user_data, uint64_t num_iterations)
+{
+    font_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        bench_do_not_optimise(get_font_render_data(bench->font, bench->size));
+}
+
+static void bench_font_miss(void *user_data, uint64_t num_iterations)
+{
+    font_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        bench_do_not_optimise(get_font_render_data(bench->font, bench->size));
+
+        // Evict it again so the next call bakes too, the eviction is counted in the result.
+        font_release_render_data(bench->font, bench->size);
+    }
+
+    glFinish();
+}
+
+void bench_assets(bench_runner_t *runner)
+{
+    const size_t key_counts[] = {16, 1000, 100000};
+    for (size_t i = 0; i < sizeof(key_counts) / sizeof(key_counts[0]); i++)
+    {
+        char hit_name[128], miss_name[128];
+        snprintf(hit_name, sizeof(hit_name), "asset_cache/shget_hit/%zu", key_counts[i]);
+        snprintf(miss_name, sizeof(miss_name), "asset_cache/shgeti_miss/%zu", key_counts[i]);
+        if (!bench_enabled(runner, hit_name) && !bench_enabled(runner, miss_name))
+            continue;
+
+        asset_cache_bench_t bench = {.num_keys = key_counts[i], .rng = 1};
+        char(*keys)[48] = calloc(bench.num_keys, sizeof(keys[0]));
+        bench.lookup_keys = calloc(bench.num_keys, sizeof(bench.lookup_keys[0]));
+        bench.missing_keys = calloc(BENCH_NUM_MISSING_KEYS, sizeof(bench.missing_keys[0]));
+        for (size_t j = 0; j < BENCH_NUM_MISSING_KEYS; j++)
+            snprintf(bench.missing_keys[j], sizeof(bench.missing_keys[j]), "./missing/asset_%05zu.png", j);
+
+        // Like the real cache the keys aren't copied by stb_ds, they have to outlive the table.
+        for (size_t j = 0; j < bench.num_keys; j++)
+        {
+            snprintf(keys[j], sizeof(keys[j]), "./textures/asset_%05zu.png", j);
+            memcpy(bench.lookup_keys[j], keys[j], sizeof(keys[j]));
+
+            texture_t texture = {.name = keys[j], .texture = (GLuint)j + 1};
+            shput(bench.cache.sh_textures, keys[j], texture);
+        }
+
+        bench_run(runner, hit_name, bench_asset_cache_hit, &bench, 1, 0);
+        bench_run(runner, miss_name, bench_asset_cache_miss, &bench, 1, 0);
+
+        // No asset_cache_free, the textures were never created.
+        shfree(bench.cache.sh_textures);
+        free(keys);
+        free(bench.lookup_keys);
+        free(bench.missing_keys);
+    }
+
+    if (!runner->app)
+        return;
+
+    font_t *font = &shget(runner->app->asset_cache->sh_fonts, runner->app->stats_overlay.font_path);
+
+    const float sizes[] = {16, 48};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        char hit_name[128], miss_name[128];
+        snprintf(hit_name, sizeof(hit_name), "get_font_render_data/hit/%.0f", sizes[i]);
+        snprintf(miss_name, sizeof(miss_name), "get_font_render_data/miss/%.0f", sizes[i]);
+
+        // Sizes nothing else uses, so the miss never evicts a bake the overlay relies on.
+        font_bench_t bench = {.font = font, .size = sizes[i] + 0.25f};
+
+        bench_run(runner, miss_name, bench_font_miss, &bench, 1, 16);
+
+        get_font_render_data(font, bench.size);
+        bench_run(runner, hit_name, bench_font_hit, &bench, 1, 0);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/entities.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+typedef struct entity_bench_t
+{
+    world_t *world;
+    uint64_t rng;
+
+    // set_parent ping-pongs entities between these two.
+    entity_t *parent_a;
+    entity_t *parent_b;
+    entity_t *moving;
+    // parent_a's children, for picking one at random, or the tops of the chains in the deep tree.
+    entity_t **arr_wide;
+} entity_bench_t;
+
+static void bench_world_populate(world_t *world, size_t num_entities, uint64_t *rng)
+{
+    for (size_t i = 0; i < num_entities; i++)
+    {
+        entity_t *entity = entity_new(world);
+        vec3 pos = {(float)(rng_next(rng) % 1280), (float)(rng_next(rng) % 720), 0};
+        set_pos(&entity->transform, pos);
+        set_scale(&entity->transform, (vec2){32, 32});
+    }
+
+    update_global_system(world);
+}
+
+static void bench_update_local_clean(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        update_local_system(bench->world);
+}
+
+static void bench_update_local_dirty(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+    entity_t **entities = bench->world->entities;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        for (size_t j = 0; j < arrlenu(entities); j++)
+            entities[j]->transform.is_dirty = 1;
+
+        update_local_system(bench->world);
+    }
+}
+
+static void bench_update_global(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Like a step, the arena grows to fit the traversal on the first reset after it overflows.
+        frame_arena_begin(&bench->world->sim_arena);
+        update_global_system(bench->world);
+    }
+}
+
+static void bench_update_global_moving(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Moving the top of every chain means every global matrix has to be recomputed.
+        for (size_t j = 0; j < arrlenu(bench->arr_wide); j++)
+            set_pos(&bench->arr_wide[j]->transform, (vec3){(float)(i & 255), (float)j, 0});
+
+        update_local_system(bench->world);
+        frame_arena_begin(&bench->world->sim_arena);
+        update_global_system(bench->world);
+    }
+}
+
+static void bench_set_parent_wide(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Random position in a wide parent, should cost the same as the last child now there's no search.
+        entity_t *entity = bench->arr_wide[rng_next(&bench->rng) % arrlenu(bench->arr_wide)];
+
+        set_parent(entity, bench->parent_b);
+        set_parent(entity, bench->parent_a);
+    }
+}
+
+static void bench_set_parent_deep(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Detach the bottom half of the chain and hang it back where it was.
+        set_parent(bench->moving, bench->parent_b);
+        set_parent(bench->moving, bench->parent_a);
+    }
+}
+
+static void bench_reparent_children(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        reparent_children(bench->parent_a, bench->parent_b);
+        reparent_children(bench->parent_b, bench->parent_a);
+    }
+}
+
+static void bench_entity_churn(void *user_data, uint64_t num_iterations)
+{
+    entity_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Never the root at index 0.
+        size_t index = 1 + rng_next(&bench->rng) % (arrlenu(bench->world->entities) - 1);
+        entity_free(bench->world, bench->world->entities[index]);
+        bench_do_not_optimise(entity_new(bench->world));
+    }
+}
+
+void bench_entities(bench_runner_t *runner)
+{
+    const size_t counts[] = {1000, 100000, 1000000};
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        size_t count = counts[i];
+        if (count > runner->max_entities)
+            continue;
+
+        char local_clean_name[128], local_dirty_name[128], global_name[128];
+        snprintf(local_clean_name, sizeof(local_clean_name), "update_local_system/clean/%zu", count);
+        snprintf(local_dirty_name, sizeof(local_dirty_name), "update_local_system/dirty/%zu", count);
+        snprintf(global_name, sizeof(global_name), "update_global_system/flat/%zu", count);
+
+        if (!bench_enabled(runner, local_clean_name) && !bench_enabled(runner, local_dirty_name) && !bench_enabled(runner, global_name))
+            continue;
+
+        entity_bench_t bench = {.world = world_new(0, 0, FRAME_ARENA_SIZE, 1), .rng = 1};
+        bench_world_populate(bench.world, count, &bench.rng);
+
+        // Reported per entity.
+        uint64_t num_entities = arrlenu(bench.world->entities);
+        bench_run(runner, local_clean_name, bench_update_local_clean, &bench, num_entities, 0);
+        bench_run(runner, local_dirty_name, bench_update_local_dirty, &bench, num_entities, 0);
+        bench_run(runner, global_name, bench_update_global, &bench, num_entities, 0);
+
+        world_free(bench.world);
+    }
+
+    const size_t widths[] = {100, 10000};
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++)
+    {
+        char set_parent_name[128], reparent_name[128];
+        snprintf(set_parent_name, sizeof(set_parent_name), "set_parent/wide/%zu", widths[i]);
+        snprintf(reparent_name, sizeof(reparent_name), "reparent_children/%zu", widths[i]);
+        if (!bench_enabled(runner, set_parent_name) && !bench_enabled(runner, reparent_name))
+            continue;
+
+        entity_bench_t bench = {.world = world_new(0, 0, FRAME_ARENA_SIZE, 1), .rng = 1};
+        bench.parent_a = entity_new(bench.world);
+        bench.parent_b = entity_new(bench.world);
+        for (size_t j = 0; j < widths[i]; j++)
+        {
+            entity_t *entity = entity_new(bench.world);
+            set_parent(entity, bench.parent_a);
+            arrput(bench.arr_wide, entity);
+        }
+
+        bench_run(runner, set_parent_name, bench_set_parent_wide, &bench, 2, 0);
+        // Per child moved, there and back.
+        bench_run(runner, reparent_name, bench_reparent_children, &bench, 2 * widths[i], 0);
+
+        arrfree(bench.arr_wide);
+        world_free(bench.world);
+    }
+
+    const size_t depths[] = {100, 10000};
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++)
+    {
+        char set_parent_name[128], global_name[128];
+        snprintf(set_parent_name, sizeof(set_parent_name), "set_parent/deep/%zu", depths[i]);
+        snprintf(global_name, sizeof(global_name), "update_global_system/deep/%zu", depths[i]);
+        if (!bench_enabled(runner, set_parent_name) && !bench_enabled(runner, global_name))
+            continue;
+
+        entity_bench_t bench = {.world = world_new(0, 0, FRAME_ARENA_SIZE, 1), .rng = 1};
+        bench.parent_b = entity_new(bench.world);
+        set_parent(bench.parent_b, bench.world->root);
+
+        entity_t *parent = bench.world->root;
+        for (size_t j = 0; j < depths[i]; j++)
+        {
+            entity_t *entity = entity_new(bench.world);
+            set_parent(entity, parent);
+
+            if (j == depths[i] / 2)
+            {
+                bench.parent_a = parent;
+                bench.moving = entity;
+            }
+
+            parent = entity;
+        }
+
+        bench_run(runner, set_parent_name, bench_set_parent_deep, &bench, 2, 0);
+        bench_run(runner, global_name, bench_update_global, &bench, arrlenu(bench.world->entities), 0);
+
+        world_free(bench.world);
+    }
+
+    {
+        // A million entities as a thousand chains a thousand deep, deep enough to overflow a recursive traversal.
+        const size_t num_chains = 1000, chain_length = 1000;
+        const char *static_name = "update_global_system/depth_1000/1000000/static";
+        const char *moving_name = "update_global_system/depth_1000/1000000/moving";
+        if (num_chains * chain_length <= runner->max_entities &&
+            (bench_enabled(runner, static_name) || bench_enabled(runner, moving_name)))
+        {
+            entity_bench_t bench = {.world = world_new(0, 0, FRAME_ARENA_SIZE, 1), .rng = 1};
+            for (size_t j = 0; j < num_chains; j++)
+            {
+                entity_t *parent = bench.world->root;
+                for (size_t k = 0; k < chain_length; k++)
+                {
+                    entity_t *entity = entity_new(bench.world);
+                    set_parent(entity, parent);
+                    set_pos(&entity->transform, (vec3){1, 1, 0});
+                    parent = entity;
+
+                    if (k == 0)
+                        arrput(bench.arr_wide, entity);
+                }
+            }
+
+            update_local_system(bench.world);
+            update_global_system(bench.world);
+
+            uint64_t num_entities = arrlenu(bench.world->entities);
+            bench_run(runner, static_name, bench_update_global, &bench, num_entities, 0);
+            bench_run(runner, moving_name, bench_update_global_moving, &bench, num_entities, 0);
+
+            arrfree(bench.arr_wide);
+            world_free(bench.world);
+        }
+    }
+
+    const size_t live_counts[] = {1000, 100000};
+    for (size_t i = 0; i < sizeof(live_counts) / sizeof(live_counts[0]); i++)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "entity_new_free/churn/%zu", live_counts[i]);
+        if (live_counts[i] > runner->max_entities || !bench_enabled(runner, name))
+            continue;
+
+        entity_bench_t bench = {.world = world_new(0, 0, FRAME_ARENA_SIZE, 1), .rng = 1};
+        for (size_t j = 0; j < live_counts[i]; j++)
+            entity_new(bench.world);
+
+        // One free and one new per op.
+        bench_run(runner, name, bench_entity_churn, &bench, 1, 0);
+
+        world_free(bench.world);
+    }
+}
\ No newline at end of file
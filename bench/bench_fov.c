@@ -0,0 +1,148 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/fov.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_PLAYERS 100
+#define BENCH_NUM_MOVED 10
+#define BENCH_VIEW_RADIUS 24
+
+typedef struct fov_bench_t
+{
+    fov_t fov;
+    job_system_t *jobs;
+    fov_bitset_t scratch;
+    uint8_t *texels;
+    uint64_t rng;
+} fov_bench_t;
+
+static void bench_random_open_tile(const fov_t *fov, uint64_t *rng, int32_t *x, int32_t *y)
+{
+    do
+    {
+        *x = (int32_t)(rng_next(rng) % fov->width);
+        *y = (int32_t)(rng_next(rng) % fov->height);
+    } while (fov_bitset_get(&fov->opaque, *x, *y));
+}
+
+static void bench_compute(void *user_data, uint64_t num_iterations)
+{
+    fov_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        int32_t x, y;
+        bench_random_open_tile(&bench->fov, &bench->rng, &x, &y);
+        fov_compute(&bench->fov.opaque, x, y, BENCH_VIEW_RADIUS, &bench->scratch);
+        bench_do_not_optimise(bench->scratch.words);
+
+        // Same as a viewer being recomputed, only the square it touched.
+        fov_bitset_clear_words(&bench->scratch, x < BENCH_VIEW_RADIUS ? 0 : (uint32_t)x - BENCH_VIEW_RADIUS, y < BENCH_VIEW_RADIUS ? 0 : (uint32_t)y - BENCH_VIEW_RADIUS,
+                               (uint32_t)x + BENCH_VIEW_RADIUS + 1 > bench->scratch.width ? bench->scratch.width : (uint32_t)x + BENCH_VIEW_RADIUS + 1,
+                               (uint32_t)y + BENCH_VIEW_RADIUS + 1 > bench->scratch.height ? bench->scratch.height : (uint32_t)y + BENCH_VIEW_RADIUS + 1);
+    }
+}
+
+static void bench_update_all(void *user_data, uint64_t num_iterations)
+{
+    fov_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        fov_update_all(&bench->fov, bench->jobs);
+}
+
+static void bench_update_moved(void *user_data, uint64_t num_iterations)
+{
+    fov_bench_t *bench = user_data;
+    fov_t *fov = &bench->fov;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // A turn where a tenth of the players take a step, everyone else stands still and is left alone.
+        for (uint32_t j = 0; j < BENCH_NUM_MOVED; j++)
+        {
+            uint32_t player = (uint32_t)(rng_next(&bench->rng) % BENCH_NUM_PLAYERS);
+            const fov_viewer_t *viewer = &fov->arr_viewers[player];
+            int32_t x = viewer->x + (int32_t)(rng_next(&bench->rng) % 3) - 1, y = viewer->y + (int32_t)(rng_next(&bench->rng) % 3) - 1;
+            if (x >= 0 && y >= 0 && (uint32_t)x < fov->width && (uint32_t)y < fov->height && !fov_bitset_get(&fov->opaque, x, y))
+                fov_move_viewer(fov, player, x, y);
+        }
+
+        fov_update(fov, bench->jobs);
+    }
+}
+
+static void bench_write_texels(void *user_data, uint64_t num_iterations)
+{
+    fov_bench_t *bench = user_data;
+    const fov_viewer_t *viewer = &bench->fov.arr_viewers[0];
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        fov_write_texels(&viewer->visible, &viewer->explored, bench->texels);
+        bench_do_not_optimise(bench->texels);
+    }
+}
+
+void bench_fov(bench_runner_t *runner)
+{
+    const uint32_t map_size = 1024;
+    // Tile types from tilemap_generate, the last one is a wall like in the pathfinding benchmarks.
+    const uint8_t opaque_tiles[] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+    const char *compute_name = "fov/1024/compute/radius_24";
+    const char *update_all_names[] = {"fov/1024/update_all/100_players", "fov/1024/update_all/100_players/1_thread"};
+    const char *moved_name = "fov/1024/update/10_of_100_moved";
+    const char *texels_name = "fov/1024/write_texels";
+
+    uint8_t any_enabled = bench_enabled(runner, compute_name) || bench_enabled(runner, moved_name) || bench_enabled(runner, texels_name);
+    for (size_t i = 0; i < 2; i++)
+        any_enabled |= bench_enabled(runner, update_all_names[i]);
+    if (!any_enabled)
+        return;
+
+    tilemap_t tilemap = tilemap_new(map_size, map_size, 1);
+    tilemap_generate(&tilemap, 1, 8);
+
+    fov_bench_t bench = {0};
+    bench.rng = 1;
+    bench.fov = fov_from_tilemap(&tilemap, opaque_tiles, sizeof(opaque_tiles));
+    tilemap_free(&tilemap);
+
+    bench.scratch = fov_bitset_new(map_size, map_size);
+    bench.texels = malloc((size_t)map_size * map_size);
+
+    // Spread out over the map, so the explored bitsets have some of everything in them.
+    for (uint32_t i = 0; i < BENCH_NUM_PLAYERS; i++)
+    {
+        int32_t x, y;
+        bench_random_open_tile(&bench.fov, &bench.rng, &x, &y);
+        fov_add_viewer(&bench.fov, x, y, BENCH_VIEW_RADIUS);
+    }
+
+    job_system_t *job_systems[2] = {job_system_new(JOB_SYSTEM_AUTO_WORKERS), job_system_new(0)};
+    fov_update(&bench.fov, job_systems[0]);
+
+    bench_run(runner, compute_name, bench_compute, &bench, 1, 0);
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        bench.jobs = job_systems[i];
+        bench_run(runner, update_all_names[i], bench_update_all, &bench, 1, 0);
+    }
+
+    bench.jobs = job_systems[0];
+    bench_run(runner, moved_name, bench_update_moved, &bench, 1, 0);
+    bench_run(runner, texels_name, bench_write_texels, &bench, 1, 0);
+
+    if (bench_enabled(runner, update_all_names[0]))
+        printf("%s over %u threads\n", update_all_names[0], job_system_num_threads(job_systems[0]));
+
+    job_system_free(job_systems[0]);
+    job_system_free(job_systems[1]);
+    free(bench.texels);
+    fov_bitset_free(&bench.scratch);
+    fov_free(&bench.fov);
+}
\ No newline at end of file
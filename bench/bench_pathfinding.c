@@ -0,0 +1,312 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/pathfinding.h"
+#include "../src/path_hierarchy.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_QUERIES 10000
+// Goals are picked within this many tiles of the start on each axis, unit moves and AI lookahead rather than
+// corner to corner.
+#define BENCH_QUERY_RANGE 64
+// Anywhere to anywhere, what the hierarchy is for.
+#define BENCH_NUM_LONG_QUERIES 1000
+// Tiles knocked down or built up before each query in the edit benchmark.
+#define BENCH_EDITS_PER_QUERY 8
+
+typedef struct pathfinding_bench_t
+{
+    const path_grid_t *grid;
+    path_algorithm_e algorithm;
+    path_query_t *queries;
+    path_t *results;
+    uint64_t next_query;
+
+    job_system_t *jobs;
+    pathfinder_t *pathfinders;
+
+    path_grid_t *mutable_grid;
+    path_hierarchy_t hierarchy;
+    path_query_t *long_queries;
+    uint64_t rng;
+} pathfinding_bench_t;
+
+static void bench_find_one(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint64_t index = bench->next_query++ % BENCH_NUM_QUERIES;
+        pathfinder_find(&bench->pathfinders[0], bench->grid, &bench->queries[index], bench->algorithm, &bench->results[index]);
+    }
+}
+
+static void bench_find_batch(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        pathfinder_find_batch(bench->jobs, bench->pathfinders, bench->grid, bench->queries, bench->results, BENCH_NUM_QUERIES, bench->algorithm);
+}
+
+static void bench_find_long(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint64_t index = bench->next_query++ % BENCH_NUM_LONG_QUERIES;
+        pathfinder_find(&bench->pathfinders[0], bench->grid, &bench->long_queries[index], bench->algorithm, &bench->results[index]);
+    }
+}
+
+static void bench_hierarchy_find_long(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint64_t index = bench->next_query++ % BENCH_NUM_LONG_QUERIES;
+        path_hierarchy_find(&bench->hierarchy, bench->mutable_grid, &bench->long_queries[index], &bench->results[index]);
+    }
+}
+
+static void bench_hierarchy_edit_find(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+    path_grid_t *grid = bench->mutable_grid;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // Craters and barricades, the query pays for rebuilding what they touched.
+        for (uint32_t j = 0; j < BENCH_EDITS_PER_QUERY; j++)
+        {
+            uint32_t x = (uint32_t)(rng_next(&bench->rng) % grid->width), y = (uint32_t)(rng_next(&bench->rng) % grid->height);
+            uint8_t cost = path_grid_cost(grid, (int32_t)x, (int32_t)y) == PATH_COST_BLOCKED ? 1 : PATH_COST_BLOCKED;
+            path_hierarchy_set_cost(&bench->hierarchy, grid, x, y, cost);
+        }
+
+        uint64_t index = bench->next_query++ % BENCH_NUM_LONG_QUERIES;
+        path_hierarchy_find(&bench->hierarchy, grid, &bench->long_queries[index], &bench->results[index]);
+    }
+}
+
+static void bench_hierarchy_build(void *user_data, uint64_t num_iterations)
+{
+    pathfinding_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        path_hierarchy_t hierarchy = path_hierarchy_new(bench->mutable_grid, TILEMAP_CHUNK_SIZE);
+        path_hierarchy_free(&hierarchy);
+    }
+}
+
+static void bench_pick_long_queries(const path_grid_t *grid, path_query_t *queries, uint64_t *rng)
+{
+    for (size_t i = 0; i < BENCH_NUM_LONG_QUERIES; i++)
+    {
+        path_query_t query;
+        do
+        {
+            query.start_x = (uint32_t)(rng_next(rng) % grid->width);
+            query.start_y = (uint32_t)(rng_next(rng) % grid->height);
+            query.goal_x = (uint32_t)(rng_next(rng) % grid->width);
+            query.goal_y = (uint32_t)(rng_next(rng) % grid->height);
+        } while (path_grid_cost(grid, (int32_t)query.start_x, (int32_t)query.start_y) == PATH_COST_BLOCKED ||
+                 path_grid_cost(grid, (int32_t)query.goal_x, (int32_t)query.goal_y) == PATH_COST_BLOCKED);
+
+        queries[i] = query;
+    }
+}
+
+static void bench_pick_queries(const path_grid_t *grid, path_query_t *queries, uint64_t *rng)
+{
+    for (size_t i = 0; i < BENCH_NUM_QUERIES; i++)
+    {
+        path_query_t query;
+        do
+        {
+            query.start_x = (uint32_t)(rng_next(rng) % grid->width);
+            query.start_y = (uint32_t)(rng_next(rng) % grid->height);
+        } while (path_grid_cost(grid, (int32_t)query.start_x, (int32_t)query.start_y) == PATH_COST_BLOCKED);
+
+        do
+        {
+            int64_t x = (int64_t)query.start_x + (int64_t)(rng_next(rng) % (2 * BENCH_QUERY_RANGE + 1)) - BENCH_QUERY_RANGE;
+            int64_t y = (int64_t)query.start_y + (int64_t)(rng_next(rng) % (2 * BENCH_QUERY_RANGE + 1)) - BENCH_QUERY_RANGE;
+            query.goal_x = (uint32_t)(x < 0 ? 0 : x >= grid->width ? grid->width - 1 : x);
+            query.goal_y = (uint32_t)(y < 0 ? 0 : y >= grid->height ? grid->height - 1 : y);
+        } while (path_grid_cost(grid, (int32_t)query.goal_x, (int32_t)query.goal_y) == PATH_COST_BLOCKED);
+
+        queries[i] = query;
+    }
+}
+
+static void bench_print_summary(const char *label, const path_t *results)
+{
+    uint64_t num_found = 0, num_expanded = 0, num_points = 0;
+    for (size_t i = 0; i < BENCH_NUM_QUERIES; i++)
+    {
+        num_found += results[i].found;
+        num_expanded += results[i].num_expanded;
+        num_points += arrlenu(results[i].arr_points);
+    }
+
+    printf("%s: %.1f%% found, %.0f nodes expanded and %.0f tiles long on average\n",
+           label,
+           100.0 * num_found / BENCH_NUM_QUERIES,
+           (double)num_expanded / BENCH_NUM_QUERIES,
+           num_found ? (double)num_points / num_found : 0.0);
+}
+
+void bench_pathfinding(bench_runner_t *runner)
+{
+    const uint32_t map_size = 1024;
+    // Tile types from tilemap_generate, the last one is a wall. Mud, sand and rough ground in the weighted one.
+    const uint8_t uniform_costs[] = {PATH_COST_BLOCKED, 1, 1, 1, 1, 1, 1, 1, PATH_COST_BLOCKED};
+    const uint8_t weighted_costs[] = {PATH_COST_BLOCKED, 1, 1, 2, 3, 1, 1, 4, PATH_COST_BLOCKED};
+
+    const char *single_names[] = {"pathfinding/1024/astar/uniform", "pathfinding/1024/jps/uniform", "pathfinding/1024/astar/weighted"};
+    const path_algorithm_e single_algorithms[] = {PATH_ALGORITHM_ASTAR, PATH_ALGORITHM_JPS, PATH_ALGORITHM_ASTAR};
+    const char *batch_names[] = {"pathfinding/1024/batch_10k/jps/uniform", "pathfinding/1024/batch_10k/astar/weighted"};
+    const char *serial_batch_names[] = {"pathfinding/1024/batch_10k/jps/uniform/1_thread", "pathfinding/1024/batch_10k/astar/weighted/1_thread"};
+    const char *long_names[] = {"pathfinding/1024/long/astar", "pathfinding/1024/long/jps", "pathfinding/1024/long/hpa"};
+    const char *build_name = "pathfinding/1024/hpa/build";
+    const char *edit_name = "pathfinding/1024/hpa/edit_8_then_find";
+
+    uint8_t any_enabled = 0;
+    for (size_t i = 0; i < 3; i++)
+        any_enabled |= bench_enabled(runner, single_names[i]);
+    for (size_t i = 0; i < 2; i++)
+        any_enabled |= bench_enabled(runner, batch_names[i]) | bench_enabled(runner, serial_batch_names[i]);
+    for (size_t i = 0; i < 3; i++)
+        any_enabled |= bench_enabled(runner, long_names[i]);
+    any_enabled |= bench_enabled(runner, build_name) | bench_enabled(runner, edit_name);
+    if (!any_enabled)
+        return;
+
+    tilemap_t tilemap = tilemap_new(map_size, map_size, 1);
+    tilemap_generate(&tilemap, 1, 8);
+    path_grid_t grids[2] = {
+        path_grid_from_tilemap(&tilemap, uniform_costs, sizeof(uniform_costs)),
+        path_grid_from_tilemap(&tilemap, weighted_costs, sizeof(weighted_costs)),
+    };
+    tilemap_free(&tilemap);
+
+    // Same starts and goals on both, the walls are in the same place.
+    uint64_t rng = 1;
+    pathfinding_bench_t bench = {0};
+    bench.queries = malloc(BENCH_NUM_QUERIES * sizeof(path_query_t));
+    bench.results = calloc(BENCH_NUM_QUERIES, sizeof(path_t));
+    bench_pick_queries(&grids[0], bench.queries, &rng);
+
+    job_system_t *job_systems[2] = {job_system_new(JOB_SYSTEM_AUTO_WORKERS), job_system_new(0)};
+    uint32_t num_pathfinders = job_system_num_threads(job_systems[0]);
+    bench.pathfinders = malloc(num_pathfinders * sizeof(pathfinder_t));
+    for (uint32_t i = 0; i < num_pathfinders; i++)
+        bench.pathfinders[i] = pathfinder_new(map_size * map_size);
+
+    // Per query.
+    for (size_t i = 0; i < 3; i++)
+    {
+        bench.grid = &grids[single_algorithms[i] == PATH_ALGORITHM_ASTAR && i == 2];
+        bench.algorithm = single_algorithms[i];
+        bench_run(runner, single_names[i], bench_find_one, &bench, 1, 0);
+    }
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        bench.grid = &grids[i];
+        bench.algorithm = i ? PATH_ALGORITHM_ASTAR : PATH_ALGORITHM_JPS;
+
+        bench.jobs = job_systems[0];
+        bench_run(runner, batch_names[i], bench_find_batch, &bench, BENCH_NUM_QUERIES, 0);
+        if (bench_enabled(runner, batch_names[i]))
+        {
+            char label[160];
+            snprintf(label, sizeof(label), "%s over %u threads", batch_names[i], num_pathfinders);
+            bench_print_summary(label, bench.results);
+        }
+
+        bench.jobs = job_systems[1];
+        bench_run(runner, serial_batch_names[i], bench_find_batch, &bench, BENCH_NUM_QUERIES, 0);
+    }
+
+    // Long queries over the uniform grid, the hierarchy against searching every tile.
+    bench.long_queries = malloc(BENCH_NUM_LONG_QUERIES * sizeof(path_query_t));
+    bench_pick_long_queries(&grids[0], bench.long_queries, &rng);
+    bench.grid = bench.mutable_grid = &grids[0];
+    // Optimal costs of however many long queries A* got through, to see how far off the hierarchy's paths are.
+    uint32_t *optimal_costs = malloc(BENCH_NUM_LONG_QUERIES * sizeof(uint32_t));
+    uint64_t num_optimal = 0;
+    for (size_t i = 0; i < 2; i++)
+    {
+        bench.algorithm = i ? PATH_ALGORITHM_JPS : PATH_ALGORITHM_ASTAR;
+        bench.next_query = 0;
+        bench_run(runner, long_names[i], bench_find_long, &bench, 1, 0);
+        if (i == 0 && bench_enabled(runner, long_names[i]))
+        {
+            num_optimal = bench.next_query < BENCH_NUM_LONG_QUERIES ? bench.next_query : BENCH_NUM_LONG_QUERIES;
+            for (uint64_t j = 0; j < num_optimal; j++)
+                optimal_costs[j] = bench.results[j].cost;
+        }
+    }
+
+    if (bench_enabled(runner, long_names[2]) || bench_enabled(runner, build_name) || bench_enabled(runner, edit_name))
+    {
+        bench_run(runner, build_name, bench_hierarchy_build, &bench, 1, 0);
+
+        bench.hierarchy = path_hierarchy_new(&grids[0], TILEMAP_CHUNK_SIZE);
+        bench.next_query = 0;
+        bench_run(runner, long_names[2], bench_hierarchy_find_long, &bench, 1, 0);
+        if (bench_enabled(runner, long_names[2]))
+        {
+            const path_hierarchy_stats_t *stats = &bench.hierarchy.stats;
+            printf("%s: %llu queries, %.1f%% segment cache hits", long_names[2],
+                   (unsigned long long)stats->num_queries,
+                   100.0 * stats->num_segment_hits / (double)(stats->num_segment_hits + stats->num_segment_misses + !stats->num_segment_hits));
+            uint64_t num_compared = bench.next_query < num_optimal ? bench.next_query : num_optimal;
+            uint64_t optimal_cost = 0, hierarchy_cost = 0;
+            for (uint64_t j = 0; j < num_compared; j++)
+            {
+                optimal_cost += optimal_costs[j];
+                hierarchy_cost += bench.results[j].cost;
+            }
+            if (optimal_cost)
+                printf(", paths %.2f%% longer than A* over %llu queries", 100.0 * ((double)hierarchy_cost / (double)optimal_cost - 1.0), (unsigned long long)num_compared);
+            printf("\n");
+        }
+
+        bench.rng = 2;
+        bench.hierarchy.stats = (path_hierarchy_stats_t){0};
+        bench_run(runner, edit_name, bench_hierarchy_edit_find, &bench, 1, 0);
+        if (bench_enabled(runner, edit_name) && bench.hierarchy.stats.num_rebuilds)
+        {
+            const path_hierarchy_stats_t *stats = &bench.hierarchy.stats;
+            printf("%s: %.1f clusters and %.3f ms per rebuild, %.1f%% segment cache hits\n", edit_name,
+                   (double)stats->num_clusters_rebuilt / (double)stats->num_rebuilds,
+                   stats->total_rebuild_ms / (float)stats->num_rebuilds,
+                   100.0 * stats->num_segment_hits / (double)(stats->num_segment_hits + stats->num_segment_misses + !stats->num_segment_hits));
+        }
+
+        path_hierarchy_free(&bench.hierarchy);
+    }
+    free(optimal_costs);
+    free(bench.long_queries);
+
+    for (uint32_t i = 0; i < num_pathfinders; i++)
+        pathfinder_free(&bench.pathfinders[i]);
+    free(bench.pathfinders);
+    job_system_free(job_systems[0]);
+    job_system_free(job_systems[1]);
+
+    for (size_t i = 0; i < BENCH_NUM_QUERIES; i++)
+        path_free(&bench.results[i]);
+    free(bench.results);
+    free(bench.queries);
+    path_grid_free(&grids[0]);
+    path_grid_free(&grids[1]);
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/replication.h"
+#include "../src/world_snapshot.h"
+#include "../src/asset_cache.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_ENTITIES 100000
+// Every subscriber on localhost keeps a whole copy of the world, so fewer of them.
+#define BENCH_NUM_LOCALHOST_ENTITIES 10000
+#define BENCH_MAX_SUBSCRIBERS 8
+#define BENCH_NUM_TEXTURES 16
+#define BENCH_CHILDREN_PER_PARENT 10
+// One in this many entities moves each turn.
+#define BENCH_MOVING_EVERY 10
+
+typedef struct replication_bench_t
+{
+    world_t *world;
+    uint32_t turn;
+
+    replication_state_t baseline;
+    replication_state_t current;
+    // What a spectator has, deltas are applied to it and the world.
+    replication_state_t received;
+    uint8_t *arr_delta;
+
+    replication_server_t server;
+    replication_client_t clients[BENCH_MAX_SUBSCRIBERS];
+    world_t *spectators[BENCH_MAX_SUBSCRIBERS];
+    uint32_t num_clients;
+} replication_bench_t;
+
+// Groups of sprites under a parent, like the stress scene.
+static void bench_world_populate(world_t *world, uint32_t num_entities, uint64_t *rng)
+{
+    asset_cache_t *cache = world->asset_cache;
+
+    entity_t *parent = world->root;
+    for (uint32_t i = 1; i < num_entities; i++)
+    {
+        entity_t *entity = entity_new(world);
+        uint8_t is_parent = i % BENCH_CHILDREN_PER_PARENT == 1;
+        set_parent(entity, is_parent ? world->root : parent);
+        if (is_parent)
+            parent = entity;
+
+        float x = (float)(rng_next(rng) % 100000) / 100, y = (float)(rng_next(rng) % 100000) / 100;
+        set_pos(&entity->transform, (vec3){x, y, 1});
+        set_scale(&entity->transform, (vec2){32, 32});
+
+        entity->render_type = RENDER_TYPE_SPRITE;
+        entity->sprite.texture = &cache->sh_textures[rng_next(rng) % BENCH_NUM_TEXTURES].value;
+        memcpy(entity->sprite.anchor, (vec2){0.5f, 0.5f}, sizeof(vec2));
+        memcpy(entity->sprite.color, (vec4){1, 1, 1, 1}, sizeof(vec4));
+    }
+
+    update_global_system(world);
+}
+
+// A different tenth of the entities each turn take a step, nothing is created or reparented so it's all deltas.
+static void bench_world_move(world_t *world, uint32_t turn)
+{
+    for (size_t i = 1 + turn % BENCH_MOVING_EVERY; i < arrlenu(world->entities); i += BENCH_MOVING_EVERY)
+    {
+        transform_t *transform = &world->entities[i]->transform;
+        float step = turn % 2 ? 1.5f : -1.5f;
+        set_pos(transform, (vec3){transform->pos[0] + step, transform->pos[1] - step * 0.5f, transform->pos[2]});
+    }
+}
+
+static void bench_capture(void *user_data, uint64_t num_iterations)
+{
+    replication_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        replication_state_capture(&bench->current, bench->world);
+        bench_do_not_optimise(bench->current.arr_entities);
+    }
+}
+
+static void bench_encode_delta(void *user_data, uint64_t num_iterations)
+{
+    replication_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint32_t num_changed = replication_encode_delta(&bench->baseline, &bench->current, (uint32_t)i, &bench->arr_delta);
+        bench_do_not_optimise((void *)(uintptr_t)num_changed);
+    }
+}
+
+static void bench_apply_delta(void *user_data, uint64_t num_iterations)
+{
+    replication_bench_t *bench = user_data;
+
+    // The same delta again and again, it adds to where everything already is so it's never a no-op.
+    const uint8_t *payload = bench->arr_delta + REPLICATION_MESSAGE_HEADER_SIZE;
+    size_t payload_size = arrlenu(bench->arr_delta) - REPLICATION_MESSAGE_HEADER_SIZE;
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint8_t is_applied = replication_apply_delta(&bench->received, bench->world, payload, payload_size);
+        bench_do_not_optimise((void *)(uintptr_t)is_applied);
+    }
+}
+
+// Until every spectator has the server's last turn.
+static void bench_sync(replication_bench_t *bench)
+{
+    for (uint8_t is_synced = 0; !is_synced;)
+    {
+        replication_server_flush(&bench->server);
+
+        is_synced = 1;
+        for (uint32_t i = 0; i < bench->num_clients; i++)
+        {
+            replication_client_t *client = &bench->clients[i];
+            replication_client_poll(client, bench->spectators[i]);
+            is_synced &= client->is_disconnected || (client->has_keyframe && client->turn == bench->server.turn - 1);
+        }
+    }
+}
+
+// A whole turn, moving, encoding, sending and every spectator applying it. Results are per spectator.
+static void bench_localhost(void *user_data, uint64_t num_iterations)
+{
+    replication_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        bench_world_move(bench->world, bench->turn++);
+        replication_server_publish(&bench->server, bench->world);
+        bench_sync(bench);
+    }
+}
+
+static void bench_localhost_run(bench_runner_t *runner, const char *name, asset_cache_t *cache, uint32_t num_clients)
+{
+    if (!bench_enabled(runner, name))
+        return;
+
+    uint64_t rng = 2;
+    replication_bench_t bench = {.world = world_new(cache, 0, FRAME_ARENA_SIZE, 1), .num_clients = num_clients};
+    bench_world_populate(bench.world, BENCH_NUM_LOCALHOST_ENTITIES, &rng);
+
+    net_init();
+    bench.server = replication_server_new(0);
+    if (bench.server.listener == NET_INVALID_SOCKET)
+    {
+        printf("%s: couldn't listen on localhost, skipped\n", name);
+        world_free(bench.world);
+        return;
+    }
+
+    for (uint32_t i = 0; i < num_clients; i++)
+    {
+        bench.clients[i] = replication_client_new("127.0.0.1", bench.server.port);
+        bench.spectators[i] = world_new(cache, 0, FRAME_ARENA_SIZE, 1);
+    }
+
+    // Everyone has their keyframe before anything is timed.
+    replication_server_publish(&bench.server, bench.world);
+    bench_sync(&bench);
+
+    bench_run(runner, name, bench_localhost, &bench, num_clients, 0);
+
+    const replication_stats_t *stats = &bench.server.stats;
+    printf("%s: %.1f bytes a turn, %.3f ms a turn to encode, %.3f ms a spectator a turn to send\n",
+           name,
+           stats->num_deltas ? (double)stats->total_delta_bytes / stats->num_deltas : 0.0,
+           stats->total_encode_ms / stats->num_turns,
+           stats->num_subscriber_turns ? stats->total_send_ms / (double)stats->num_subscriber_turns : 0.0);
+
+    for (uint32_t i = 0; i < num_clients; i++)
+    {
+        replication_client_free(&bench.clients[i]);
+        world_free(bench.spectators[i]);
+    }
+    replication_server_free(&bench.server);
+    net_shutdown();
+    world_free(bench.world);
+}
+
+void bench_replication(bench_runner_t *runner)
+{
+    const char *capture_name = "replication/capture/100k_entities";
+    const char *encode_name = "replication/encode_delta/100k_entities_10pct_moving";
+    const char *apply_name = "replication/apply_delta/100k_entities_10pct_moving";
+    const char *localhost_1_name = "replication/localhost_turn/10k_entities_1_spectator";
+    const char *localhost_8_name = "replication/localhost_turn/10k_entities_8_spectators";
+
+    uint8_t is_encoding = bench_enabled(runner, capture_name) || bench_enabled(runner, encode_name) || bench_enabled(runner, apply_name);
+    if (!is_encoding && !bench_enabled(runner, localhost_1_name) && !bench_enabled(runner, localhost_8_name))
+        return;
+
+    // No asset_cache_new or asset_cache_free, nothing in it is a real GL object.
+    asset_cache_t cache = {0};
+    sh_new_strdup(cache.sh_textures);
+    for (uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++)
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "./images/bench_texture_%02u.png", i);
+        shput(cache.sh_textures, key, ((texture_t){0}));
+    }
+
+    if (is_encoding)
+    {
+        uint64_t rng = 1;
+        replication_bench_t bench = {.world = world_new(&cache, 0, FRAME_ARENA_SIZE, 1)};
+        bench_world_populate(bench.world, BENCH_NUM_ENTITIES, &rng);
+        replication_state_capture(&bench.baseline, bench.world);
+        replication_state_capture(&bench.received, bench.world);
+        bench_world_move(bench.world, 0);
+
+        bench_run(runner, capture_name, bench_capture, &bench, 1, 0);
+        replication_state_capture(&bench.current, bench.world);
+        bench_run(runner, encode_name, bench_encode_delta, &bench, 1, 0);
+
+        uint32_t num_changed = replication_encode_delta(&bench.baseline, &bench.current, 0, &bench.arr_delta);
+        uint8_t *arr_keyframe = 0;
+        world_snapshot_save(bench.world, &arr_keyframe);
+        printf("replication: %u of %u entities changed in %zu bytes, %.2f bytes each, against a %.1f KB keyframe\n",
+               num_changed,
+               BENCH_NUM_ENTITIES,
+               arrlenu(bench.arr_delta),
+               num_changed ? (double)arrlenu(bench.arr_delta) / num_changed : 0.0,
+               (double)arrlenu(arr_keyframe) / 1024);
+
+        // Last, it moves the world around.
+        bench_run(runner, apply_name, bench_apply_delta, &bench, 1, 0);
+
+        arrfree(arr_keyframe);
+        arrfree(bench.arr_delta);
+        replication_state_free(&bench.baseline);
+        replication_state_free(&bench.current);
+        replication_state_free(&bench.received);
+        world_free(bench.world);
+    }
+
+    bench_localhost_run(runner, localhost_1_name, &cache, 1);
+    bench_localhost_run(runner, localhost_8_name, &cache, 8);
+
+    shfree(cache.sh_textures);
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../src/app.h"
+#include "../src/engine/engine.h"
+#include "../src/util/rng.h"
+
+typedef struct sprite_batch_bench_t
+{
+    sprite_batch_t *batch;
+    sprite_t sprite;
+    render_transform_t transforms[256];
+    sprite_quad_t quad;
+    // Clears the batch before it fills so only the CPU side is measured, no GL needed.
+    uint8_t discard;
+
+    // A whole scene's worth for the mixed benchmarks, interpolated then submitted like a frame would.
+    render_transform_t *previous;
+    render_transform_t *current;
+    size_t num_sprites;
+} sprite_batch_bench_t;
+
+static void sprite_batch_bench_discard(sprite_batch_t *batch)
+{
+    if (batch->num_quads + 1 >= batch->max_batch_size)
+        batch->num_quads = 0;
+}
+
+static void bench_submit_sprite(void *user_data, uint64_t num_iterations)
+{
+    sprite_batch_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        if (bench->discard)
+            sprite_batch_bench_discard(bench->batch);
+
+        submit_sprite(bench->batch, &bench->sprite, &bench->transforms[i & 255]);
+    }
+
+    if (!bench->discard)
+    {
+        sprite_batch_flush(bench->batch);
+        glFinish();
+    }
+
+    bench_do_not_optimise(bench->batch->vertices);
+}
+
+static void bench_submit_quad(void *user_data, uint64_t num_iterations)
+{
+    sprite_batch_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        if (bench->discard)
+            sprite_batch_bench_discard(bench->batch);
+
+        bench->quad.pos[0][0] = (float)(i & 255);
+        sprite_batch_submit_quad(bench->batch, &bench->quad, bench->sprite.texture->texture);
+    }
+
+    if (!bench->discard)
+    {
+        sprite_batch_flush(bench->batch);
+        glFinish();
+    }
+
+    bench_do_not_optimise(bench->batch->vertices);
+}
+
+static void bench_submit_scene(void *user_data, uint64_t num_iterations)
+{
+    sprite_batch_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        for (size_t j = 0; j < bench->num_sprites; j++)
+        {
+            sprite_batch_bench_discard(bench->batch);
+
+            render_transform_t transform;
+            render_transform_lerp(&transform, &bench->previous[j], &bench->current[j], 0.5f);
+            submit_sprite(bench->batch, &bench->sprite, &transform);
+        }
+    }
+
+    bench_do_not_optimise(bench->batch->vertices);
+}
+
+// Scene where rotated_percent of the sprites rotate between steps and the rest stay axis aligned.
+static void bench_scene_fill(sprite_batch_bench_t *bench, uint32_t rotated_percent, uint64_t *rng)
+{
+    for (size_t i = 0; i < bench->num_sprites; i++)
+    {
+        render_transform_t transform = {0};
+        transform.pos[0] = (float)(rng_next(rng) % 1280);
+        transform.pos[1] = (float)(rng_next(rng) % 720);
+        transform.scale[0] = transform.scale[1] = 32;
+        transform.flip_flags = (uint8_t)(rng_next(rng) & (TRANSFORM_FLIP_X | TRANSFORM_FLIP_Y));
+        bench->previous[i] = bench->current[i] = transform;
+
+        if (rng_next(rng) % 100 < rotated_percent)
+        {
+            float angle = (float)(rng_next(rng) % 628) / 100.0f;
+            bench->previous[i].is_rotated = bench->current[i].is_rotated = 1;
+            bench->previous[i].cos_rotation = cosf(angle);
+            bench->previous[i].sin_rotation = sinf(angle);
+            bench->current[i].cos_rotation = cosf(angle + 0.1f);
+            bench->current[i].sin_rotation = sinf(angle + 0.1f);
+        }
+    }
+}
+
+void bench_sprite_batch(bench_runner_t *runner)
+{
+    uint64_t rng = 1;
+
+    // A texture id that's never drawn, the CPU-only benchmarks never reach GL.
+    texture_t fake_texture = {.name = "bench", .texture = 1};
+
+    sprite_batch_bench_t bench = {0};
+    bench.sprite = (sprite_t){.anchor = {0.5f, 0.5f}, .color = {1, 1, 1, 1}, .texture = &fake_texture};
+    for (size_t i = 0; i < 256; i++)
+    {
+        render_transform_t *transform = &bench.transforms[i];
+        transform->pos[0] = (float)(rng_next(&rng) % 1280);
+        transform->pos[1] = (float)(rng_next(&rng) % 720);
+        transform->scale[0] = transform->scale[1] = 32;
+    }
+    bench.quad = (sprite_quad_t){
+        .pos = {{0, 0}, {0, 32}, {32, 32}, {32, 0}},
+        .uv = {{0, 0}, {0, 1}, {1, 1}, {1, 0}},
+        .color = {1, 1, 1, 1},
+    };
+
+    const sprite_vertex_format_e formats[] = {SPRITE_VERTEX_FORMAT_FLOAT, SPRITE_VERTEX_FORMAT_COMPACT};
+    const char *format_names[] = {"float", "compact"};
+    // Indexed or not, 4 or 6 vertices a quad.
+    const char *quad_names[] = {"arrays", "indexed"};
+    const uint32_t rotated_percents[] = {0, 10, 50, 100};
+
+    bench.num_sprites = 100000;
+    bench.previous = calloc(bench.num_sprites, sizeof(render_transform_t));
+    bench.current = calloc(bench.num_sprites, sizeof(render_transform_t));
+
+    for (size_t f = 0; f < 2; f++)
+    {
+        for (size_t q = 0; q < 2; q++)
+        {
+            char name[128];
+
+            sprite_batch_t cpu_batch = {0};
+            cpu_batch.max_batch_size = 1000;
+            cpu_batch.vertex_format = formats[f];
+            cpu_batch.vertex_size = formats[f] == SPRITE_VERTEX_FORMAT_COMPACT ? sizeof(compact_vertex_t) : sizeof(vertex_t);
+            cpu_batch.vertices_per_quad = q ? 4 : 6;
+            cpu_batch.vertices = calloc(cpu_batch.max_batch_size * cpu_batch.vertices_per_quad, cpu_batch.vertex_size);
+            cpu_batch.current_texture_id = fake_texture.texture;
+
+            bench.batch = &cpu_batch;
+            bench.discard = 1;
+            snprintf(name, sizeof(name), "sprite_batch/submit_sprite/cpu/%s/%s", format_names[f], quad_names[q]);
+            bench_run(runner, name, bench_submit_sprite, &bench, 1, 0);
+            snprintf(name, sizeof(name), "sprite_batch/submit_quad/cpu/%s/%s", format_names[f], quad_names[q]);
+            bench_run(runner, name, bench_submit_quad, &bench, 1, 0);
+
+            for (size_t i = 0; i < sizeof(rotated_percents) / sizeof(rotated_percents[0]); i++)
+            {
+                snprintf(name, sizeof(name), "sprite_batch/scene_100k/rotated_%u/cpu/%s/%s", rotated_percents[i], format_names[f], quad_names[q]);
+                if (!bench_enabled(runner, name))
+                    continue;
+
+                // Same scene for every layout.
+                uint64_t scene_rng = 1 + i;
+                bench_scene_fill(&bench, rotated_percents[i], &scene_rng);
+                // Per sprite.
+                bench_run(runner, name, bench_submit_scene, &bench, bench.num_sprites, 0);
+            }
+
+            free(cpu_batch.vertices);
+        }
+    }
+
+    free(bench.previous);
+    free(bench.current);
+
+    if (!runner->app)
+        return;
+
+    // The full path, uploading and drawing every 1000 quads into the headless render target.
+    app_t *app = runner->app;
+
+    texture_t texture = {.name = "bench"};
+    const uint32_t white = 0xffffffff;
+    GL_CALL(glCreateTextures(GL_TEXTURE_2D, 1, &texture.texture));
+    GL_CALL(glTextureStorage2D(texture.texture, 1, GL_RGBA8, 1, 1));
+    GL_CALL(glTextureSubImage2D(texture.texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &white));
+
+    render_target_bind(&app->render_target);
+    GLuint program = app->sprite_batch->program;
+    mat4x4 view_proj;
+    mat4x4_ortho(view_proj, 0, (float)app->window_width, 0, (float)app->window_height, -1, 1);
+    GL_CALL(glUseProgram(program));
+    glUniformMatrix4fv(glGetUniformLocation(program, "mat_view_proj"), 1, GL_FALSE, view_proj[0]);
+    GL_CALL(glUseProgram(0));
+
+    bench.sprite.texture = &texture;
+    bench.discard = 0;
+    for (size_t f = 0; f < 2; f++)
+    {
+        for (size_t q = 0; q < 2; q++)
+        {
+            char name[128];
+            sprite_batch_options_t options = {.max_batch_size = 1000, .vertex_format = formats[f], .indexed = (uint8_t)q};
+            sprite_batch_t batch = sprite_batch_new(program, &options);
+            bench.batch = &batch;
+
+            snprintf(name, sizeof(name), "sprite_batch/submit_sprite/flush/%s/%s", format_names[f], quad_names[q]);
+            bench_run(runner, name, bench_submit_sprite, &bench, 1, 0);
+            snprintf(name, sizeof(name), "sprite_batch/submit_quad/flush/%s/%s", format_names[f], quad_names[q]);
+            bench_run(runner, name, bench_submit_quad, &bench, 1, 0);
+
+            sprite_batch_free(&batch);
+        }
+    }
+
+    render_target_unbind(app->window_width, app->window_height);
+    glDeleteTextures(1, &texture.texture);
+}
\ No newline at end of file
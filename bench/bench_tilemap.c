@@ -0,0 +1,115 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/app.h"
+#include "../src/engine/memory.h"
+#include "../src/engine/render_target.h"
+#include "../src/util/rng.h"
+
+typedef struct tilemap_bench_t
+{
+    tilemap_t *tilemap;
+    tilemap_renderer_t *renderer;
+    compact_vertex_t *vertices;
+    mat4x4 view_proj;
+    uint64_t rng;
+} tilemap_bench_t;
+
+static void bench_chunk_write_vertices(void *user_data, uint64_t num_iterations)
+{
+    tilemap_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint32_t chunk = (uint32_t)(rng_next(&bench->rng) % ((uint64_t)bench->tilemap->chunks_x * bench->tilemap->chunks_y));
+        uint32_t num_quads = tilemap_chunk_write_vertices(bench->tilemap, chunk % bench->tilemap->chunks_x, chunk / bench->tilemap->chunks_x, 3, 3, bench->vertices);
+        bench_do_not_optimise((void *)(uintptr_t)num_quads);
+    }
+}
+
+static void bench_visible_chunks(void *user_data, uint64_t num_iterations)
+{
+    tilemap_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        uint32_t range[4];
+        bench->view_proj[3][0] = (float)(i & 1023) / 1024.0f;
+        bench_do_not_optimise((void *)(uintptr_t)tilemap_visible_chunks(bench->tilemap, bench->view_proj, range));
+        bench_do_not_optimise(range);
+    }
+}
+
+static void bench_draw_static(void *user_data, uint64_t num_iterations)
+{
+    tilemap_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        tilemap_renderer_draw(bench->renderer, bench->view_proj);
+
+    glFinish();
+}
+
+static void bench_draw_edit(void *user_data, uint64_t num_iterations)
+{
+    tilemap_bench_t *bench = user_data;
+    tilemap_t *tilemap = &bench->renderer->tilemap;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        // One tile in the middle of the view changes every frame, one chunk's rebuild on top of the static draw.
+        tilemap_set(tilemap, tilemap->width / 2, tilemap->height / 2, (tile_id_t)(1 + (i & 7)));
+        tilemap_renderer_draw(bench->renderer, bench->view_proj);
+    }
+
+    glFinish();
+}
+
+void bench_tilemap(bench_runner_t *runner)
+{
+    const uint32_t map_size = 4096;
+    const char *write_name = "tilemap/chunk_write_vertices";
+    const char *visible_name = "tilemap/visible_chunks/4096";
+    const char *static_name = "tilemap/draw/4096/static";
+    const char *edit_name = "tilemap/draw/4096/edit";
+
+    uint8_t wants_gl = runner->app && (bench_enabled(runner, static_name) || bench_enabled(runner, edit_name));
+    if (!bench_enabled(runner, write_name) && !bench_enabled(runner, visible_name) && !wants_gl)
+        return;
+
+    tilemap_t tilemap = tilemap_new(map_size, map_size, 32);
+    tilemap.origin[0] = tilemap.origin[1] = -(float)map_size * 32 / 2;
+    tilemap_generate(&tilemap, 1, 8);
+
+    tilemap_bench_t bench = {.tilemap = &tilemap, .rng = 1};
+    bench.vertices = malloc(TILEMAP_CHUNK_TILES * 4 * sizeof(compact_vertex_t));
+    // The default window's view of the middle of the map.
+    mat4x4_ortho(bench.view_proj, -640, 640, -360, 360, -1, 100);
+
+    // Per chunk.
+    bench_run(runner, write_name, bench_chunk_write_vertices, &bench, 1, 0);
+    bench_run(runner, visible_name, bench_visible_chunks, &bench, 1, 0);
+
+    if (wants_gl)
+    {
+        app_t *app = runner->app;
+        tilemap_renderer_t renderer = tilemap_renderer_new(app->sprite_batch->program, &tilemap, 8);
+        bench.renderer = &renderer;
+
+        render_target_bind(&app->render_target);
+
+        // Per frame, after the first draw has built what's in view.
+        tilemap_renderer_draw(&renderer, bench.view_proj);
+        printf("tilemap: %u draw calls, %u chunks built and %u quads for the first frame of a %ux%u map\n",
+               renderer.num_draw_calls, renderer.num_chunks_built, renderer.num_quads_drawn, map_size, map_size);
+
+        bench_run(runner, static_name, bench_draw_static, &bench, 1, 0);
+        bench_run(runner, edit_name, bench_draw_edit, &bench, 1, 0);
+
+        render_target_unbind(app->window_width, app->window_height);
+        tilemap_renderer_free(&renderer);
+    }
+
+    free(bench.vertices);
+    tilemap_free(&tilemap);
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/turn.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_PLAYERS 100
+#define BENCH_UNITS_PER_PLAYER 1000
+
+typedef struct turn_bench_t
+{
+    turn_state_t state;
+    job_system_t *jobs;
+} turn_bench_t;
+
+static void bench_queue_ai(void *user_data, uint64_t num_iterations)
+{
+    turn_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        turn_queue_ai_actions(&bench->state, bench->jobs);
+}
+
+static void bench_resolve(void *user_data, uint64_t num_iterations)
+{
+    turn_bench_t *bench = user_data;
+
+    // The AI's decisions are part of the turn, a player's client would have sent theirs.
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        turn_queue_ai_actions(&bench->state, bench->jobs);
+        turn_resolve(&bench->state, bench->jobs);
+    }
+}
+
+static void bench_hash(void *user_data, uint64_t num_iterations)
+{
+    turn_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        bench_do_not_optimise((void *)(uintptr_t)turn_state_hash(&bench->state));
+}
+
+void bench_turn(bench_runner_t *runner)
+{
+    const uint32_t map_size = 1024;
+    // Tile types from tilemap_generate, the last one is a wall like in the pathfinding benchmarks.
+    const uint8_t blocked_tiles[] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+    const char *queue_name = "turn/1024/queue_ai/100x1000_units";
+    const char *resolve_names[] = {"turn/1024/resolve/100x1000_units", "turn/1024/resolve/100x1000_units/1_thread"};
+    const char *hash_name = "turn/1024/hash/100x1000_units";
+
+    if (!bench_enabled(runner, queue_name) && !bench_enabled(runner, resolve_names[0]) && !bench_enabled(runner, resolve_names[1]) &&
+        !bench_enabled(runner, hash_name))
+        return;
+
+    tilemap_t tilemap = tilemap_new(map_size, map_size, 1);
+    tilemap_generate(&tilemap, 1, 8);
+
+    turn_bench_t bench = {0};
+    bench.state = turn_state_from_tilemap(&tilemap, blocked_tiles, sizeof(blocked_tiles), 1);
+    tilemap_free(&tilemap);
+
+    // Each player's army starts out together in its own corner of the map, the fighting happens where they meet.
+    uint64_t rng = 1;
+    uint32_t camps_x = 10, camp_size = map_size / camps_x;
+    for (uint32_t player = 0; player < BENCH_NUM_PLAYERS; player++)
+    {
+        uint32_t camp_x = (player % camps_x) * camp_size, camp_y = (player / camps_x) * camp_size;
+        for (uint32_t i = 0; i < BENCH_UNITS_PER_PLAYER;)
+        {
+            int32_t x = (int32_t)(camp_x + rng_next(&rng) % camp_size), y = (int32_t)(camp_y + rng_next(&rng) % camp_size);
+            if (!turn_is_open(&bench.state, x, y) || bench.state.occupancy[(size_t)y * bench.state.width + x] != TURN_NO_UNIT)
+                continue;
+
+            turn_add_unit(&bench.state, x, y, (uint16_t)player, 1);
+            i++;
+        }
+    }
+
+    job_system_t *job_systems[2] = {job_system_new(JOB_SYSTEM_AUTO_WORKERS), job_system_new(0)};
+    bench.jobs = job_systems[0];
+
+    bench_run(runner, queue_name, bench_queue_ai, &bench, 1, 0);
+    for (size_t i = 0; i < 2; i++)
+    {
+        bench.jobs = job_systems[i];
+        bench_run(runner, resolve_names[i], bench_resolve, &bench, 1, 0);
+    }
+
+    if (bench_enabled(runner, resolve_names[0]) || bench_enabled(runner, resolve_names[1]))
+    {
+        const turn_stats_t *stats = &bench.state.stats;
+        printf("turn %u: %u moves, %u blocked, %u attacks, %u deaths, %u items\n",
+               bench.state.turn_number,
+               stats->num_moves,
+               stats->num_blocked,
+               stats->num_attacks,
+               stats->num_deaths,
+               stats->num_items_used);
+    }
+
+    bench_run(runner, hash_name, bench_hash, &bench, 1, 0);
+
+    job_system_free(job_systems[0]);
+    job_system_free(job_systems[1]);
+    turn_state_free(&bench.state);
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/world_snapshot.h"
+#include "../src/asset_cache.h"
+#include "../src/engine/memory.h"
+#include "../src/util/rng.h"
+
+#define BENCH_NUM_ENTITIES 100000
+#define BENCH_NUM_TEXTURES 16
+#define BENCH_CHILDREN_PER_PARENT 10
+
+typedef struct world_snapshot_bench_t
+{
+    world_t *world;
+    // Loaded into and emptied again every iteration.
+    world_t *loaded;
+    uint8_t *arr_snapshot;
+} world_snapshot_bench_t;
+
+// Groups of sprites under a parent, like the stress scene, with a label here and there.
+static void bench_world_populate(world_t *world, uint64_t *rng)
+{
+    const char *labels[] = {"unit", "squad", "HP 10", "Hello, World!"};
+    asset_cache_t *cache = world->asset_cache;
+
+    entity_t *parent = world->root;
+    for (uint32_t i = 1; i < BENCH_NUM_ENTITIES; i++)
+    {
+        entity_t *entity = entity_new(world);
+        uint8_t is_parent = i % BENCH_CHILDREN_PER_PARENT == 1;
+        set_parent(entity, is_parent ? world->root : parent);
+        if (is_parent)
+            parent = entity;
+
+        float x = (float)(rng_next(rng) % 100000) / 100, y = (float)(rng_next(rng) % 100000) / 100;
+        set_pos(&entity->transform, (vec3){x, y, 1});
+        set_scale(&entity->transform, (vec2){32, 32});
+
+        if (rng_next(rng) % 10 == 0)
+        {
+            entity->render_type = RENDER_TYPE_TEXT;
+            entity->text = (text_t){.text = (char *)labels[rng_next(rng) % 4], .font = &cache->sh_fonts[0].value, .font_size = 16};
+        }
+        else
+        {
+            entity->render_type = RENDER_TYPE_SPRITE;
+            entity->sprite.texture = &cache->sh_textures[rng_next(rng) % BENCH_NUM_TEXTURES].value;
+            memcpy(entity->sprite.anchor, (vec2){0.5f, 0.5f}, sizeof(vec2));
+            memcpy(entity->sprite.color, (vec4){1, 1, 1, 1}, sizeof(vec4));
+        }
+    }
+
+    update_global_system(world);
+}
+
+static void bench_save(void *user_data, uint64_t num_iterations)
+{
+    world_snapshot_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        world_snapshot_save(bench->world, &bench->arr_snapshot);
+        bench_do_not_optimise(bench->arr_snapshot);
+    }
+}
+
+static void bench_load(void *user_data, uint64_t num_iterations)
+{
+    world_snapshot_bench_t *bench = user_data;
+
+    // Freeing the last load's entities is part of it, the same as loading over a world that's already there.
+    for (uint64_t i = 0; i < num_iterations; i++)
+    {
+        entity_free_all(bench->loaded);
+        uint8_t is_loaded = world_snapshot_load(bench->loaded, bench->arr_snapshot, arrlenu(bench->arr_snapshot));
+        bench_do_not_optimise((void *)(uintptr_t)is_loaded);
+    }
+}
+
+static void bench_hash(void *user_data, uint64_t num_iterations)
+{
+    world_snapshot_bench_t *bench = user_data;
+
+    for (uint64_t i = 0; i < num_iterations; i++)
+        bench_do_not_optimise((void *)(uintptr_t)world_snapshot_hash(bench->world));
+}
+
+void bench_world_snapshot(bench_runner_t *runner)
+{
+    const char *save_name = "world_snapshot/save/100k_entities";
+    const char *load_name = "world_snapshot/load/100k_entities";
+    const char *hash_name = "world_snapshot/hash/100k_entities";
+
+    if (!bench_enabled(runner, save_name) && !bench_enabled(runner, load_name) && !bench_enabled(runner, hash_name))
+        return;
+
+    // No asset_cache_new or asset_cache_free, nothing in it is a real GL object.
+    asset_cache_t cache = {0};
+    sh_new_strdup(cache.sh_textures);
+    sh_new_strdup(cache.sh_fonts);
+    for (uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++)
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "./images/bench_texture_%02u.png", i);
+        shput(cache.sh_textures, key, ((texture_t){0}));
+    }
+    shput(cache.sh_fonts, "./font/CONSTAN.TTF", ((font_t){0}));
+
+    uint64_t rng = 1;
+    world_snapshot_bench_t bench = {.world = world_new(&cache, 0, FRAME_ARENA_SIZE, 1), .loaded = world_new(&cache, 0, FRAME_ARENA_SIZE, 1)};
+    bench_world_populate(bench.world, &rng);
+    world_snapshot_save(bench.world, &bench.arr_snapshot);
+
+    bench_run(runner, save_name, bench_save, &bench, 1, 0);
+    bench_run(runner, load_name, bench_load, &bench, 1, 0);
+    bench_run(runner, hash_name, bench_hash, &bench, 1, 0);
+
+    // A load has to come out the same as what was saved.
+    entity_free_all(bench.loaded);
+    world_snapshot_load(bench.loaded, bench.arr_snapshot, arrlenu(bench.arr_snapshot));
+    update_global_system(bench.loaded);
+    uint8_t is_same = world_snapshot_hash(bench.loaded) == world_snapshot_hash(bench.world);
+    printf("world_snapshot: %u entities in %zu bytes, %.1f bytes each, %s after loading\n",
+           BENCH_NUM_ENTITIES,
+           arrlenu(bench.arr_snapshot),
+           (double)arrlenu(bench.arr_snapshot) / BENCH_NUM_ENTITIES,
+           is_same ? "same hash" : "DIFFERENT HASH");
+
+    arrfree(bench.arr_snapshot);
+    world_free(bench.world);
+    world_free(bench.loaded);
+    shfree(cache.sh_textures);
+    shfree(cache.sh_fonts);
+}
\ No newline at end of file
@@ -0,0 +1,387 @@
+// Dedicated server, runs matches without a window, GL or any assets. Only the simulation is linked, see the makefile's
+// server target.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "../src/world.h"
+#include "../src/world_scheduler.h"
+#include "../src/journal.h"
+#include "../src/engine/memory.h"
+#include "../src/engine/profiler.h"
+#include "../src/engine/job_system.h"
+
+typedef struct server_options_t
+{
+    uint32_t num_matches;
+    uint32_t num_players;
+    uint32_t map_size;
+    // Each match resolves a turn this often.
+    uint32_t turn_ms;
+    // Turns each match plays before the server stops.
+    uint32_t num_turns;
+    // CPU time a match's turn should take, any more and it waits for the matches within theirs.
+    float budget_ms;
+    // Threads besides the main one that run turns, JOB_SYSTEM_AUTO_WORKERS for one less than the number of cores.
+    uint32_t num_threads;
+    // Ignore the turn timers and resolve turns back to back, for measuring how many matches a core could run.
+    uint8_t is_fast;
+    uint64_t seed;
+    // Journal the first match's turns and write them here once it's done, null for no.
+    const char *record_path;
+    // Play a journal back instead of hosting anything, then seek back to seek_turn. UINT32_MAX seeks half way.
+    const char *replay_path;
+    uint32_t seek_turn;
+} server_options_t;
+
+static void server_usage(const char *program)
+{
+    printf("Usage: %s [--matches N] [--players N] [--map N] [--turn-ms MS] [--turns N] [--budget-ms MS]\n"
+           "    [--threads N] [--fast] [--seed N] [--record PATH]\n"
+           "   or: %s --replay PATH [--seek N] [--threads N]\n",
+           program,
+           program);
+    exit(1);
+}
+
+static server_options_t server_options_parse(int argc, char **argv)
+{
+    server_options_t result = {
+        .num_matches = 64,
+        .num_players = 4,
+        .map_size = 128,
+        .turn_ms = 1000,
+        .num_turns = 30,
+        .budget_ms = 1,
+        .num_threads = JOB_SYSTEM_AUTO_WORKERS,
+        .seed = 1,
+        .seek_turn = UINT32_MAX,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+
+        if (strcmp(arg, "--matches") == 0 && value)
+        {
+            result.num_matches = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--players") == 0 && value)
+        {
+            result.num_players = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--map") == 0 && value)
+        {
+            result.map_size = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--turn-ms") == 0 && value)
+        {
+            result.turn_ms = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--turns") == 0 && value)
+        {
+            result.num_turns = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--budget-ms") == 0 && value)
+        {
+            result.budget_ms = strtof(value, 0);
+            i++;
+        }
+        else if (strcmp(arg, "--threads") == 0 && value)
+        {
+            result.num_threads = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--fast") == 0)
+        {
+            result.is_fast = 1;
+        }
+        else if (strcmp(arg, "--seed") == 0 && value)
+        {
+            result.seed = strtoull(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--record") == 0 && value)
+        {
+            result.record_path = value;
+            i++;
+        }
+        else if (strcmp(arg, "--replay") == 0 && value)
+        {
+            result.replay_path = value;
+            i++;
+        }
+        else if (strcmp(arg, "--seek") == 0 && value)
+        {
+            result.seek_turn = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else
+        {
+            server_usage(argv[0]);
+        }
+    }
+
+    if (!result.num_matches || !result.num_players || !result.map_size || !result.turn_ms || !result.num_turns)
+        server_usage(argv[0]);
+
+    return result;
+}
+
+static size_t server_live_bytes(void)
+{
+    size_t result = 0;
+    for (uint32_t tag = 0; tag < MEMORY_TAG_COUNT; tag++)
+        result += memory_get_stats((memory_tag_e)tag).live_bytes;
+    return result;
+}
+
+static int server_compare_floats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static float counter_to_ms(uint64_t counter)
+{
+    return (float)((double)counter * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+static void server_print_percentiles(const char *name, float *samples, size_t num_samples)
+{
+    double total = 0;
+    for (size_t i = 0; i < num_samples; i++)
+        total += samples[i];
+    qsort(samples, num_samples, sizeof(float), server_compare_floats);
+
+    printf("%s: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+           name,
+           total / num_samples,
+           samples[num_samples / 2],
+           samples[num_samples * 99 / 100],
+           samples[num_samples * 999 / 1000],
+           samples[num_samples - 1]);
+}
+
+// Plays a recorded match back as fast as it goes, checking every turn against the recording, then seeks back into it.
+static void server_replay(const server_options_t *options)
+{
+    journal_t journal = {0};
+    if (!journal_load_file(&journal, options->replay_path))
+    {
+        printf("Couldn't load a journal of this version from %s\n", options->replay_path);
+        return;
+    }
+
+    size_t keyframe_bytes = 0;
+    for (size_t i = 0; i < arrlenu(journal.arr_keyframes); i++)
+        keyframe_bytes += arrlenu(journal.arr_keyframes[i].arr_data);
+
+    printf("Replaying %u turns of a %ux%u match with %u players, seed %llu, a keyframe every %u turns (%.1f KB of them)\n",
+           journal.num_turns,
+           journal.map_size,
+           journal.map_size,
+           journal.num_players,
+           (unsigned long long)journal.seed,
+           journal.keyframe_turns,
+           (double)keyframe_bytes / 1024);
+
+    // Only the one match, its own systems can have the threads.
+    job_system_t *jobs = job_system_new(options->num_threads);
+    uint64_t start = SDL_GetPerformanceCounter();
+    world_t *world = journal_world_new(&journal, jobs, SERVER_ARENA_SIZE);
+    uint64_t spawned = SDL_GetPerformanceCounter();
+
+    uint8_t has_diverged = 0;
+    while (world->turns->turn_number < journal.num_turns && !has_diverged)
+        has_diverged = !journal_play_turn(&journal, world);
+
+    uint32_t num_played = world->turns->turn_number;
+    float play_ms = counter_to_ms(SDL_GetPerformanceCounter() - spawned);
+    printf("Map and spawns in %.2f ms, then %u turns in %.2f ms, %.0f turns/s\n",
+           counter_to_ms(spawned - start),
+           num_played,
+           play_ms,
+           num_played / (play_ms / 1000));
+
+    if (has_diverged)
+    {
+        printf("Diverged on turn %u, it doesn't hash the same as the recording\n", num_played - 1);
+    }
+    else if (journal.num_turns)
+    {
+        printf("Every turn hashed the same as the recording\n");
+
+        // From the end, so it has to go back through a keyframe rather than play on.
+        uint32_t turn = options->seek_turn < journal.num_turns ? options->seek_turn : journal.num_turns / 2;
+        uint32_t keyframe = turn / journal.keyframe_turns;
+        if (keyframe >= arrlenu(journal.arr_keyframes))
+            keyframe = (uint32_t)arrlenu(journal.arr_keyframes) - 1;
+
+        uint64_t seek_start = SDL_GetPerformanceCounter();
+        uint8_t is_found = journal_seek(&journal, world, turn);
+        float seek_ms = counter_to_ms(SDL_GetPerformanceCounter() - seek_start);
+        printf("Seek back to turn %u%s: %.3f ms from the keyframe at turn %u, playing it from the start takes %.3f ms\n",
+               turn,
+               is_found ? "" : " failed",
+               seek_ms,
+               journal.arr_keyframes[keyframe].turn,
+               play_ms * turn / num_played);
+    }
+
+    world_free(world);
+    job_system_free(jobs);
+    journal_free(&journal);
+}
+
+int main(int argc, char **argv)
+{
+    server_options_t options = server_options_parse(argc, argv);
+
+    // Timers, threads and atomics only, SDL_Init isn't needed for any of them and video never is.
+    profiler_init();
+    profiler_set_thread_name("main");
+
+    if (options.replay_path)
+    {
+        server_replay(&options);
+        profiler_shutdown();
+        memory_report_leaks();
+        return 0;
+    }
+
+    // Matches take turns on the pool's threads, each turn runs start to finish on one of them. Inside a turn the
+    // systems' own parallel_fors run inline.
+    job_system_t *pool = job_system_new(options.num_threads);
+    job_system_t *inline_jobs = job_system_new(0);
+    uint32_t num_threads = job_system_num_threads(pool);
+    world_scheduler_t scheduler = world_scheduler_new(pool);
+
+    size_t live_bytes_before = server_live_bytes();
+    world_t **matches = mem_alloc(MEMORY_TAG_GENERAL, options.num_matches * sizeof(world_t *));
+    uint64_t turn_period = (uint64_t)options.turn_ms * SDL_GetPerformanceFrequency() / 1000;
+    for (uint32_t i = 0; i < options.num_matches; i++)
+    {
+        // No asset cache, nothing in a match draws.
+        world_t *world = world_new(0, inline_jobs, SERVER_ARENA_SIZE, options.seed + i);
+        // Every step is a turn, the timer decides when the step happens.
+        world->turn_steps = 1;
+        world_spawn_tilemap(world, options.map_size);
+        world_spawn_players(world, options.num_players);
+        matches[i] = world;
+    }
+    size_t live_bytes_started = server_live_bytes();
+
+    // The first match's turns, freed before the memory is counted again since it isn't part of the match.
+    journal_t journal = {0};
+    if (options.record_path)
+    {
+        journal = journal_new(matches[0]->seed, options.map_size, options.num_players, JOURNAL_KEYFRAME_TURNS);
+        matches[0]->journal = &journal;
+    }
+
+    // Spread over the first turn, so the matches' turns don't all land at once.
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t i = 0; i < options.num_matches; i++)
+        world_scheduler_add(&scheduler, matches[i], start + turn_period * i / options.num_matches, turn_period, options.budget_ms);
+
+    printf("Running %u matches of %u players on %ux%u maps on %u threads, a turn every %u ms%s\n",
+           options.num_matches,
+           options.num_players,
+           options.map_size,
+           options.map_size,
+           num_threads,
+           options.turn_ms,
+           options.is_fast ? ", back to back with --fast" : "");
+
+    // Untracked, so they don't count towards the matches' memory.
+    size_t max_samples = (size_t)options.num_matches * options.num_turns;
+    float *turn_times_ms = malloc(max_samples * sizeof(float));
+    float *latencies_ms = malloc(max_samples * sizeof(float));
+    float *match_latencies_ms = malloc(options.num_matches * sizeof(float));
+    size_t num_samples = 0;
+    uint32_t num_finished = 0, num_over_budget = 0, num_in_debt = 0;
+
+    while (arrlenu(scheduler.arr_worlds))
+    {
+        uint32_t num_run = world_scheduler_run_due(&scheduler, options.is_fast ? UINT64_MAX : SDL_GetPerformanceCounter());
+        for (uint32_t i = 0; i < num_run; i++)
+        {
+            scheduled_world_t *scheduled = &scheduler.arr_worlds[scheduler.arr_due[i].index];
+            turn_times_ms[num_samples] = scheduled->last_turn_ms;
+            latencies_ms[num_samples++] = scheduled->last_latency_ms;
+        }
+
+        // Backwards, so removing one doesn't move any that are still to be looked at.
+        for (uint32_t i = (uint32_t)arrlenu(scheduler.arr_worlds); i-- > 0;)
+        {
+            scheduled_world_t *scheduled = &scheduler.arr_worlds[i];
+            if (scheduled->num_turns < options.num_turns)
+                continue;
+
+            match_latencies_ms[num_finished++] = (float)(scheduled->total_latency_ms / scheduled->num_turns);
+            num_over_budget += scheduled->num_over_budget;
+            num_in_debt += scheduled->debt_ms > 0;
+            world_scheduler_remove(&scheduler, i);
+        }
+
+        uint64_t next_turn = world_scheduler_next_due(&scheduler), now = SDL_GetPerformanceCounter();
+        if (!options.is_fast && next_turn != UINT64_MAX && next_turn > now)
+            SDL_Delay((uint32_t)counter_to_ms(next_turn - now));
+    }
+
+    float seconds = counter_to_ms(SDL_GetPerformanceCounter() - start) / 1000;
+
+    if (options.record_path)
+    {
+        if (journal_save_file(&journal, options.record_path))
+            printf("Recorded the first match's %u turns to %s\n", journal.num_turns, options.record_path);
+        else
+            printf("Couldn't write the journal to %s\n", options.record_path);
+        matches[0]->journal = 0;
+        journal_free(&journal);
+    }
+    size_t live_bytes_finished = server_live_bytes();
+
+    double total_turn_ms = 0;
+    for (size_t i = 0; i < num_samples; i++)
+        total_turn_ms += turn_times_ms[i];
+    double mean_turn_ms = total_turn_ms / num_samples;
+
+    printf("%zu turns in %.2f s, %.0f turns/s\n", num_samples, seconds, num_samples / seconds);
+    server_print_percentiles("Turn CPU time", turn_times_ms, num_samples);
+    server_print_percentiles("Turn latency, due to done", latencies_ms, num_samples);
+    qsort(match_latencies_ms, num_finished, sizeof(float), server_compare_floats);
+    printf("Mean latency per match: best %.3f ms, worst %.3f ms\n", match_latencies_ms[0], match_latencies_ms[num_finished - 1]);
+    printf("Budget: %u of %zu turns over %.2f ms, %u matches finished in debt\n", num_over_budget, num_samples, options.budget_ms, num_in_debt);
+    printf("Memory per match: %.1f KB to start, %.1f KB after %u turns\n",
+           (double)(live_bytes_started - live_bytes_before) / options.num_matches / 1024,
+           (double)(live_bytes_finished - live_bytes_before) / options.num_matches / 1024,
+           options.num_turns);
+    // One core spends mean_turn_ms of every turn_ms on each match, however they're interleaved.
+    printf("Matches per core with a %u ms turn timer: %.0f, hosting %.1f per thread\n",
+           options.turn_ms,
+           options.turn_ms / mean_turn_ms,
+           (double)options.num_matches / num_threads);
+
+    free(turn_times_ms);
+    free(latencies_ms);
+    free(match_latencies_ms);
+    world_scheduler_free(&scheduler);
+    for (uint32_t i = 0; i < options.num_matches; i++)
+        world_free(matches[i]);
+    mem_free(matches);
+    job_system_free(inline_jobs);
+    job_system_free(pool);
+
+    profiler_shutdown();
+    memory_report_leaks();
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "app.h"
+#include <stdlib.h>
+#include <string.h>
+#include "engine/memory.h"
+#include <assert.h>
+#include "engine/engine.h"
+#include "engine/profiler.h"
+#include <stdio.h>
+
+app_t *app_new(const app_options_t *options)
+{
+    profiler_init();
+    profiler_set_thread_name("main");
+
+    app_t *app = mem_calloc(MEMORY_TAG_GENERAL, 1, sizeof(app_t));
+    app->options = *options;
+
+    app->frame_arena = frame_arena_new(FRAME_ARENA_SIZE, MEMORY_TAG_ARENAS);
+    // Rebound by the simulation thread to its own, if there is one.
+    frame_arena_bind(&app->frame_arena);
+
+    app->jobs = job_system_new(JOB_WORKER_THREADS < 0 ? JOB_SYSTEM_AUTO_WORKERS : (uint32_t)JOB_WORKER_THREADS);
+
+    app->is_headless = options->headless;
+
+    if (app->is_headless)
+    {
+        // EGL pbuffer context without a display server, works with Mesa's llvmpipe.
+        // Still overridable through the SDL_VIDEODRIVER environment variable, eg. x11 for a hidden window.
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "offscreen");
+    }
+
+    // Must be set before the window is created, EGL backed drivers pick their config with the window.
+    // 4.5 is all the renderer needs (DSA) and is as high as llvmpipe goes.
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+
+    app->window_width = options->window_width;
+    app->window_height = options->window_height;
+    snprintf(app->window_title, sizeof(app->window_title), "Hello, SDL2!");
+    {
+        SDL_Window *window = SDL_CreateWindow(
+            app->window_title,
+            SDL_WINDOWPOS_CENTERED,
+            SDL_WINDOWPOS_CENTERED,
+            app->window_width,
+            app->window_height,
+            SDL_WINDOW_OPENGL | (app->is_headless ? SDL_WINDOW_HIDDEN : 0));
+
+        if (!window)
+            printf("Failed to create window: %s\n", SDL_GetError());
+
+        assert(window);
+        app->window = window;
+    }
+
+    if (!app->is_headless)
+        SDL_ShowWindow(app->window);
+
+    app->keyboard_state = SDL_GetKeyboardState(&app->keyboard_state_length);
+    app->last_keyboard_state = mem_calloc(MEMORY_TAG_GENERAL, app->keyboard_state_length, sizeof(uint8_t));
+    assert(app->keyboard_state && app->last_keyboard_state);
+
+    app->context = SDL_GL_CreateContext(app->window);
+    if (!app->context)
+        printf("Failed to create GL context: %s\n", SDL_GetError());
+    assert(app->context);
+
+    if (!gladLoadGLLoader(&SDL_GL_GetProcAddress))
+    {
+        return 0;
+    }
+
+    // Swap interval only sticks once there's a context.
+    // Headless runs are benchmarks, they go as fast as they can.
+    if (app->is_headless)
+        app->frame_pacer = frame_pacer_new(0, 0, VSYNC_MODE_OFF);
+    else
+        app->frame_pacer = frame_pacer_new(TARGET_FPS, BACKGROUND_FPS, VSYNC_MODE);
+
+    if (app->is_headless)
+        app->render_target = render_target_new(app->window_width, app->window_height);
+
+    if (options->dump_dir)
+    {
+        app->frame_capture = frame_capture_new(app->window_width, app->window_height, options->dump_dir);
+        app->has_frame_capture = 1;
+    }
+
+    app->asset_cache = asset_cache_new();
+    app->world = world_new(app->asset_cache, app->jobs, FRAME_ARENA_SIZE, options->world_seed);
+
+    // Malloc instead of calloc as we're going to memcpy to this address
+    app->sprite_batch = mem_alloc(MEMORY_TAG_BATCHER, sizeof(sprite_batch_t));
+    assert(app->asset_cache && app->sprite_batch);
+    {
+        GLenum shader_types[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+        const char *batched_sprite_shader_src_path = "./shader/shader.glsl";
+        MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+        shput(app->asset_cache->sh_programs, batched_sprite_shader_src_path, create_program(batched_sprite_shader_src_path, shader_types, 2));
+        GLuint program = shget(app->asset_cache->sh_programs, batched_sprite_shader_src_path);
+
+        sprite_batch_options_t batch_options = {
+            .max_batch_size = 1000,
+            .vertex_format = options->compact_vertices ? SPRITE_VERTEX_FORMAT_COMPACT : SPRITE_VERTEX_FORMAT_FLOAT,
+            .indexed = options->indexed_quads,
+        };
+        sprite_batch_t temp_sprite_batch = sprite_batch_new(program, &batch_options);
+        memcpy(app->sprite_batch, &temp_sprite_batch, sizeof(sprite_batch_t));
+    }
+
+    app->render_snapshots = render_snapshots_new();
+
+    app->gpu_timer = gpu_timer_new();
+    app->sprite_batch->gpu_timer = &app->gpu_timer;
+
+    {
+        const char *overlay_font_path = "./font/CONSTAN.TTF";
+        MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+        if (shgeti(app->asset_cache->sh_fonts, overlay_font_path) == -1)
+            shput(app->asset_cache->sh_fonts, overlay_font_path, font_load(overlay_font_path));
+
+        app->stats_overlay = stats_overlay_new(overlay_font_path, 16);
+    }
+
+    app->is_running = 1;
+
+    return app;
+}
+
+void app_free(app_t *app)
+{
+    if (app->has_frame_capture)
+        frame_capture_free(&app->frame_capture);
+
+    if (app->is_headless)
+        render_target_free(&app->render_target);
+
+    if (app->tilemap_renderer)
+    {
+        tilemap_renderer_free(app->tilemap_renderer);
+        mem_free(app->tilemap_renderer);
+    }
+
+    if (app->fog_renderer)
+    {
+        fog_renderer_free(app->fog_renderer);
+        mem_free(app->fog_renderer);
+    }
+
+    world_free(app->world);
+
+    gpu_timer_free(&app->gpu_timer);
+    render_snapshots_free(&app->render_snapshots);
+    sprite_batch_free(app->sprite_batch);
+    mem_free(app->sprite_batch);
+    asset_cache_free(app->asset_cache);
+
+    frame_arena_free(&app->frame_arena);
+
+    job_system_free(app->jobs);
+
+    mem_free(app->last_keyboard_state);
+
+    SDL_GL_DeleteContext(app->context);
+    SDL_DestroyWindow(app->window);
+    SDL_Quit();
+
+    profiler_shutdown();
+
+    mem_free(app);
+
+    // Everything the engine allocated should be gone by now.
+    memory_report_leaks();
+}
\ No newline at end of file
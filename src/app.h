@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+#include <glad/glad.h>
+
+#include "entities.h"
+#include "world.h"
+#include "asset_cache.h"
+#include "sprite_batch.h"
+#include "stats_overlay.h"
+#include "render_snapshot.h"
+#include "tilemap_renderer.h"
+#include "fog_renderer.h"
+#include "engine/fixed_step.h"
+#include "engine/frame_pacer.h"
+#include "engine/render_target.h"
+#include "options.h"
+#include "engine/gpu_timer.h"
+#include "engine/frame_stats.h"
+#include "engine/arena.h"
+#include "engine/job_system.h"
+
+typedef struct stress_scene_t stress_scene_t;
+typedef struct replication_server_t replication_server_t;
+typedef struct replication_client_t replication_client_t;
+typedef struct app_t
+{
+    app_options_t options;
+
+    SDL_Window *window;
+    int window_width, window_height;
+    char window_title[256];
+
+    SDL_GLContext context;
+
+    // Headless apps draw into render_target instead of the window.
+    uint8_t is_headless;
+    render_target_t render_target;
+    uint8_t has_frame_capture;
+    frame_capture_t frame_capture;
+
+    int32_t keyboard_state_length;
+    const uint8_t *keyboard_state;
+    uint8_t *last_keyboard_state;
+
+    // What's simulated, everything else here is for showing it.
+    world_t *world;
+    asset_cache_t *asset_cache;
+    sprite_batch_t *sprite_batch;
+
+    // Null without a map, the renderer draws its own copy of the world's. The fog shows what the first player sees.
+    tilemap_renderer_t *tilemap_renderer;
+    fog_renderer_t *fog_renderer;
+
+    gpu_timer_t gpu_timer;
+    frame_stats_t frame_stats;
+    stats_overlay_t stats_overlay;
+
+    frame_pacer_t frame_pacer;
+    uint64_t last_title_update;
+    uint64_t num_frames_since_title_update;
+
+    fixed_step_t fixed_step;
+    render_snapshots_t render_snapshots;
+    // Time the renderer interpolates the latest snapshot to, normally now.
+    uint64_t render_time;
+    // Only set with THREADED_SIMULATION, the simulation then owns the world until it's joined.
+    SDL_Thread *sim_thread;
+    SDL_atomic_t is_sim_running;
+
+    // Transient memory, reset at the top of every frame. The world's step arena is separate, the simulation can run on
+    // its own thread. Double buffered, last frame's allocations last one more before they're reused.
+    frame_arena_t frame_arena;
+
+    // Shared by every system that splits its work across cores, see JOB_WORKER_THREADS.
+    job_system_t *jobs;
+
+    // Set instead of the normal scene with --stress, owned by lib_start.
+    stress_scene_t *stress_scene;
+    // Set with --serve and --spectate, both owned by lib_start. A spectator's entities are whatever the server last
+    // sent, it doesn't simulate anything itself.
+    replication_server_t *replication_server;
+    replication_client_t *replication_client;
+
+    uint8_t is_running;
+} app_t;
+
+/// @brief The window, GL context and renderer, and an empty world for them to show.
+app_t *app_new(const app_options_t *options);
+void app_free(app_t *app);
\ No newline at end of file
@@ -1,6 +1,19 @@
 #include "asset_cache.h"
 #include <stdlib.h>
-#include "vendor/stb_ds.h"
+#include "engine/memory.h"
+
+asset_cache_t *asset_cache_new(void)
+{
+    MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+
+    asset_cache_t *result = mem_calloc(MEMORY_TAG_ASSET_CACHE, 1, sizeof(asset_cache_t));
+
+#define X(kv_struct, type, var, ...) sh_new_strdup(result->var);
+    FOR_EACH_CACHE_TYPE
+#undef X
+
+    return result;
+}
 
 void asset_cache_delete_program(GLuint *program)
 {
@@ -20,5 +33,5 @@ void asset_cache_free(asset_cache_t *p_cache)
 
 #undef X
 
-    free(p_cache);
+    mem_free(p_cache);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <glad/glad.h>
 #include "texture.h"
+#include "font.h"
 #include "text.h"
 
 // (key/value struct name, type of value, variable name, function to cleanup ref to entry);
@@ -25,6 +26,9 @@ typedef struct asset_cache_t
 #undef X
 } asset_cache_t;
 
+/// @brief Empty cache, the tables copy their keys so paths don't have to outlive it.
+asset_cache_t *asset_cache_new(void);
+
 void asset_cache_free(asset_cache_t *p_cache);
 
 /// @brief Delete the opengl program stored at this pointer, only for use with asset_cache_t.
@@ -0,0 +1,128 @@
+#include "arena.h"
+#include <string.h>
+#include <assert.h>
+
+static _Thread_local frame_arena_t *tls_frame_arena;
+
+arena_t arena_new(size_t capacity, memory_tag_e tag)
+{
+    arena_t result = {0};
+    result.tag = tag;
+    result.capacity = capacity;
+    result.base = capacity ? mem_alloc(tag, capacity) : 0;
+    assert(!capacity || result.base);
+
+    return result;
+}
+
+void arena_free(arena_t *self)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_overflow); i++)
+        mem_free(self->arr_overflow[i]);
+
+    arrfree(self->arr_overflow);
+    mem_free(self->base);
+
+    *self = (arena_t){0};
+}
+
+void *arena_alloc(arena_t *self, size_t size, size_t alignment)
+{
+    assert(alignment && (alignment & (alignment - 1)) == 0);
+
+    size_t start = (self->offset + alignment - 1) & ~(alignment - 1);
+    if (start + size <= self->capacity)
+    {
+        self->offset = start + size;
+        if (self->offset + self->overflow_bytes > self->high_water)
+            self->high_water = self->offset + self->overflow_bytes;
+
+        return self->base + start;
+    }
+
+    // Heap blocks are aligned for anything the engine stores.
+    assert(alignment <= 16);
+
+    void *block = mem_alloc(self->tag, size);
+    assert(block);
+
+    MEMORY_SCOPE(self->tag);
+    arrput(self->arr_overflow, block);
+    self->overflow_bytes += size;
+    self->num_overflows++;
+    if (self->offset + self->overflow_bytes > self->high_water)
+        self->high_water = self->offset + self->overflow_bytes;
+
+    return block;
+}
+
+void *arena_calloc(arena_t *self, size_t count, size_t size, size_t alignment)
+{
+    if (size && count > SIZE_MAX / size)
+        return 0;
+
+    void *result = arena_alloc(self, count * size, alignment);
+    memset(result, 0, count * size);
+
+    return result;
+}
+
+void arena_reset(arena_t *self)
+{
+    if (self->overflow_bytes)
+    {
+        for (size_t i = 0; i < arrlenu(self->arr_overflow); i++)
+            mem_free(self->arr_overflow[i]);
+
+        // Keeps its capacity, the next overflow shouldn't have to allocate the list too.
+        arrsetlen(self->arr_overflow, 0);
+
+        // Room for the worst reset seen plus half again for alignment padding and growth.
+        size_t capacity = self->high_water + self->high_water / 2;
+        mem_free(self->base);
+        self->base = mem_alloc(self->tag, capacity);
+        assert(self->base);
+        self->capacity = capacity;
+        self->overflow_bytes = 0;
+    }
+
+    self->offset = 0;
+    self->high_water = 0;
+}
+
+frame_arena_t frame_arena_new(size_t capacity, memory_tag_e tag)
+{
+    frame_arena_t result = {0};
+    for (size_t i = 0; i < 2; i++)
+        result.arenas[i] = arena_new(capacity, tag);
+
+    return result;
+}
+
+void frame_arena_free(frame_arena_t *self)
+{
+    if (tls_frame_arena == self)
+        tls_frame_arena = 0;
+
+    for (size_t i = 0; i < 2; i++)
+        arena_free(&self->arenas[i]);
+
+    *self = (frame_arena_t){0};
+}
+
+void frame_arena_begin(frame_arena_t *self)
+{
+    self->frame_number++;
+    arena_reset(frame_arena_current(self));
+}
+
+void frame_arena_bind(frame_arena_t *self)
+{
+    tls_frame_arena = self;
+}
+
+arena_t *frame_arena_get(void)
+{
+    assert(tls_frame_arena);
+    return frame_arena_current(tls_frame_arena);
+}
\ No newline at end of file
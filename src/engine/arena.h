@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "memory.h"
+
+// Linear bump allocator for memory that only has to live until the next reset, allocating is an add and freeing is
+// resetting the whole thing. Running out never fails, the extra comes from the heap and the next reset grows the
+// arena to fit it, so after the first few frames it's sized to the worst frame seen and stops touching the heap.
+typedef struct arena_t
+{
+    uint8_t *base;
+    size_t capacity;
+    size_t offset;
+    memory_tag_e tag;
+
+    // Most bytes in use at once since the last reset, including anything that overflowed.
+    size_t high_water;
+    // Heap blocks for allocations that didn't fit, freed on reset.
+    void **arr_overflow;
+    size_t overflow_bytes;
+    uint64_t num_overflows;
+} arena_t;
+
+arena_t arena_new(size_t capacity, memory_tag_e tag);
+void arena_free(arena_t *self);
+
+/// @brief Uninitialised memory valid until the next reset, alignment must be a power of two.
+void *arena_alloc(arena_t *self, size_t size, size_t alignment);
+void *arena_calloc(arena_t *self, size_t count, size_t size, size_t alignment);
+
+#define ARENA_ALLOC_ARRAY(arena, type, count) ((type *)arena_alloc((arena), sizeof(type) * (count), _Alignof(type)))
+
+/// @brief Free everything at once, grows the arena first if anything overflowed since the last reset.
+void arena_reset(arena_t *self);
+
+/// @brief Scratch use inside a function, everything allocated after the mark is given back by arena_rewind.
+static inline size_t arena_mark(const arena_t *self)
+{
+    return self->offset;
+}
+
+static inline void arena_rewind(arena_t *self, size_t mark)
+{
+    // Overflow blocks stay until the reset, they're what sizes the arena.
+    self->offset = mark;
+}
+
+// Two arenas that swap every frame, so something allocated one frame is still valid through the next. Allocate from
+// current, read last frame's data out of previous.
+typedef struct frame_arena_t
+{
+    arena_t arenas[2];
+    uint64_t frame_number;
+} frame_arena_t;
+
+frame_arena_t frame_arena_new(size_t capacity, memory_tag_e tag);
+void frame_arena_free(frame_arena_t *self);
+
+/// @brief Swap and reset the new current arena, call at the top of every frame before anything allocates.
+void frame_arena_begin(frame_arena_t *self);
+
+static inline arena_t *frame_arena_current(frame_arena_t *self)
+{
+    return &self->arenas[self->frame_number & 1];
+}
+
+static inline arena_t *frame_arena_previous(frame_arena_t *self)
+{
+    return &self->arenas[(self->frame_number + 1) & 1];
+}
+
+/// @brief Make self the calling thread's frame arena, for code with no app to hand, eg. font baking.
+void frame_arena_bind(frame_arena_t *self);
+
+/// @brief The current arena of the calling thread's bound frame arena, asserts one is bound.
+arena_t *frame_arena_get(void);
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "engine.h"
+#include "profiler.h"
+#include "memory.h"
 #include "../util/fs.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -56,22 +58,24 @@ GLuint createAndCompileShader(const char *path, GLenum type)
     {
         GLsizei logLength;
         glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-        char *log = calloc(logLength, sizeof(char));
+        char *log = mem_calloc(MEMORY_TAG_GENERAL, logLength, sizeof(char));
         glGetShaderInfoLog(shader, logLength, 0, log);
         printf("Failed to compile shader\n\tFile:\t%s\n\tError:\t%s\n", path, log);
         assert(0);
     }
 
-    free((void *)source);
+    mem_free((void *)source);
 
     return shader;
 }
 
 GLuint create_program(const char *path, GLenum *p_shader_types, size_t num_shader_types)
 {
+    PROFILE_FUNCTION();
+
     GLuint program = GL_CALL(glCreateProgram());
 
-    GLuint *shaders = (GLuint *)alloca(num_shader_types * sizeof(GLenum));
+    GLuint shaders[num_shader_types];
 
     char *source = readFileToString(path);
     for (size_t shader_index = 0; shader_index < num_shader_types; shader_index++)
@@ -100,7 +104,7 @@ GLuint create_program(const char *path, GLenum *p_shader_types, size_t num_shade
 
         GLuint shader = GL_CALL(glCreateShader(type));
         shaders[shader_index] = shader;
-        const char *sources[3] = {"#version 460\n", preamble, source};
+        const char *sources[3] = {"#version 450\n", preamble, source};
         GL_CALL(glShaderSource(shader, 3, sources, 0));
         GL_CALL(glCompileShader(shader));
 
@@ -110,7 +114,7 @@ GLuint create_program(const char *path, GLenum *p_shader_types, size_t num_shade
         {
             GLsizei logLength;
             glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
-            char *log = calloc(logLength, sizeof(char));
+            char *log = mem_calloc(MEMORY_TAG_GENERAL, logLength, sizeof(char));
             glGetShaderInfoLog(shader, logLength, 0, log);
             printf("Failed to compile shader\n\tFile:\t%s\n\tError:\t%s\n", path, log);
             assert(0);
@@ -127,6 +131,6 @@ GLuint create_program(const char *path, GLenum *p_shader_types, size_t num_shade
         GL_CALL(glDeleteShader(shaders[i]));
     }
 
-    free((void *)source);
+    mem_free((void *)source);
     return program;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <glad/glad.h>
 
 #define GL_CALL(x) \
@@ -0,0 +1,49 @@
+#include "fixed_step.h"
+#include <assert.h>
+#include <SDL2/SDL.h>
+
+fixed_step_t fixed_step_new(uint32_t tick_rate, uint32_t max_catchup_steps, uint64_t now)
+{
+    assert(tick_rate > 0 && max_catchup_steps > 0);
+
+    fixed_step_t result = {0};
+    result.step_counter = SDL_GetPerformanceFrequency() / tick_rate;
+    result.step_seconds = 1.0f / (float)tick_rate;
+    result.sim_time = now;
+    result.max_catchup_steps = max_catchup_steps;
+
+    return result;
+}
+
+uint32_t fixed_step_update(fixed_step_t *self, uint64_t now)
+{
+    if (now <= self->sim_time)
+        return 0;
+
+    uint64_t num_steps = (now - self->sim_time) / self->step_counter;
+
+    if (num_steps > self->max_catchup_steps)
+    {
+        uint64_t num_dropped = num_steps - self->max_catchup_steps;
+        self->sim_time += num_dropped * self->step_counter;
+        self->num_dropped_steps += num_dropped;
+        num_steps = self->max_catchup_steps;
+    }
+
+    return (uint32_t)num_steps;
+}
+
+void fixed_step_end_step(fixed_step_t *self)
+{
+    self->sim_time += self->step_counter;
+    self->num_steps++;
+}
+
+float fixed_step_alpha(uint64_t sim_time, uint64_t step_counter, uint64_t now)
+{
+    if (now <= sim_time || step_counter == 0)
+        return 0.0f;
+
+    float alpha = (float)((double)(now - sim_time) / (double)step_counter);
+    return alpha > 1.0f ? 1.0f : alpha;
+}
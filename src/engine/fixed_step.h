@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// Fixed timestep clock, all times are SDL_GetPerformanceCounter values.
+// The simulation owns sim_time and steps it forward in fixed increments until it has caught up with real time.
+typedef struct fixed_step_t
+{
+    uint64_t step_counter;
+    float step_seconds;
+
+    // Time the simulation has reached, always a whole number of steps after the start.
+    uint64_t sim_time;
+    uint64_t num_steps;
+
+    // More steps than this in one update and the clock gives up on the backlog, the simulation slows down rather
+    // than spiralling when a step costs more than real time.
+    uint32_t max_catchup_steps;
+    uint64_t num_dropped_steps;
+} fixed_step_t;
+
+fixed_step_t fixed_step_new(uint32_t tick_rate, uint32_t max_catchup_steps, uint64_t now);
+
+/// @brief Number of steps to run to catch up with now, capped at max_catchup_steps.
+uint32_t fixed_step_update(fixed_step_t *self, uint64_t now);
+
+/// @brief Advance sim_time by one step, call after each step returned by fixed_step_update has been simulated.
+void fixed_step_end_step(fixed_step_t *self);
+
+/// @brief How far now is into the step after sim_time, 0 - 1, used to interpolate between the last two states.
+float fixed_step_alpha(uint64_t sim_time, uint64_t step_counter, uint64_t now);
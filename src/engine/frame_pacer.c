@@ -0,0 +1,131 @@
+#include "frame_pacer.h"
+#include <math.h>
+#include <stdio.h>
+#include "profiler.h"
+
+frame_pacer_t frame_pacer_new(uint32_t target_fps, uint32_t background_fps, vsync_mode_e vsync_mode)
+{
+    frame_pacer_t result = {0};
+
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    result.target_frame_counter = target_fps ? frequency / target_fps : 0;
+    result.background_frame_counter = background_fps ? frequency / background_fps : result.target_frame_counter;
+
+    // Assume a typical 1ms timer until there are real measurements.
+    result.sleep_overshoot_mean = (double)frequency / 1000.0;
+
+    result.vsync_mode = vsync_mode;
+    if (SDL_GL_SetSwapInterval(vsync_mode) != 0)
+    {
+        if (vsync_mode == VSYNC_MODE_ADAPTIVE && SDL_GL_SetSwapInterval(VSYNC_MODE_ON) == 0)
+        {
+            result.vsync_mode = VSYNC_MODE_ON;
+        }
+        else
+        {
+            printf("Frame pacer: failed to set swap interval %d: %s\n", vsync_mode, SDL_GetError());
+            result.vsync_mode = SDL_GL_GetSwapInterval();
+        }
+    }
+
+    result.next_frame_time = SDL_GetPerformanceCounter();
+
+    return result;
+}
+
+static void frame_pacer_sleep(frame_pacer_t *self)
+{
+    const double one_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+
+    uint64_t before = SDL_GetPerformanceCounter();
+    SDL_Delay(1);
+    uint64_t after = SDL_GetPerformanceCounter();
+
+    // Welford's running mean/variance, capped so it keeps adapting if the system gets busier.
+    double overshoot = (double)(after - before) - one_ms;
+    self->num_sleeps = self->num_sleeps < 1000 ? self->num_sleeps + 1 : 1000;
+    double delta = overshoot - self->sleep_overshoot_mean;
+    self->sleep_overshoot_mean += delta / (double)self->num_sleeps;
+    self->sleep_overshoot_variance += (delta * (overshoot - self->sleep_overshoot_mean) - self->sleep_overshoot_variance) / (double)self->num_sleeps;
+}
+
+void frame_pacer_wait(frame_pacer_t *self)
+{
+    uint64_t frame_counter = self->is_background ? self->background_frame_counter : self->target_frame_counter;
+    uint64_t start = SDL_GetPerformanceCounter();
+    self->last_wait_counter = 0;
+
+    if (frame_counter == 0)
+    {
+        self->next_frame_time = start;
+        return;
+    }
+
+    PROFILE_FUNCTION();
+
+    uint64_t target = self->next_frame_time + frame_counter;
+
+    // More than a frame behind, don't try to make up for it with a burst of unpaced frames.
+    if (start > target)
+    {
+        self->next_frame_time = start;
+        return;
+    }
+
+    const double one_ms = (double)SDL_GetPerformanceFrequency() / 1000.0;
+    double sleep_margin = one_ms + self->sleep_overshoot_mean + 2.0 * sqrt(self->sleep_overshoot_variance);
+
+    uint64_t now = start;
+    // Signed, a sleep can overshoot past the target and the difference mustn't wrap round.
+    while ((double)((int64_t)target - (int64_t)now) > sleep_margin)
+    {
+        frame_pacer_sleep(self);
+        now = SDL_GetPerformanceCounter();
+        sleep_margin = one_ms + self->sleep_overshoot_mean + 2.0 * sqrt(self->sleep_overshoot_variance);
+    }
+
+    while (now < target)
+    {
+        now = SDL_GetPerformanceCounter();
+    }
+
+    self->next_frame_time = target;
+    self->last_wait_counter = now - start;
+}
+
+void frame_pacer_handle_event(frame_pacer_t *self, const SDL_Event *event)
+{
+    if (event->type != SDL_WINDOWEVENT)
+        return;
+
+    switch (event->window.event)
+    {
+    case SDL_WINDOWEVENT_FOCUS_LOST:
+    case SDL_WINDOWEVENT_MINIMIZED:
+    case SDL_WINDOWEVENT_HIDDEN:
+    {
+        self->is_background = 1;
+        break;
+    }
+    case SDL_WINDOWEVENT_FOCUS_GAINED:
+    case SDL_WINDOWEVENT_RESTORED:
+    case SDL_WINDOWEVENT_SHOWN:
+    {
+        self->is_background = 0;
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+}
+
+uint8_t frame_pacer_every(uint64_t *last_time, uint32_t interval_ms, uint64_t now)
+{
+    if (now - *last_time < SDL_GetPerformanceFrequency() * interval_ms / 1000)
+        return 0;
+
+    *last_time = now;
+    return 1;
+}
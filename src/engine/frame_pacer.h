@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+typedef enum vsync_mode_e
+{
+    VSYNC_MODE_ADAPTIVE = -1,
+    VSYNC_MODE_OFF = 0,
+    VSYNC_MODE_ON = 1,
+} vsync_mode_e;
+
+// Caps the frame rate without burning a core.
+// Waiting sleeps with SDL_Delay while there's comfortably more time left than the OS tends to oversleep by, then
+// spins for the remainder. The oversleep is measured on every sleep so the margin tracks the machine it runs on.
+// All times are SDL_GetPerformanceCounter values.
+typedef struct frame_pacer_t
+{
+    // 0 for uncapped.
+    uint64_t target_frame_counter;
+    uint64_t background_frame_counter;
+    uint8_t is_background;
+
+    uint64_t next_frame_time;
+
+    // Running mean and variance of how far past the requested time SDL_Delay(1) returns.
+    double sleep_overshoot_mean;
+    double sleep_overshoot_variance;
+    uint64_t num_sleeps;
+
+    vsync_mode_e vsync_mode;
+
+    // Time spent waiting in the last call to frame_pacer_wait.
+    uint64_t last_wait_counter;
+} frame_pacer_t;
+
+/// @brief Needs a current GL context, vsync is set up straight away.
+/// @param target_fps 0 for uncapped.
+/// @param background_fps Frame rate while the window is unfocused or minimised, 0 to use target_fps.
+/// @param vsync_mode Adaptive falls back to regular vsync when the driver doesn't support it.
+frame_pacer_t frame_pacer_new(uint32_t target_fps, uint32_t background_fps, vsync_mode_e vsync_mode);
+
+/// @brief Block until the next frame is due.
+void frame_pacer_wait(frame_pacer_t *self);
+
+/// @brief Track focus and minimise window events to switch to the background frame rate.
+void frame_pacer_handle_event(frame_pacer_t *self, const SDL_Event *event);
+
+/// @brief For throttling periodic work such as window title and overlay updates.
+/// @return 1 and resets last_time once interval_ms has passed since last_time.
+uint8_t frame_pacer_every(uint64_t *last_time, uint32_t interval_ms, uint64_t now);
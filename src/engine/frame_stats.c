@@ -0,0 +1,59 @@
+#include "frame_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+
+static int compare_floats(const void *a, const void *b)
+{
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+static float sorted_percentile(const float *sorted, size_t count, float percentile)
+{
+    size_t index = (size_t)(percentile * (float)(count - 1) + 0.5f);
+    return sorted[index < count ? index : count - 1];
+}
+
+frame_timings_summary_t frame_timings_summarise(const float *frame_ms, size_t count)
+{
+    frame_timings_summary_t result = {0};
+    result.count = count;
+
+    if (count == 0)
+        return result;
+
+    float *sorted = mem_alloc(MEMORY_TAG_GENERAL, count * sizeof(float));
+    memcpy(sorted, frame_ms, count * sizeof(float));
+    qsort(sorted, count, sizeof(float), compare_floats);
+
+    double total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += sorted[i];
+
+    result.min_ms = sorted[0];
+    result.max_ms = sorted[count - 1];
+    result.mean_ms = (float)(total / (double)count);
+    result.p50_ms = sorted_percentile(sorted, count, 0.50f);
+    result.p95_ms = sorted_percentile(sorted, count, 0.95f);
+    result.p99_ms = sorted_percentile(sorted, count, 0.99f);
+
+    mem_free(sorted);
+
+    return result;
+}
+
+void frame_timings_print(const char *label, const frame_timings_summary_t *summary)
+{
+    printf("%s: %zu frames | mean %.3f ms (%.1f FPS) | min %.3f | p50 %.3f | p95 %.3f | p99 %.3f | max %.3f ms\n",
+           label,
+           summary->count,
+           summary->mean_ms,
+           summary->mean_ms > 0 ? 1000.0f / summary->mean_ms : 0.0f,
+           summary->min_ms,
+           summary->p50_ms,
+           summary->p95_ms,
+           summary->p99_ms,
+           summary->max_ms);
+}
\ No newline at end of file
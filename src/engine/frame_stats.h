@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-frame timings shared by the CPU and GPU side, filled in by lib_start and shown by the stats overlay.
+// GPU numbers lag the CPU ones by a couple of frames as they're only read back once the queries are ready.
+typedef struct frame_stats_t
+{
+    uint64_t frame_number;
+    uint64_t frame_start;
+
+    // Start of the previous frame to the start of this one, including any pacing wait.
+    float frame_interval_ms;
+    float cpu_wait_ms;
+
+    float cpu_frame_ms;
+    float cpu_render_ms;
+    float cpu_swap_ms;
+
+    // Simulation runs at its own fixed rate, these come from the latest render snapshot.
+    float cpu_tick_ms;
+    uint64_t sim_step_number;
+    uint32_t num_sim_steps;
+
+    float gpu_frame_ms;
+    float gpu_clear_ms;
+    float gpu_batch_ms;
+    uint32_t gpu_num_flushes;
+    float gpu_tilemap_ms;
+    uint64_t gpu_frame_number;
+
+    uint32_t num_flushes;
+    uint32_t num_quads;
+
+    // Zero without a tilemap.
+    uint32_t num_tile_draws;
+    uint32_t num_tile_chunks_built;
+    uint32_t num_tile_quads;
+
+    // Tracked heap allocations during the frame, see engine/memory.h, and the most the frame arenas held.
+    uint32_t num_heap_allocs;
+    uint64_t total_heap_allocs;
+    size_t frame_arena_bytes;
+    size_t sim_arena_bytes;
+} frame_stats_t;
+
+typedef struct frame_timings_summary_t
+{
+    size_t count;
+    float min_ms, mean_ms, max_ms;
+    float p50_ms, p95_ms, p99_ms;
+} frame_timings_summary_t;
+
+/// @brief Percentiles over a run of frame times, doesn't modify frame_ms.
+frame_timings_summary_t frame_timings_summarise(const float *frame_ms, size_t count);
+
+void frame_timings_print(const char *label, const frame_timings_summary_t *summary);
@@ -0,0 +1,131 @@
+#include "gpu_timer.h"
+#include "engine.h"
+#include <string.h>
+
+gpu_timer_t gpu_timer_new()
+{
+    gpu_timer_t result = {0};
+
+    for (size_t i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; i++)
+    {
+        GL_CALL(glGenQueries(GPU_TIMER_MAX_ZONES * 2, result.frames[i].queries));
+    }
+
+    return result;
+}
+
+void gpu_timer_free(gpu_timer_t *self)
+{
+    for (size_t i = 0; i < GPU_TIMER_FRAMES_IN_FLIGHT; i++)
+    {
+        glDeleteQueries(GPU_TIMER_MAX_ZONES * 2, self->frames[i].queries);
+    }
+
+    *self = (gpu_timer_t){0};
+}
+
+static void gpu_timer_resolve(gpu_timer_t *self, gpu_timer_frame_t *frame)
+{
+    frame->is_pending = 0;
+
+    if (frame->num_zones == 0)
+        return;
+
+    // Nested zones end out of array order so every end query has to be checked, asking for a result that isn't
+    // available yet would block.
+    for (uint32_t i = 0; i < frame->num_zones; i++)
+    {
+        GLuint available = GL_FALSE;
+        GL_CALL(glGetQueryObjectuiv(frame->queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available));
+        if (!available)
+        {
+            self->num_dropped_frames++;
+            return;
+        }
+    }
+
+    for (uint32_t i = 0; i < frame->num_zones; i++)
+    {
+        GL_CALL(glGetQueryObjectui64v(frame->queries[i * 2 + 0], GL_QUERY_RESULT, &self->resolved_begin[i]));
+        GL_CALL(glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &self->resolved_end[i]));
+        self->resolved_names[i] = frame->names[i];
+    }
+
+    self->resolved_num_zones = frame->num_zones;
+    self->resolved_frame_number = frame->frame_number;
+}
+
+void gpu_timer_begin_frame(gpu_timer_t *self)
+{
+    gpu_timer_frame_t *frame = &self->frames[self->frame_number % GPU_TIMER_FRAMES_IN_FLIGHT];
+
+    // This pool was last used GPU_TIMER_FRAMES_IN_FLIGHT frames ago, by now it's very likely finished.
+    if (frame->is_pending)
+    {
+        gpu_timer_resolve(self, frame);
+    }
+
+    frame->num_zones = 0;
+    frame->is_out_of_zones = 0;
+    frame->frame_number = self->frame_number;
+}
+
+void gpu_timer_end_frame(gpu_timer_t *self)
+{
+    gpu_timer_frame_t *frame = &self->frames[self->frame_number % GPU_TIMER_FRAMES_IN_FLIGHT];
+    frame->is_pending = 1;
+
+    self->frame_number++;
+}
+
+uint32_t gpu_timer_begin(gpu_timer_t *self, const char *name)
+{
+    gpu_timer_frame_t *frame = &self->frames[self->frame_number % GPU_TIMER_FRAMES_IN_FLIGHT];
+
+    if (frame->num_zones >= GPU_TIMER_MAX_ZONES)
+    {
+        if (!frame->is_out_of_zones)
+        {
+            frame->is_out_of_zones = 1;
+            self->num_dropped_frames++;
+        }
+        return GPU_TIMER_INVALID_ZONE;
+    }
+
+    uint32_t zone = frame->num_zones++;
+    frame->names[zone] = name;
+    GL_CALL(glQueryCounter(frame->queries[zone * 2 + 0], GL_TIMESTAMP));
+    // Write the end query straight away so a zone that never ends still has a valid result to read back.
+    GL_CALL(glQueryCounter(frame->queries[zone * 2 + 1], GL_TIMESTAMP));
+
+    return zone;
+}
+
+void gpu_timer_end(gpu_timer_t *self, uint32_t zone)
+{
+    if (zone == GPU_TIMER_INVALID_ZONE)
+        return;
+
+    gpu_timer_frame_t *frame = &self->frames[self->frame_number % GPU_TIMER_FRAMES_IN_FLIGHT];
+    GL_CALL(glQueryCounter(frame->queries[zone * 2 + 1], GL_TIMESTAMP));
+}
+
+float gpu_timer_get_ms(const gpu_timer_t *self, const char *name, uint32_t *out_count)
+{
+    uint64_t total_ns = 0;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < self->resolved_num_zones; i++)
+    {
+        if (strcmp(self->resolved_names[i], name) == 0)
+        {
+            total_ns += self->resolved_end[i] - self->resolved_begin[i];
+            count++;
+        }
+    }
+
+    if (out_count)
+        *out_count = count;
+
+    return (float)((double)total_ns / 1000000.0);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <glad/glad.h>
+
+// GPU zone timer built on GL_TIMESTAMP queries.
+// Timestamps (rather than GL_TIME_ELAPSED) are used so zones can nest, eg. every batch flush inside the frame zone.
+// Each frame gets its own query pool and results are read back GPU_TIMER_FRAMES_IN_FLIGHT - 1 frames later, only once
+// the driver reports them available, so reading results never stalls the pipeline.
+
+#define GPU_TIMER_FRAMES_IN_FLIGHT 3
+#define GPU_TIMER_MAX_ZONES 256
+
+typedef struct gpu_timer_frame_t
+{
+    GLuint queries[GPU_TIMER_MAX_ZONES * 2];
+    const char *names[GPU_TIMER_MAX_ZONES];
+    uint32_t num_zones;
+    uint64_t frame_number;
+    uint8_t is_pending;
+    // Asked for more than GPU_TIMER_MAX_ZONES, counted as dropped once however many more it asked for.
+    uint8_t is_out_of_zones;
+} gpu_timer_frame_t;
+
+typedef struct gpu_timer_t
+{
+    gpu_timer_frame_t frames[GPU_TIMER_FRAMES_IN_FLIGHT];
+    uint64_t frame_number;
+
+    // Results of the most recently resolved frame.
+    uint64_t resolved_frame_number;
+    uint64_t resolved_begin[GPU_TIMER_MAX_ZONES];
+    uint64_t resolved_end[GPU_TIMER_MAX_ZONES];
+    const char *resolved_names[GPU_TIMER_MAX_ZONES];
+    uint32_t resolved_num_zones;
+
+    // Frames whose queries weren't ready by the time the pool came round again, or that ran out of zones.
+    uint64_t num_dropped_frames;
+} gpu_timer_t;
+
+#define GPU_TIMER_INVALID_ZONE UINT32_MAX
+
+gpu_timer_t gpu_timer_new();
+void gpu_timer_free(gpu_timer_t *self);
+
+/// @brief Resolve the oldest frame in flight if its queries are ready and start recording a new frame.
+void gpu_timer_begin_frame(gpu_timer_t *self);
+void gpu_timer_end_frame(gpu_timer_t *self);
+
+/// @brief Issue the begin timestamp for a zone.
+/// @param name Must outlive the results, string literals or __func__.
+/// @return Zone handle for gpu_timer_end, GPU_TIMER_INVALID_ZONE if the frame is out of zones.
+uint32_t gpu_timer_begin(gpu_timer_t *self, const char *name);
+void gpu_timer_end(gpu_timer_t *self, uint32_t zone);
+
+/// @brief Sum of all resolved zones with this name in milliseconds.
+/// @param out_count Optional, number of zones that matched.
+float gpu_timer_get_ms(const gpu_timer_t *self, const char *name, uint32_t *out_count);
@@ -0,0 +1,178 @@
+#include "job_system.h"
+#include <stdio.h>
+#include <assert.h>
+#include "memory.h"
+#include "profiler.h"
+
+typedef struct job_worker_t
+{
+    job_system_t *system;
+    uint32_t index;
+} job_worker_t;
+
+static _Thread_local uint8_t tls_is_in_job;
+
+static void job_system_run_batches(job_system_t *self, job_range_fn_t fn, void *user_data, uint32_t count, uint32_t batch_size, uint32_t worker_index)
+{
+    tls_is_in_job = 1;
+
+    for (;;)
+    {
+        uint32_t begin = (uint32_t)SDL_AtomicAdd(&self->next, (int)batch_size);
+        if (begin >= count)
+            break;
+
+        uint32_t end = begin + batch_size > count ? count : begin + batch_size;
+        fn(user_data, begin, end, worker_index);
+
+        // Whoever finishes the last item wakes the caller.
+        int num_done = (int)(end - begin);
+        if (SDL_AtomicAdd(&self->remaining, -num_done) == num_done)
+        {
+            SDL_LockMutex(self->mutex);
+            SDL_CondSignal(self->done);
+            SDL_UnlockMutex(self->mutex);
+        }
+    }
+
+    tls_is_in_job = 0;
+}
+
+static int job_worker_thread(void *data)
+{
+    job_worker_t worker = *(job_worker_t *)data;
+    mem_free(data);
+
+    job_system_t *self = worker.system;
+    profiler_set_thread_name(self->thread_names[worker.index - 1]);
+
+    uint64_t last_generation = 0;
+    SDL_LockMutex(self->mutex);
+    for (;;)
+    {
+        while (self->generation == last_generation && !self->is_quitting)
+            SDL_CondWait(self->wake, self->mutex);
+
+        if (self->is_quitting)
+            break;
+
+        last_generation = self->generation;
+        job_range_fn_t fn = self->fn;
+        void *user_data = self->user_data;
+        uint32_t count = self->count, batch_size = self->batch_size;
+        self->num_busy++;
+        SDL_UnlockMutex(self->mutex);
+
+        job_system_run_batches(self, fn, user_data, count, batch_size, worker.index);
+
+        SDL_LockMutex(self->mutex);
+        if (--self->num_busy == 0)
+            SDL_CondSignal(self->done);
+    }
+    SDL_UnlockMutex(self->mutex);
+
+    return 0;
+}
+
+job_system_t *job_system_new(uint32_t num_workers)
+{
+    if (num_workers == JOB_SYSTEM_AUTO_WORKERS)
+    {
+        int num_cores = SDL_GetCPUCount();
+        num_workers = num_cores > 1 ? (uint32_t)num_cores - 1 : 0;
+    }
+    if (num_workers > JOB_SYSTEM_MAX_WORKERS)
+        num_workers = JOB_SYSTEM_MAX_WORKERS;
+
+    job_system_t *self = mem_calloc(MEMORY_TAG_GENERAL, 1, sizeof(job_system_t));
+    assert(self);
+    self->submit_mutex = SDL_CreateMutex();
+    self->mutex = SDL_CreateMutex();
+    self->wake = SDL_CreateCond();
+    self->done = SDL_CreateCond();
+    assert(self->submit_mutex && self->mutex && self->wake && self->done);
+
+    for (uint32_t i = 0; i < num_workers; i++)
+    {
+        snprintf(self->thread_names[i], sizeof(self->thread_names[i]), "job_worker_%u", i + 1);
+
+        job_worker_t *worker = mem_alloc(MEMORY_TAG_GENERAL, sizeof(job_worker_t));
+        *worker = (job_worker_t){self, i + 1};
+        self->threads[i] = SDL_CreateThread(job_worker_thread, self->thread_names[i], worker);
+        assert(self->threads[i]);
+    }
+    self->num_workers = num_workers;
+
+    return self;
+}
+
+void job_system_free(job_system_t *self)
+{
+    SDL_LockMutex(self->mutex);
+    self->is_quitting = 1;
+    SDL_CondBroadcast(self->wake);
+    SDL_UnlockMutex(self->mutex);
+
+    for (uint32_t i = 0; i < self->num_workers; i++)
+        SDL_WaitThread(self->threads[i], 0);
+
+    SDL_DestroyCond(self->done);
+    SDL_DestroyCond(self->wake);
+    SDL_DestroyMutex(self->mutex);
+    SDL_DestroyMutex(self->submit_mutex);
+
+    mem_free(self);
+}
+
+void job_system_parallel_for(job_system_t *self, uint32_t count, uint32_t batch_size, job_range_fn_t fn, void *user_data)
+{
+    assert(batch_size > 0);
+    if (count == 0)
+        return;
+
+    PROFILE_FUNCTION();
+
+    // Nothing to wait on without workers, so a pool with none is fine from inside another pool's job.
+    if (self->num_workers == 0)
+    {
+        fn(user_data, 0, count, 0);
+        return;
+    }
+
+    // A job waiting on its own pool would wait forever once every worker was doing the same.
+    assert(!tls_is_in_job);
+
+    // Not worth waking anyone for.
+    if (count <= batch_size)
+    {
+        fn(user_data, 0, count, 0);
+        return;
+    }
+
+    SDL_LockMutex(self->submit_mutex);
+
+    SDL_LockMutex(self->mutex);
+    // A worker that only woke after the last job ended still holds that job, let it find nothing left first.
+    while (self->num_busy > 0)
+        SDL_CondWait(self->done, self->mutex);
+
+    self->fn = fn;
+    self->user_data = user_data;
+    self->count = count;
+    self->batch_size = batch_size;
+    SDL_AtomicSet(&self->next, 0);
+    SDL_AtomicSet(&self->remaining, (int)count);
+    self->generation++;
+    SDL_CondBroadcast(self->wake);
+    SDL_UnlockMutex(self->mutex);
+
+    job_system_run_batches(self, fn, user_data, count, batch_size, 0);
+
+    // Workers still inside the job may be about to take a batch, the next job can't reset the counters under them.
+    SDL_LockMutex(self->mutex);
+    while (SDL_AtomicGet(&self->remaining) > 0 || self->num_busy > 0)
+        SDL_CondWait(self->done, self->mutex);
+    SDL_UnlockMutex(self->mutex);
+
+    SDL_UnlockMutex(self->submit_mutex);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+#define JOB_SYSTEM_MAX_WORKERS 64
+// One worker per core besides the caller's.
+#define JOB_SYSTEM_AUTO_WORKERS UINT32_MAX
+
+/// @brief Does items [begin, end) of a parallel_for.
+/// @param worker_index 0 for the thread that called parallel_for, 1 to num_workers for the pool's threads. For
+/// indexing per-worker scratch, there are job_system_num_threads of them.
+typedef void (*job_range_fn_t)(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index);
+
+// A fixed pool of threads for splitting a loop across cores. Only one parallel_for runs at a time, the caller takes
+// batches like any worker and it returns once every item is done, so there's nothing to wait on or free afterwards.
+typedef struct job_system_t
+{
+    SDL_Thread *threads[JOB_SYSTEM_MAX_WORKERS];
+    char thread_names[JOB_SYSTEM_MAX_WORKERS][24];
+    uint32_t num_workers;
+
+    // Serialises callers, parallel_for can be called from any thread but not from inside a job.
+    SDL_mutex *submit_mutex;
+
+    // Guards everything below that isn't atomic.
+    SDL_mutex *mutex;
+    SDL_cond *wake;
+    SDL_cond *done;
+    uint8_t is_quitting;
+    // Bumped for every parallel_for, workers wake when it's not what they last saw.
+    uint64_t generation;
+    // Workers still inside the current job, it isn't over until they've all left even if every item is done.
+    uint32_t num_busy;
+
+    job_range_fn_t fn;
+    void *user_data;
+    uint32_t count;
+    uint32_t batch_size;
+    SDL_atomic_t next;
+    SDL_atomic_t remaining;
+} job_system_t;
+
+/// @param num_workers Threads besides the caller's, 0 runs everything on the caller and can be shared by any number of
+/// threads, even from inside another pool's jobs. JOB_SYSTEM_AUTO_WORKERS for one less than the number of cores.
+job_system_t *job_system_new(uint32_t num_workers);
+void job_system_free(job_system_t *self);
+
+/// @brief Everything that can be running a job at once, the workers plus the caller.
+static inline uint32_t job_system_num_threads(const job_system_t *self)
+{
+    return self->num_workers + 1;
+}
+
+/// @brief Call fn over [0, count) in batches of batch_size spread over the pool, returns when all of them are done.
+void job_system_parallel_for(job_system_t *self, uint32_t count, uint32_t batch_size, job_range_fn_t fn, void *user_data);
\ No newline at end of file
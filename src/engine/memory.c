@@ -0,0 +1,284 @@
+#include "memory.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <SDL2/SDL.h>
+
+static const char *g_memory_tag_names[MEMORY_TAG_COUNT] = {
+#define X(tag, name) name,
+    FOR_EACH_MEMORY_TAG
+#undef X
+};
+
+static memory_tag_stats_t g_memory_stats[MEMORY_TAG_COUNT];
+// Allocations come from the simulation thread too, the stats are only a few adds so a spin lock is plenty.
+static SDL_SpinLock g_memory_lock;
+
+static _Thread_local memory_tag_e tls_memory_tag = MEMORY_TAG_GENERAL;
+
+#if MEMORY_TRACKING
+
+#define MEMORY_HEADER_MAGIC 0x4d454d54u
+
+// 16 bytes so blocks keep malloc's alignment.
+typedef struct memory_header_t
+{
+    size_t size;
+    uint32_t tag;
+    uint32_t magic;
+} memory_header_t;
+
+static void memory_track_alloc(memory_tag_e tag, size_t size)
+{
+    SDL_AtomicLock(&g_memory_lock);
+    memory_tag_stats_t *stats = &g_memory_stats[tag];
+    stats->live_bytes += size;
+    stats->num_allocs++;
+    if (stats->live_bytes > stats->peak_bytes)
+        stats->peak_bytes = stats->live_bytes;
+    SDL_AtomicUnlock(&g_memory_lock);
+}
+
+static void memory_track_free(memory_tag_e tag, size_t size)
+{
+    SDL_AtomicLock(&g_memory_lock);
+    memory_tag_stats_t *stats = &g_memory_stats[tag];
+    stats->live_bytes -= size;
+    stats->num_frees++;
+    SDL_AtomicUnlock(&g_memory_lock);
+}
+
+static memory_header_t *memory_get_header(void *ptr)
+{
+    memory_header_t *header = (memory_header_t *)ptr - 1;
+    // Anything else means this block came from plain malloc or was already freed.
+    assert(header->magic == MEMORY_HEADER_MAGIC);
+    return header;
+}
+
+void *mem_alloc(memory_tag_e tag, size_t size)
+{
+    assert(tag < MEMORY_TAG_COUNT);
+
+    memory_header_t *header = malloc(sizeof(memory_header_t) + size);
+    if (!header)
+        return 0;
+
+    header->size = size;
+    header->tag = tag;
+    header->magic = MEMORY_HEADER_MAGIC;
+    memory_track_alloc(tag, size);
+
+    return header + 1;
+}
+
+void *mem_calloc(memory_tag_e tag, size_t count, size_t size)
+{
+    if (size && count > SIZE_MAX / size)
+        return 0;
+
+    void *result = mem_alloc(tag, count * size);
+    if (result)
+        memset(result, 0, count * size);
+
+    return result;
+}
+
+void *mem_realloc(memory_tag_e tag, void *ptr, size_t size)
+{
+    if (!ptr)
+        return mem_alloc(tag, size);
+
+    if (size == 0)
+    {
+        mem_free(ptr);
+        return 0;
+    }
+
+    memory_header_t *header = memory_get_header(ptr);
+    memory_tag_e block_tag = (memory_tag_e)header->tag;
+    size_t old_size = header->size;
+
+    memory_header_t *new_header = realloc(header, sizeof(memory_header_t) + size);
+    if (!new_header)
+        return 0;
+
+    new_header->size = size;
+
+    // A realloc counts as a free of the old block and a new allocation, like it is to the heap.
+    memory_track_free(block_tag, old_size);
+    memory_track_alloc(block_tag, size);
+
+    return new_header + 1;
+}
+
+void mem_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    memory_header_t *header = memory_get_header(ptr);
+    memory_track_free((memory_tag_e)header->tag, header->size);
+
+    header->magic = 0;
+    free(header);
+}
+
+#else
+
+void *mem_alloc(memory_tag_e tag, size_t size)
+{
+    return malloc(size);
+}
+
+void *mem_calloc(memory_tag_e tag, size_t count, size_t size)
+{
+    return calloc(count, size);
+}
+
+void *mem_realloc(memory_tag_e tag, void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void mem_free(void *ptr)
+{
+    free(ptr);
+}
+
+#endif
+
+void *memory_stbds_realloc(void *ptr, size_t size)
+{
+    return mem_realloc(tls_memory_tag, ptr, size);
+}
+
+memory_tag_e memory_set_tag(memory_tag_e tag)
+{
+    assert(tag < MEMORY_TAG_COUNT);
+
+    memory_tag_e previous = tls_memory_tag;
+    tls_memory_tag = tag;
+    return previous;
+}
+
+memory_tag_e memory_get_tag(void)
+{
+    return tls_memory_tag;
+}
+
+void memory_gpu_alloc(memory_tag_e tag, size_t bytes)
+{
+    SDL_AtomicLock(&g_memory_lock);
+    memory_tag_stats_t *stats = &g_memory_stats[tag];
+    stats->gpu_bytes += bytes;
+    if (stats->gpu_bytes > stats->gpu_peak_bytes)
+        stats->gpu_peak_bytes = stats->gpu_bytes;
+    SDL_AtomicUnlock(&g_memory_lock);
+}
+
+void memory_gpu_free(memory_tag_e tag, size_t bytes)
+{
+    SDL_AtomicLock(&g_memory_lock);
+    g_memory_stats[tag].gpu_bytes -= bytes;
+    SDL_AtomicUnlock(&g_memory_lock);
+}
+
+size_t memory_texture_bytes(uint32_t width, uint32_t height, uint32_t bytes_per_pixel, uint8_t has_mips)
+{
+    size_t bytes = (size_t)width * height * bytes_per_pixel;
+    return has_mips ? bytes + bytes / 3 : bytes;
+}
+
+const char *memory_tag_name(memory_tag_e tag)
+{
+    assert(tag < MEMORY_TAG_COUNT);
+    return g_memory_tag_names[tag];
+}
+
+memory_tag_stats_t memory_get_stats(memory_tag_e tag)
+{
+    assert(tag < MEMORY_TAG_COUNT);
+
+    SDL_AtomicLock(&g_memory_lock);
+    memory_tag_stats_t result = g_memory_stats[tag];
+    SDL_AtomicUnlock(&g_memory_lock);
+
+    return result;
+}
+
+uint64_t memory_total_allocs(void)
+{
+    uint64_t result = 0;
+
+    SDL_AtomicLock(&g_memory_lock);
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        result += g_memory_stats[i].num_allocs;
+    SDL_AtomicUnlock(&g_memory_lock);
+
+    return result;
+}
+
+static double memory_mib(size_t bytes)
+{
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+void memory_dump(FILE *file)
+{
+    memory_tag_stats_t total = {0};
+
+    fprintf(file, "%-12s %12s %12s %12s %12s %12s %12s\n", "tag", "live MiB", "peak MiB", "live allocs", "allocs", "gpu MiB", "gpu peak MiB");
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+    {
+        memory_tag_stats_t stats = memory_get_stats((memory_tag_e)i);
+        fprintf(file,
+                "%-12s %12.3f %12.3f %12llu %12llu %12.3f %12.3f\n",
+                g_memory_tag_names[i],
+                memory_mib(stats.live_bytes),
+                memory_mib(stats.peak_bytes),
+                (unsigned long long)(stats.num_allocs - stats.num_frees),
+                (unsigned long long)stats.num_allocs,
+                memory_mib(stats.gpu_bytes),
+                memory_mib(stats.gpu_peak_bytes));
+
+        total.live_bytes += stats.live_bytes;
+        total.num_allocs += stats.num_allocs;
+        total.num_frees += stats.num_frees;
+        total.gpu_bytes += stats.gpu_bytes;
+    }
+
+    // Tag peaks happen at different times, so there's no meaningful total peak.
+    fprintf(file,
+            "%-12s %12.3f %12s %12llu %12llu %12.3f %12s\n",
+            "total",
+            memory_mib(total.live_bytes),
+            "-",
+            (unsigned long long)(total.num_allocs - total.num_frees),
+            (unsigned long long)total.num_allocs,
+            memory_mib(total.gpu_bytes),
+            "-");
+    fflush(file);
+}
+
+uint32_t memory_report_leaks(void)
+{
+    uint32_t num_leaking = 0;
+
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+    {
+        memory_tag_stats_t stats = memory_get_stats((memory_tag_e)i);
+        uint64_t live_allocs = stats.num_allocs - stats.num_frees;
+        if (live_allocs == 0 && stats.gpu_bytes == 0)
+            continue;
+
+        printf("Memory leak: %s still has %zu bytes in %llu allocations and %zu GPU bytes\n",
+               g_memory_tag_names[i],
+               stats.live_bytes,
+               (unsigned long long)live_allocs,
+               stats.gpu_bytes);
+        num_leaking++;
+    }
+
+    return num_leaking;
+}
\ No newline at end of file
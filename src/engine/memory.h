@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Tagged heap allocations and GPU memory estimates, per subsystem.
+// Every block carries a small header with its size and tag so frees are accounted to whatever allocated them.
+// stb_ds containers go through the same allocator, new containers take the calling thread's current tag (see
+// MEMORY_SCOPE) and keep it as they grow. Include this instead of vendor/stb_ds.h so every container is tracked.
+// With MEMORY_TRACKING off everything is plain malloc/free and the stats stay at zero.
+
+// (enum, name shown in the overlay and dumps)
+#define FOR_EACH_MEMORY_TAG                        \
+    X(MEMORY_TAG_GENERAL, "general")               \
+    X(MEMORY_TAG_ENTITIES, "entities")             \
+    X(MEMORY_TAG_TRANSFORMS, "transforms")         \
+    X(MEMORY_TAG_BATCHER, "batcher")               \
+    X(MEMORY_TAG_FONTS, "fonts")                   \
+    X(MEMORY_TAG_TEXTURES, "textures")             \
+    X(MEMORY_TAG_ASSET_CACHE, "asset_cache")       \
+    X(MEMORY_TAG_RENDER, "render")                 \
+    X(MEMORY_TAG_PROFILER, "profiler")             \
+    X(MEMORY_TAG_ARENAS, "arenas")                 \
+    X(MEMORY_TAG_TILEMAP, "tilemap")               \
+    X(MEMORY_TAG_PATHFINDING, "pathfinding")       \
+    X(MEMORY_TAG_FOV, "fov")                       \
+    X(MEMORY_TAG_TURNS, "turns")                   \
+    X(MEMORY_TAG_SNAPSHOTS, "snapshots")           \
+    X(MEMORY_TAG_REPLICATION, "replication")       \
+    X(MEMORY_TAG_JOURNAL, "journal")
+
+typedef enum memory_tag_e
+{
+#define X(tag, name) tag,
+    FOR_EACH_MEMORY_TAG
+#undef X
+        MEMORY_TAG_COUNT,
+} memory_tag_e;
+
+typedef struct memory_tag_stats_t
+{
+    size_t live_bytes;
+    size_t peak_bytes;
+    uint64_t num_allocs;
+    uint64_t num_frees;
+
+    // Estimated from the sizes and formats of the GL objects each subsystem creates.
+    size_t gpu_bytes;
+    size_t gpu_peak_bytes;
+} memory_tag_stats_t;
+
+void *mem_alloc(memory_tag_e tag, size_t size);
+void *mem_calloc(memory_tag_e tag, size_t count, size_t size);
+/// @brief Null ptr allocates with tag, otherwise the block keeps the tag it was allocated with.
+void *mem_realloc(memory_tag_e tag, void *ptr, size_t size);
+/// @brief Only for blocks from the mem_ functions, null is fine.
+void mem_free(void *ptr);
+
+/// @brief Set the tag new stb_ds containers on this thread are accounted to.
+/// @return The previous tag.
+memory_tag_e memory_set_tag(memory_tag_e tag);
+memory_tag_e memory_get_tag(void);
+
+static inline void memory_restore_tag(memory_tag_e *previous)
+{
+    memory_set_tag(*previous);
+}
+
+#define MEMORY_CONCAT_IMPL(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_IMPL(a, b)
+
+// Containers created in the rest of the enclosing block are accounted to tag.
+#define MEMORY_SCOPE(tag) \
+    memory_tag_e MEMORY_CONCAT(_memory_scope_, __LINE__) __attribute__((cleanup(memory_restore_tag))) = memory_set_tag(tag)
+
+/// @brief Record a GL object's estimated size, call memory_gpu_free with the same size when it's deleted.
+void memory_gpu_alloc(memory_tag_e tag, size_t bytes);
+void memory_gpu_free(memory_tag_e tag, size_t bytes);
+
+/// @brief Bytes for a width x height texture with bytes_per_pixel, plus a third for a full mip chain.
+size_t memory_texture_bytes(uint32_t width, uint32_t height, uint32_t bytes_per_pixel, uint8_t has_mips);
+
+const char *memory_tag_name(memory_tag_e tag);
+memory_tag_stats_t memory_get_stats(memory_tag_e tag);
+
+/// @brief Allocations made so far over every tag, diff it across a frame to count that frame's allocations.
+uint64_t memory_total_allocs(void);
+
+/// @brief Print a table of every tag's stats.
+void memory_dump(FILE *file);
+
+/// @brief Print every tag that still has live allocations or GPU memory, call once everything should be freed.
+/// @return Number of tags with leaks.
+uint32_t memory_report_leaks(void);
+
+// stb_ds knows nothing of tags, so it gets the current one.
+void *memory_stbds_realloc(void *ptr, size_t size);
+
+#define STBDS_REALLOC(context, ptr, size) memory_stbds_realloc(ptr, size)
+#define STBDS_FREE(context, ptr) mem_free(ptr)
+#include "../vendor/stb_ds.h"
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "net.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#define net_last_error_would_block() (WSAGetLastError() == WSAEWOULDBLOCK)
+#define net_close_native closesocket
+typedef int net_length_t;
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define net_last_error_would_block() (errno == EAGAIN || errno == EWOULDBLOCK)
+#define net_close_native close
+typedef size_t net_length_t;
+#endif
+
+// Linux can be told per send not to raise SIGPIPE, elsewhere net_init ignores it for the whole process.
+#ifdef MSG_NOSIGNAL
+#define NET_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define NET_SEND_FLAGS 0
+#endif
+
+void net_init(void)
+{
+#ifdef _WIN32
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#elif !defined(MSG_NOSIGNAL)
+    signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+void net_shutdown(void)
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+static void net_configure(net_socket_t socket)
+{
+#ifdef _WIN32
+    u_long is_non_blocking = 1;
+    ioctlsocket((SOCKET)socket, FIONBIO, &is_non_blocking);
+#else
+    fcntl((int)socket, F_SETFL, fcntl((int)socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    // Small messages go straight out rather than waiting to be coalesced.
+    int is_no_delay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&is_no_delay, sizeof(is_no_delay));
+}
+
+net_socket_t net_listen(uint16_t port, uint16_t *port_out)
+{
+    net_socket_t listener = (net_socket_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == NET_INVALID_SOCKET)
+        return NET_INVALID_SOCKET;
+
+    // A restarted server can take its port straight back.
+    int is_reused = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&is_reused, sizeof(is_reused));
+
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        net_close_native(listener);
+        return NET_INVALID_SOCKET;
+    }
+
+    if (port_out)
+    {
+        socklen_t length = sizeof(address);
+        getsockname(listener, (struct sockaddr *)&address, &length);
+        *port_out = ntohs(address.sin_port);
+    }
+
+    net_configure(listener);
+    return listener;
+}
+
+net_socket_t net_accept(net_socket_t listener)
+{
+    net_socket_t connection = (net_socket_t)accept(listener, 0, 0);
+    if (connection == NET_INVALID_SOCKET)
+        return NET_INVALID_SOCKET;
+
+    net_configure(connection);
+    return connection;
+}
+
+net_socket_t net_connect(const char *host, uint16_t port)
+{
+    // IPv4 only like net_listen, and unlike getaddrinfo this is there on both sides without extra feature macros.
+    struct hostent *entry = gethostbyname(host);
+    if (!entry || entry->h_addrtype != AF_INET || !entry->h_addr_list[0])
+        return NET_INVALID_SOCKET;
+
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    memcpy(&address.sin_addr, entry->h_addr_list[0], sizeof(address.sin_addr));
+
+    net_socket_t connection = (net_socket_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connection == NET_INVALID_SOCKET)
+        return NET_INVALID_SOCKET;
+
+    if (connect(connection, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        net_close_native(connection);
+        return NET_INVALID_SOCKET;
+    }
+
+    net_configure(connection);
+    return connection;
+}
+
+int64_t net_send(net_socket_t socket, const void *data, size_t size)
+{
+    int64_t sent = send(socket, data, (net_length_t)size, NET_SEND_FLAGS);
+    if (sent < 0)
+        return net_last_error_would_block() ? 0 : -1;
+
+    return sent;
+}
+
+int64_t net_recv(net_socket_t socket, void *data, size_t size)
+{
+    int64_t received = recv(socket, data, (net_length_t)size, 0);
+    if (received < 0)
+        return net_last_error_would_block() ? 0 : -1;
+
+    // An orderly shutdown from the other end.
+    if (received == 0 && size)
+        return -1;
+
+    return received;
+}
+
+void net_close(net_socket_t socket)
+{
+    if (socket != NET_INVALID_SOCKET)
+        net_close_native(socket);
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Winsock's SOCKET or a file descriptor, wide enough for either.
+typedef intptr_t net_socket_t;
+#define NET_INVALID_SOCKET ((net_socket_t)-1)
+
+/// @brief Before any other net_ call, starts Winsock on Windows and stops a dropped connection raising SIGPIPE
+/// elsewhere. Safe to call more than once.
+void net_init(void);
+void net_shutdown(void);
+
+/// @brief Non-blocking TCP listener on every interface.
+/// @param port 0 for any free one.
+/// @param port_out The port it ended up on, can be null.
+/// @return NET_INVALID_SOCKET if it can't be bound.
+net_socket_t net_listen(uint16_t port, uint16_t *port_out);
+
+/// @return The next waiting connection, non-blocking with Nagle off, or NET_INVALID_SOCKET if there aren't any.
+net_socket_t net_accept(net_socket_t listener);
+
+/// @brief Blocks until connected, then it's non-blocking with Nagle off like an accepted one.
+/// @param host A name or an address, eg. "127.0.0.1".
+/// @return NET_INVALID_SOCKET if nothing answers.
+net_socket_t net_connect(const char *host, uint16_t port);
+
+/// @return Bytes sent, possibly fewer than size and 0 when the send buffer is full. -1 once the connection is gone.
+int64_t net_send(net_socket_t socket, const void *data, size_t size);
+
+/// @return Bytes received, 0 when there's nothing waiting. -1 once the connection is closed or broken.
+int64_t net_recv(net_socket_t socket, void *data, size_t size);
+
+void net_close(net_socket_t socket);
\ No newline at end of file
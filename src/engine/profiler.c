@@ -0,0 +1,224 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <SDL2/SDL.h>
+#include "memory.h"
+
+typedef struct profiler_event_t
+{
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} profiler_event_t;
+
+typedef struct profiler_thread_t
+{
+    uint32_t index;
+    SDL_threadID thread_id;
+    const char *name;
+
+    // Only ever written by the owning thread, read by profiler_dump.
+    SDL_atomic_t write_index;
+    profiler_event_t events[PROFILER_RING_CAPACITY];
+
+    // Open PROFILE_BEGIN zones, private to the owning thread.
+    profiler_scope_t stack[PROFILER_MAX_DEPTH];
+    uint32_t depth;
+} profiler_thread_t;
+
+static profiler_thread_t *g_profiler_threads[PROFILER_MAX_THREADS];
+static SDL_atomic_t g_profiler_num_threads;
+static uint64_t g_profiler_start_counter;
+
+static _Thread_local profiler_thread_t *tls_profiler_thread;
+static _Thread_local uint8_t tls_profiler_thread_rejected;
+
+void profiler_init()
+{
+    g_profiler_start_counter = SDL_GetPerformanceCounter();
+}
+
+void profiler_shutdown()
+{
+    int32_t num_threads = SDL_AtomicGet(&g_profiler_num_threads);
+    for (int32_t i = 0; i < num_threads && i < PROFILER_MAX_THREADS; i++)
+    {
+        mem_free(g_profiler_threads[i]);
+        g_profiler_threads[i] = 0;
+    }
+
+    SDL_AtomicSet(&g_profiler_num_threads, 0);
+    tls_profiler_thread = 0;
+}
+
+static profiler_thread_t *profiler_get_thread()
+{
+    if (tls_profiler_thread || tls_profiler_thread_rejected)
+        return tls_profiler_thread;
+
+    uint32_t index = (uint32_t)SDL_AtomicAdd(&g_profiler_num_threads, 1);
+    if (index >= PROFILER_MAX_THREADS)
+    {
+        // Out of slots, this thread just won't show up in the trace.
+        tls_profiler_thread_rejected = 1;
+        return 0;
+    }
+
+    profiler_thread_t *thread = mem_calloc(MEMORY_TAG_PROFILER, 1, sizeof(profiler_thread_t));
+    assert(thread);
+    thread->index = index;
+    thread->thread_id = SDL_ThreadID();
+
+    SDL_MemoryBarrierRelease();
+    g_profiler_threads[index] = thread;
+
+    tls_profiler_thread = thread;
+    return thread;
+}
+
+void profiler_set_thread_name(const char *name)
+{
+    profiler_thread_t *thread = profiler_get_thread();
+    if (thread)
+        thread->name = name;
+}
+
+void profiler_record(const char *name, uint64_t start, uint64_t end)
+{
+    profiler_thread_t *thread = profiler_get_thread();
+    if (!thread)
+        return;
+
+    uint32_t index = (uint32_t)SDL_AtomicGet(&thread->write_index);
+    profiler_event_t *event = &thread->events[index & (PROFILER_RING_CAPACITY - 1)];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+
+    // Publish the event before the index so the reader never sees a half written slot.
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&thread->write_index, (int)(index + 1));
+}
+
+void profiler_zone_begin(const char *name)
+{
+    profiler_thread_t *thread = profiler_get_thread();
+    if (!thread)
+        return;
+
+    assert(thread->depth < PROFILER_MAX_DEPTH);
+    thread->stack[thread->depth++] = (profiler_scope_t){name, SDL_GetPerformanceCounter()};
+}
+
+void profiler_zone_end()
+{
+    uint64_t end = SDL_GetPerformanceCounter();
+
+    profiler_thread_t *thread = profiler_get_thread();
+    if (!thread)
+        return;
+
+    assert(thread->depth > 0);
+    profiler_scope_t *scope = &thread->stack[--thread->depth];
+    profiler_record(scope->name, scope->start, end);
+}
+
+profiler_scope_t profiler_scope_begin(const char *name)
+{
+    return (profiler_scope_t){name, SDL_GetPerformanceCounter()};
+}
+
+void profiler_scope_end(profiler_scope_t *scope)
+{
+    profiler_record(scope->name, scope->start, SDL_GetPerformanceCounter());
+}
+
+static void profiler_write_json_string(FILE *file, const char *str)
+{
+    fputc('"', file);
+    for (; str && *str; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', file);
+        fputc(*str, file);
+    }
+    fputc('"', file);
+}
+
+uint8_t profiler_dump(const char *path)
+{
+    PROFILE_FUNCTION();
+
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        printf("Profiler: failed to open %s for writing\n", path);
+        return 0;
+    }
+
+    const double counter_to_us = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    profiler_event_t *events = mem_alloc(MEMORY_TAG_PROFILER, sizeof(profiler_event_t) * PROFILER_RING_CAPACITY);
+    assert(events);
+
+    fputs("{\"traceEvents\":[\n", file);
+
+    size_t num_written = 0;
+    int32_t num_threads = SDL_AtomicGet(&g_profiler_num_threads);
+    for (int32_t thread_index = 0; thread_index < num_threads && thread_index < PROFILER_MAX_THREADS; thread_index++)
+    {
+        profiler_thread_t *thread = g_profiler_threads[thread_index];
+        SDL_MemoryBarrierAcquire();
+        if (!thread)
+            continue;
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", num_written++ ? ",\n" : "", thread->index);
+        if (thread->name)
+        {
+            profiler_write_json_string(file, thread->name);
+        }
+        else
+        {
+            fprintf(file, "\"thread %lu\"", (unsigned long)thread->thread_id);
+        }
+        fputs("}}", file);
+
+        uint32_t end = (uint32_t)SDL_AtomicGet(&thread->write_index);
+        SDL_MemoryBarrierAcquire();
+        uint32_t count = end < PROFILER_RING_CAPACITY ? end : PROFILER_RING_CAPACITY;
+        uint32_t begin = end - count;
+
+        for (uint32_t i = begin; i != end; i++)
+        {
+            events[i - begin] = thread->events[i & (PROFILER_RING_CAPACITY - 1)];
+        }
+
+        // The owning thread keeps writing while we copy, anything it may have lapped in the meantime is garbage.
+        SDL_MemoryBarrierAcquire();
+        uint32_t end_after_copy = (uint32_t)SDL_AtomicGet(&thread->write_index);
+        uint32_t num_overwritten = end_after_copy - end;
+        uint32_t first_valid = num_overwritten < count ? num_overwritten : count;
+
+        for (uint32_t i = first_valid; i < count; i++)
+        {
+            profiler_event_t *event = &events[i];
+            double ts = (double)(event->start - g_profiler_start_counter) * counter_to_us;
+            double dur = (double)(event->end - event->start) * counter_to_us;
+
+            fputs(",\n{\"name\":", file);
+            profiler_write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->index, ts, dur);
+        }
+    }
+
+    fputs("\n]}\n", file);
+    fclose(file);
+    mem_free(events);
+
+    printf("Profiler: wrote %s\n", path);
+    return 1;
+}
+
+#endif
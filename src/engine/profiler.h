@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+// CPU zone profiler.
+// Zones are timed with SDL_GetPerformanceCounter and written as complete events into a ring buffer owned by the
+// calling thread, so recording never takes a lock. profiler_dump writes everything still in the rings as Chrome
+// trace_event JSON (open in chrome://tracing or ui.perfetto.dev).
+// Everything below compiles to nothing unless PROFILER_ENABLED is set in settings.h.
+
+#define PROFILER_MAX_THREADS 32
+// Must be a power of two.
+#define PROFILER_RING_CAPACITY (1 << 16)
+#define PROFILER_MAX_DEPTH 64
+
+typedef struct profiler_scope_t
+{
+    const char *name;
+    uint64_t start;
+} profiler_scope_t;
+
+#if PROFILER_ENABLED
+
+void profiler_init();
+void profiler_shutdown();
+
+/// @brief Name the calling thread in the trace, registers the thread if it hasn't recorded anything yet.
+void profiler_set_thread_name(const char *name);
+
+/// @brief Record an already timed zone on the calling thread.
+/// @param name Must outlive the profiler, string literals or __func__.
+void profiler_record(const char *name, uint64_t start, uint64_t end);
+
+void profiler_zone_begin(const char *name);
+void profiler_zone_end();
+
+profiler_scope_t profiler_scope_begin(const char *name);
+void profiler_scope_end(profiler_scope_t *scope);
+
+/// @brief Write every zone currently held in the thread rings to a Chrome trace_event JSON file.
+/// @return 1 on success.
+uint8_t profiler_dump(const char *path);
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+// Times the rest of the enclosing block, including early returns.
+#define PROFILE_SCOPE(name) \
+    profiler_scope_t PROFILER_CONCAT(_profiler_scope_, __LINE__) __attribute__((cleanup(profiler_scope_end))) = profiler_scope_begin(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+#define PROFILE_BEGIN(name) profiler_zone_begin(name)
+#define PROFILE_END() profiler_zone_end()
+
+#else
+
+#define profiler_init() ((void)0)
+#define profiler_shutdown() ((void)0)
+#define profiler_set_thread_name(name) ((void)0)
+#define profiler_record(name, start, end) ((void)0)
+static inline uint8_t profiler_dump(const char *path)
+{
+    return 0;
+}
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+
+#endif
@@ -0,0 +1,162 @@
+#include "render_target.h"
+#include "engine.h"
+#include "profiler.h"
+#include "memory.h"
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+render_target_t render_target_new(int width, int height)
+{
+    render_target_t result = {0};
+    result.width = width;
+    result.height = height;
+
+    GL_CALL(glCreateTextures(GL_TEXTURE_2D, 1, &result.color_texture));
+    GL_CALL(glTextureStorage2D(result.color_texture, 1, GL_RGBA8, width, height));
+
+    GL_CALL(glCreateRenderbuffers(1, &result.depth_renderbuffer));
+    GL_CALL(glNamedRenderbufferStorage(result.depth_renderbuffer, GL_DEPTH24_STENCIL8, width, height));
+
+    GL_CALL(glCreateFramebuffers(1, &result.framebuffer));
+    GL_CALL(glNamedFramebufferTexture(result.framebuffer, GL_COLOR_ATTACHMENT0, result.color_texture, 0));
+    GL_CALL(glNamedFramebufferRenderbuffer(result.framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, result.depth_renderbuffer));
+
+    GLenum status = glCheckNamedFramebufferStatus(result.framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("Render target %dx%d incomplete: 0x%x\n", width, height, status);
+        assert(0);
+    }
+
+    glObjectLabel(GL_FRAMEBUFFER, result.framebuffer, -1, "Framebuffer(render_target_t)");
+
+    // RGBA8 colour and a packed 32 bit depth stencil.
+    memory_gpu_alloc(MEMORY_TAG_RENDER, memory_texture_bytes(width, height, 8, 0));
+
+    return result;
+}
+
+void render_target_free(render_target_t *self)
+{
+    glDeleteFramebuffers(1, &self->framebuffer);
+    glDeleteRenderbuffers(1, &self->depth_renderbuffer);
+    glDeleteTextures(1, &self->color_texture);
+    memory_gpu_free(MEMORY_TAG_RENDER, memory_texture_bytes(self->width, self->height, 8, 0));
+
+    *self = (render_target_t){0};
+}
+
+void render_target_bind(const render_target_t *self)
+{
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, self->framebuffer));
+    GL_CALL(glViewport(0, 0, self->width, self->height));
+}
+
+void render_target_unbind(int window_width, int window_height)
+{
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GL_CALL(glViewport(0, 0, window_width, window_height));
+}
+
+frame_capture_t frame_capture_new(int width, int height, const char *dump_dir)
+{
+    frame_capture_t result = {0};
+    result.width = width;
+    result.height = height;
+    result.dump_dir = dump_dir;
+
+    GL_CALL(glCreateBuffers(2, result.pixel_buffers));
+    for (size_t i = 0; i < 2; i++)
+    {
+        GL_CALL(glNamedBufferStorage(result.pixel_buffers[i], (GLsizeiptr)width * height * 4, 0, GL_MAP_READ_BIT));
+        result.pending_frame[i] = -1;
+    }
+    memory_gpu_alloc(MEMORY_TAG_RENDER, memory_texture_bytes(width, height, 4 * 2, 0));
+
+    return result;
+}
+
+static void frame_capture_write(frame_capture_t *self, uint32_t buffer_index)
+{
+    int64_t frame_number = self->pending_frame[buffer_index];
+    if (frame_number < 0)
+        return;
+
+    PROFILE_FUNCTION();
+
+    self->pending_frame[buffer_index] = -1;
+
+    const uint8_t *pixels = glMapNamedBuffer(self->pixel_buffers[buffer_index], GL_READ_ONLY);
+    if (!pixels)
+    {
+        printf("Frame capture: failed to map pixel buffer for frame %lld\n", (long long)frame_number);
+        return;
+    }
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/frame_%06lld.ppm", self->dump_dir, (long long)frame_number);
+
+    FILE *file = fopen(path, "wb");
+    if (file)
+    {
+        fprintf(file, "P6\n%d %d\n255\n", self->width, self->height);
+
+        // GL rows start at the bottom, PPM at the top, and PPM has no alpha.
+        arena_t *arena = frame_arena_get();
+        size_t mark = arena_mark(arena);
+        uint8_t *row = ARENA_ALLOC_ARRAY(arena, uint8_t, (size_t)self->width * 3);
+        for (int y = self->height - 1; y >= 0; y--)
+        {
+            const uint8_t *src = pixels + (size_t)y * self->width * 4;
+            for (int x = 0; x < self->width; x++)
+            {
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            fwrite(row, 1, (size_t)self->width * 3, file);
+        }
+        arena_rewind(arena, mark);
+
+        fclose(file);
+        self->num_written++;
+    }
+    else
+    {
+        printf("Frame capture: failed to open %s\n", path);
+    }
+
+    glUnmapNamedBuffer(self->pixel_buffers[buffer_index]);
+}
+
+void frame_capture_free(frame_capture_t *self)
+{
+    // Oldest first so files come out in order.
+    frame_capture_write(self, self->next_buffer);
+    frame_capture_write(self, !self->next_buffer);
+
+    glDeleteBuffers(2, self->pixel_buffers);
+    memory_gpu_free(MEMORY_TAG_RENDER, memory_texture_bytes(self->width, self->height, 4 * 2, 0));
+
+    *self = (frame_capture_t){0};
+}
+
+void frame_capture_capture(frame_capture_t *self, uint64_t frame_number)
+{
+    PROFILE_FUNCTION();
+
+    uint32_t buffer_index = self->next_buffer;
+    self->next_buffer = !self->next_buffer;
+
+    // Whatever was in this buffer was read two captures ago and is long finished, write it out before reusing it.
+    frame_capture_write(self, buffer_index);
+
+    GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, self->pixel_buffers[buffer_index]));
+    GL_CALL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GL_CALL(glReadPixels(0, 0, self->width, self->height, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+    GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    self->pending_frame[buffer_index] = (int64_t)frame_number;
+}
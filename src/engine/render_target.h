@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include <glad/glad.h>
+
+/// @brief Offscreen framebuffer with an RGBA8 colour texture and a depth renderbuffer.
+typedef struct render_target_t
+{
+    GLuint framebuffer;
+    GLuint color_texture;
+    GLuint depth_renderbuffer;
+    int width, height;
+} render_target_t;
+
+render_target_t render_target_new(int width, int height);
+void render_target_free(render_target_t *self);
+
+/// @brief Bind for drawing and set the viewport to cover it.
+void render_target_bind(const render_target_t *self);
+
+/// @brief Back to the window's default framebuffer.
+void render_target_unbind(int window_width, int window_height);
+
+// Reads back frames from a render target without stalling: each capture starts an async glReadPixels into one of two
+// pixel pack buffers, the buffer is only mapped when it comes round again two captures later.
+typedef struct frame_capture_t
+{
+    GLuint pixel_buffers[2];
+    // Frame number each buffer holds, -1 when it holds nothing.
+    int64_t pending_frame[2];
+    uint32_t next_buffer;
+    int width, height;
+
+    const char *dump_dir;
+    uint64_t num_written;
+} frame_capture_t;
+
+frame_capture_t frame_capture_new(int width, int height, const char *dump_dir);
+
+/// @brief Writes out any capture still in flight.
+void frame_capture_free(frame_capture_t *self);
+
+/// @brief Start reading back the currently bound read framebuffer and write out the previous capture.
+void frame_capture_capture(frame_capture_t *self, uint64_t frame_number);
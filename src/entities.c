@@ -1,146 +1,172 @@
 #include "entities.h"
 #include <stdlib.h>
-#include "vendor/stb_ds.h"
+#include <string.h>
+#include "engine/memory.h"
 #include <assert.h>
-#include "engine/engine.h"
-#include "search.h"
 
-app_t *app_new()
+entity_t *entity_new(world_t *world)
 {
-    app_t *app = calloc(1, sizeof(app_t));
+    MEMORY_SCOPE(MEMORY_TAG_ENTITIES);
 
-    app->window_width = 1280;
-    app->window_height = 720;
-    strcpy_s(app->window_title, sizeof(app->window_title), "Hello, SDL2!");
-    {
-        SDL_Window *window = SDL_CreateWindow(
-            app->window_title,
-            SDL_WINDOWPOS_CENTERED,
-            SDL_WINDOWPOS_CENTERED,
-            app->window_width,
-            app->window_height,
-            SDL_WINDOW_OPENGL);
-
-        assert(window);
-        app->window = window;
-    }
-
-    SDL_ShowWindow(app->window);
-    SDL_GL_SetSwapInterval(0);
-
-    app->keyboard_state = SDL_GetKeyboardState(&app->keyboard_state_length);
-    app->last_keyboard_state = calloc(app->keyboard_state_length, sizeof(uint8_t));
-    assert(app->keyboard_state && app->last_keyboard_state);
+    entity_t *entity = mem_calloc(MEMORY_TAG_ENTITIES, 1, sizeof(entity_t));
+    // Unit scale, scale is inherited so zero would collapse everything under it.
+    entity->transform.scale[0] = entity->transform.scale[1] = 1;
+    entity->transform.is_dirty = 1;
+    arrput(world->entities, entity);
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
-
-    app->context = SDL_GL_CreateContext(app->window);
-    assert(app->context);
-
-    if (!gladLoadGLLoader(&SDL_GL_GetProcAddress))
+    return entity;
+}
+void entity_free(world_t *world, entity_t *entity)
+{
+    size_t index = -1;
+    for (size_t i = 0; i < arrlen(world->entities); i++)
     {
-        return 0;
+        if (world->entities[i] == entity)
+        {
+            index = i;
+            break;
+        }
     }
 
-    app->entities = 0;
-    app->root = entity_new(app);
+    assert(index != -1);
 
-    app->asset_cache = calloc(1, sizeof(asset_cache_t));
+    // Unlink it so nothing is left pointing at it, its children become orphans and get put under root next update.
+    entity_detach(entity);
 
-    // Malloc instead of calloc as we're going to memcpy to this address
-    app->sprite_batch = malloc(sizeof(sprite_batch_t));
-    assert(app->asset_cache && app->sprite_batch);
+    entity_t *child = entity->first_child;
+    while (child)
     {
-        GLenum shader_types[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
-        const char *batched_sprite_shader_src_path = "./shader/shader.glsl";
-        shput(app->asset_cache->sh_programs, batched_sprite_shader_src_path, create_program(batched_sprite_shader_src_path, shader_types, 2));
-        GLuint program = shget(app->asset_cache->sh_programs, batched_sprite_shader_src_path);
-
-        sprite_batch_t temp_sprite_batch = sprite_batch_new(program, 1000);
-        memcpy_s(app->sprite_batch, sizeof(sprite_batch_t), &temp_sprite_batch, sizeof(sprite_batch_t));
+        entity_t *next = child->next_sibling;
+        child->parent = 0;
+        child->prev_sibling = 0;
+        child->next_sibling = 0;
+        child = next;
     }
 
-    app->is_running = 1;
-
-    return app;
+    mem_free(entity);
+    arrdelswap(world->entities, index);
 }
 
-void app_free(app_t *app)
+void entity_free_subtree(world_t *world, entity_t *entity)
 {
-    sprite_batch_free(app->sprite_batch);
-    asset_cache_free(app->asset_cache);
-
-    for (size_t i = 0; i < arrlen(app->entities); i++)
-        entity_free(app, app->entities[i]);
+    assert(entity != world->root);
+    assert(arrlenu(world->arr_subtree_sizes) == arrlenu(world->entities));
 
-    arrfree(app->entities);
+    uint32_t first = entity->hierarchy_index;
+    assert(first < arrlenu(world->entities) && world->entities[first] == entity);
+    uint32_t count = world->arr_subtree_sizes[first];
 
-    free(app->last_keyboard_state);
+    for (uint32_t parent = world->arr_parent_indices[first]; parent != HIERARCHY_NO_PARENT; parent = world->arr_parent_indices[parent])
+        world->arr_subtree_sizes[parent] -= count;
 
-    SDL_GL_DeleteContext(app->context);
-    SDL_DestroyWindow(app->window);
-    SDL_Quit();
+    // Only the top needs unlinking, everything else in the range goes with it.
+    entity_detach(entity);
+    for (uint32_t i = first; i < first + count; i++)
+        mem_free(world->entities[i]);
 
-    free(app);
-}
+    arrdeln(world->entities, first, count);
+    arrdeln(world->arr_parent_indices, first, count);
+    arrdeln(world->arr_subtree_sizes, first, count);
 
-entity_t *entity_new(app_t *app)
-{
-    entity_t *entity = calloc(1, sizeof(entity_t));
-    arrput(app->entities, entity);
+    // Nothing after the range can have a parent inside it, it's still a valid pre-order once the indices move down.
+    for (size_t i = first; i < arrlenu(world->entities); i++)
+    {
+        if (world->arr_parent_indices[i] != HIERARCHY_NO_PARENT && world->arr_parent_indices[i] > first)
+            world->arr_parent_indices[i] -= count;
 
-    return entity;
+        world->entities[i]->hierarchy_index = (uint32_t)i;
+    }
 }
-void entity_free(app_t *app, entity_t *entity)
+
+void entity_free_all(world_t *world)
 {
-    size_t index = -1;
-    for (size_t i = 0; i < arrlen(app->entities); i++)
+    for (size_t i = 0; i < arrlenu(world->entities); i++)
     {
-        if (app->entities[i] == entity)
-        {
-            index = i;
-            break;
-        }
+        if (world->entities[i] != world->root)
+            mem_free(world->entities[i]);
     }
 
-    assert(index != -1);
-
-    free(entity);
-    arrdelswap(app->entities, index);
+    arrsetlen(world->entities, 1);
+    world->entities[0] = world->root;
+    world->root->hierarchy_index = 0;
+    world->root->first_child = world->root->last_child = 0;
+    world->root->num_children = 0;
+
+    // Root on its own is still a valid flattened hierarchy.
+    arrsetlen(world->arr_parent_indices, 1);
+    arrsetlen(world->arr_subtree_sizes, 1);
+    world->arr_parent_indices[0] = HIERARCHY_NO_PARENT;
+    world->arr_subtree_sizes[0] = 1;
 }
 
-int32_t compare_entities(const entity_t *a, const entity_t *b)
+void entity_detach(entity_t *entity)
 {
-    return a == b;
+    entity_t *parent = entity->parent;
+    if (!parent)
+        return;
+
+    if (entity->prev_sibling)
+        entity->prev_sibling->next_sibling = entity->next_sibling;
+    else
+        parent->first_child = entity->next_sibling;
+
+    if (entity->next_sibling)
+        entity->next_sibling->prev_sibling = entity->prev_sibling;
+    else
+        parent->last_child = entity->prev_sibling;
+
+    parent->num_children--;
+
+    entity->parent = 0;
+    entity->prev_sibling = 0;
+    entity->next_sibling = 0;
 }
 
 entity_t *set_parent(entity_t *entity, entity_t *parent)
 {
-    // TODO WT: Setting the parent should move the entity to the correct sorted position in app->entities.
+    // TODO WT: Setting the parent should move the entity to the correct sorted position in world->entities.
+    assert(entity != parent);
     entity_t *old_parent = entity->parent;
 
-    if (old_parent)
-    {
-        uint32_t num_children = arrlenu(old_parent->children);
-        entity_t **found = lfind(
-            entity,
-            old_parent->children,
-            &num_children,
-            sizeof(entity_t *),
-            (int (*)(const void *, const void *))compare_entities);
-
-        if (found)
-        {
-            size_t index = (found - old_parent->children) / sizeof(entity_t);
-            arrdel(old_parent->children, index);
-        }
-    }
+    entity_detach(entity);
 
-    arrput(parent->children, entity);
     entity->parent = parent;
+    entity->prev_sibling = parent->last_child;
+    if (parent->last_child)
+        parent->last_child->next_sibling = entity;
+    else
+        parent->first_child = entity;
+
+    parent->last_child = entity;
+    parent->num_children++;
+
+    entity->transform.is_global_dirty = 1;
 
     return old_parent;
 }
+
+void reparent_children(entity_t *from, entity_t *to)
+{
+    assert(from != to);
+    if (!from->first_child)
+        return;
+
+    for (entity_t *child = from->first_child; child; child = child->next_sibling)
+    {
+        child->parent = to;
+        child->transform.is_global_dirty = 1;
+    }
+
+    from->first_child->prev_sibling = to->last_child;
+    if (to->last_child)
+        to->last_child->next_sibling = from->first_child;
+    else
+        to->first_child = from->first_child;
+
+    to->last_child = from->last_child;
+    to->num_children += from->num_children;
+
+    from->first_child = 0;
+    from->last_child = 0;
+    from->num_children = 0;
+}
\ No newline at end of file
@@ -1,49 +1,27 @@
 #pragma once
 #include <stdint.h>
 
-#include <SDL2/SDL.h>
-#include <glad/glad.h>
-
-#include "asset_cache.h"
-#include "sprite_batch.h"
+#include "render_type.h"
 #include "sprite.h"
 #include "transform.h"
 #include "text.h"
 #include "camera.h"
-
-typedef struct entity_t entity_t;
-typedef struct app_t
-{
-
-    SDL_Window *window;
-    int window_width, window_height;
-    char window_title[256];
-
-    SDL_GLContext context;
-
-    int32_t keyboard_state_length;
-    const uint8_t *keyboard_state;
-    uint8_t *last_keyboard_state;
-
-    entity_t *root;
-    entity_t **entities;
-    asset_cache_t *asset_cache;
-    sprite_batch_t *sprite_batch;
-
-    uint8_t is_running;
-} app_t;
-
-typedef enum render_type_e
-{
-    RENDER_TYPE_NONE = 0,
-    RENDER_TYPE_SPRITE,
-    RENDER_TYPE_TEXT,
-} render_type_e;
+#include "world.h"
 
 typedef struct entity_t
 {
+    // Children are an intrusive doubly linked list, so attaching and detaching never searches or moves anything.
     entity_t *parent;
-    entity_t **children;
+    entity_t *first_child;
+    entity_t *last_child;
+    entity_t *next_sibling;
+    entity_t *prev_sibling;
+    uint32_t num_children;
+    // Position in world->entities as of the last update_global_system.
+    uint32_t hierarchy_index;
+
+    // Skips drawing this entity and everything under it.
+    uint8_t is_hidden;
 
     transform_t transform;
 
@@ -63,36 +41,135 @@ typedef struct entity_t
 
 } entity_t;
 
-app_t *app_new();
-void app_free(app_t *app);
-
-entity_t *entity_new(app_t *app);
-void entity_free(app_t *world, entity_t *app);
+entity_t *entity_new(world_t *world);
+void entity_free(world_t *world, entity_t *entity);
 
+/// @brief Move entity, and everything under it, to the end of parent's children. O(1).
+/// @param parent Mustn't be entity or one of its descendants.
+/// @return The previous parent.
 entity_t *set_parent(entity_t *entity, entity_t *parent);
 
+/// @brief Free entity and everything under it, a contiguous range of world->entities.
+/// Needs the flattened order to be current, ie. nothing created, freed or moved since update_global_system.
+void entity_free_subtree(world_t *world, entity_t *entity);
+
+/// @brief Free everything but root, leaving it with no children, eg. before loading a whole new world under it.
+void entity_free_all(world_t *world);
+
+/// @brief Take entity out of its parent's children, it ends up under root on the next update_global_system.
+void entity_detach(entity_t *entity);
+
+/// @brief Move every child of from, with their subtrees, to the end of to's children in one splice, eg. a whole squad
+/// changing formation. O(1) for the lists, plus updating each moved child's parent.
+/// @param to Mustn't be under from.
+void reparent_children(entity_t *from, entity_t *to);
+
 #if UNIT_TEST
 #include <assert.h>
 
 static void entities_unit_tests_set_parent()
 {
-    app_t *app = calloc(1, sizeof(app_t));
+    world_t *world = calloc(1, sizeof(world_t));
 
-    entity_t *parent = entity_new(app);
+    entity_t *parent = entity_new(world);
 
-    entity_t *child = entity_new(app);
+    entity_t *child = entity_new(world);
 
     entity_t *old_expect_0 = set_parent(child, parent);
 
-    assert(parent->children[0] == child);
+    assert(parent->first_child == child);
     assert(child->parent == parent);
     assert(old_expect_0 == 0);
+
+    // Moving the middle of three leaves the other two linked in order.
+    entity_t *other = entity_new(world);
+    entity_t *last = entity_new(world);
+    set_parent(other, parent);
+    set_parent(last, parent);
+
+    entity_t *other_parent = entity_new(world);
+    entity_t *old_expect_parent = set_parent(other, other_parent);
+    assert(old_expect_parent == parent);
+    assert(parent->num_children == 2);
+    assert(parent->first_child == child && child->next_sibling == last);
+    assert(parent->last_child == last && last->prev_sibling == child);
+    assert(other_parent->first_child == other && other->parent == other_parent);
+}
+
+static void entities_unit_tests_reparent_children()
+{
+    world_t *world = calloc(1, sizeof(world_t));
+    world->root = entity_new(world);
+
+    entity_t *from = entity_new(world);
+    entity_t *to = entity_new(world);
+    entity_t *existing = entity_new(world);
+    set_parent(existing, to);
+
+    entity_t *units[3];
+    for (size_t i = 0; i < 3; i++)
+    {
+        units[i] = entity_new(world);
+        set_parent(units[i], from);
+    }
+
+    reparent_children(from, to);
+
+    assert(from->num_children == 0 && !from->first_child && !from->last_child);
+    assert(to->num_children == 4);
+    assert(existing->next_sibling == units[0] && units[0]->prev_sibling == existing);
+    assert(to->last_child == units[2]);
+    for (size_t i = 0; i < 3; i++)
+        assert(units[i]->parent == to);
+}
+
+static void entities_unit_tests_flatten()
+{
+    world_t *world = calloc(1, sizeof(world_t));
+    world->root = entity_new(world);
+
+    // root -> a -> (b, c), root -> d, created out of order.
+    entity_t *d = entity_new(world);
+    entity_t *c = entity_new(world);
+    entity_t *a = entity_new(world);
+    entity_t *b = entity_new(world);
+    set_parent(a, world->root);
+    set_parent(b, a);
+    set_parent(c, a);
+    set_parent(d, world->root);
+
+    update_local_system(world);
+    update_global_system(world);
+
+    entity_t *expected[] = {world->root, a, b, c, d};
+    uint32_t expected_parents[] = {HIERARCHY_NO_PARENT, 0, 1, 1, 0};
+    uint32_t expected_sizes[] = {5, 3, 1, 1, 1};
+    for (size_t i = 0; i < 5; i++)
+    {
+        assert(world->entities[i] == expected[i] && expected[i]->hierarchy_index == i);
+        assert(world->arr_parent_indices[i] == expected_parents[i]);
+        assert(world->arr_subtree_sizes[i] == expected_sizes[i]);
+    }
+
+    // Children follow their parent.
+    set_pos(&a->transform, (vec3){10, 20, 0});
+    set_pos(&b->transform, (vec3){1, 2, 0});
+    update_local_system(world);
+    update_global_system(world);
+    assert(b->transform.global_matrix[3][0] == 11 && b->transform.global_matrix[3][1] == 22);
+
+    entity_free_subtree(world, a);
+    assert(arrlenu(world->entities) == 2 && world->entities[1] == d && d->hierarchy_index == 1);
+    assert(world->arr_subtree_sizes[0] == 2 && world->arr_parent_indices[1] == 0);
+    assert(world->root->num_children == 1 && world->root->first_child == d);
 }
 
 static int entities_unit_tests(void)
 {
     entities_unit_tests_set_parent();
+    entities_unit_tests_reparent_children();
+    entities_unit_tests_flatten();
 
     return 1;
 }
-#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "fog_renderer.h"
+#include <assert.h>
+#include "engine/engine.h"
+#include "engine/profiler.h"
+#include "engine/memory.h"
+#include "engine/arena.h"
+#include "app.h"
+
+fog_renderer_t fog_renderer_new(const tilemap_t *tilemap)
+{
+    fog_renderer_t result = {0};
+    result.width = tilemap->width;
+    result.height = tilemap->height;
+    result.origin[0] = tilemap->origin[0];
+    result.origin[1] = tilemap->origin[1];
+    result.inv_size[0] = 1.0f / (tilemap->width * tilemap->tile_size);
+    result.inv_size[1] = 1.0f / (tilemap->height * tilemap->tile_size);
+
+    GL_CALL(glCreateTextures(GL_TEXTURE_2D, 1, &result.texture));
+    GL_CALL(glTextureStorage2D(result.texture, 1, GL_R8, result.width, result.height));
+    result.gpu_bytes = memory_texture_bytes(result.width, result.height, 1, 0);
+    memory_gpu_alloc(MEMORY_TAG_FOV, result.gpu_bytes);
+
+    GLubyte unseen = FOV_TEXEL_UNSEEN;
+    GL_CALL(glClearTexImage(result.texture, 0, GL_RED, GL_UNSIGNED_BYTE, &unseen));
+
+    // Nearest, a tile is either seen or it isn't. Past the edge is the same as the edge.
+    GL_CALL(glCreateSamplers(1, &result.sampler));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    glObjectLabel(GL_TEXTURE, result.texture, -1, "Texture(fog_renderer_t)");
+
+    return result;
+}
+
+void fog_renderer_free(fog_renderer_t *self)
+{
+    glDeleteSamplers(1, &self->sampler);
+    glDeleteTextures(1, &self->texture);
+    memory_gpu_free(MEMORY_TAG_FOV, self->gpu_bytes);
+
+    *self = (fog_renderer_t){0};
+}
+
+void fog_renderer_upload(fog_renderer_t *self, const fov_bitset_t *visible, const fov_bitset_t *explored)
+{
+    PROFILE_FUNCTION();
+    assert(visible->width == self->width && visible->height == self->height);
+
+    arena_t *arena = frame_arena_get();
+    size_t mark = arena_mark(arena);
+    uint8_t *texels = ARENA_ALLOC_ARRAY(arena, uint8_t, (size_t)self->width * self->height);
+    fov_write_texels(visible, explored, texels);
+
+    // Rows of a byte a texel aren't 4 byte aligned unless the width happens to be.
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CALL(glTextureSubImage2D(self->texture, 0, 0, 0, self->width, self->height, GL_RED, GL_UNSIGNED_BYTE, texels));
+    self->num_uploads++;
+
+    arena_rewind(arena, mark);
+}
+
+void fog_render_system(app_t *app)
+{
+    fog_renderer_t *renderer = app->fog_renderer;
+    if (!renderer)
+        return;
+
+    PROFILE_FUNCTION();
+
+    render_snapshots_t *snapshots = &app->render_snapshots;
+    const render_snapshot_t *snapshot = render_snapshots_acquire(snapshots);
+    if (snapshot->fog_revision && snapshot->fog_revision != renderer->revision)
+    {
+        // Views of the snapshot's copy, visible then explored.
+        uint32_t words_per_row = (renderer->width + 63) / 64;
+        size_t num_words = (size_t)words_per_row * renderer->height;
+        assert(arrlenu(snapshot->arr_fog_words) == num_words * 2);
+        fov_bitset_t visible = {renderer->width, renderer->height, words_per_row, snapshot->arr_fog_words};
+        fov_bitset_t explored = {renderer->width, renderer->height, words_per_row, snapshot->arr_fog_words + num_words};
+
+        fog_renderer_upload(renderer, &visible, &explored);
+        renderer->revision = snapshot->fog_revision;
+    }
+    render_snapshots_release(snapshots);
+
+    // Program state, stays on for the tilemap and sprites until something screen space turns it off.
+    GLuint program = app->sprite_batch->program;
+    GL_CALL(glProgramUniform1i(program, glGetUniformLocation(program, "fog_enabled"), renderer->revision != 0));
+    GL_CALL(glProgramUniform2fv(program, glGetUniformLocation(program, "fog_origin"), 1, renderer->origin));
+    GL_CALL(glProgramUniform2fv(program, glGetUniformLocation(program, "fog_inv_size"), 1, renderer->inv_size));
+    GL_CALL(glBindTextureUnit(1, renderer->texture));
+    GL_CALL(glBindSampler(1, renderer->sampler));
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <glad/glad.h>
+#include "tilemap.h"
+#include "fov.h"
+
+typedef struct app_t app_t;
+
+/// @brief Fog of war over a tilemap, an R8 texel per tile the sprite shader multiplies everything world space by.
+/// Only uploaded when the field of view it shows has changed, once a turn rather than once a frame.
+typedef struct fog_renderer_t
+{
+    GLuint texture;
+    GLuint sampler;
+    uint32_t width, height;
+    size_t gpu_bytes;
+
+    // World space corner of tile 0, 0 and one over the map's world size, so the shader can go from position to texel.
+    float origin[2];
+    float inv_size[2];
+
+    // Of the field of view last uploaded, 0 for never.
+    uint32_t revision;
+    uint32_t num_uploads;
+} fog_renderer_t;
+
+/// @brief Starts out unseen everywhere.
+fog_renderer_t fog_renderer_new(const tilemap_t *tilemap);
+void fog_renderer_free(fog_renderer_t *self);
+
+/// @brief Replace the whole texture, expanded through the frame arena.
+void fog_renderer_upload(fog_renderer_t *self, const fov_bitset_t *visible, const fov_bitset_t *explored);
+
+/// @brief Upload the latest snapshot's fog if it's new and turn it on for everything drawn after, no-op without one.
+void fog_render_system(app_t *app);
\ No newline at end of file
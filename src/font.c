@@ -1,10 +1,14 @@
 #include "font.h"
 #include <stdio.h>
-#include "vendor/stb_ds.h"
+#include "engine/memory.h"
+#include "engine/arena.h"
 #include "engine/engine.h"
+#include "engine/profiler.h"
 
 font_t font_load(const char *path)
 {
+    PROFILE_FUNCTION();
+
     uint8_t *bytes;
     FILE *file = fopen(path, "r");
 
@@ -13,7 +17,7 @@ font_t font_load(const char *path)
 
     rewind(file);
 
-    bytes = calloc(num_bytes, sizeof(uint8_t));
+    bytes = mem_calloc(MEMORY_TAG_FONTS, num_bytes, sizeof(uint8_t));
 
     fread(bytes, sizeof(uint8_t), num_bytes, file);
 
@@ -33,14 +37,19 @@ const rendered_font_data_t *const get_font_render_data(font_t *font, float size)
         return &hmget(font->hm_rendered, size);
     }
 
+    PROFILE_SCOPE("bake_font");
+
     const int32_t tex_size = size * 8;
 
-    uint8_t bitmap[tex_size * tex_size];
-    stbtt_bakedchar *cdata = calloc(96, sizeof(stbtt_bakedchar));
+    // Both bitmaps are only needed until the upload, big sizes would overflow the stack as a VLA.
+    arena_t *arena = frame_arena_get();
+    size_t mark = arena_mark(arena);
+    uint8_t *bitmap = ARENA_ALLOC_ARRAY(arena, uint8_t, (size_t)tex_size * tex_size);
+    stbtt_bakedchar *cdata = mem_calloc(MEMORY_TAG_FONTS, 96, sizeof(stbtt_bakedchar));
 
     stbtt_BakeFontBitmap(font->buffer, 0, size, bitmap, tex_size, tex_size, 32, 96, cdata);
 
-    uint8_t *rgba_bitmap = calloc(tex_size * tex_size * 4, sizeof(uint8_t));
+    uint8_t *rgba_bitmap = ARENA_ALLOC_ARRAY(arena, uint8_t, (size_t)tex_size * tex_size * 4);
 
     for (size_t i = 0; i < tex_size * tex_size; i++)
     {
@@ -62,21 +71,39 @@ const rendered_font_data_t *const get_font_render_data(font_t *font, float size)
     GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
     GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 
-    free(rgba_bitmap);
+    arena_rewind(arena, mark);
+    memory_gpu_alloc(MEMORY_TAG_FONTS, memory_texture_bytes(tex_size, tex_size, 4, 1));
 
+    MEMORY_SCOPE(MEMORY_TAG_FONTS);
     hmput(font->hm_rendered, size, result);
     return &hmget(font->hm_rendered, size);
 }
 
+void font_release_render_data(font_t *font, float size)
+{
+    if (hmgeti(font->hm_rendered, size) == -1)
+        return;
+
+    rendered_font_data_t *data = &hmget(font->hm_rendered, size);
+    glDeleteTextures(1, &data->texture);
+    mem_free(data->char_data);
+    memory_gpu_free(MEMORY_TAG_FONTS, memory_texture_bytes(data->tex_size, data->tex_size, 4, 1));
+
+    (void)hmdel(font->hm_rendered, size);
+}
+
 void font_cleanup(font_t *font)
 {
     for (size_t i = 0; i < hmlen(font->hm_rendered); i++)
     {
         rendered_font_data_t *data = &font->hm_rendered[i].value;
         glDeleteTextures(1, &data->texture);
-        free(data->char_data);
+        mem_free(data->char_data);
+        memory_gpu_free(MEMORY_TAG_FONTS, memory_texture_bytes(data->tex_size, data->tex_size, 4, 1));
     }
 
-    free(font->buffer);
+    hmfree(font->hm_rendered);
+    mem_free(font->buffer);
+    font->buffer = 0;
     font->buffer_length = 0;
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
 #include <glad/glad.h>
 #include "vendor/stb_truetype.h"
 
@@ -25,4 +27,7 @@ typedef struct font_t
 font_t font_load(const char *path);
 void font_cleanup(font_t *font);
 
-const rendered_font_data_t *const get_font_render_data(font_t *font, float size);
\ No newline at end of file
+const rendered_font_data_t *const get_font_render_data(font_t *font, float size);
+
+/// @brief Delete one baked size, the next get_font_render_data for it bakes it again.
+void font_release_render_data(font_t *font, float size);
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "fov.h"
+#include <string.h>
+#include <assert.h>
+#include <SDL2/SDL.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+
+fov_bitset_t fov_bitset_new(uint32_t width, uint32_t height)
+{
+    fov_bitset_t result = {0};
+    result.width = width;
+    result.height = height;
+    result.words_per_row = (width + 63) / 64;
+
+    size_t num_words = (size_t)result.words_per_row * height;
+    result.words = mem_calloc(MEMORY_TAG_FOV, num_words, sizeof(uint64_t));
+    assert(!num_words || result.words);
+
+    return result;
+}
+
+void fov_bitset_free(fov_bitset_t *self)
+{
+    mem_free(self->words);
+
+    *self = (fov_bitset_t){0};
+}
+
+void fov_bitset_clear_words(fov_bitset_t *self, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
+{
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    uint32_t first_word = x0 >> 6, last_word = (x1 - 1) >> 6;
+    for (uint32_t y = y0; y < y1; y++)
+        memset(&self->words[(size_t)y * self->words_per_row + first_word], 0, (last_word - first_word + 1) * sizeof(uint64_t));
+}
+
+fov_t fov_new(uint32_t width, uint32_t height)
+{
+    fov_t result = {0};
+    result.width = width;
+    result.height = height;
+    result.opaque = fov_bitset_new(width, height);
+
+    return result;
+}
+
+fov_t fov_from_tilemap(const tilemap_t *tilemap, const uint8_t *opaque_tiles, uint32_t num_opaque_tiles)
+{
+    PROFILE_FUNCTION();
+
+    fov_t result = fov_new(tilemap->width, tilemap->height);
+    for (uint32_t y = 0; y < tilemap->height; y++)
+    {
+        for (uint32_t x = 0; x < tilemap->width; x++)
+        {
+            tile_id_t tile = tilemap_get(tilemap, x, y);
+            if (tile != TILE_EMPTY && tile < num_opaque_tiles && opaque_tiles[tile])
+                fov_bitset_set(&result.opaque, x, y, 1);
+        }
+    }
+
+    return result;
+}
+
+void fov_free(fov_t *self)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_viewers); i++)
+    {
+        fov_bitset_free(&self->arr_viewers[i].visible);
+        fov_bitset_free(&self->arr_viewers[i].explored);
+    }
+
+    arrfree(self->arr_viewers);
+    arrfree(self->arr_dirty);
+    fov_bitset_free(&self->opaque);
+
+    *self = (fov_t){0};
+}
+
+uint32_t fov_add_viewer(fov_t *self, int32_t x, int32_t y, uint32_t radius)
+{
+    fov_viewer_t viewer = {0};
+    viewer.x = x;
+    viewer.y = y;
+    viewer.radius = radius;
+    viewer.is_dirty = 1;
+    viewer.visible = fov_bitset_new(self->width, self->height);
+    viewer.explored = fov_bitset_new(self->width, self->height);
+
+    MEMORY_SCOPE(MEMORY_TAG_FOV);
+    arrput(self->arr_viewers, viewer);
+
+    return (uint32_t)arrlenu(self->arr_viewers) - 1;
+}
+
+void fov_move_viewer(fov_t *self, uint32_t viewer, int32_t x, int32_t y)
+{
+    assert(viewer < arrlenu(self->arr_viewers));
+
+    fov_viewer_t *state = &self->arr_viewers[viewer];
+    if (state->x == x && state->y == y)
+        return;
+
+    state->x = x;
+    state->y = y;
+    state->is_dirty = 1;
+}
+
+void fov_set_opaque(fov_t *self, uint32_t x, uint32_t y, uint8_t is_opaque)
+{
+    assert(x < self->width && y < self->height);
+    if (fov_bitset_get(&self->opaque, (int32_t)x, (int32_t)y) == !!is_opaque)
+        return;
+
+    fov_bitset_set(&self->opaque, x, y, is_opaque);
+
+    // Only a viewer whose square could reach it, the shadow it casts never leaves the radius.
+    for (size_t i = 0; i < arrlenu(self->arr_viewers); i++)
+    {
+        fov_viewer_t *viewer = &self->arr_viewers[i];
+        int32_t dx = (int32_t)x - viewer->x, dy = (int32_t)y - viewer->y;
+        if (dx < 0)
+            dx = -dx;
+        if (dy < 0)
+            dy = -dy;
+
+        if ((uint32_t)dx <= viewer->radius && (uint32_t)dy <= viewer->radius)
+            viewer->is_dirty = 1;
+    }
+}
+
+void fov_apply_edits(fov_t *self, const tilemap_edit_t *edits, size_t num_edits, const uint8_t *opaque_tiles, uint32_t num_opaque_tiles)
+{
+    for (size_t i = 0; i < num_edits; i++)
+    {
+        tile_id_t tile = edits[i].tile;
+        uint8_t is_opaque = tile != TILE_EMPTY && tile < num_opaque_tiles && opaque_tiles[tile];
+        fov_set_opaque(self, edits[i].x, edits[i].y, is_opaque);
+    }
+}
+
+// One octant of recursive shadowcasting, rows further out than row between the start and end slopes. The multipliers
+// turn octant coordinates, depth out along the row and distance across it, into map ones.
+static void fov_cast(const fov_bitset_t *opaque,
+                     fov_bitset_t *visible,
+                     int32_t origin_x,
+                     int32_t origin_y,
+                     int32_t radius,
+                     int32_t row,
+                     float start,
+                     float end,
+                     int32_t xx,
+                     int32_t xy,
+                     int32_t yx,
+                     int32_t yy)
+{
+    if (start < end)
+        return;
+
+    int32_t radius_squared = radius * radius + radius;
+    float next_start = start;
+    for (int32_t depth = row; depth <= radius; depth++)
+    {
+        uint8_t is_blocked = 0;
+        for (int32_t across = -depth; across <= 0; across++)
+        {
+            // Slopes through the tile's far and near corners.
+            float left = (across - 0.5f) / (-depth + 0.5f);
+            float right = (across + 0.5f) / (-depth - 0.5f);
+            if (start < right)
+                continue;
+            if (end > left)
+                break;
+
+            int32_t x = origin_x + across * xx - depth * xy;
+            int32_t y = origin_y + across * yx - depth * yy;
+            uint8_t is_inside = x >= 0 && y >= 0 && (uint32_t)x < visible->width && (uint32_t)y < visible->height;
+            if (is_inside && across * across + depth * depth <= radius_squared)
+                fov_bitset_set(visible, (uint32_t)x, (uint32_t)y, 1);
+
+            // Off the map blocks like a wall.
+            uint8_t is_opaque = !is_inside || fov_bitset_get(opaque, x, y);
+            if (is_blocked)
+            {
+                if (is_opaque)
+                {
+                    next_start = right;
+                    continue;
+                }
+
+                is_blocked = 0;
+                start = next_start;
+            }
+            else if (is_opaque && depth < radius)
+            {
+                // Everything past this wall in the row so far is lit, carry on beyond it then resume after it.
+                is_blocked = 1;
+                fov_cast(opaque, visible, origin_x, origin_y, radius, depth + 1, start, left, xx, xy, yx, yy);
+                next_start = right;
+            }
+        }
+
+        if (is_blocked)
+            break;
+    }
+}
+
+void fov_compute(const fov_bitset_t *opaque, int32_t x, int32_t y, uint32_t radius, fov_bitset_t *visible)
+{
+    if (x < 0 || y < 0 || (uint32_t)x >= visible->width || (uint32_t)y >= visible->height)
+        return;
+
+    fov_bitset_set(visible, (uint32_t)x, (uint32_t)y, 1);
+
+    static const int32_t octants[8][4] = {
+        {1, 0, 0, 1},
+        {0, 1, 1, 0},
+        {0, -1, 1, 0},
+        {-1, 0, 0, 1},
+        {-1, 0, 0, -1},
+        {0, -1, -1, 0},
+        {0, 1, -1, 0},
+        {1, 0, 0, -1},
+    };
+    for (size_t i = 0; i < 8; i++)
+        fov_cast(opaque, visible, x, y, (int32_t)radius, 1, 1.0f, 0.0f, octants[i][0], octants[i][1], octants[i][2], octants[i][3]);
+}
+
+static inline int64_t fov_clamp(int64_t value, int64_t min, int64_t max)
+{
+    return value < min ? min : value > max ? max : value;
+}
+
+static void fov_recompute_viewer(fov_t *self, fov_viewer_t *viewer)
+{
+    uint32_t *rect = viewer->visible_rect;
+    fov_bitset_clear_words(&viewer->visible, rect[0], rect[1], rect[2], rect[3]);
+    // Up to date even off the map, where it sees nothing.
+    viewer->is_dirty = 0;
+
+    // Clamped to the map on both sides, a viewer off the map can have its whole square past either edge.
+    int64_t r = viewer->radius;
+    rect[0] = (uint32_t)fov_clamp(viewer->x - r, 0, self->width);
+    rect[1] = (uint32_t)fov_clamp(viewer->y - r, 0, self->height);
+    rect[2] = (uint32_t)fov_clamp(viewer->x + r + 1, 0, self->width);
+    rect[3] = (uint32_t)fov_clamp(viewer->y + r + 1, 0, self->height);
+    if (rect[0] >= rect[2] || rect[1] >= rect[3])
+        return;
+
+    fov_compute(&self->opaque, viewer->x, viewer->y, viewer->radius, &viewer->visible);
+
+    // Only the words the square covers can have anything new in them.
+    uint32_t first_word = rect[0] >> 6, last_word = (rect[2] - 1) >> 6;
+    for (uint32_t y = rect[1]; y < rect[3]; y++)
+    {
+        size_t row = (size_t)y * viewer->visible.words_per_row;
+        for (uint32_t word = first_word; word <= last_word; word++)
+            viewer->explored.words[row + word] |= viewer->visible.words[row + word];
+    }
+}
+
+static void fov_update_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    fov_t *self = user_data;
+    (void)worker_index;
+
+    // Each viewer only writes its own bitsets, the opacity is only read.
+    for (uint32_t i = begin; i < end; i++)
+        fov_recompute_viewer(self, &self->arr_viewers[self->arr_dirty[i]]);
+}
+
+uint32_t fov_update(fov_t *self, job_system_t *jobs)
+{
+    PROFILE_FUNCTION();
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    MEMORY_SCOPE(MEMORY_TAG_FOV);
+    arrsetlen(self->arr_dirty, 0);
+    for (uint32_t i = 0; i < arrlenu(self->arr_viewers); i++)
+    {
+        if (self->arr_viewers[i].is_dirty)
+            arrput(self->arr_dirty, i);
+    }
+
+    uint32_t num_dirty = (uint32_t)arrlenu(self->arr_dirty);
+    if (jobs)
+        job_system_parallel_for(jobs, num_dirty, 4, fov_update_range, self);
+    else
+        fov_update_range(self, 0, num_dirty, 0);
+
+    if (num_dirty)
+        self->revision++;
+
+    self->num_recomputed = num_dirty;
+    self->update_ms = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+    return num_dirty;
+}
+
+void fov_update_all(fov_t *self, job_system_t *jobs)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_viewers); i++)
+        self->arr_viewers[i].is_dirty = 1;
+
+    fov_update(self, jobs);
+}
+
+void fov_write_texels(const fov_bitset_t *visible, const fov_bitset_t *explored, uint8_t *texels)
+{
+    PROFILE_FUNCTION();
+    assert(visible->width == explored->width && visible->height == explored->height);
+
+    for (uint32_t y = 0; y < visible->height; y++)
+    {
+        const uint64_t *visible_row = &visible->words[(size_t)y * visible->words_per_row];
+        const uint64_t *explored_row = &explored->words[(size_t)y * explored->words_per_row];
+        uint8_t *texel_row = &texels[(size_t)y * visible->width];
+
+        for (uint32_t word = 0; word < visible->words_per_row; word++)
+        {
+            uint64_t seen = visible_row[word], known = explored_row[word];
+            uint32_t x0 = word * 64;
+            uint32_t count = visible->width - x0 < 64 ? visible->width - x0 : 64;
+
+            // Most of a big map is one or the other, fill whole words of it at once.
+            if (!known)
+            {
+                memset(&texel_row[x0], FOV_TEXEL_UNSEEN, count);
+                continue;
+            }
+
+            for (uint32_t bit = 0; bit < count; bit++)
+                texel_row[x0 + bit] = (seen >> bit) & 1 ? FOV_TEXEL_VISIBLE : (known >> bit) & 1 ? FOV_TEXEL_EXPLORED : FOV_TEXEL_UNSEEN;
+        }
+    }
+}
\ No newline at end of file
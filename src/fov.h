@@ -0,0 +1,194 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "tilemap.h"
+#include "engine/job_system.h"
+
+/// @brief A bit per tile, 64 tiles to a word and every row starting on a new word.
+typedef struct fov_bitset_t
+{
+    uint32_t width, height;
+    uint32_t words_per_row;
+    uint64_t *words;
+} fov_bitset_t;
+
+fov_bitset_t fov_bitset_new(uint32_t width, uint32_t height);
+void fov_bitset_free(fov_bitset_t *self);
+
+/// @brief Clear every bit in [x0, x1) by [y0, y1), a whole word at a time so bits either side of it can go too.
+void fov_bitset_clear_words(fov_bitset_t *self, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
+/// @return 0 outside the bitset.
+static inline uint8_t fov_bitset_get(const fov_bitset_t *self, int32_t x, int32_t y)
+{
+    if (x < 0 || y < 0 || (uint32_t)x >= self->width || (uint32_t)y >= self->height)
+        return 0;
+
+    return (self->words[(size_t)y * self->words_per_row + ((uint32_t)x >> 6)] >> (x & 63)) & 1;
+}
+
+static inline void fov_bitset_set(fov_bitset_t *self, uint32_t x, uint32_t y, uint8_t value)
+{
+    uint64_t *word = &self->words[(size_t)y * self->words_per_row + (x >> 6)];
+    uint64_t bit = 1ull << (x & 63);
+    *word = value ? *word | bit : *word & ~bit;
+}
+
+/// @brief Someone who can see, a player or anything else with its own view of the map.
+typedef struct fov_viewer_t
+{
+    int32_t x, y;
+    uint32_t radius;
+    // Needs recomputing, it moved or something changed within its radius.
+    uint8_t is_dirty;
+
+    // Tiles it can see right now and every one it has ever seen.
+    fov_bitset_t visible;
+    fov_bitset_t explored;
+    // Where visible has bits set, [x0, y0, x1, y1), so recomputing only clears that much.
+    uint32_t visible_rect[4];
+} fov_viewer_t;
+
+/// @brief Field of view for every viewer over one map, by recursive shadowcasting. Opaque tiles are seen but block
+/// everything behind them.
+typedef struct fov_t
+{
+    uint32_t width, height;
+    fov_bitset_t opaque;
+    fov_viewer_t *arr_viewers;
+
+    // Moves on whenever a viewer's bitsets change, for anything that copies them to compare against.
+    uint32_t revision;
+    // Viewers recomputed by the last fov_update and how long it took.
+    uint32_t num_recomputed;
+    float update_ms;
+
+    // Scratch, the dirty viewers handed out to the job system.
+    uint32_t *arr_dirty;
+} fov_t;
+
+/// @brief Nothing opaque and no viewers.
+fov_t fov_new(uint32_t width, uint32_t height);
+
+/// @brief Opacity of each tile looked up by its ID, TILE_EMPTY and IDs past the end of opaque_tiles are see-through.
+fov_t fov_from_tilemap(const tilemap_t *tilemap, const uint8_t *opaque_tiles, uint32_t num_opaque_tiles);
+
+void fov_free(fov_t *self);
+
+/// @return The viewer's index, stable for as long as the fov_t lives.
+uint32_t fov_add_viewer(fov_t *self, int32_t x, int32_t y, uint32_t radius);
+void fov_move_viewer(fov_t *self, uint32_t viewer, int32_t x, int32_t y);
+
+/// @brief Make a tile block sight or not, dirties every viewer close enough to see it.
+void fov_set_opaque(fov_t *self, uint32_t x, uint32_t y, uint8_t is_opaque);
+
+/// @brief Tilemap edits into the opacity, tile IDs looked up the same way as fov_from_tilemap.
+void fov_apply_edits(fov_t *self, const tilemap_edit_t *edits, size_t num_edits, const uint8_t *opaque_tiles, uint32_t num_opaque_tiles);
+
+/// @brief Recompute every dirty viewer, spread over the job system's threads.
+/// @return Viewers recomputed.
+uint32_t fov_update(fov_t *self, job_system_t *jobs);
+
+/// @brief Recompute every viewer whether it needs it or not.
+void fov_update_all(fov_t *self, job_system_t *jobs);
+
+/// @brief Set the bit of every tile visible from x, y within radius. Doesn't clear anything first.
+void fov_compute(const fov_bitset_t *opaque, int32_t x, int32_t y, uint32_t radius, fov_bitset_t *visible);
+
+// Fog texel values, how much of each tile's colour the sprite shader keeps.
+#define FOV_TEXEL_VISIBLE 255
+#define FOV_TEXEL_EXPLORED 96
+#define FOV_TEXEL_UNSEEN 0
+
+/// @brief A byte per tile for an R8 fog texture, rows tightly packed.
+/// @param texels Room for width * height.
+void fov_write_texels(const fov_bitset_t *visible, const fov_bitset_t *explored, uint8_t *texels);
+
+#if UNIT_TEST
+#include <assert.h>
+#include <string.h>
+#include "engine/memory.h"
+#include "util/rng.h"
+
+static void fov_unit_tests_shadowcasting()
+{
+    fov_t fov = fov_new(41, 41);
+    uint32_t viewer = fov_add_viewer(&fov, 20, 20, 10);
+    fov_update(&fov, 0);
+
+    // Open ground, a disc.
+    fov_bitset_t *visible = &fov.arr_viewers[viewer].visible;
+    assert(fov_bitset_get(visible, 20, 20) && fov_bitset_get(visible, 30, 20) && fov_bitset_get(visible, 27, 27));
+    assert(!fov_bitset_get(visible, 31, 20) && !fov_bitset_get(visible, 29, 29));
+
+    // A wall three tiles east, it's seen but what's behind it isn't. Moving away doesn't need it rebuilt.
+    for (uint32_t y = 18; y <= 22; y++)
+        fov_set_opaque(&fov, 23, y, 1);
+    assert(fov.arr_viewers[viewer].is_dirty);
+    fov_update(&fov, 0);
+    assert(fov_bitset_get(visible, 23, 20) && !fov_bitset_get(visible, 24, 20) && !fov_bitset_get(visible, 28, 20));
+    assert(fov_bitset_get(visible, 17, 20));
+
+    // Moving clears what it could see before, but not what it has explored.
+    fov_move_viewer(&fov, viewer, 10, 20);
+    fov_update(&fov, 0);
+    assert(!fov_bitset_get(visible, 30, 20) && fov_bitset_get(&fov.arr_viewers[viewer].explored, 30, 20));
+
+    // Too far away to matter.
+    fov_set_opaque(&fov, 40, 40, 1);
+    assert(!fov.arr_viewers[viewer].is_dirty);
+    assert(fov_update(&fov, 0) == 0);
+
+    // Off the map it sees nothing, once.
+    fov_move_viewer(&fov, viewer, -100, 20);
+    assert(fov_update(&fov, 0) == 1 && !fov_bitset_get(visible, 0, 20));
+    assert(fov_update(&fov, 0) == 0);
+
+    fov_free(&fov);
+}
+
+static void fov_unit_tests_parallel_matches_serial()
+{
+    // Viewers computed together on the job system see exactly what they would on their own.
+    fov_t fov = fov_new(200, 150);
+    uint64_t rng = 3;
+    for (uint32_t y = 0; y < fov.height; y++)
+    {
+        for (uint32_t x = 0; x < fov.width; x++)
+        {
+            if (rng_next(&rng) % 100 < 15)
+                fov_set_opaque(&fov, x, y, 1);
+        }
+    }
+
+    for (uint32_t i = 0; i < 40; i++)
+    {
+        uint64_t r = rng_next(&rng);
+        fov_add_viewer(&fov, (int32_t)(r % fov.width), (int32_t)((r >> 32) % fov.height), 12);
+    }
+
+    job_system_t *jobs = job_system_new(3);
+    assert(fov_update(&fov, jobs) == 40);
+
+    fov_bitset_t expected = fov_bitset_new(fov.width, fov.height);
+    for (uint32_t i = 0; i < arrlenu(fov.arr_viewers); i++)
+    {
+        const fov_viewer_t *viewer = &fov.arr_viewers[i];
+        memset(expected.words, 0, (size_t)expected.words_per_row * expected.height * sizeof(uint64_t));
+        fov_compute(&fov.opaque, viewer->x, viewer->y, viewer->radius, &expected);
+        assert(memcmp(expected.words, viewer->visible.words, (size_t)expected.words_per_row * expected.height * sizeof(uint64_t)) == 0);
+    }
+
+    fov_bitset_free(&expected);
+    job_system_free(jobs);
+    fov_free(&fov);
+}
+
+static int fov_unit_tests(void)
+{
+    fov_unit_tests_shadowcasting();
+    fov_unit_tests_parallel_matches_serial();
+
+    return 1;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include "journal.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+
+typedef struct journal_reader_t
+{
+    const uint8_t *at;
+    const uint8_t *end;
+    uint8_t is_overrun;
+} journal_reader_t;
+
+static inline void journal_put(uint8_t **arr, const void *value, size_t size)
+{
+    if (!size)
+        return;
+    memcpy(arraddnptr(*arr, size), value, size);
+}
+
+static inline void journal_put_varint(uint8_t **arr, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        arrput(*arr, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    arrput(*arr, (uint8_t)value);
+}
+
+static inline void journal_get(journal_reader_t *reader, void *value, size_t size)
+{
+    if (!size)
+        return;
+    if ((size_t)(reader->end - reader->at) < size)
+    {
+        reader->is_overrun = 1;
+        memset(value, 0, size);
+        return;
+    }
+
+    memcpy(value, reader->at, size);
+    reader->at += size;
+}
+
+static inline uint64_t journal_get_varint(journal_reader_t *reader)
+{
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        if (reader->at == reader->end)
+            break;
+
+        uint8_t byte = *reader->at++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    reader->is_overrun = 1;
+    return 0;
+}
+
+// Explored tiles are mostly unexplored, so runs of empty words are stored as a count and the rest as they are.
+static void journal_put_bitset(uint8_t **arr, const fov_bitset_t *bits)
+{
+    size_t num_words = (size_t)bits->words_per_row * bits->height;
+    for (size_t i = 0; i < num_words;)
+    {
+        size_t set_start = i;
+        while (set_start < num_words && !bits->words[set_start])
+            set_start++;
+        size_t set_end = set_start;
+        while (set_end < num_words && bits->words[set_end])
+            set_end++;
+
+        journal_put_varint(arr, set_start - i);
+        journal_put_varint(arr, set_end - set_start);
+        journal_put(arr, &bits->words[set_start], (set_end - set_start) * sizeof(uint64_t));
+        i = set_end;
+    }
+}
+
+static uint8_t journal_get_bitset(journal_reader_t *reader, fov_bitset_t *bits)
+{
+    size_t num_words = (size_t)bits->words_per_row * bits->height;
+    for (size_t i = 0; i < num_words;)
+    {
+        uint64_t num_empty = journal_get_varint(reader);
+        uint64_t num_set = journal_get_varint(reader);
+        if (reader->is_overrun || !(num_empty + num_set) || num_empty > num_words - i || num_set > num_words - i - num_empty)
+            return 0;
+
+        memset(&bits->words[i], 0, num_empty * sizeof(uint64_t));
+        i += num_empty;
+        journal_get(reader, &bits->words[i], num_set * sizeof(uint64_t));
+        i += num_set;
+    }
+
+    return !reader->is_overrun;
+}
+
+// Field by field, padding never goes in.
+static void journal_put_keyframe(uint8_t **arr, const world_t *world)
+{
+    const turn_state_t *turns = world->turns;
+    uint32_t num_units = (uint32_t)arrlenu(turns->arr_units);
+    journal_put(arr, &num_units, sizeof(num_units));
+    for (uint32_t i = 0; i < num_units; i++)
+    {
+        const turn_unit_t *unit = &turns->arr_units[i];
+        journal_put(arr, &unit->x, sizeof(unit->x));
+        journal_put(arr, &unit->y, sizeof(unit->y));
+        journal_put(arr, &unit->hp, sizeof(unit->hp));
+        journal_put(arr, &unit->team, sizeof(unit->team));
+        journal_put(arr, &unit->is_ai, sizeof(unit->is_ai));
+        journal_put(arr, &unit->num_items, sizeof(unit->num_items));
+    }
+
+    const fov_t *fov = world->fov;
+    for (uint32_t i = 0; i < arrlenu(fov->arr_viewers); i++)
+    {
+        const fov_viewer_t *viewer = &fov->arr_viewers[i];
+        journal_put(arr, &viewer->x, sizeof(viewer->x));
+        journal_put(arr, &viewer->y, sizeof(viewer->y));
+        journal_put_bitset(arr, &viewer->explored);
+    }
+}
+
+static uint8_t journal_restore_keyframe(const journal_keyframe_t *keyframe, world_t *world)
+{
+    PROFILE_FUNCTION();
+
+    turn_state_t *turns = world->turns;
+    fov_t *fov = world->fov;
+    journal_reader_t reader = {keyframe->arr_data, keyframe->arr_data + arrlenu(keyframe->arr_data), 0};
+
+    // Units are all read and checked before anything changes, a bad one would be written off the map.
+    uint32_t num_units;
+    journal_get(&reader, &num_units, sizeof(num_units));
+    if (reader.is_overrun || num_units != arrlenu(turns->arr_units))
+        return 0;
+
+    turn_unit_t *units = arena_alloc(frame_arena_current(&world->sim_arena), num_units * sizeof(turn_unit_t), _Alignof(turn_unit_t));
+    for (uint32_t i = 0; i < num_units; i++)
+    {
+        turn_unit_t *unit = &units[i];
+        *unit = (turn_unit_t){0};
+        journal_get(&reader, &unit->x, sizeof(unit->x));
+        journal_get(&reader, &unit->y, sizeof(unit->y));
+        journal_get(&reader, &unit->hp, sizeof(unit->hp));
+        journal_get(&reader, &unit->team, sizeof(unit->team));
+        journal_get(&reader, &unit->is_ai, sizeof(unit->is_ai));
+        journal_get(&reader, &unit->num_items, sizeof(unit->num_items));
+        if (reader.is_overrun || unit->x < 0 || unit->y < 0 || (uint32_t)unit->x >= turns->width || (uint32_t)unit->y >= turns->height)
+            return 0;
+    }
+
+    // Every view is recomputed from where it was, which puts back what it could see.
+    for (uint32_t i = 0; i < arrlenu(fov->arr_viewers); i++)
+    {
+        int32_t x, y;
+        journal_get(&reader, &x, sizeof(x));
+        journal_get(&reader, &y, sizeof(y));
+        fov_viewer_t *viewer = &fov->arr_viewers[i];
+        if (reader.is_overrun || x < 0 || y < 0 || (uint32_t)x >= fov->width || (uint32_t)y >= fov->height || !journal_get_bitset(&reader, &viewer->explored))
+            return 0;
+
+        fov_move_viewer(fov, i, x, y);
+        viewer->is_dirty = 1;
+    }
+
+    if (reader.at != reader.end)
+        return 0;
+
+    turn_restore(turns, keyframe->turn, units, num_units);
+    fov_update(fov, world->jobs);
+    return 1;
+}
+
+journal_t journal_new(uint64_t seed, uint32_t map_size, uint32_t num_players, uint32_t keyframe_turns)
+{
+    assert(map_size && num_players && keyframe_turns);
+    return (journal_t){.seed = seed, .map_size = map_size, .num_players = num_players, .keyframe_turns = keyframe_turns};
+}
+
+void journal_free(journal_t *self)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_keyframes); i++)
+        arrfree(self->arr_keyframes[i].arr_data);
+    arrfree(self->arr_keyframes);
+    arrfree(self->arr_actions);
+    arrfree(self->arr_hashes);
+    *self = (journal_t){0};
+}
+
+world_t *journal_world_new(const journal_t *self, job_system_t *jobs, size_t arena_size)
+{
+    world_t *world = world_new(0, jobs, arena_size, self->seed);
+    world_spawn_tilemap(world, self->map_size);
+    world_spawn_players(world, self->num_players);
+    return world;
+}
+
+void journal_record_turn(journal_t *self, const world_t *world)
+{
+    const turn_state_t *turns = world->turns;
+    assert(turns->turn_number == self->num_turns && arrlenu(world->fov->arr_viewers) == self->num_players);
+
+    MEMORY_SCOPE(MEMORY_TAG_JOURNAL);
+    if (self->num_turns % self->keyframe_turns == 0)
+    {
+        journal_keyframe_t keyframe = {self->num_turns, 0};
+        journal_put_keyframe(&keyframe.arr_data, world);
+        arrput(self->arr_keyframes, keyframe);
+    }
+
+    // Players are the first units.
+    memcpy(arraddnptr(self->arr_actions, self->num_players), turns->arr_actions, self->num_players * sizeof(turn_action_t));
+}
+
+void journal_record_result(journal_t *self, const world_t *world)
+{
+    assert(world->turns->turn_number == self->num_turns + 1);
+
+    MEMORY_SCOPE(MEMORY_TAG_JOURNAL);
+    arrput(self->arr_hashes, turn_state_hash(world->turns));
+    self->num_turns++;
+}
+
+uint8_t journal_play_turn(const journal_t *self, world_t *world)
+{
+    turn_state_t *turns = world->turns;
+    uint32_t turn = turns->turn_number;
+    assert(turn < self->num_turns);
+
+    // Played outside world_step, so the step arena has to be moved on here.
+    frame_arena_begin(&world->sim_arena);
+
+    const turn_action_t *actions = &self->arr_actions[(size_t)turn * self->num_players];
+    for (uint32_t i = 0; i < self->num_players; i++)
+        turn_queue_action(turns, i, actions[i]);
+    world_resolve_turn(world);
+
+    return turn_state_hash(turns) == self->arr_hashes[turn];
+}
+
+uint8_t journal_seek(const journal_t *self, world_t *world, uint32_t turn)
+{
+    PROFILE_FUNCTION();
+    assert(turn <= self->num_turns && (turn == world->turns->turn_number || arrlenu(self->arr_keyframes)));
+
+    if (world->turns->turn_number != turn)
+    {
+        // Every turn with a result has a keyframe at or before it.
+        size_t index = turn / self->keyframe_turns;
+        if (index >= arrlenu(self->arr_keyframes))
+            index = arrlenu(self->arr_keyframes) - 1;
+        const journal_keyframe_t *keyframe = &self->arr_keyframes[index];
+
+        uint32_t current = world->turns->turn_number;
+        if ((current < keyframe->turn || current > turn) && !journal_restore_keyframe(keyframe, world))
+            return 0;
+    }
+
+    while (world->turns->turn_number < turn)
+    {
+        if (!journal_play_turn(self, world))
+            return 0;
+    }
+
+    return 1;
+}
+
+void journal_save(const journal_t *self, uint8_t **arr_out)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MEMORY_TAG_JOURNAL);
+    arrsetlen(*arr_out, 0);
+
+    journal_header_t header;
+    // Zeroed first so the padding is too, the same journal always saves the same bytes.
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.seed = self->seed;
+    header.map_size = self->map_size;
+    header.num_players = self->num_players;
+    header.keyframe_turns = self->keyframe_turns;
+    header.num_turns = self->num_turns;
+    header.num_keyframes = (uint32_t)arrlenu(self->arr_keyframes);
+    journal_put(arr_out, &header, sizeof(header));
+
+    // Moves are most of it, a target only matters for an attack.
+    for (size_t i = 0; i < (size_t)self->num_turns * self->num_players; i++)
+    {
+        const turn_action_t *action = &self->arr_actions[i];
+        journal_put(arr_out, &action->type, sizeof(action->type));
+        journal_put(arr_out, &action->dx, sizeof(action->dx));
+        journal_put(arr_out, &action->dy, sizeof(action->dy));
+        journal_put_varint(arr_out, action->target);
+    }
+
+    journal_put(arr_out, self->arr_hashes, self->num_turns * sizeof(uint64_t));
+
+    for (size_t i = 0; i < arrlenu(self->arr_keyframes); i++)
+    {
+        const journal_keyframe_t *keyframe = &self->arr_keyframes[i];
+        journal_put_varint(arr_out, arrlenu(keyframe->arr_data));
+        journal_put(arr_out, keyframe->arr_data, arrlenu(keyframe->arr_data));
+    }
+}
+
+uint8_t journal_load(journal_t *self, const uint8_t *data, size_t size)
+{
+    PROFILE_FUNCTION();
+    journal_free(self);
+
+    journal_header_t header;
+    journal_reader_t reader = {data, data + size, 0};
+    journal_get(&reader, &header, sizeof(header));
+
+    // Each action takes at least 4 bytes and each hash 8, anything claiming more than fits is refused before it's
+    // allocated.
+    uint64_t num_actions = (uint64_t)header.num_turns * header.num_players;
+    if (reader.is_overrun || memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 || header.version != JOURNAL_VERSION ||
+        !header.map_size || !header.num_players || !header.keyframe_turns ||
+        header.num_keyframes != ((uint64_t)header.num_turns + header.keyframe_turns - 1) / header.keyframe_turns ||
+        num_actions * 4 + (uint64_t)header.num_turns * 8 > size)
+        return 0;
+
+    *self = journal_new(header.seed, header.map_size, header.num_players, header.keyframe_turns);
+    self->num_turns = header.num_turns;
+
+    MEMORY_SCOPE(MEMORY_TAG_JOURNAL);
+    arrsetlen(self->arr_actions, num_actions);
+    for (size_t i = 0; i < num_actions; i++)
+    {
+        turn_action_t *action = &self->arr_actions[i];
+        *action = (turn_action_t){0};
+        journal_get(&reader, &action->type, sizeof(action->type));
+        journal_get(&reader, &action->dx, sizeof(action->dx));
+        journal_get(&reader, &action->dy, sizeof(action->dy));
+        uint64_t target = journal_get_varint(&reader);
+        action->target = (uint32_t)target;
+        if (target > UINT32_MAX)
+            reader.is_overrun = 1;
+    }
+
+    arrsetlen(self->arr_hashes, header.num_turns);
+    journal_get(&reader, self->arr_hashes, header.num_turns * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < header.num_keyframes && !reader.is_overrun; i++)
+    {
+        uint64_t num_bytes = journal_get_varint(&reader);
+        if (num_bytes > (uint64_t)(reader.end - reader.at))
+        {
+            reader.is_overrun = 1;
+            break;
+        }
+
+        journal_keyframe_t keyframe = {i * header.keyframe_turns, 0};
+        journal_put(&keyframe.arr_data, reader.at, num_bytes);
+        reader.at += num_bytes;
+        arrput(self->arr_keyframes, keyframe);
+    }
+
+    if (reader.is_overrun || reader.at != reader.end)
+    {
+        journal_free(self);
+        return 0;
+    }
+
+    return 1;
+}
+
+uint8_t journal_save_file(const journal_t *self, const char *path)
+{
+    uint8_t *arr_data = 0;
+    journal_save(self, &arr_data);
+
+    FILE *file = fopen(path, "wb");
+    size_t num_written = file ? fwrite(arr_data, 1, arrlenu(arr_data), file) : 0;
+    uint8_t is_written = file && num_written == arrlenu(arr_data);
+    if (file && fclose(file) != 0)
+        is_written = 0;
+
+    arrfree(arr_data);
+    return is_written;
+}
+
+uint8_t journal_load_file(journal_t *self, const char *path)
+{
+    journal_free(self);
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return 0;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size <= 0)
+    {
+        fclose(file);
+        return 0;
+    }
+
+    uint8_t *data = mem_alloc(MEMORY_TAG_JOURNAL, (size_t)size);
+    size_t num_read = fread(data, 1, (size_t)size, file);
+    fclose(file);
+
+    uint8_t is_loaded = num_read == (size_t)size && journal_load(self, data, (size_t)size);
+    mem_free(data);
+    return is_loaded;
+}
\ No newline at end of file
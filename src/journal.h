@@ -0,0 +1,140 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "world.h"
+
+#define JOURNAL_MAGIC "BRJN"
+// Bump whenever the layout changes, older journals are refused rather than misread. A change to the rules plays old
+// journals out differently without changing the layout, the hashes catch that.
+#define JOURNAL_VERSION 1
+
+/// @brief Starts every saved journal, little endian like everything else in it. Then each turn's player actions, the
+/// hash after each turn and the keyframes, see journal_save.
+typedef struct journal_header_t
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+    uint32_t map_size;
+    uint32_t num_players;
+    uint32_t keyframe_turns;
+    uint32_t num_turns;
+    uint32_t num_keyframes;
+} journal_header_t;
+
+/// @brief The state at the start of a turn, every unit and each player's view. Everything else about a match either
+/// never changes or follows from these.
+typedef struct journal_keyframe_t
+{
+    uint32_t turn;
+    uint8_t *arr_data;
+} journal_keyframe_t;
+
+/// @brief Everything needed to play a match again, its seed and what the players did each turn. The map and spawns come
+/// from the seed and the AI's actions from the state, so neither goes in. Tile edits would have to, and so would
+/// anything besides the players' stand-in input drawing from world->rng during a turn. Nothing in a match does either.
+typedef struct journal_t
+{
+    // What the match was made from, see journal_world_new.
+    uint64_t seed;
+    uint32_t map_size;
+    uint32_t num_players;
+
+    uint32_t keyframe_turns;
+    uint32_t num_turns;
+    // num_players a turn, player i's action on turn t is arr_actions[t * num_players + i].
+    turn_action_t *arr_actions;
+    // turn_state_hash after each turn, a replay that hashes differently has diverged.
+    uint64_t *arr_hashes;
+    // Keyframe i is from the start of turn i * keyframe_turns.
+    journal_keyframe_t *arr_keyframes;
+} journal_t;
+
+/// @param keyframe_turns Turns between keyframes, JOURNAL_KEYFRAME_TURNS unless there's a reason otherwise.
+journal_t journal_new(uint64_t seed, uint32_t map_size, uint32_t num_players, uint32_t keyframe_turns);
+void journal_free(journal_t *self);
+
+/// @brief A world at the start of the journal's first turn, the same map and spawns as the one recorded. Nothing else
+/// can have drawn from the recorded world's rng before it spawned its map and players.
+world_t *journal_world_new(const journal_t *self, job_system_t *jobs, size_t arena_size);
+
+/// @brief The players' queued actions, and a keyframe first every keyframe_turns. Called by world_resolve_turn for a
+/// world with a journal, before it resolves. Recording has to start from the world's first turn.
+void journal_record_turn(journal_t *self, const world_t *world);
+/// @brief The hash of the turn just resolved, called by world_resolve_turn after journal_record_turn.
+void journal_record_result(journal_t *self, const world_t *world);
+
+/// @brief The world's next turn with the journal's player actions instead of anyone's input, then checks its hash.
+/// @return 0 if the world has diverged from the recording.
+uint8_t journal_play_turn(const journal_t *self, world_t *world);
+
+/// @brief Put a world from journal_world_new at the start of a turn, up to num_turns for the end of the match. Restores
+/// the keyframe before it and plays the turns from there, or plays on from where the world is if that's closer.
+/// @return 0 if the world diverged on the way or a keyframe is corrupt, the world is left part way.
+uint8_t journal_seek(const journal_t *self, world_t *world, uint32_t turn);
+
+/// @param arr_out Replaced with the journal, an stb_ds array so saving again reuses its capacity.
+void journal_save(const journal_t *self, uint8_t **arr_out);
+/// @brief Replaces whatever self held.
+/// @return 0 for anything that isn't a whole journal of this version, self is then empty.
+uint8_t journal_load(journal_t *self, const uint8_t *data, size_t size);
+
+uint8_t journal_save_file(const journal_t *self, const char *path);
+uint8_t journal_load_file(journal_t *self, const char *path);
+
+#if UNIT_TEST
+#include <assert.h>
+#include <string.h>
+#include "engine/memory.h"
+
+static int journal_unit_tests(void)
+{
+    world_t *world = world_new(0, 0, 4096, 3);
+    world->turn_steps = 1;
+    world_spawn_tilemap(world, 48);
+    world_spawn_players(world, 2);
+
+    journal_t journal = journal_new(3, 48, 2, 16);
+    world->journal = &journal;
+    for (uint32_t i = 0; i < 70; i++)
+        world_step(world);
+    assert(journal.num_turns == 70 && arrlenu(journal.arr_keyframes) == 5);
+
+    // Through a saved copy, so the file format is covered too.
+    uint8_t *arr_saved = 0;
+    journal_save(&journal, &arr_saved);
+    journal_t loaded = {0};
+    assert(journal_load(&loaded, arr_saved, arrlenu(arr_saved)));
+
+    // Played from the start, every turn hashes the same as the recording.
+    world_t *replay = journal_world_new(&loaded, 0, 4096);
+    assert(journal_seek(&loaded, replay, 70));
+    assert(turn_state_hash(replay->turns) == turn_state_hash(world->turns));
+    for (uint32_t y = 0; y < 48; y++)
+    {
+        for (uint32_t x = 0; x < 48; x++)
+            assert(fov_bitset_get(&replay->fov->arr_viewers[1].explored, x, y) == fov_bitset_get(&world->fov->arr_viewers[1].explored, x, y));
+    }
+
+    // Backwards through a keyframe, and forwards again from there.
+    assert(journal_seek(&loaded, replay, 40) && replay->turns->turn_number == 40);
+    assert(turn_state_hash(replay->turns) == loaded.arr_hashes[39]);
+    assert(journal_seek(&loaded, replay, 70) && turn_state_hash(replay->turns) == turn_state_hash(world->turns));
+
+    // A turn that doesn't come out the way it was recorded stops the seek there.
+    loaded.arr_hashes[50] ^= 1;
+    assert(!journal_seek(&loaded, replay, 60) && replay->turns->turn_number == 51);
+
+    // Cut short.
+    assert(!journal_load(&loaded, arr_saved, arrlenu(arr_saved) - 1));
+    assert(loaded.num_turns == 0);
+
+    arrfree(arr_saved);
+    journal_free(&loaded);
+    journal_free(&journal);
+    world_free(replay);
+    world_free(world);
+
+    return 1;
+}
+#endif
\ No newline at end of file
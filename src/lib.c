@@ -9,12 +9,13 @@
 
 // ! Ideally engine wouldn't be included in the user code unless they're implementing extensions/plugins.
 #include "engine/engine.h"
+#include "engine/profiler.h"
 
 #include "vendor/linmath.h"
 #include "vendor/stb_image.h"
-#include "vendor/stb_ds.h"
+#include "engine/memory.h"
 
-#include "entities.h"
+#include "app.h"
 #include "sprite.h"
 #include "camera.h"
 #include "sprite_batch.h"
@@ -24,6 +25,12 @@
 
 #include "asset_cache.h"
 #include "transform.h"
+#include "stats_overlay.h"
+#include "stress_scene.h"
+#include "replication.h"
+#include "journal.h"
+#include "engine/net.h"
+#include "util/rng.h"
 
 // void rect_to_uv_matrix(vec4 rect, mat4x4 matrix)
 // {
@@ -34,26 +41,57 @@
 //     mat4x4_translate(matrix, rect[0], rect[1], 0);
 // }
 
-void startup(app_t *app)
+// Snapshots don't keep the projection, it's for whatever window the camera ends up in.
+static void camera_fit_window(app_t *app, camera_t *camera)
 {
-    asset_cache_t *asset_cache = app->asset_cache;
-    {
-        entity_t *cam_entity = entity_new(app);
-        cam_entity->has_camera = 1;
-        camera_t *camera = &cam_entity->camera;
+    camera->aspect = (float)app->window_width / (float)app->window_height;
+    camera->size = app->window_width;
 
-        set_parent(cam_entity, app->root);
+    float hw = app->window_width / 2, hh = app->window_height / 2;
+    mat4x4_ortho(camera->view_proj, -hw, hw, -hh, hh, -1, 100);
+}
 
-        // TODO WT: Consolidate all the individual components with position/scale/etc...
-        vec2 pos = {0.0f, 0.0f};
-        memcpy_s(camera->pos, sizeof(vec2), pos, sizeof(vec2));
+void spawn_camera(app_t *app)
+{
+    entity_t *cam_entity = entity_new(app->world);
+    cam_entity->has_camera = 1;
+    camera_t *camera = &cam_entity->camera;
 
-        camera->aspect = (float)app->window_width / (float)app->window_height;
-        camera->size = app->window_width;
+    set_parent(cam_entity, app->world->root);
 
-        float hw = app->window_width / 2, hh = app->window_height / 2;
-        mat4x4_ortho(camera->view_proj, -hw, hw, -hh, hh, -1, 100);
-    }
+    // TODO WT: Consolidate all the individual components with position/scale/etc...
+    vec2 pos = {0.0f, 0.0f};
+    memcpy(camera->pos, pos, sizeof(vec2));
+
+    camera_fit_window(app, camera);
+}
+
+/// @brief The world's map, and a renderer for it.
+void spawn_tilemap(app_t *app, uint32_t size)
+{
+    world_spawn_tilemap(app->world, size);
+
+    app->tilemap_renderer = mem_alloc(MEMORY_TAG_TILEMAP, sizeof(tilemap_renderer_t));
+    *app->tilemap_renderer = tilemap_renderer_new(app->sprite_batch->program, app->world->tilemap, WORLD_NUM_TILE_TYPES);
+    app->tilemap_renderer->gpu_timer = &app->gpu_timer;
+}
+
+/// @brief The world's players, and fog for what the first one sees. Needs the map first.
+void spawn_players(app_t *app, uint32_t num_players)
+{
+    world_spawn_players(app->world, num_players);
+
+    app->fog_renderer = mem_alloc(MEMORY_TAG_FOV, sizeof(fog_renderer_t));
+    *app->fog_renderer = fog_renderer_new(app->world->tilemap);
+}
+
+void startup(app_t *app)
+{
+    asset_cache_t *asset_cache = app->asset_cache;
+    // Its own sequence from the world's seed, so the scene doesn't change what the world draws for the match.
+    uint64_t scene_rng = rng_hash(app->world->seed);
+
+    spawn_camera(app);
 
     {
         const size_t num_sprites = 500;
@@ -62,52 +100,60 @@ void startup(app_t *app)
         const vec2 min_max_scale = {10, 100};
 
         const char *banana_texture_path = "./images/fruit_banana.png";
-        shput(asset_cache->sh_textures, banana_texture_path, texture_new_load_entire(banana_texture_path));
+        {
+            MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+            shput(asset_cache->sh_textures, banana_texture_path, texture_new_load_entire(banana_texture_path));
+        }
         texture_t *tex = &shget(asset_cache->sh_textures, banana_texture_path);
 
         for (size_t i = 0; i < num_sprites; i++)
         {
-            entity_t *e = entity_new(app);
-            set_parent(e, app->root);
+            entity_t *e = entity_new(app->world);
+            set_parent(e, app->world->root);
 
             e->render_type = RENDER_TYPE_SPRITE;
-            float scale = min_max_scale[0] + ((float)rand() / RAND_MAX) * min_max_scale[1];
+            float scale = min_max_scale[0] + rng_float(&scene_rng) * min_max_scale[1];
             vec3 pos = {
-                ((float)rand() / RAND_MAX) * size[0] - size[0] / 2,
-                ((float)rand() / RAND_MAX) * size[1] - size[1] / 2,
+                rng_float(&scene_rng) * size[0] - size[0] / 2,
+                rng_float(&scene_rng) * size[1] - size[1] / 2,
                 1.0,
             };
-            memcpy_s(e->transform.pos, sizeof(vec3), pos, sizeof(vec3));
+            memcpy(e->transform.pos, pos, sizeof(vec3));
             vec2 scaleVec = {scale, scale};
-            memcpy_s(e->transform.scale, sizeof(vec2), scaleVec, sizeof(vec2));
+            memcpy(e->transform.scale, scaleVec, sizeof(vec2));
 
             vec2 anchor = {0.5, 0.5};
-            memcpy_s(e->sprite.anchor, sizeof(vec2), anchor, sizeof(vec2));
+            memcpy(e->sprite.anchor, anchor, sizeof(vec2));
             vec4 color = {
-                0xff / 255.0, // ((float)rand() / RAND_MAX),
-                0,            // ((float)rand() / RAND_MAX),
-                0xff / 255.0, // ((float)rand() / RAND_MAX),
+                0xff / 255.0, // rng_float(&scene_rng),
+                0,            // rng_float(&scene_rng),
+                0xff / 255.0, // rng_float(&scene_rng),
                 1.0,
             };
-            memcpy_s(e->sprite.color, sizeof(vec4), color, sizeof(vec4));
+            memcpy(e->sprite.color, color, sizeof(vec4));
             e->sprite.texture = tex;
         }
     }
     {
         const char *constan_font_path = "./font/CONSTAN.TTF";
-        shput(asset_cache->sh_fonts, constan_font_path, font_load(constan_font_path));
+        // The stats overlay may have loaded it already.
+        if (shgeti(asset_cache->sh_fonts, constan_font_path) == -1)
+        {
+            MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+            shput(asset_cache->sh_fonts, constan_font_path, font_load(constan_font_path));
+        }
 
         font_t *constan = &shget(asset_cache->sh_fonts, constan_font_path);
 
-        entity_t *e = entity_new(app);
+        entity_t *e = entity_new(app->world);
         e->render_type = RENDER_TYPE_TEXT;
         text_t *hello_text = &e->text;
-        set_parent(e, app->root);
+        set_parent(e, app->world->root);
 
         hello_text->font = constan;
         hello_text->font_size = 30;
         vec2 scale = {1.0, 1.0};
-        memcpy_s(e->transform.scale, sizeof(vec2), scale, sizeof(vec2));
+        memcpy(e->transform.scale, scale, sizeof(vec2));
 
         hello_text->text = "Hello, World!";
     }
@@ -123,78 +169,371 @@ void startup(app_t *app)
 
         for (size_t i = 0; i < num_sprites; i++)
         {
-            entity_t *e = entity_new(app);
-            set_parent(e, app->root);
+            entity_t *e = entity_new(app->world);
+            set_parent(e, app->world->root);
             e->render_type = RENDER_TYPE_SPRITE;
 
-            float scale = min_max_scale[0] + ((float)rand() / RAND_MAX) * min_max_scale[1];
+            float scale = min_max_scale[0] + rng_float(&scene_rng) * min_max_scale[1];
             vec3 pos = {
-                ((float)rand() / RAND_MAX) * size[0] - size[0] / 2,
-                ((float)rand() / RAND_MAX) * size[1] - size[1] / 2,
+                rng_float(&scene_rng) * size[0] - size[0] / 2,
+                rng_float(&scene_rng) * size[1] - size[1] / 2,
                 1.0,
             };
-            memcpy_s(e->transform.pos, sizeof(vec3), pos, sizeof(vec3));
+            memcpy(e->transform.pos, pos, sizeof(vec3));
             vec2 scaleVec = {scale, scale};
-            memcpy_s(e->transform.scale, sizeof(vec2), scaleVec, sizeof(vec2));
+            memcpy(e->transform.scale, scaleVec, sizeof(vec2));
 
             vec2 anchor = {0.5, 0.5};
-            memcpy_s(e->sprite.anchor, sizeof(vec2), anchor, sizeof(vec2));
+            memcpy(e->sprite.anchor, anchor, sizeof(vec2));
             vec4 color = {
-                1.0, //((float)rand() / RAND_MAX),
-                1.0, //((float)rand() / RAND_MAX),
-                1.0, //((float)rand() / RAND_MAX),
+                1.0, //rng_float(&scene_rng),
+                1.0, //rng_float(&scene_rng),
+                1.0, //rng_float(&scene_rng),
                 0.8,
             };
-            memcpy_s(e->sprite.color, sizeof(vec4), color, sizeof(vec4));
+            memcpy(e->sprite.color, color, sizeof(vec4));
             e->sprite.texture = tex;
         }
     }
 }
 
-void tick(app_t *app)
+/// @brief Whatever the server has sent since the last step instead of simulating.
+static void spectate_system(app_t *app)
+{
+    replication_client_t *client = app->replication_client;
+    uint32_t num_keyframes = client->num_keyframes;
+    replication_client_poll(client, app->world);
+
+    // Systems' scratch from the step before stays readable through this one.
+    frame_arena_begin(&app->world->sim_arena);
+    update_local_system(app->world);
+    update_global_system(app->world);
+
+    // A new world doesn't move in from wherever the old one's entities were, and is drawn with this window's camera.
+    if (client->num_keyframes != num_keyframes)
+    {
+        entity_t **entities = app->world->entities;
+        for (size_t i = 0; i < arrlenu(entities); i++)
+        {
+            if (entities[i]->has_camera)
+                camera_fit_window(app, &entities[i]->camera);
+        }
+        store_previous_transform_system(app->world);
+    }
+}
+
+/// @brief One fixed simulation step, runs SIM_TICK_RATE times a second regardless of frame rate.
+void tick(app_t *app, float delta_seconds)
+{
+    PROFILE_FUNCTION();
+
+    store_previous_transform_system(app->world);
+
+    if (app->replication_client)
+    {
+        spectate_system(app);
+        return;
+    }
+
+    if (app->stress_scene)
+        stress_scene_tick(app->stress_scene, app, delta_seconds);
+
+    world_step(app->world);
+
+    // A turn for spectators every REPLICATION_STEPS, anything still queued goes out on the steps in between.
+    if (app->replication_server)
+    {
+        if (app->fixed_step.num_steps % REPLICATION_STEPS == 0)
+            replication_server_publish(app->replication_server, app->world);
+        else
+            replication_server_flush(app->replication_server);
+    }
+}
+
+void render(app_t *app)
 {
+    PROFILE_FUNCTION();
 
+    fog_render_system(app);
+    tilemap_render_system(app);
     sprite_batch_render_system(app);
 }
 
-lib_start_result lib_start()
+static float counter_to_ms(uint64_t counter)
 {
-    app_t *app = app_new();
+    return (float)((double)counter * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
 
-    startup(app);
+static void publish_snapshot(app_t *app, float tick_ms)
+{
+    render_snapshot_t *snapshot = render_snapshots_back(&app->render_snapshots);
+    render_snapshot_build(snapshot, app->world);
 
-    uint64_t last_time;
-    uint64_t this_time = SDL_GetTicks64();
+    snapshot->step_number = app->fixed_step.num_steps;
+    snapshot->sim_time = app->fixed_step.sim_time;
+    snapshot->step_counter = app->fixed_step.step_counter;
+    snapshot->tick_ms = tick_ms;
 
-    uint64_t elapsed_times[60];
-    size_t curr_frame_time = 0;
-    while (app->is_running)
+    render_snapshots_publish(&app->render_snapshots);
+}
+
+/// @brief Run as many fixed steps as it takes to catch up with now.
+/// @return Number of steps run.
+static uint32_t simulate(app_t *app, uint64_t now)
+{
+    uint32_t num_steps = fixed_step_update(&app->fixed_step, now);
+
+    for (uint32_t i = 0; i < num_steps; i++)
     {
-        memcpy_s(
-            app->last_keyboard_state,
-            sizeof(uint8_t) * app->keyboard_state_length,
-            app->keyboard_state,
-            sizeof(uint8_t) * app->keyboard_state_length);
+        uint64_t tick_start = SDL_GetPerformanceCounter();
+        tick(app, app->fixed_step.step_seconds);
+        fixed_step_end_step(&app->fixed_step);
+        uint64_t tick_end = SDL_GetPerformanceCounter();
+
+        // Only the last step of a catch up burst is ever drawn.
+        if (i == num_steps - 1)
+            publish_snapshot(app, counter_to_ms(tick_end - tick_start));
+    }
 
-        last_time = this_time;
-        this_time = SDL_GetTicks64();
+    return num_steps;
+}
+
+static int simulation_thread(void *data)
+{
+    app_t *app = data;
+    profiler_set_thread_name("simulation");
+    frame_arena_bind(&app->world->sim_arena);
+
+    while (SDL_AtomicGet(&app->is_sim_running))
+    {
+        simulate(app, SDL_GetPerformanceCounter());
 
-        uint64_t total = 0;
-        elapsed_times[(curr_frame_time++) % 60] = this_time - last_time;
-        size_t num_frames_to_average = curr_frame_time < 60 ? curr_frame_time : 60;
-        for (size_t i = 0; i < num_frames_to_average; i++)
+        // Sleep until the next step is due rather than spinning, SDL_Delay(0) still yields.
+        uint64_t next_step = app->fixed_step.sim_time + app->fixed_step.step_counter;
+        uint64_t now = SDL_GetPerformanceCounter();
+        if (next_step > now)
+            SDL_Delay((uint32_t)((next_step - now) * 1000 / SDL_GetPerformanceFrequency()));
+    }
+
+    return 0;
+}
+
+void collect_frame_stats(app_t *app, uint64_t frame_start, uint64_t render_start, uint64_t render_end, uint64_t swap_start, uint64_t swap_end)
+{
+    frame_stats_t *stats = &app->frame_stats;
+
+    stats->frame_interval_ms = stats->frame_start ? counter_to_ms(frame_start - stats->frame_start) : 0;
+    stats->frame_start = frame_start;
+    stats->cpu_wait_ms = counter_to_ms(app->frame_pacer.last_wait_counter);
+
+    stats->cpu_frame_ms = counter_to_ms(swap_end - frame_start);
+    stats->cpu_render_ms = counter_to_ms(render_end - render_start);
+    stats->cpu_swap_ms = counter_to_ms(swap_end - swap_start);
+
+    const render_snapshot_t *snapshot = render_snapshots_acquire(&app->render_snapshots);
+    stats->num_sim_steps = (uint32_t)(snapshot->step_number - stats->sim_step_number);
+    stats->sim_step_number = snapshot->step_number;
+    stats->cpu_tick_ms = snapshot->tick_ms;
+    render_snapshots_release(&app->render_snapshots);
+
+    // Anything tracked, from either thread. Steady state this should be 0, anything per-frame belongs in an arena.
+    uint64_t total_allocs = memory_total_allocs();
+    stats->num_heap_allocs = (uint32_t)(total_allocs - stats->total_heap_allocs);
+    stats->total_heap_allocs = total_allocs;
+    stats->frame_arena_bytes = frame_arena_current(&app->frame_arena)->high_water;
+    stats->sim_arena_bytes = frame_arena_current(&app->world->sim_arena)->high_water;
+
+    stats->num_flushes = app->sprite_batch->num_flushes;
+    stats->num_quads = app->sprite_batch->num_quads_drawn;
+    app->sprite_batch->num_flushes = 0;
+    app->sprite_batch->num_quads_drawn = 0;
+
+    if (app->tilemap_renderer)
+    {
+        stats->num_tile_draws = app->tilemap_renderer->num_draw_calls;
+        stats->num_tile_chunks_built = app->tilemap_renderer->num_chunks_built;
+        stats->num_tile_quads = app->tilemap_renderer->num_quads_drawn;
+        app->tilemap_renderer->num_draw_calls = 0;
+        app->tilemap_renderer->num_chunks_built = 0;
+        app->tilemap_renderer->num_quads_drawn = 0;
+    }
+
+    gpu_timer_t *gpu_timer = &app->gpu_timer;
+    stats->gpu_frame_number = gpu_timer->resolved_frame_number;
+    stats->gpu_frame_ms = gpu_timer_get_ms(gpu_timer, "frame", 0);
+    stats->gpu_clear_ms = gpu_timer_get_ms(gpu_timer, "clear", 0);
+    stats->gpu_batch_ms = gpu_timer_get_ms(gpu_timer, "sprite_batch_flush", &stats->gpu_num_flushes);
+    stats->gpu_tilemap_ms = gpu_timer_get_ms(gpu_timer, "tilemap", 0);
+
+    stats->frame_number++;
+
+    if (app->stats_overlay.is_visible && frame_pacer_every(&app->stats_overlay.last_update, TITLE_UPDATE_INTERVAL_MS, swap_end))
+        stats_overlay_update(&app->stats_overlay, stats);
+
+    app->num_frames_since_title_update++;
+    uint64_t last_title_update = app->last_title_update;
+    if (frame_pacer_every(&app->last_title_update, TITLE_UPDATE_INTERVAL_MS, swap_end))
+    {
+        float seconds = (float)((double)(swap_end - last_title_update) / (double)SDL_GetPerformanceFrequency());
+        snprintf(app->window_title, sizeof(app->window_title), "Hello, Sprite Batching | %.1f FPS", (float)app->num_frames_since_title_update / seconds);
+        SDL_SetWindowTitle(app->window, app->window_title);
+        app->num_frames_since_title_update = 0;
+    }
+}
+
+static void print_run_report(const float *arr_frame_ms, const float *arr_gpu_frame_ms)
+{
+    frame_timings_summary_t cpu_summary = frame_timings_summarise(arr_frame_ms, arrlenu(arr_frame_ms));
+    frame_timings_print("CPU frame", &cpu_summary);
+
+    // GPU results lag a couple of frames and the first ones have nothing resolved yet.
+    if (arrlenu(arr_gpu_frame_ms))
+    {
+        frame_timings_summary_t gpu_summary = frame_timings_summarise(arr_gpu_frame_ms, arrlenu(arr_gpu_frame_ms));
+        frame_timings_print("GPU frame", &gpu_summary);
+    }
+}
+
+static void print_replication_report(const replication_stats_t *stats)
+{
+    if (!stats->num_turns)
+    {
+        printf("Replication: nobody spectated\n");
+        return;
+    }
+
+    // Keyframes aren't in the per turn average, they're sent once a spectator joins or the hierarchy changes.
+    printf("Replication: %u turns, %u keyframes averaging %.1f KB, %.1f bytes a turn in between\n",
+           stats->num_turns,
+           stats->num_keyframes,
+           stats->num_keyframes ? (double)stats->total_keyframe_bytes / stats->num_keyframes / 1024 : 0.0,
+           stats->num_deltas ? (double)stats->total_delta_bytes / stats->num_deltas : 0.0);
+    printf("Replication: %.3f ms a turn to encode, %.3f ms a turn for each spectator to send\n",
+           stats->total_encode_ms / stats->num_turns,
+           stats->num_subscriber_turns ? stats->total_send_ms / (double)stats->num_subscriber_turns : 0.0);
+}
+
+lib_start_result lib_start(int argc, char **argv)
+{
+    app_options_t options = app_options_parse(argc, argv);
+    app_t *app = app_new(&options);
+
+    stress_scene_t stress_scene = {0};
+    if (options.stress.enabled)
+    {
+        spawn_camera(app);
+        stress_scene = stress_scene_new(app, &options.stress);
+        app->stress_scene = &stress_scene;
+    }
+    else
+    {
+        startup(app);
+    }
+
+    // Sockets are only started for --serve or --spectate.
+    replication_server_t replication_server = {0};
+    replication_client_t replication_client = {0};
+    if (options.serve_port || options.spectate_host[0])
+        net_init();
+
+    if (options.spectate_host[0])
+    {
+        replication_client = replication_client_new(options.spectate_host, options.spectate_port);
+        if (replication_client.socket == NET_INVALID_SOCKET)
         {
-            total += elapsed_times[i];
+            printf("Couldn't connect to %s:%u to spectate\n", options.spectate_host, options.spectate_port);
+            stress_scene_free(&stress_scene);
+            app_free(app);
+            net_shutdown();
+            return 0;
         }
 
-        float delta_seconds = ((float)total / (float)num_frames_to_average) / 1000.0;
+        // The scene above is only there to load the same textures and fonts as the server, the first keyframe
+        // replaces it. Maps aren't sent, so neither is one made.
+        app->replication_client = &replication_client;
+        app->stress_scene = 0;
+        entity_free_all(app->world);
+    }
+    else
+    {
+        if (options.map_size)
+            spawn_tilemap(app, options.map_size);
+        if (options.map_size && options.num_players)
+            spawn_players(app, options.num_players);
+    }
 
-        sprintf(app->window_title, "Hello, Sprite Batching | %.1f FPS", 1.0 / delta_seconds);
-        SDL_SetWindowTitle(app->window, app->window_title);
+    // From the first turn, nothing has been resolved yet.
+    journal_t journal = {0};
+    if (options.record_path)
+    {
+        journal = journal_new(app->world->seed, options.map_size, options.num_players, JOURNAL_KEYFRAME_TURNS);
+        app->world->journal = &journal;
+    }
+
+    if (options.serve_port)
+    {
+        replication_server = replication_server_new(options.serve_port);
+        if (replication_server.listener == NET_INVALID_SOCKET)
+            printf("Couldn't listen for spectators on port %u\n", options.serve_port);
+        else
+            app->replication_server = &replication_server;
+    }
+
+    app->fixed_step = fixed_step_new(SIM_TICK_RATE, SIM_MAX_CATCHUP_STEPS, SDL_GetPerformanceCounter());
+
+    // Something to draw before the first step, previous == current so nothing moves yet.
+    update_local_system(app->world);
+    update_global_system(app->world);
+    store_previous_transform_system(app->world);
+    publish_snapshot(app, 0);
+
+    // Headless runs step exactly once per frame and render with no interpolation, so the same frame always comes out
+    // the same no matter how fast the machine is.
+    if (THREADED_SIMULATION && !app->is_headless)
+    {
+        SDL_AtomicSet(&app->is_sim_running, 1);
+        app->sim_thread = SDL_CreateThread(simulation_thread, "simulation", app);
+        assert(app->sim_thread);
+    }
+
+    app->last_title_update = SDL_GetPerformanceCounter();
+
+    // Frame times are kept for the report at the end of benchmark and stress runs.
+    uint8_t is_recording = options.num_frames || options.stress.enabled;
+    float *arr_frame_ms = 0;
+    float *arr_gpu_frame_ms = 0;
+    if (options.num_frames)
+    {
+        arrsetcap(arr_frame_ms, options.num_frames);
+        arrsetcap(arr_gpu_frame_ms, options.num_frames);
+    }
+
+    // Containers and caches fill up over the first frames, after that a frame that allocates is a regression.
+    const uint64_t num_warmup_frames = 60;
+    uint64_t num_allocating_frames = 0;
+    uint32_t max_frame_allocs = 0;
+
+    uint64_t run_start = SDL_GetPerformanceCounter();
+    uint64_t run_duration = (uint64_t)(options.stress.duration_seconds * (double)SDL_GetPerformanceFrequency());
+
+    while (app->is_running)
+    {
+        frame_pacer_wait(&app->frame_pacer);
+        frame_arena_begin(&app->frame_arena);
+
+        PROFILE_SCOPE("frame");
+        uint64_t frame_start = SDL_GetPerformanceCounter();
+
+        memcpy(
+            app->last_keyboard_state,
+            app->keyboard_state,
+            sizeof(uint8_t) * app->keyboard_state_length);
 
         SDL_Event event;
         while (SDL_PollEvent(&event))
         {
+            frame_pacer_handle_event(&app->frame_pacer, &event);
+
             switch (event.type)
             {
             case SDL_QUIT:
@@ -208,15 +547,131 @@ lib_start_result lib_start()
         if (app->keyboard_state[SDL_SCANCODE_ESCAPE])
             app->is_running = 0;
 
+        if (app->keyboard_state[SDL_SCANCODE_F9] && !app->last_keyboard_state[SDL_SCANCODE_F9])
+            profiler_dump("./profile.json");
+
+        if (app->keyboard_state[SDL_SCANCODE_F10] && !app->last_keyboard_state[SDL_SCANCODE_F10])
+            memory_dump(stdout);
+
+        if (app->keyboard_state[SDL_SCANCODE_F3] && !app->last_keyboard_state[SDL_SCANCODE_F3])
+        {
+            app->stats_overlay.is_visible = !app->stats_overlay.is_visible;
+            // Show something straight away rather than after the next update interval.
+            app->stats_overlay.last_update = 0;
+        }
+
+        if (app->is_headless)
+        {
+            simulate(app, app->fixed_step.sim_time + app->fixed_step.step_counter);
+            app->render_time = app->fixed_step.sim_time;
+        }
+        else
+        {
+            if (!app->sim_thread)
+                simulate(app, frame_start);
+
+            app->render_time = SDL_GetPerformanceCounter();
+        }
+
+        if (app->is_headless)
+            render_target_bind(&app->render_target);
+
+        gpu_timer_begin_frame(&app->gpu_timer);
+        uint32_t gpu_frame_zone = gpu_timer_begin(&app->gpu_timer, "frame");
+
+        uint32_t gpu_clear_zone = gpu_timer_begin(&app->gpu_timer, "clear");
         GL_CALL(glClearColor(0.5, 0.5, 0.5, 1.0));
         GL_CALL(glClearDepthf(1));
         GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+        gpu_timer_end(&app->gpu_timer, gpu_clear_zone);
+
+        uint64_t render_start = SDL_GetPerformanceCounter();
+        render(app);
+        uint64_t render_end = SDL_GetPerformanceCounter();
+
+        stats_overlay_render_system(app);
 
-        tick(app);
+        if (app->has_frame_capture && app->frame_stats.frame_number % options.dump_every == 0)
+            frame_capture_capture(&app->frame_capture, app->frame_stats.frame_number);
 
+        gpu_timer_end(&app->gpu_timer, gpu_frame_zone);
+        gpu_timer_end_frame(&app->gpu_timer);
+
+        uint64_t swap_start = SDL_GetPerformanceCounter();
+        PROFILE_BEGIN("swap");
         SDL_GL_SwapWindow(app->window);
+        PROFILE_END();
+        uint64_t swap_end = SDL_GetPerformanceCounter();
+
+        collect_frame_stats(app, frame_start, render_start, render_end, swap_start, swap_end);
+
+        if (app->frame_stats.frame_number > num_warmup_frames && app->frame_stats.num_heap_allocs)
+        {
+            num_allocating_frames++;
+            if (app->frame_stats.num_heap_allocs > max_frame_allocs)
+                max_frame_allocs = app->frame_stats.num_heap_allocs;
+        }
+
+        if (is_recording)
+        {
+            arrput(arr_frame_ms, app->frame_stats.cpu_frame_ms);
+            if (app->frame_stats.gpu_frame_number)
+                arrput(arr_gpu_frame_ms, app->frame_stats.gpu_frame_ms);
+        }
+
+        if (options.num_frames && app->frame_stats.frame_number >= options.num_frames)
+            app->is_running = 0;
+
+        if (options.stress.enabled && swap_end - run_start >= run_duration)
+            app->is_running = 0;
+    }
+
+    float run_seconds = (float)((double)(SDL_GetPerformanceCounter() - run_start) / (double)SDL_GetPerformanceFrequency());
+
+    if (app->sim_thread)
+    {
+        SDL_AtomicSet(&app->is_sim_running, 0);
+        SDL_WaitThread(app->sim_thread, 0);
+        app->sim_thread = 0;
     }
 
+    if (options.stress.enabled)
+        stress_scene_write_report(&stress_scene, app, arr_frame_ms, arrlenu(arr_frame_ms), arr_gpu_frame_ms, arrlenu(arr_gpu_frame_ms), run_seconds);
+    else if (options.num_frames)
+        print_run_report(arr_frame_ms, arr_gpu_frame_ms);
+
+    if (is_recording && app->frame_stats.frame_number > num_warmup_frames)
+        printf("Heap allocations: %llu of %llu frames after warm up allocated, at most %u in one frame\n",
+               (unsigned long long)num_allocating_frames,
+               (unsigned long long)(app->frame_stats.frame_number - num_warmup_frames),
+               max_frame_allocs);
+
+    if (app->replication_server)
+        print_replication_report(&replication_server.stats);
+    if (options.record_path)
+    {
+        if (journal_save_file(&journal, options.record_path))
+            printf("Recorded %u turns to %s\n", journal.num_turns, options.record_path);
+        else
+            printf("Couldn't write the journal to %s\n", options.record_path);
+    }
+    if (app->replication_client)
+        printf("Spectated: %u keyframes and %u deltas, %.1f KB received\n",
+               replication_client.num_keyframes,
+               replication_client.num_deltas,
+               (double)replication_client.bytes_received / 1024);
+
+    arrfree(arr_frame_ms);
+    arrfree(arr_gpu_frame_ms);
+
+    replication_server_free(&replication_server);
+    replication_client_free(&replication_client);
+    if (options.serve_port || options.spectate_host[0])
+        net_shutdown();
+
+    app->world->journal = 0;
+    journal_free(&journal);
+    stress_scene_free(&stress_scene);
     app_free(app);
 
     return 1;
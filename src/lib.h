@@ -2,15 +2,25 @@
 #include <stdint.h>
 
 typedef uint8_t lib_start_result;
-lib_start_result lib_start();
+lib_start_result lib_start(int argc, char **argv);
 
 #if UNIT_TEST
 #include "entities.h"
+#include "tilemap.h"
+#include "pathfinding.h"
+#include "path_hierarchy.h"
+#include "fov.h"
+#include "turn.h"
+#include "world_snapshot.h"
+#include "replication.h"
+#include "world_scheduler.h"
+#include "journal.h"
+#include "render_snapshot.h"
 #include "stdio.h"
 
 static int lib_unit_tests()
 {
-    int32_t success = entities_unit_tests();
+    int32_t success = entities_unit_tests() && tilemap_unit_tests() && pathfinding_unit_tests() && path_hierarchy_unit_tests() && fov_unit_tests() && turn_unit_tests() && world_snapshot_unit_tests() && replication_unit_tests() && world_scheduler_unit_tests() && journal_unit_tests() && render_snapshot_unit_tests();
 
     if (success)
     {
@@ -19,4 +29,4 @@ static int lib_unit_tests()
 
     return success;
 }
-#endif
+#endif
\ No newline at end of file
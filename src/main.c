@@ -6,7 +6,7 @@
 int main(int argc, char **argv)
 {
     puts("RUNNING UNIT TESTS\n");
-    return lib_unit_tests();
+    return lib_unit_tests() ? 0 : 1;
 }
 #else
 
@@ -14,7 +14,7 @@ int main(int argc, char **argv)
 
 int main(int argc, char **argv)
 {
-    lib_start();
+    lib_start(argc, argv);
 
     return 0;
 }
@@ -0,0 +1,215 @@
+#include "options.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void app_options_usage(const char *program)
+{
+    printf("Usage: %s [--headless] [--frames N] [--size WxH] [--dump-dir DIR] [--dump-every N]\n"
+           "    [--vertex-format compact|float] [--quads indexed|arrays] [--map N] [--players N]\n"
+           "    [--world-seed N] [--record PATH] [--serve PORT] [--spectate HOST:PORT]\n"
+           "    [--stress] [--entities N] [--depth N] [--fan-out N] [--text-ratio F] [--textures N] [--moving F]\n"
+           "    [--churn N] [--duration S] [--report PATH] [--seed N]\n",
+           program);
+    exit(1);
+}
+
+app_options_t app_options_parse(int argc, char **argv)
+{
+    app_options_t result = {0};
+    result.window_width = 1280;
+    result.window_height = 720;
+    result.compact_vertices = 1;
+    result.indexed_quads = 1;
+    result.world_seed = 1;
+
+    stress_options_t *stress = &result.stress;
+    stress->num_entities = 10000;
+    stress->depth = 1;
+    stress->fan_out = 4;
+    stress->text_ratio = 0.05f;
+    stress->num_textures = 1;
+    stress->moving_fraction = 0.1f;
+    stress->churn_per_second = 0;
+    stress->duration_seconds = 30;
+    stress->report_path = "./stress_report.json";
+    stress->seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : 0;
+
+        if (strcmp(arg, "--headless") == 0)
+        {
+            result.headless = 1;
+        }
+        else if (strcmp(arg, "--frames") == 0 && value)
+        {
+            result.num_frames = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--size") == 0 && value)
+        {
+            if (sscanf(value, "%dx%d", &result.window_width, &result.window_height) != 2 || result.window_width <= 0 || result.window_height <= 0)
+                app_options_usage(argv[0]);
+            i++;
+        }
+        else if (strcmp(arg, "--dump-dir") == 0 && value)
+        {
+            result.dump_dir = value;
+            i++;
+        }
+        else if (strcmp(arg, "--dump-every") == 0 && value)
+        {
+            result.dump_every = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--vertex-format") == 0 && value)
+        {
+            if (strcmp(value, "compact") == 0)
+                result.compact_vertices = 1;
+            else if (strcmp(value, "float") == 0)
+                result.compact_vertices = 0;
+            else
+                app_options_usage(argv[0]);
+            i++;
+        }
+        else if (strcmp(arg, "--quads") == 0 && value)
+        {
+            if (strcmp(value, "indexed") == 0)
+                result.indexed_quads = 1;
+            else if (strcmp(value, "arrays") == 0)
+                result.indexed_quads = 0;
+            else
+                app_options_usage(argv[0]);
+            i++;
+        }
+        else if (strcmp(arg, "--map") == 0 && value)
+        {
+            result.map_size = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--players") == 0 && value)
+        {
+            result.num_players = (uint32_t)strtoul(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--world-seed") == 0 && value)
+        {
+            result.world_seed = strtoull(value, 0, 10);
+            i++;
+        }
+        else if (strcmp(arg, "--record") == 0 && value)
+        {
+            result.record_path = value;
+            i++;
+        }
+        else if (strcmp(arg, "--serve") == 0 && value)
+        {
+            result.serve_port = (uint16_t)strtoul(value, 0, 10);
+            if (!result.serve_port)
+                app_options_usage(argv[0]);
+            i++;
+        }
+        else if (strcmp(arg, "--spectate") == 0 && value)
+        {
+            // The last colon, anything before it is the host.
+            const char *colon = strrchr(value, ':');
+            size_t host_length = colon ? (size_t)(colon - value) : 0;
+            if (!host_length || host_length >= sizeof(result.spectate_host))
+                app_options_usage(argv[0]);
+
+            memcpy(result.spectate_host, value, host_length);
+            result.spectate_host[host_length] = 0;
+            result.spectate_port = (uint16_t)strtoul(colon + 1, 0, 10);
+            if (!result.spectate_port)
+                app_options_usage(argv[0]);
+            i++;
+        }
+        else if (strcmp(arg, "--stress") == 0)
+        {
+            stress->enabled = 1;
+        }
+        else if (strcmp(arg, "--entities") == 0 && value)
+        {
+            stress->num_entities = (uint32_t)strtoul(value, 0, 10);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--depth") == 0 && value)
+        {
+            stress->depth = (uint32_t)strtoul(value, 0, 10);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--fan-out") == 0 && value)
+        {
+            stress->fan_out = (uint32_t)strtoul(value, 0, 10);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--text-ratio") == 0 && value)
+        {
+            stress->text_ratio = strtof(value, 0);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--textures") == 0 && value)
+        {
+            stress->num_textures = (uint32_t)strtoul(value, 0, 10);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--moving") == 0 && value)
+        {
+            stress->moving_fraction = strtof(value, 0);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--churn") == 0 && value)
+        {
+            stress->churn_per_second = strtof(value, 0);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--duration") == 0 && value)
+        {
+            stress->duration_seconds = strtof(value, 0);
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--report") == 0 && value)
+        {
+            stress->report_path = value;
+            stress->enabled = 1;
+            i++;
+        }
+        else if (strcmp(arg, "--seed") == 0 && value)
+        {
+            stress->seed = strtoull(value, 0, 10);
+            stress->enabled = 1;
+            i++;
+        }
+        else
+        {
+            app_options_usage(argv[0]);
+        }
+    }
+
+    // Nothing to record without players taking turns.
+    if (result.record_path && (!result.map_size || !result.num_players || result.spectate_host[0]))
+        app_options_usage(argv[0]);
+
+    if (stress->enabled && (stress->depth == 0 || stress->fan_out == 0 || stress->num_textures == 0 || stress->duration_seconds <= 0))
+        app_options_usage(argv[0]);
+
+    // Stress runs stop on their duration instead.
+    if (result.headless && !stress->enabled && result.num_frames == 0)
+        result.num_frames = 600;
+
+    if (result.dump_dir && result.dump_every == 0)
+        result.dump_every = 1;
+
+    return result;
+}
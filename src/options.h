@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+
+/// @brief Generated scene for capacity planning, replaces the normal startup scene.
+typedef struct stress_options_t
+{
+    uint8_t enabled;
+
+    uint32_t num_entities;
+    // Levels below root, 1 puts everything directly under root. Every entity above the bottom level has fan_out
+    // children.
+    uint32_t depth;
+    uint32_t fan_out;
+    // Fraction of entities that are text instead of sprites.
+    float text_ratio;
+    // Sprites pick randomly between this many textures, each one breaks the batch.
+    uint32_t num_textures;
+    // Fraction of entities moved every simulation step.
+    float moving_fraction;
+    // Leaves despawned and respawned per second.
+    float churn_per_second;
+
+    float duration_seconds;
+    const char *report_path;
+    uint64_t seed;
+} stress_options_t;
+
+/// @brief Command line options.
+typedef struct app_options_t
+{
+    int window_width, window_height;
+
+    // Hidden window (SDL's offscreen EGL driver unless SDL_VIDEODRIVER says otherwise), rendering to an FBO,
+    // uncapped frame rate and a timing report on exit.
+    uint8_t headless;
+    // Stop after this many frames, 0 to run until quit. Defaults to 600 when headless.
+    uint32_t num_frames;
+
+    // Write every dump_every'th frame as a PPM to this directory, 0 for no dumps.
+    const char *dump_dir;
+    uint32_t dump_every;
+
+    // Sprite batch vertices as 16 byte compact_vertex_t rather than 36 bytes of floats, see sprite_batch.h.
+    uint8_t compact_vertices;
+    // 4 vertices a sprite through a shared index buffer rather than 6 with glDrawArrays.
+    uint8_t indexed_quads;
+
+    // Side of a generated square tilemap in tiles, 0 for none.
+    uint32_t map_size;
+    // Wandering viewers on the map, each with its own field of view. The fog drawn over it is the first one's.
+    uint32_t num_players;
+    // Seeds the match and the startup scene, the same seed makes the same map and spawns.
+    uint64_t world_seed;
+    // Journal every turn of the match and write it here on exit, null for no. See src/journal.h.
+    const char *record_path;
+
+    // Stream the world to spectators on this TCP port every REPLICATION_STEPS, 0 for no server.
+    uint16_t serve_port;
+    // Draw someone else's world instead of simulating one, empty for no. Textures and fonts come from this machine.
+    char spectate_host[256];
+    uint16_t spectate_port;
+
+    stress_options_t stress;
+} app_options_t;
+
+/// @brief Parse the command line, prints usage and exits on anything it doesn't recognise.
+///   --headless            Render offscreen and print timing stats on exit.
+///   --frames N            Quit after N frames.
+///   --size WxH            Window/framebuffer size, default 1280x720.
+///   --dump-dir DIR        Write frames to DIR/frame_NNNNNN.ppm.
+///   --dump-every N        Dump every Nth frame, default 1 once --dump-dir is set.
+///   --vertex-format F     Sprite vertices, compact (default, 16 bytes) or float (36 bytes).
+///   --quads M             indexed (default, 4 vertices a sprite and glDrawElements) or arrays (6 and glDrawArrays).
+///   --map N               Generate an N by N tile map under the scene, eg. 4096.
+///   --players N           Players wandering the map, fog of war shows what the first can see. Default 0, no fog.
+///   --world-seed N        Seed for the map, the players and the startup scene, default 1.
+///   --record PATH         Write a journal of every turn to PATH on exit, play it back with the server's --replay.
+///   --serve PORT          Stream the world to spectators connecting on PORT.
+///   --spectate HOST:PORT  Watch a --serve world rather than running one.
+///   --stress              Run the generated stress scene for a fixed duration and write a report, any of the
+///                         options below imply it.
+///   --entities N          Stress entity count, default 10000.
+///   --depth N             Hierarchy levels below root, default 1.
+///   --fan-out N           Children per entity above the bottom level, default 4.
+///   --text-ratio F        Fraction of entities that are text, default 0.05.
+///   --textures N          Distinct sprite textures, default 1.
+///   --moving F            Fraction of entities moving each step, default 0.1.
+///   --churn N             Leaves despawned and spawned per second, default 0.
+///   --duration S          Seconds to run for, default 30.
+///   --report PATH         Where to write the report, default ./stress_report.json.
+///   --seed N              Scene generation seed, default 1.
+app_options_t app_options_parse(int argc, char **argv);
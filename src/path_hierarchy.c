@@ -0,0 +1,643 @@
+#include "path_hierarchy.h"
+#include <string.h>
+#include <assert.h>
+#include <SDL2/SDL.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+
+static void path_hierarchy_mark_dirty(path_hierarchy_t *self, uint32_t cluster_x, uint32_t cluster_y)
+{
+    path_cluster_t *cluster = &self->clusters[cluster_y * self->clusters_x + cluster_x];
+    if (!cluster->is_dirty)
+        self->num_dirty++;
+
+    cluster->is_dirty = 1;
+}
+
+path_hierarchy_t path_hierarchy_new(path_grid_t *grid, uint32_t cluster_size)
+{
+    PROFILE_FUNCTION();
+    assert(cluster_size);
+
+    path_hierarchy_t result = {0};
+    result.width = grid->width;
+    result.height = grid->height;
+    result.cluster_size = cluster_size;
+    result.clusters_x = (grid->width + cluster_size - 1) / cluster_size;
+    result.clusters_y = (grid->height + cluster_size - 1) / cluster_size;
+
+    uint32_t num_clusters = result.clusters_x * result.clusters_y;
+    result.clusters = mem_calloc(MEMORY_TAG_PATHFINDING, num_clusters, sizeof(path_cluster_t));
+    assert(!num_clusters || result.clusters);
+
+    for (uint32_t cy = 0; cy < result.clusters_y; cy++)
+    {
+        for (uint32_t cx = 0; cx < result.clusters_x; cx++)
+        {
+            path_cluster_t *cluster = &result.clusters[cy * result.clusters_x + cx];
+            cluster->x = cx * cluster_size;
+            cluster->y = cy * cluster_size;
+            cluster->width = grid->width - cluster->x < cluster_size ? grid->width - cluster->x : cluster_size;
+            cluster->height = grid->height - cluster->y < cluster_size ? grid->height - cluster->y : cluster_size;
+            cluster->is_right_dirty = cluster->is_bottom_dirty = 1;
+            path_hierarchy_mark_dirty(&result, cx, cy);
+        }
+    }
+
+    // Every opening along a border is either one tile apart from the next or wide enough for two entrances.
+    result.max_entrances = 4 * ((cluster_size + 1) / 2);
+    result.local = pathfinder_new(cluster_size * cluster_size);
+    result.abstract = pathfinder_new(num_clusters * result.max_entrances + 2);
+    result.start_costs = mem_alloc(MEMORY_TAG_PATHFINDING, result.max_entrances * sizeof(uint32_t));
+    result.goal_costs = mem_alloc(MEMORY_TAG_PATHFINDING, result.max_entrances * sizeof(uint32_t));
+    result.is_target = mem_alloc(MEMORY_TAG_PATHFINDING, (size_t)cluster_size * cluster_size);
+    assert(result.start_costs && result.goal_costs && result.is_target);
+
+    path_hierarchy_update(&result, grid);
+
+    return result;
+}
+
+void path_hierarchy_free(path_hierarchy_t *self)
+{
+    for (uint32_t i = 0; i < self->clusters_x * self->clusters_y; i++)
+    {
+        path_cluster_t *cluster = &self->clusters[i];
+        arrfree(cluster->arr_right);
+        arrfree(cluster->arr_bottom);
+        arrfree(cluster->arr_entrances);
+        arrfree(cluster->arr_costs);
+        arrfree(cluster->arr_segments);
+        arrfree(cluster->arr_segment_points);
+    }
+
+    mem_free(self->clusters);
+    pathfinder_free(&self->local);
+    pathfinder_free(&self->abstract);
+    mem_free(self->start_costs);
+    mem_free(self->goal_costs);
+    mem_free(self->is_target);
+    arrfree(self->arr_abstract_path);
+
+    *self = (path_hierarchy_t){0};
+}
+
+void path_hierarchy_invalidate(path_hierarchy_t *self, uint32_t x, uint32_t y)
+{
+    assert(x < self->width && y < self->height);
+
+    uint32_t cx = x / self->cluster_size, cy = y / self->cluster_size;
+    uint32_t lx = x % self->cluster_size, ly = y % self->cluster_size;
+    path_hierarchy_mark_dirty(self, cx, cy);
+
+    // On an edge, the openings along that border change and with them the neighbour's entrances.
+    if (lx == self->cluster_size - 1 && cx + 1 < self->clusters_x)
+    {
+        self->clusters[cy * self->clusters_x + cx].is_right_dirty = 1;
+        path_hierarchy_mark_dirty(self, cx + 1, cy);
+    }
+    if (lx == 0 && cx > 0)
+    {
+        self->clusters[cy * self->clusters_x + cx - 1].is_right_dirty = 1;
+        path_hierarchy_mark_dirty(self, cx - 1, cy);
+    }
+    if (ly == self->cluster_size - 1 && cy + 1 < self->clusters_y)
+    {
+        self->clusters[cy * self->clusters_x + cx].is_bottom_dirty = 1;
+        path_hierarchy_mark_dirty(self, cx, cy + 1);
+    }
+    if (ly == 0 && cy > 0)
+    {
+        self->clusters[(cy - 1) * self->clusters_x + cx].is_bottom_dirty = 1;
+        path_hierarchy_mark_dirty(self, cx, cy - 1);
+    }
+}
+
+void path_hierarchy_set_cost(path_hierarchy_t *self, path_grid_t *grid, uint32_t x, uint32_t y, uint8_t cost)
+{
+    if (path_grid_cost(grid, (int32_t)x, (int32_t)y) == cost)
+        return;
+
+    path_grid_set_cost(grid, x, y, cost);
+    path_hierarchy_invalidate(self, x, y);
+}
+
+void path_hierarchy_apply_edits(path_hierarchy_t *self,
+                                path_grid_t *grid,
+                                const tilemap_edit_t *edits,
+                                size_t num_edits,
+                                const uint8_t *tile_costs,
+                                uint32_t num_tile_costs)
+{
+    for (size_t i = 0; i < num_edits; i++)
+    {
+        tile_id_t tile = edits[i].tile;
+        uint8_t cost = tile != TILE_EMPTY && tile < num_tile_costs ? tile_costs[tile] : PATH_COST_BLOCKED;
+        path_hierarchy_set_cost(self, grid, edits[i].x, edits[i].y, cost);
+    }
+}
+
+// Openings along one border, a run of tiles open on both sides gets an entrance in its middle or one at each end.
+static void path_border_rebuild(const path_grid_t *grid, path_transition_t **arr, uint32_t first, uint32_t along, uint32_t across, uint32_t length)
+{
+    MEMORY_SCOPE(MEMORY_TAG_PATHFINDING);
+    arrsetlen(*arr, 0);
+
+    uint32_t run_start = 0;
+    for (uint32_t i = 0; i <= length; i++)
+    {
+        uint32_t tile = first + i * along;
+        uint8_t is_open = i < length && grid->costs[tile] != PATH_COST_BLOCKED && grid->costs[tile + across] != PATH_COST_BLOCKED;
+        if (is_open)
+            continue;
+
+        uint32_t run_length = i - run_start;
+        if (run_length >= PATH_WIDE_ENTRANCE)
+        {
+            uint32_t a = first + run_start * along, b = first + (i - 1) * along;
+            arrput(*arr, ((path_transition_t){a, a + across}));
+            arrput(*arr, ((path_transition_t){b, b + across}));
+        }
+        else if (run_length)
+        {
+            uint32_t a = first + (run_start + run_length / 2) * along;
+            arrput(*arr, ((path_transition_t){a, a + across}));
+        }
+
+        run_start = i + 1;
+    }
+}
+
+static uint32_t path_cluster_local(const path_hierarchy_t *self, const path_cluster_t *cluster, uint32_t tile)
+{
+    return (tile / self->width - cluster->y) * self->cluster_size + tile % self->width - cluster->x;
+}
+
+static uint32_t path_cluster_tile(const path_hierarchy_t *self, const path_cluster_t *cluster, uint32_t local)
+{
+    return (cluster->y + local / self->cluster_size) * self->width + cluster->x + local % self->cluster_size;
+}
+
+// From start without leaving the cluster, A* when there's a goal and Dijkstra over the whole cluster when there isn't.
+// Reversed, g is the cost from each tile to start instead. Dijkstra stops early once num_targets tiles flagged in
+// is_target are closed. Nodes are positions in the cluster, see path_cluster_local.
+static uint8_t path_cluster_search(path_hierarchy_t *self,
+                                   const path_grid_t *grid,
+                                   const path_cluster_t *cluster,
+                                   uint32_t start,
+                                   uint32_t goal,
+                                   uint8_t reverse,
+                                   const uint8_t *is_target,
+                                   uint32_t num_targets,
+                                   uint32_t *num_expanded)
+{
+    assert(!reverse || goal == PATH_NO_NODE);
+
+    pathfinder_t *local = &self->local;
+    pathfinder_begin(local);
+    pathfinder_open(local, path_cluster_local(self, cluster, start), PATH_NO_NODE, 0, 0);
+    uint32_t local_goal = goal == PATH_NO_NODE ? PATH_NO_NODE : path_cluster_local(self, cluster, goal);
+    int32_t goal_x = (int32_t)(goal % grid->width), goal_y = (int32_t)(goal / grid->width);
+
+    while (local->heap_size)
+    {
+        uint32_t node = pathfinder_pop(local);
+        (*num_expanded)++;
+        if (node == local_goal)
+            return 1;
+
+        if (is_target && is_target[node] && --num_targets == 0)
+            return 1;
+
+        uint32_t tile = path_cluster_tile(self, cluster, node);
+        int32_t x = (int32_t)(tile % grid->width), y = (int32_t)(tile / grid->width);
+        int32_t lx = (int32_t)(node % self->cluster_size), ly = (int32_t)(node / self->cluster_size);
+        uint32_t g = local->nodes[node].g;
+        uint8_t tile_cost = grid->costs[tile];
+
+        // The 3x3 around the tile, blocked outside the cluster. Read once, the diagonals need their neighbours too.
+        uint8_t costs[3][3];
+        for (int32_t dy = -1; dy <= 1; dy++)
+        {
+            uint8_t row_inside = ly + dy >= 0 && ly + dy < (int32_t)cluster->height;
+            for (int32_t dx = -1; dx <= 1; dx++)
+            {
+                uint8_t inside = row_inside && lx + dx >= 0 && lx + dx < (int32_t)cluster->width;
+                costs[dy + 1][dx + 1] = inside ? grid->costs[tile + (int32_t)grid->width * dy + dx] : PATH_COST_BLOCKED;
+            }
+        }
+
+        for (int32_t dy = -1; dy <= 1; dy++)
+        {
+            for (int32_t dx = -1; dx <= 1; dx++)
+            {
+                uint8_t cost = costs[dy + 1][dx + 1];
+                if ((!dx && !dy) || cost == PATH_COST_BLOCKED)
+                    continue;
+
+                uint32_t step = PATH_STRAIGHT_COST;
+                if (dx && dy)
+                {
+                    if (costs[1][dx + 1] == PATH_COST_BLOCKED || costs[dy + 1][1] == PATH_COST_BLOCKED)
+                        continue;
+                    step = PATH_DIAGONAL_COST;
+                }
+
+                // Closed, nothing to do. Saves the call for most of them, every tile is next to the way it came.
+                uint32_t neighbour = (uint32_t)((int32_t)node + (int32_t)self->cluster_size * dy + dx);
+                const path_node_t *state = &local->nodes[neighbour];
+                if (state->generation == local->generation && state->heap_index == PATH_NO_NODE)
+                    continue;
+
+                uint32_t h = local_goal == PATH_NO_NODE ? 0 : path_octile(goal_x - (x + dx), goal_y - (y + dy)) * grid->min_cost;
+                pathfinder_open(local, neighbour, node, g + step * (reverse ? tile_cost : cost), h);
+            }
+        }
+    }
+
+    return local_goal == PATH_NO_NODE;
+}
+
+// Tiles of the last search's path to goal, start excluded.
+static void path_cluster_append_path(path_hierarchy_t *self, const path_cluster_t *cluster, uint32_t start, uint32_t goal, uint32_t **arr)
+{
+    uint32_t local_start = path_cluster_local(self, cluster, start);
+    uint32_t count = 0;
+    for (uint32_t node = path_cluster_local(self, cluster, goal); node != local_start; node = self->local.nodes[node].parent)
+        count++;
+
+    uint32_t *points = arraddnptr(*arr, count);
+    for (uint32_t node = path_cluster_local(self, cluster, goal); node != local_start; node = self->local.nodes[node].parent)
+        points[--count] = path_cluster_tile(self, cluster, node);
+}
+
+static void path_cluster_add_entrance(path_cluster_t *cluster, uint32_t tile)
+{
+    // Corners can come from two borders.
+    for (size_t i = 0; i < arrlenu(cluster->arr_entrances); i++)
+    {
+        if (cluster->arr_entrances[i].tile == tile)
+            return;
+    }
+
+    arrput(cluster->arr_entrances, ((path_entrance_t){tile, {PATH_NO_NODE, PATH_NO_NODE}}));
+}
+
+static void path_cluster_rebuild(path_hierarchy_t *self, const path_grid_t *grid, uint32_t cx, uint32_t cy)
+{
+    MEMORY_SCOPE(MEMORY_TAG_PATHFINDING);
+    path_cluster_t *cluster = &self->clusters[cy * self->clusters_x + cx];
+
+    arrsetlen(cluster->arr_entrances, 0);
+    for (size_t i = 0; i < arrlenu(cluster->arr_right); i++)
+        path_cluster_add_entrance(cluster, cluster->arr_right[i].from);
+    for (size_t i = 0; i < arrlenu(cluster->arr_bottom); i++)
+        path_cluster_add_entrance(cluster, cluster->arr_bottom[i].from);
+    if (cx > 0)
+    {
+        const path_cluster_t *left = cluster - 1;
+        for (size_t i = 0; i < arrlenu(left->arr_right); i++)
+            path_cluster_add_entrance(cluster, left->arr_right[i].to);
+    }
+    if (cy > 0)
+    {
+        const path_cluster_t *above = cluster - self->clusters_x;
+        for (size_t i = 0; i < arrlenu(above->arr_bottom); i++)
+            path_cluster_add_entrance(cluster, above->arr_bottom[i].to);
+    }
+
+    uint32_t n = (uint32_t)arrlenu(cluster->arr_entrances);
+    assert(n <= self->max_entrances);
+    arrsetlen(cluster->arr_costs, n * n);
+    arrsetlen(cluster->arr_segments, n * n);
+    arrsetlen(cluster->arr_segment_points, 0);
+
+    // One Dijkstra from each entrance reaches all the others. Every path costs the same both ways when every tile does,
+    // then each search only needs the entrances after its own.
+    uint8_t is_symmetric = grid->is_uniform;
+    uint8_t *is_target = self->is_target;
+    memset(is_target, 0, (size_t)self->cluster_size * self->cluster_size);
+    for (uint32_t j = 0; j < n; j++)
+        is_target[path_cluster_local(self, cluster, cluster->arr_entrances[j].tile)] = 1;
+
+    uint32_t num_expanded = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t num_targets = n;
+        if (is_symmetric)
+        {
+            is_target[path_cluster_local(self, cluster, cluster->arr_entrances[i].tile)] = 0;
+            num_targets = n - i - 1;
+            if (!num_targets)
+                break;
+        }
+
+        path_cluster_search(self, grid, cluster, cluster->arr_entrances[i].tile, PATH_NO_NODE, 0, is_target, num_targets, &num_expanded);
+        for (uint32_t j = is_symmetric ? i + 1 : 0; j < n; j++)
+        {
+            // Unreached entrances never closed, their g could be an overestimate from before the search stopped.
+            uint32_t local = path_cluster_local(self, cluster, cluster->arr_entrances[j].tile);
+            uint32_t cost = pathfinder_g(&self->local, local);
+            if (cost != PATH_NO_NODE && self->local.nodes[local].heap_index != PATH_NO_NODE)
+                cost = PATH_NO_NODE;
+
+            cluster->arr_costs[i * n + j] = cost;
+            if (is_symmetric)
+                cluster->arr_costs[j * n + i] = cost;
+        }
+        cluster->arr_costs[i * n + i] = 0;
+    }
+
+    for (uint32_t i = 0; i < n * n; i++)
+        cluster->arr_segments[i] = PATH_NO_NODE;
+
+    cluster->is_dirty = 0;
+    cluster->needs_relink = 1;
+    if (cx > 0)
+        cluster[-1].needs_relink = 1;
+    if (cx + 1 < self->clusters_x)
+        cluster[1].needs_relink = 1;
+    if (cy > 0)
+        cluster[-(int32_t)self->clusters_x].needs_relink = 1;
+    if (cy + 1 < self->clusters_y)
+        cluster[self->clusters_x].needs_relink = 1;
+}
+
+static void path_cluster_link(path_hierarchy_t *self, uint32_t cluster_index, uint32_t tile, uint32_t other_index, uint32_t other_tile)
+{
+    const path_cluster_t *other = &self->clusters[other_index];
+    uint32_t other_entrance = PATH_NO_NODE;
+    for (uint32_t i = 0; i < arrlenu(other->arr_entrances); i++)
+    {
+        if (other->arr_entrances[i].tile == other_tile)
+        {
+            other_entrance = i;
+            break;
+        }
+    }
+    assert(other_entrance != PATH_NO_NODE);
+
+    path_cluster_t *cluster = &self->clusters[cluster_index];
+    for (size_t i = 0; i < arrlenu(cluster->arr_entrances); i++)
+    {
+        path_entrance_t *entrance = &cluster->arr_entrances[i];
+        if (entrance->tile != tile)
+            continue;
+
+        entrance->links[entrance->links[0] != PATH_NO_NODE] = other_index * self->max_entrances + other_entrance;
+        return;
+    }
+    assert(0);
+}
+
+static void path_cluster_relink(path_hierarchy_t *self, uint32_t cx, uint32_t cy)
+{
+    uint32_t index = cy * self->clusters_x + cx;
+    path_cluster_t *cluster = &self->clusters[index];
+    for (size_t i = 0; i < arrlenu(cluster->arr_entrances); i++)
+        cluster->arr_entrances[i].links[0] = cluster->arr_entrances[i].links[1] = PATH_NO_NODE;
+
+    for (size_t i = 0; i < arrlenu(cluster->arr_right); i++)
+        path_cluster_link(self, index, cluster->arr_right[i].from, index + 1, cluster->arr_right[i].to);
+    for (size_t i = 0; i < arrlenu(cluster->arr_bottom); i++)
+        path_cluster_link(self, index, cluster->arr_bottom[i].from, index + self->clusters_x, cluster->arr_bottom[i].to);
+    if (cx > 0)
+    {
+        const path_cluster_t *left = cluster - 1;
+        for (size_t i = 0; i < arrlenu(left->arr_right); i++)
+            path_cluster_link(self, index, left->arr_right[i].to, index - 1, left->arr_right[i].from);
+    }
+    if (cy > 0)
+    {
+        const path_cluster_t *above = cluster - self->clusters_x;
+        for (size_t i = 0; i < arrlenu(above->arr_bottom); i++)
+            path_cluster_link(self, index, above->arr_bottom[i].to, index - self->clusters_x, above->arr_bottom[i].from);
+    }
+
+    cluster->needs_relink = 0;
+}
+
+void path_hierarchy_update(path_hierarchy_t *self, path_grid_t *grid)
+{
+    assert(grid->width == self->width && grid->height == self->height);
+
+    if (!self->num_dirty)
+        return;
+
+    PROFILE_FUNCTION();
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    // Borders first, entrances come from both sides of them.
+    for (uint32_t cy = 0; cy < self->clusters_y; cy++)
+    {
+        for (uint32_t cx = 0; cx < self->clusters_x; cx++)
+        {
+            path_cluster_t *cluster = &self->clusters[cy * self->clusters_x + cx];
+            uint32_t corner = cluster->y * self->width + cluster->x;
+            if (cluster->is_right_dirty && cx + 1 < self->clusters_x)
+                path_border_rebuild(grid, &cluster->arr_right, corner + cluster->width - 1, self->width, 1, cluster->height);
+            if (cluster->is_bottom_dirty && cy + 1 < self->clusters_y)
+                path_border_rebuild(grid, &cluster->arr_bottom, corner + (cluster->height - 1) * self->width, 1, self->width, cluster->width);
+
+            cluster->is_right_dirty = cluster->is_bottom_dirty = 0;
+        }
+    }
+
+    for (uint32_t cy = 0; cy < self->clusters_y; cy++)
+    {
+        for (uint32_t cx = 0; cx < self->clusters_x; cx++)
+        {
+            if (self->clusters[cy * self->clusters_x + cx].is_dirty)
+                path_cluster_rebuild(self, grid, cx, cy);
+        }
+    }
+
+    for (uint32_t cy = 0; cy < self->clusters_y; cy++)
+    {
+        for (uint32_t cx = 0; cx < self->clusters_x; cx++)
+        {
+            if (self->clusters[cy * self->clusters_x + cx].needs_relink)
+                path_cluster_relink(self, cx, cy);
+        }
+    }
+
+    float ms = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    self->stats.num_rebuilds++;
+    self->stats.num_clusters_rebuilt += self->num_dirty;
+    self->stats.last_rebuild_ms = ms;
+    self->stats.total_rebuild_ms += ms;
+    self->num_dirty = 0;
+}
+
+// Tiles from entrance i to j through the cluster, searched for the first time and copied after that.
+static void path_cluster_append_segment(path_hierarchy_t *self, const path_grid_t *grid, path_cluster_t *cluster, uint32_t i, uint32_t j, uint32_t **arr)
+{
+    uint32_t n = (uint32_t)arrlenu(cluster->arr_entrances);
+    uint32_t *segment = &cluster->arr_segments[i * n + j];
+    if (*segment == PATH_NO_NODE)
+    {
+        self->stats.num_segment_misses++;
+
+        uint32_t start = cluster->arr_entrances[i].tile, goal = cluster->arr_entrances[j].tile;
+        uint32_t num_expanded = 0;
+        uint8_t found = path_cluster_search(self, grid, cluster, start, goal, 0, 0, 0, &num_expanded);
+        assert(found);
+        (void)found;
+
+        *segment = (uint32_t)arrlenu(cluster->arr_segment_points);
+        arrput(cluster->arr_segment_points, 0);
+        path_cluster_append_path(self, cluster, start, goal, &cluster->arr_segment_points);
+        cluster->arr_segment_points[*segment] = (uint32_t)arrlenu(cluster->arr_segment_points) - *segment - 1;
+    }
+    else
+    {
+        self->stats.num_segment_hits++;
+    }
+
+    uint32_t length = cluster->arr_segment_points[*segment];
+    memcpy(arraddnptr(*arr, length), &cluster->arr_segment_points[*segment + 1], length * sizeof(uint32_t));
+}
+
+static uint32_t path_hierarchy_h(const path_grid_t *grid, const path_query_t *query, uint32_t tile)
+{
+    int32_t dx = (int32_t)query->goal_x - (int32_t)(tile % grid->width);
+    int32_t dy = (int32_t)query->goal_y - (int32_t)(tile / grid->width);
+
+    return path_octile(dx, dy) * grid->min_cost;
+}
+
+uint8_t path_hierarchy_find(path_hierarchy_t *self, path_grid_t *grid, const path_query_t *query, path_t *out)
+{
+    path_hierarchy_update(self, grid);
+
+    MEMORY_SCOPE(MEMORY_TAG_PATHFINDING);
+    arrsetlen(out->arr_points, 0);
+    out->found = 0;
+    out->cost = 0;
+    out->num_expanded = 0;
+    self->stats.num_queries++;
+
+    if (path_grid_cost(grid, (int32_t)query->start_x, (int32_t)query->start_y) == PATH_COST_BLOCKED ||
+        path_grid_cost(grid, (int32_t)query->goal_x, (int32_t)query->goal_y) == PATH_COST_BLOCKED)
+        return 0;
+
+    uint32_t start = query->start_y * grid->width + query->start_x;
+    uint32_t goal = query->goal_y * grid->width + query->goal_x;
+    if (!grid->components_dirty && grid->components[start] != grid->components[goal])
+        return 0;
+
+    uint32_t start_index = (query->start_y / self->cluster_size) * self->clusters_x + query->start_x / self->cluster_size;
+    uint32_t goal_index = (query->goal_y / self->cluster_size) * self->clusters_x + query->goal_x / self->cluster_size;
+    path_cluster_t *start_cluster = &self->clusters[start_index];
+    path_cluster_t *goal_cluster = &self->clusters[goal_index];
+
+    if (start_index == goal_index && path_cluster_search(self, grid, start_cluster, start, goal, 0, 0, 0, &out->num_expanded))
+    {
+        self->stats.num_local_queries++;
+        out->found = 1;
+        out->cost = self->local.nodes[path_cluster_local(self, start_cluster, goal)].g;
+        arrput(out->arr_points, start);
+        path_cluster_append_path(self, start_cluster, start, goal, &out->arr_points);
+        return 1;
+    }
+
+    // Start and goal join the abstract graph through what they can reach in their own clusters.
+    path_cluster_search(self, grid, start_cluster, start, PATH_NO_NODE, 0, 0, 0, &out->num_expanded);
+    for (uint32_t i = 0; i < arrlenu(start_cluster->arr_entrances); i++)
+        self->start_costs[i] = pathfinder_g(&self->local, path_cluster_local(self, start_cluster, start_cluster->arr_entrances[i].tile));
+
+    path_cluster_search(self, grid, goal_cluster, goal, PATH_NO_NODE, 1, 0, 0, &out->num_expanded);
+    for (uint32_t i = 0; i < arrlenu(goal_cluster->arr_entrances); i++)
+        self->goal_costs[i] = pathfinder_g(&self->local, path_cluster_local(self, goal_cluster, goal_cluster->arr_entrances[i].tile));
+
+    pathfinder_t *abstract = &self->abstract;
+    uint32_t start_node = self->clusters_x * self->clusters_y * self->max_entrances;
+    uint32_t goal_node = start_node + 1;
+
+    pathfinder_begin(abstract);
+    pathfinder_open(abstract, start_node, PATH_NO_NODE, 0, path_hierarchy_h(grid, query, start));
+    uint8_t found = 0;
+    while (abstract->heap_size)
+    {
+        uint32_t node = pathfinder_pop(abstract);
+        out->num_expanded++;
+        uint32_t g = abstract->nodes[node].g;
+
+        if (node == goal_node)
+        {
+            found = 1;
+            break;
+        }
+
+        if (node == start_node)
+        {
+            for (uint32_t i = 0; i < arrlenu(start_cluster->arr_entrances); i++)
+            {
+                if (self->start_costs[i] != PATH_NO_NODE)
+                    pathfinder_open(abstract, start_index * self->max_entrances + i, node, g + self->start_costs[i], path_hierarchy_h(grid, query, start_cluster->arr_entrances[i].tile));
+            }
+            continue;
+        }
+
+        uint32_t cluster_index = node / self->max_entrances, i = node % self->max_entrances;
+        const path_cluster_t *cluster = &self->clusters[cluster_index];
+        const path_entrance_t *entrance = &cluster->arr_entrances[i];
+        uint32_t n = (uint32_t)arrlenu(cluster->arr_entrances);
+
+        if (cluster_index == goal_index && self->goal_costs[i] != PATH_NO_NODE)
+            pathfinder_open(abstract, goal_node, node, g + self->goal_costs[i], 0);
+
+        for (uint32_t j = 0; j < n; j++)
+        {
+            uint32_t cost = cluster->arr_costs[i * n + j];
+            if (j != i && cost != PATH_NO_NODE)
+                pathfinder_open(abstract, cluster_index * self->max_entrances + j, node, g + cost, path_hierarchy_h(grid, query, cluster->arr_entrances[j].tile));
+        }
+
+        for (size_t k = 0; k < 2; k++)
+        {
+            uint32_t link = entrance->links[k];
+            if (link == PATH_NO_NODE)
+                continue;
+
+            uint32_t tile = self->clusters[link / self->max_entrances].arr_entrances[link % self->max_entrances].tile;
+            pathfinder_open(abstract, link, node, g + PATH_STRAIGHT_COST * grid->costs[tile], path_hierarchy_h(grid, query, tile));
+        }
+    }
+
+    // Only when the regions aren't labelled, the abstract graph is small enough to find out the slow way.
+    if (!found)
+        return 0;
+
+    out->found = 1;
+    out->cost = abstract->nodes[goal_node].g;
+
+    arrsetlen(self->arr_abstract_path, 0);
+    for (uint32_t node = abstract->nodes[goal_node].parent; node != start_node; node = abstract->nodes[node].parent)
+        arrput(self->arr_abstract_path, node);
+
+    // Refined back to front through the abstract path, which is goal first.
+    arrput(out->arr_points, start);
+    uint32_t num_abstract = (uint32_t)arrlenu(self->arr_abstract_path);
+    uint32_t first = self->arr_abstract_path[num_abstract - 1];
+    uint32_t first_tile = self->clusters[first / self->max_entrances].arr_entrances[first % self->max_entrances].tile;
+    path_cluster_search(self, grid, start_cluster, start, first_tile, 0, 0, 0, &out->num_expanded);
+    path_cluster_append_path(self, start_cluster, start, first_tile, &out->arr_points);
+
+    for (uint32_t k = num_abstract - 1; k > 0; k--)
+    {
+        uint32_t from = self->arr_abstract_path[k], to = self->arr_abstract_path[k - 1];
+        path_cluster_t *to_cluster = &self->clusters[to / self->max_entrances];
+        if (from / self->max_entrances == to / self->max_entrances)
+            path_cluster_append_segment(self, grid, to_cluster, from % self->max_entrances, to % self->max_entrances, &out->arr_points);
+        else
+            arrput(out->arr_points, to_cluster->arr_entrances[to % self->max_entrances].tile);
+    }
+
+    uint32_t last = self->arr_abstract_path[0];
+    uint32_t last_tile = goal_cluster->arr_entrances[last % self->max_entrances].tile;
+    path_cluster_search(self, grid, goal_cluster, last_tile, goal, 0, 0, 0, &out->num_expanded);
+    path_cluster_append_path(self, goal_cluster, last_tile, goal, &out->arr_points);
+
+    return 1;
+}
\ No newline at end of file
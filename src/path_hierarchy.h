@@ -0,0 +1,233 @@
+#pragma once
+#include <stdint.h>
+#include "pathfinding.h"
+#include "tilemap.h"
+
+// Openings along a cluster border at least this wide get an entrance at each end instead of one in the middle, so
+// paths hugging a wide opening's edge don't detour through its centre.
+#define PATH_WIDE_ENTRANCE 6
+
+/// @brief One step across a border, from a tile on the owning cluster's side to the tile beside it in the next.
+typedef struct path_transition_t
+{
+    uint32_t from, to;
+} path_transition_t;
+
+/// @brief A tile on a cluster's edge that paths can leave or enter it through, a node in the abstract graph.
+typedef struct path_entrance_t
+{
+    uint32_t tile;
+    // Abstract nodes in neighbouring clusters one straight step away, PATH_NO_NODE if unused. A corner tile can sit on
+    // two borders.
+    uint32_t links[2];
+} path_entrance_t;
+
+typedef struct path_cluster_t
+{
+    // Tile rectangle, the last row and column of clusters can be smaller.
+    uint32_t x, y, width, height;
+
+    // Across the right and bottom borders, the left and top ones belong to the neighbours.
+    path_transition_t *arr_right;
+    path_transition_t *arr_bottom;
+
+    path_entrance_t *arr_entrances;
+    // Cost of the cheapest path from entrance i to j that stays inside the cluster at [i * n + j], PATH_NO_NODE if there
+    // isn't one.
+    uint32_t *arr_costs;
+    // Where the tiles of that path start in arr_segment_points, PATH_NO_NODE until a query first refines it.
+    uint32_t *arr_segments;
+    // Each segment is its length then its tiles, the first entrance excluded.
+    uint32_t *arr_segment_points;
+
+    uint8_t is_dirty;
+    uint8_t is_right_dirty, is_bottom_dirty;
+    // Entrances here or next door were rebuilt, links may point at the wrong ones.
+    uint8_t needs_relink;
+} path_cluster_t;
+
+typedef struct path_hierarchy_stats_t
+{
+    uint64_t num_queries;
+    // Start and goal in the same cluster and a path between them inside it, no abstract search.
+    uint64_t num_local_queries;
+    // Refining an abstract path, a segment through a cluster reused from an earlier query or searched for.
+    uint64_t num_segment_hits;
+    uint64_t num_segment_misses;
+
+    uint64_t num_rebuilds;
+    uint64_t num_clusters_rebuilt;
+    float last_rebuild_ms;
+    float total_rebuild_ms;
+} path_hierarchy_stats_t;
+
+/// @brief HPA*, the grid cut into clusters with precomputed paths between the entrances on their edges. Long queries
+/// search the small graph of entrances and then only refine the clusters the path goes through. Edits only invalidate
+/// the clusters they touch, which are rebuilt before the next query. Paths are within a few percent of optimal.
+/// Not thread safe, queries write to the segment cache.
+typedef struct path_hierarchy_t
+{
+    uint32_t width, height;
+    uint32_t cluster_size;
+    uint32_t clusters_x, clusters_y;
+    path_cluster_t *clusters;
+    uint32_t num_dirty;
+
+    // Abstract node IDs are cluster * max_entrances + entrance, the query's start and goal are the two after them.
+    uint32_t max_entrances;
+    // Tile searches inside one cluster, indexed by the tile's position in it.
+    pathfinder_t local;
+    pathfinder_t abstract;
+
+    // Scratch for each query.
+    uint32_t *start_costs;
+    uint32_t *goal_costs;
+    // Entrances of the cluster being rebuilt, by position in it.
+    uint8_t *is_target;
+    uint32_t *arr_abstract_path;
+
+    path_hierarchy_stats_t stats;
+} path_hierarchy_t;
+
+/// @brief Builds every cluster.
+/// @param cluster_size TILEMAP_CHUNK_SIZE lines clusters up with the tilemap's chunks.
+path_hierarchy_t path_hierarchy_new(path_grid_t *grid, uint32_t cluster_size);
+void path_hierarchy_free(path_hierarchy_t *self);
+
+/// @brief Flag the clusters a change to this tile's cost affects, for grids changed without path_hierarchy_set_cost.
+void path_hierarchy_invalidate(path_hierarchy_t *self, uint32_t x, uint32_t y);
+
+void path_hierarchy_set_cost(path_hierarchy_t *self, path_grid_t *grid, uint32_t x, uint32_t y, uint8_t cost);
+
+/// @brief Tilemap edits into the grid, tile IDs to costs the same way as path_grid_from_tilemap.
+void path_hierarchy_apply_edits(path_hierarchy_t *self,
+                                path_grid_t *grid,
+                                const tilemap_edit_t *edits,
+                                size_t num_edits,
+                                const uint8_t *tile_costs,
+                                uint32_t num_tile_costs);
+
+/// @brief Rebuild whatever edits invalidated. Queries do this themselves, call it to keep the cost out of them. The
+/// grid's regions are only used while they're up to date, relabelling them is the caller's choice.
+void path_hierarchy_update(path_hierarchy_t *self, path_grid_t *grid);
+
+/// @brief Path from start to goal through the abstract graph, written to out like pathfinder_find.
+/// @return out->found.
+uint8_t path_hierarchy_find(path_hierarchy_t *self, path_grid_t *grid, const path_query_t *query, path_t *out);
+
+#if UNIT_TEST
+#include <assert.h>
+#include "util/rng.h"
+
+static void path_hierarchy_unit_tests_random_grid(path_grid_t *grid, uint64_t *rng, uint32_t weighted)
+{
+    for (uint32_t y = 0; y < grid->height; y++)
+    {
+        for (uint32_t x = 0; x < grid->width; x++)
+        {
+            uint32_t r = (uint32_t)(rng_next(rng) % 100);
+            path_grid_set_cost(grid, x, y, r < 25 ? PATH_COST_BLOCKED : weighted ? (uint8_t)(1 + r % 3) : 1);
+        }
+    }
+    path_grid_update_components(grid);
+}
+
+static void path_hierarchy_unit_tests_check_path(const path_grid_t *grid, const path_query_t *query, const path_t *path)
+{
+    assert(path->arr_points[0] == query->start_y * grid->width + query->start_x);
+    assert(arrlast(path->arr_points) == query->goal_y * grid->width + query->goal_x);
+
+    // Every step is to an open neighbour without cutting a corner and they add up to the cost.
+    uint32_t cost = 0;
+    for (size_t i = 1; i < arrlenu(path->arr_points); i++)
+    {
+        int32_t x = (int32_t)(path->arr_points[i] % grid->width), y = (int32_t)(path->arr_points[i] / grid->width);
+        int32_t dx = x - (int32_t)(path->arr_points[i - 1] % grid->width);
+        int32_t dy = y - (int32_t)(path->arr_points[i - 1] / grid->width);
+        assert(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && (dx || dy));
+        assert(path_grid_cost(grid, x, y) != PATH_COST_BLOCKED);
+        if (dx && dy)
+            assert(path_grid_cost(grid, x - dx, y) != PATH_COST_BLOCKED && path_grid_cost(grid, x, y - dy) != PATH_COST_BLOCKED);
+
+        cost += (dx && dy ? PATH_DIAGONAL_COST : PATH_STRAIGHT_COST) * path_grid_cost(grid, x, y);
+    }
+    assert(cost == path->cost);
+}
+
+static void path_hierarchy_unit_tests_matches_astar()
+{
+    // Finds a path whenever A* does, never cheaper than it and not much worse. After edits it answers exactly as one
+    // built from scratch would, so nothing stale survives invalidation.
+    for (uint32_t weighted = 0; weighted < 2; weighted++)
+    {
+        uint64_t rng = 11 + weighted;
+        path_grid_t grid = path_grid_new(70, 53);
+        path_hierarchy_unit_tests_random_grid(&grid, &rng, weighted);
+
+        path_hierarchy_t hierarchy = path_hierarchy_new(&grid, 8);
+        pathfinder_t pathfinder = pathfinder_new(grid.width * grid.height);
+        path_t astar = {0}, hpa = {0}, fresh_path = {0};
+        uint64_t total_astar = 0, total_hpa = 0;
+
+        for (uint32_t round = 0; round < 4; round++)
+        {
+            for (uint32_t i = 0; i < 200; i++)
+            {
+                uint32_t r = (uint32_t)(rng_next(&rng) >> 32);
+                path_query_t query = {r % 70, (r >> 8) % 53, (r >> 16) % 70, (r >> 24) % 53};
+
+                pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_ASTAR, &astar);
+                path_hierarchy_find(&hierarchy, &grid, &query, &hpa);
+                assert(astar.found == hpa.found);
+                if (!hpa.found)
+                    continue;
+
+                assert(hpa.cost >= astar.cost);
+                path_hierarchy_unit_tests_check_path(&grid, &query, &hpa);
+                total_astar += astar.cost;
+                total_hpa += hpa.cost;
+            }
+
+            path_hierarchy_t fresh = path_hierarchy_new(&grid, 8);
+            for (uint32_t i = 0; i < 50; i++)
+            {
+                uint32_t r = (uint32_t)(rng_next(&rng) >> 32);
+                path_query_t query = {r % 70, (r >> 8) % 53, (r >> 16) % 70, (r >> 24) % 53};
+
+                path_hierarchy_find(&hierarchy, &grid, &query, &hpa);
+                path_hierarchy_find(&fresh, &grid, &query, &fresh_path);
+                assert(hpa.found == fresh_path.found && hpa.cost == fresh_path.cost);
+            }
+            path_hierarchy_free(&fresh);
+
+            // Knock down and put up walls, borders and insides alike.
+            for (uint32_t i = 0; i < 40; i++)
+            {
+                uint32_t r = (uint32_t)(rng_next(&rng) >> 32);
+                uint32_t x = r % 70, y = (r >> 8) % 53;
+                uint8_t cost = path_grid_cost(&grid, (int32_t)x, (int32_t)y) == PATH_COST_BLOCKED ? (uint8_t)(1 + weighted * (r >> 16) % 3) : PATH_COST_BLOCKED;
+                path_hierarchy_set_cost(&hierarchy, &grid, x, y, cost);
+            }
+            assert(hierarchy.num_dirty);
+        }
+
+        // Within a tenth of optimal overall.
+        assert(total_hpa * 10 <= total_astar * 11);
+        assert(hierarchy.stats.num_segment_hits && hierarchy.stats.num_rebuilds == 4);
+
+        path_free(&astar);
+        path_free(&hpa);
+        path_free(&fresh_path);
+        pathfinder_free(&pathfinder);
+        path_hierarchy_free(&hierarchy);
+        path_grid_free(&grid);
+    }
+}
+
+static int path_hierarchy_unit_tests(void)
+{
+    path_hierarchy_unit_tests_matches_astar();
+
+    return 1;
+}
+#endif
\ No newline at end of file
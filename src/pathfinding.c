@@ -0,0 +1,515 @@
+#include "pathfinding.h"
+#include <string.h>
+#include <assert.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+
+static void path_grid_update_summary(path_grid_t *self)
+{
+    self->min_cost = 0;
+    uint32_t num_costs = 0;
+    for (uint32_t cost = 255; cost > PATH_COST_BLOCKED; cost--)
+    {
+        if (!self->cost_counts[cost])
+            continue;
+
+        self->min_cost = (uint8_t)cost;
+        num_costs++;
+    }
+
+    self->is_uniform = num_costs <= 1;
+}
+
+path_grid_t path_grid_new(uint32_t width, uint32_t height)
+{
+    path_grid_t result = {0};
+    result.width = width;
+    result.height = height;
+
+    size_t num_tiles = (size_t)width * height;
+    result.costs = mem_alloc(MEMORY_TAG_PATHFINDING, num_tiles);
+    assert(!num_tiles || result.costs);
+    memset(result.costs, 1, num_tiles);
+
+    result.cost_counts[1] = (uint32_t)num_tiles;
+    path_grid_update_summary(&result);
+
+    result.components = mem_alloc(MEMORY_TAG_PATHFINDING, num_tiles * sizeof(uint32_t));
+    assert(!num_tiles || result.components);
+    path_grid_update_components(&result);
+
+    return result;
+}
+
+path_grid_t path_grid_from_tilemap(const tilemap_t *tilemap, const uint8_t *tile_costs, uint32_t num_tile_costs)
+{
+    PROFILE_FUNCTION();
+
+    path_grid_t result = path_grid_new(tilemap->width, tilemap->height);
+    memset(result.cost_counts, 0, sizeof(result.cost_counts));
+
+    for (uint32_t y = 0; y < tilemap->height; y++)
+    {
+        for (uint32_t x = 0; x < tilemap->width; x++)
+        {
+            tile_id_t tile = tilemap_get(tilemap, x, y);
+            uint8_t cost = tile != TILE_EMPTY && tile < num_tile_costs ? tile_costs[tile] : PATH_COST_BLOCKED;
+            result.costs[(size_t)y * result.width + x] = cost;
+            result.cost_counts[cost]++;
+        }
+    }
+
+    path_grid_update_summary(&result);
+    path_grid_update_components(&result);
+
+    return result;
+}
+
+void path_grid_free(path_grid_t *self)
+{
+    mem_free(self->costs);
+    mem_free(self->components);
+
+    *self = (path_grid_t){0};
+}
+
+void path_grid_set_cost(path_grid_t *self, uint32_t x, uint32_t y, uint8_t cost)
+{
+    assert(x < self->width && y < self->height);
+
+    uint8_t *slot = &self->costs[(size_t)y * self->width + x];
+    if (*slot == cost)
+        return;
+
+    uint8_t old_cost = *slot;
+    self->cost_counts[old_cost]--;
+    self->cost_counts[cost]++;
+    *slot = cost;
+
+    if ((old_cost == PATH_COST_BLOCKED) != (cost == PATH_COST_BLOCKED))
+        self->components_dirty = 1;
+
+    // Only a cost appearing or disappearing can change either.
+    if (self->cost_counts[cost] == 1 || self->cost_counts[old_cost] == 0)
+        path_grid_update_summary(self);
+}
+
+void path_grid_update_components(path_grid_t *self)
+{
+    PROFILE_FUNCTION();
+
+    size_t num_tiles = (size_t)self->width * self->height;
+    memset(self->components, 0, num_tiles * sizeof(uint32_t));
+
+    // Flood fill 4 way, diagonals need both tiles beside them open so they never join anything the straight moves
+    // don't.
+    uint32_t *stack = mem_alloc(MEMORY_TAG_PATHFINDING, num_tiles * sizeof(uint32_t));
+    assert(!num_tiles || stack);
+    uint32_t num_components = 0;
+    for (uint32_t seed = 0; seed < num_tiles; seed++)
+    {
+        if (self->components[seed] || self->costs[seed] == PATH_COST_BLOCKED)
+            continue;
+
+        uint32_t component = ++num_components;
+        size_t stack_size = 0;
+        self->components[seed] = component;
+        stack[stack_size++] = seed;
+
+        while (stack_size)
+        {
+            uint32_t tile = stack[--stack_size];
+            uint32_t x = tile % self->width, y = tile / self->width;
+            uint32_t neighbours[4] = {
+                x > 0 ? tile - 1 : PATH_NO_NODE,
+                x + 1 < self->width ? tile + 1 : PATH_NO_NODE,
+                y > 0 ? tile - self->width : PATH_NO_NODE,
+                y + 1 < self->height ? tile + self->width : PATH_NO_NODE,
+            };
+
+            for (size_t i = 0; i < 4; i++)
+            {
+                uint32_t neighbour = neighbours[i];
+                if (neighbour == PATH_NO_NODE || self->components[neighbour] || self->costs[neighbour] == PATH_COST_BLOCKED)
+                    continue;
+
+                // Each tile is pushed once, the stack never holds more than every tile.
+                self->components[neighbour] = component;
+                stack[stack_size++] = neighbour;
+            }
+        }
+    }
+    mem_free(stack);
+
+    self->components_dirty = 0;
+}
+
+void path_free(path_t *self)
+{
+    arrfree(self->arr_points);
+
+    *self = (path_t){0};
+}
+
+pathfinder_t pathfinder_new(uint32_t num_nodes)
+{
+    pathfinder_t result = {0};
+    result.capacity = num_nodes;
+    // Zeroed so no node matches the first generation.
+    result.nodes = mem_calloc(MEMORY_TAG_PATHFINDING, num_nodes, sizeof(path_node_t));
+    result.heap = mem_alloc(MEMORY_TAG_PATHFINDING, (size_t)num_nodes * sizeof(path_heap_entry_t));
+    assert(!num_nodes || (result.nodes && result.heap));
+
+    return result;
+}
+
+void pathfinder_free(pathfinder_t *self)
+{
+    mem_free(self->nodes);
+    mem_free(self->heap);
+
+    *self = (pathfinder_t){0};
+}
+
+static void path_heap_swap(pathfinder_t *self, uint32_t a, uint32_t b)
+{
+    path_heap_entry_t temp = self->heap[a];
+    self->heap[a] = self->heap[b];
+    self->heap[b] = temp;
+
+    self->nodes[self->heap[a].node].heap_index = a;
+    self->nodes[self->heap[b].node].heap_index = b;
+}
+
+static void path_heap_up(pathfinder_t *self, uint32_t index)
+{
+    while (index > 0)
+    {
+        uint32_t parent = (index - 1) / 2;
+        if (self->heap[parent].f <= self->heap[index].f)
+            break;
+
+        path_heap_swap(self, parent, index);
+        index = parent;
+    }
+}
+
+static void path_heap_down(pathfinder_t *self, uint32_t index)
+{
+    for (;;)
+    {
+        uint32_t smallest = index;
+        uint32_t left = index * 2 + 1, right = left + 1;
+        if (left < self->heap_size && self->heap[left].f < self->heap[smallest].f)
+            smallest = left;
+        if (right < self->heap_size && self->heap[right].f < self->heap[smallest].f)
+            smallest = right;
+
+        if (smallest == index)
+            break;
+
+        path_heap_swap(self, smallest, index);
+        index = smallest;
+    }
+}
+
+void pathfinder_begin(pathfinder_t *self)
+{
+    // Wrapped, every stamp could match again.
+    if (++self->generation == 0)
+    {
+        memset(self->nodes, 0, (size_t)self->capacity * sizeof(path_node_t));
+        self->generation = 1;
+    }
+    self->heap_size = 0;
+}
+
+uint32_t pathfinder_pop(pathfinder_t *self)
+{
+    uint32_t node = self->heap[0].node;
+    self->heap_size--;
+    if (self->heap_size)
+    {
+        self->heap[0] = self->heap[self->heap_size];
+        self->nodes[self->heap[0].node].heap_index = 0;
+        path_heap_down(self, 0);
+    }
+
+    self->nodes[node].heap_index = PATH_NO_NODE;
+    return node;
+}
+
+void pathfinder_open(pathfinder_t *self, uint32_t node, uint32_t parent, uint32_t g, uint32_t h)
+{
+    assert(node < self->capacity);
+    path_node_t *state = &self->nodes[node];
+
+    if (state->generation != self->generation)
+    {
+        state->generation = self->generation;
+        state->g = g;
+        state->parent = parent;
+        state->heap_index = self->heap_size;
+        self->heap[self->heap_size++] = (path_heap_entry_t){g + h, node};
+        path_heap_up(self, state->heap_index);
+        return;
+    }
+
+    if (state->heap_index == PATH_NO_NODE || g >= state->g)
+        return;
+
+    state->g = g;
+    state->parent = parent;
+    self->heap[state->heap_index].f = g + h;
+    path_heap_up(self, state->heap_index);
+}
+
+static void path_relax(pathfinder_t *self, const path_grid_t *grid, const path_query_t *query, uint32_t node, uint32_t parent, uint32_t g)
+{
+    uint32_t x = node % grid->width, y = node / grid->width;
+    uint32_t h = path_octile((int32_t)query->goal_x - (int32_t)x, (int32_t)query->goal_y - (int32_t)y) * grid->min_cost;
+
+    pathfinder_open(self, node, parent, g, h);
+}
+
+static void path_astar_expand(pathfinder_t *self, const path_grid_t *grid, const path_query_t *query, uint32_t node)
+{
+    int32_t x = (int32_t)(node % grid->width), y = (int32_t)(node / grid->width);
+    uint32_t g = self->nodes[node].g;
+
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            if (!dx && !dy)
+                continue;
+
+            uint8_t cost = path_grid_cost(grid, x + dx, y + dy);
+            if (cost == PATH_COST_BLOCKED)
+                continue;
+
+            uint32_t step = PATH_STRAIGHT_COST;
+            if (dx && dy)
+            {
+                if (path_grid_cost(grid, x + dx, y) == PATH_COST_BLOCKED || path_grid_cost(grid, x, y + dy) == PATH_COST_BLOCKED)
+                    continue;
+                step = PATH_DIAGONAL_COST;
+            }
+
+            path_relax(self, grid, query, (uint32_t)(y + dy) * grid->width + (uint32_t)(x + dx), node, g + step * cost);
+        }
+    }
+}
+
+static uint8_t path_open(const path_grid_t *grid, int32_t x, int32_t y)
+{
+    return path_grid_cost(grid, x, y) != PATH_COST_BLOCKED;
+}
+
+// Straight along one axis until something forces a turn, the goal, or a wall.
+static uint32_t path_jump_straight(const path_grid_t *grid, const path_query_t *query, int32_t x, int32_t y, int32_t dx, int32_t dy)
+{
+    for (;;)
+    {
+        x += dx;
+        y += dy;
+        if (!path_open(grid, x, y))
+            return PATH_NO_NODE;
+
+        if ((uint32_t)x == query->goal_x && (uint32_t)y == query->goal_y)
+            return (uint32_t)y * grid->width + (uint32_t)x;
+
+        // An opening beside us that was a wall one step back, a cheaper way round starts here.
+        if (dx)
+        {
+            if ((path_open(grid, x, y + 1) && !path_open(grid, x - dx, y + 1)) ||
+                (path_open(grid, x, y - 1) && !path_open(grid, x - dx, y - 1)))
+                return (uint32_t)y * grid->width + (uint32_t)x;
+        }
+        else
+        {
+            if ((path_open(grid, x + 1, y) && !path_open(grid, x + 1, y - dy)) ||
+                (path_open(grid, x - 1, y) && !path_open(grid, x - 1, y - dy)))
+                return (uint32_t)y * grid->width + (uint32_t)x;
+        }
+    }
+}
+
+static uint32_t path_jump(const path_grid_t *grid, const path_query_t *query, int32_t x, int32_t y, int32_t dx, int32_t dy)
+{
+    if (!dx || !dy)
+        return path_jump_straight(grid, query, x, y, dx, dy);
+
+    for (;;)
+    {
+        // No cutting corners, both sides of the diagonal have to be open.
+        if (!path_open(grid, x + dx, y) || !path_open(grid, x, y + dy) || !path_open(grid, x + dx, y + dy))
+            return PATH_NO_NODE;
+
+        x += dx;
+        y += dy;
+        uint32_t node = (uint32_t)y * grid->width + (uint32_t)x;
+        if ((uint32_t)x == query->goal_x && (uint32_t)y == query->goal_y)
+            return node;
+
+        // Anything the straight jumps from here would find makes this a jump point.
+        if (path_jump_straight(grid, query, x, y, dx, 0) != PATH_NO_NODE || path_jump_straight(grid, query, x, y, 0, dy) != PATH_NO_NODE)
+            return node;
+    }
+}
+
+static void path_jps_expand(pathfinder_t *self, const path_grid_t *grid, const path_query_t *query, uint32_t node)
+{
+    int32_t x = (int32_t)(node % grid->width), y = (int32_t)(node / grid->width);
+    path_node_t *state = &self->nodes[node];
+
+    // Only the directions that could be on a shortest path given how we got here, everything at the start.
+    int8_t directions[8][2];
+    uint32_t num_directions = 0;
+    if (state->parent == PATH_NO_NODE)
+    {
+        for (int32_t dy = -1; dy <= 1; dy++)
+            for (int32_t dx = -1; dx <= 1; dx++)
+                if (dx || dy)
+                    directions[num_directions][0] = (int8_t)dx, directions[num_directions++][1] = (int8_t)dy;
+    }
+    else
+    {
+        int32_t px = (int32_t)(state->parent % grid->width), py = (int32_t)(state->parent / grid->width);
+        int32_t dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+
+        if (dx && dy)
+        {
+            directions[num_directions][0] = (int8_t)dx, directions[num_directions++][1] = 0;
+            directions[num_directions][0] = 0, directions[num_directions++][1] = (int8_t)dy;
+            directions[num_directions][0] = (int8_t)dx, directions[num_directions++][1] = (int8_t)dy;
+        }
+        else
+        {
+            // Ahead, both sides, and the diagonals between them. Blocked ones are dropped when jumping.
+            int32_t sx = dy ? 1 : 0, sy = dx ? 1 : 0;
+            directions[num_directions][0] = (int8_t)dx, directions[num_directions++][1] = (int8_t)dy;
+            for (int32_t side = -1; side <= 1; side += 2)
+            {
+                directions[num_directions][0] = (int8_t)(sx * side), directions[num_directions++][1] = (int8_t)(sy * side);
+                directions[num_directions][0] = (int8_t)(dx + sx * side), directions[num_directions++][1] = (int8_t)(dy + sy * side);
+            }
+        }
+    }
+
+    uint32_t g = state->g;
+    for (uint32_t i = 0; i < num_directions; i++)
+    {
+        int32_t dx = directions[i][0], dy = directions[i][1];
+        uint32_t jump_point = path_jump(grid, query, x, y, dx, dy);
+        if (jump_point == PATH_NO_NODE)
+            continue;
+
+        int32_t jx = (int32_t)(jump_point % grid->width), jy = (int32_t)(jump_point / grid->width);
+        path_relax(self, grid, query, jump_point, node, g + path_octile(jx - x, jy - y) * grid->min_cost);
+    }
+}
+
+static void path_write_points(pathfinder_t *self, const path_grid_t *grid, uint32_t goal, path_t *out)
+{
+    // Walked back from the goal, then reversed. Jump points can be apart, the tiles between them are filled in.
+    for (uint32_t node = goal; node != PATH_NO_NODE; node = self->nodes[node].parent)
+    {
+        uint32_t parent = self->nodes[node].parent;
+        arrput(out->arr_points, node);
+        if (parent == PATH_NO_NODE)
+            break;
+
+        int32_t x = (int32_t)(node % grid->width), y = (int32_t)(node / grid->width);
+        int32_t px = (int32_t)(parent % grid->width), py = (int32_t)(parent / grid->width);
+        int32_t dx = (px > x) - (px < x), dy = (py > y) - (py < y);
+        for (x += dx, y += dy; x != px || y != py; x += dx, y += dy)
+            arrput(out->arr_points, (uint32_t)y * grid->width + (uint32_t)x);
+    }
+
+    size_t num_points = arrlenu(out->arr_points);
+    for (size_t i = 0; i < num_points / 2; i++)
+    {
+        uint32_t temp = out->arr_points[i];
+        out->arr_points[i] = out->arr_points[num_points - 1 - i];
+        out->arr_points[num_points - 1 - i] = temp;
+    }
+}
+
+uint8_t pathfinder_find(pathfinder_t *self, const path_grid_t *grid, const path_query_t *query, path_algorithm_e algorithm, path_t *out)
+{
+    assert(self->capacity >= grid->width * grid->height);
+
+    MEMORY_SCOPE(MEMORY_TAG_PATHFINDING);
+    arrsetlen(out->arr_points, 0);
+    out->found = 0;
+    out->cost = 0;
+    out->num_expanded = 0;
+
+    if (!path_open(grid, (int32_t)query->start_x, (int32_t)query->start_y) || !path_open(grid, (int32_t)query->goal_x, (int32_t)query->goal_y))
+        return 0;
+
+    uint32_t start = query->start_y * grid->width + query->start_x;
+    uint32_t goal = query->goal_y * grid->width + query->goal_x;
+    if (!grid->components_dirty && grid->components[start] != grid->components[goal])
+        return 0;
+
+    uint8_t use_jps = grid->is_uniform && algorithm != PATH_ALGORITHM_ASTAR;
+
+    pathfinder_begin(self);
+    path_relax(self, grid, query, start, PATH_NO_NODE, 0);
+
+    while (self->heap_size)
+    {
+        uint32_t node = pathfinder_pop(self);
+        out->num_expanded++;
+
+        if (node == goal)
+        {
+            out->found = 1;
+            out->cost = self->nodes[goal].g;
+            path_write_points(self, grid, goal, out);
+            return 1;
+        }
+
+        if (use_jps)
+            path_jps_expand(self, grid, query, node);
+        else
+            path_astar_expand(self, grid, query, node);
+    }
+
+    return 0;
+}
+
+typedef struct path_batch_t
+{
+    pathfinder_t *pathfinders;
+    const path_grid_t *grid;
+    const path_query_t *queries;
+    path_t *results;
+    path_algorithm_e algorithm;
+} path_batch_t;
+
+static void path_batch_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    path_batch_t *batch = user_data;
+    pathfinder_t *pathfinder = &batch->pathfinders[worker_index];
+
+    for (uint32_t i = begin; i < end; i++)
+        pathfinder_find(pathfinder, batch->grid, &batch->queries[i], batch->algorithm, &batch->results[i]);
+}
+
+void pathfinder_find_batch(job_system_t *jobs,
+                           pathfinder_t *pathfinders,
+                           const path_grid_t *grid,
+                           const path_query_t *queries,
+                           path_t *results,
+                           uint32_t num_queries,
+                           path_algorithm_e algorithm)
+{
+    PROFILE_FUNCTION();
+
+    path_batch_t batch = {pathfinders, grid, queries, results, algorithm};
+    // Queries vary a lot in cost, small batches keep every thread busy to the end.
+    job_system_parallel_for(jobs, num_queries, 16, path_batch_range, &batch);
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "tilemap.h"
+#include "engine/job_system.h"
+
+// Can't be entered.
+#define PATH_COST_BLOCKED 0
+
+// Step costs before the tile's own cost multiplies them, roughly 1 : sqrt(2).
+#define PATH_STRAIGHT_COST 10
+#define PATH_DIAGONAL_COST 14
+
+#define PATH_NO_NODE UINT32_MAX
+
+/// @brief What a unit can walk on, one cost per tile. Movement is 8 way, diagonals only when both tiles beside
+/// them are open so nothing squeezes between two blocked corners.
+typedef struct path_grid_t
+{
+    uint32_t width, height;
+    // Row major, multiplies the cost of stepping into the tile. PATH_COST_BLOCKED for walls.
+    uint8_t *costs;
+
+    // How many tiles have each cost, keeps min_cost and is_uniform up to date as costs change.
+    uint32_t cost_counts[256];
+    // Cheapest open tile, scales the heuristic so it never overestimates.
+    uint8_t min_cost;
+    // Every open tile costs the same, which is what jump point search needs.
+    uint8_t is_uniform;
+
+    // Connected region of each open tile, 0 for blocked ones. A goal in another region fails straight away instead
+    // of searching everything reachable from the start.
+    uint32_t *components;
+    // Set when a tile is opened or blocked, the labels are ignored until path_grid_update_components.
+    uint8_t components_dirty;
+} path_grid_t;
+
+/// @brief Every tile open at cost 1.
+path_grid_t path_grid_new(uint32_t width, uint32_t height);
+
+/// @brief Cost of each tile looked up by its ID, TILE_EMPTY and IDs past the end of tile_costs are blocked.
+path_grid_t path_grid_from_tilemap(const tilemap_t *tilemap, const uint8_t *tile_costs, uint32_t num_tile_costs);
+
+void path_grid_free(path_grid_t *self);
+
+void path_grid_set_cost(path_grid_t *self, uint32_t x, uint32_t y, uint8_t cost);
+
+/// @brief Relabel connected regions after tiles have been opened or blocked. Not thread safe with queries.
+void path_grid_update_components(path_grid_t *self);
+
+/// @return PATH_COST_BLOCKED outside the grid.
+static inline uint8_t path_grid_cost(const path_grid_t *self, int32_t x, int32_t y)
+{
+    if (x < 0 || y < 0 || (uint32_t)x >= self->width || (uint32_t)y >= self->height)
+        return PATH_COST_BLOCKED;
+
+    return self->costs[(size_t)y * self->width + x];
+}
+
+/// @brief Cheapest cost from one tile to another on an open grid of cost 1, the A* heuristic.
+static inline uint32_t path_octile(int32_t dx, int32_t dy)
+{
+    dx = dx < 0 ? -dx : dx;
+    dy = dy < 0 ? -dy : dy;
+    int32_t diagonal = dx < dy ? dx : dy;
+    int32_t straight = (dx > dy ? dx : dy) - diagonal;
+
+    return (uint32_t)(diagonal * PATH_DIAGONAL_COST + straight * PATH_STRAIGHT_COST);
+}
+
+typedef enum path_algorithm_e
+{
+    // Jump point search on uniform grids, A* otherwise.
+    PATH_ALGORITHM_AUTO,
+    PATH_ALGORITHM_ASTAR,
+    // Only valid on uniform grids, falls back to A* on anything else.
+    PATH_ALGORITHM_JPS,
+} path_algorithm_e;
+
+typedef struct path_query_t
+{
+    uint32_t start_x, start_y;
+    uint32_t goal_x, goal_y;
+} path_query_t;
+
+typedef struct path_t
+{
+    uint8_t found;
+    uint32_t cost;
+    // Nodes taken off the open set, how much work the query was.
+    uint32_t num_expanded;
+    // Every tile from start to goal inclusive as y * width + x, empty if there's no path. Keeps its capacity between
+    // queries.
+    uint32_t *arr_points;
+} path_t;
+
+void path_free(path_t *self);
+
+typedef struct path_node_t
+{
+    // Everything else is garbage unless this matches the pathfinder's, so nothing is cleared between queries.
+    uint32_t generation;
+    uint32_t g;
+    uint32_t parent;
+    // Position in the open heap, PATH_NO_NODE once closed.
+    uint32_t heap_index;
+} path_node_t;
+
+typedef struct path_heap_entry_t
+{
+    uint32_t f;
+    uint32_t node;
+} path_heap_entry_t;
+
+/// @brief Scratch for one query at a time, sized once for a grid and reused. One per thread.
+typedef struct pathfinder_t
+{
+    uint32_t capacity;
+    path_node_t *nodes;
+    // Binary min heap on f, every node is in it at most once.
+    path_heap_entry_t *heap;
+    uint32_t heap_size;
+    uint32_t generation;
+} pathfinder_t;
+
+pathfinder_t pathfinder_new(uint32_t num_nodes);
+void pathfinder_free(pathfinder_t *self);
+
+// The open set on its own, for searches over something other than a path_grid_t. Nodes are any index below capacity.
+
+/// @brief Forget the last search.
+void pathfinder_begin(pathfinder_t *self);
+
+/// @brief Open node at g through parent, or lower its g if this way is cheaper. Closed nodes are never reopened so h
+/// has to be consistent.
+void pathfinder_open(pathfinder_t *self, uint32_t node, uint32_t parent, uint32_t g, uint32_t h);
+
+/// @brief Close and return the open node with the lowest g + h, the heap must not be empty.
+uint32_t pathfinder_pop(pathfinder_t *self);
+
+/// @return g of a node this search has reached, PATH_NO_NODE if it hasn't.
+static inline uint32_t pathfinder_g(const pathfinder_t *self, uint32_t node)
+{
+    return self->nodes[node].generation == self->generation ? self->nodes[node].g : PATH_NO_NODE;
+}
+
+/// @brief Cheapest path from start to goal, written to out.
+/// @return out->found.
+uint8_t pathfinder_find(pathfinder_t *self, const path_grid_t *grid, const path_query_t *query, path_algorithm_e algorithm, path_t *out);
+
+/// @brief Resolve num_queries queries across the job system's threads, results[i] is for queries[i].
+/// @param pathfinders One per job_system_num_threads(jobs), each sized for grid.
+void pathfinder_find_batch(job_system_t *jobs,
+                           pathfinder_t *pathfinders,
+                           const path_grid_t *grid,
+                           const path_query_t *queries,
+                           path_t *results,
+                           uint32_t num_queries,
+                           path_algorithm_e algorithm);
+
+#if UNIT_TEST
+#include <assert.h>
+#include "engine/memory.h"
+#include "util/rng.h"
+
+static void pathfinding_unit_tests_jps_matches_astar()
+{
+    // Same cost both ways on random uniform grids, JPS only skips nodes, it never finds a worse path.
+    path_grid_t grid = path_grid_new(48, 40);
+    uint64_t rng = 7;
+    for (uint32_t y = 0; y < grid.height; y++)
+    {
+        for (uint32_t x = 0; x < grid.width; x++)
+        {
+            if (rng_next(&rng) % 100 < 30)
+                path_grid_set_cost(&grid, x, y, PATH_COST_BLOCKED);
+        }
+    }
+    assert(grid.is_uniform);
+
+    pathfinder_t pathfinder = pathfinder_new(grid.width * grid.height);
+    path_t astar = {0}, jps = {0};
+    for (uint32_t i = 0; i < 300; i++)
+    {
+        uint32_t r = (uint32_t)(rng_next(&rng) >> 32);
+        path_query_t query = {r % 48, (r >> 8) % 40, (r >> 16) % 48, (r >> 24) % 40};
+
+        pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_ASTAR, &astar);
+        pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_JPS, &jps);
+        assert(astar.found == jps.found);
+        if (!astar.found)
+            continue;
+
+        assert(astar.cost == jps.cost);
+        assert(jps.arr_points[0] == query.start_y * grid.width + query.start_x);
+        assert(arrlast(jps.arr_points) == query.goal_y * grid.width + query.goal_x);
+        // Every step is to a neighbour.
+        for (size_t j = 1; j < arrlenu(jps.arr_points); j++)
+        {
+            int32_t dx = (int32_t)(jps.arr_points[j] % grid.width) - (int32_t)(jps.arr_points[j - 1] % grid.width);
+            int32_t dy = (int32_t)(jps.arr_points[j] / grid.width) - (int32_t)(jps.arr_points[j - 1] / grid.width);
+            assert(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && (dx || dy));
+        }
+    }
+
+    path_free(&astar);
+    path_free(&jps);
+    pathfinder_free(&pathfinder);
+    path_grid_free(&grid);
+}
+
+static void pathfinding_unit_tests_weighted()
+{
+    // A straight line through mud costs more than going around it.
+    path_grid_t grid = path_grid_new(5, 3);
+    path_grid_set_cost(&grid, 2, 1, 9);
+    assert(!grid.is_uniform && grid.min_cost == 1);
+
+    pathfinder_t pathfinder = pathfinder_new(grid.width * grid.height);
+    path_t path = {0};
+    path_query_t query = {0, 1, 4, 1};
+    assert(pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_AUTO, &path));
+    assert(path.cost == 2 * PATH_STRAIGHT_COST + 2 * PATH_DIAGONAL_COST);
+
+    // Walled off.
+    for (uint32_t y = 0; y < 3; y++)
+        path_grid_set_cost(&grid, 2, y, PATH_COST_BLOCKED);
+    assert(!pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_AUTO, &path));
+    assert(arrlenu(path.arr_points) == 0);
+
+    // Same again once the labels know it's walled off, without expanding anything.
+    assert(grid.components_dirty);
+    path_grid_update_components(&grid);
+    assert(!pathfinder_find(&pathfinder, &grid, &query, PATH_ALGORITHM_AUTO, &path) && path.num_expanded == 0);
+
+    path_free(&path);
+    pathfinder_free(&pathfinder);
+    path_grid_free(&grid);
+}
+
+static int pathfinding_unit_tests(void)
+{
+    pathfinding_unit_tests_jps_matches_astar();
+    pathfinding_unit_tests_weighted();
+
+    return 1;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "render_snapshot.h"
+#include <assert.h>
+#include <string.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "entities.h"
+
+render_snapshots_t render_snapshots_new()
+{
+    render_snapshots_t result = {0};
+    result.mutex = SDL_CreateMutex();
+    assert(result.mutex);
+
+    return result;
+}
+
+void render_snapshots_free(render_snapshots_t *self)
+{
+    for (size_t i = 0; i < 2; i++)
+    {
+        arrfree(self->buffers[i].arr_items);
+        arrfree(self->buffers[i].arr_tile_edits);
+        arrfree(self->buffers[i].arr_fog_words);
+    }
+    arrfree(self->arr_tile_edits);
+
+    SDL_DestroyMutex(self->mutex);
+
+    *self = (render_snapshots_t){0};
+}
+
+render_snapshot_t *render_snapshots_back(render_snapshots_t *self)
+{
+    return &self->buffers[!self->front];
+}
+
+void render_snapshots_publish(render_snapshots_t *self)
+{
+    render_snapshot_t *back = render_snapshots_back(self);
+
+    SDL_LockMutex(self->mutex);
+    if (arrlenu(back->arr_tile_edits))
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TILEMAP);
+        size_t num_edits = arrlenu(back->arr_tile_edits);
+        memcpy(arraddnptr(self->arr_tile_edits, num_edits), back->arr_tile_edits, num_edits * sizeof(tilemap_edit_t));
+    }
+    self->front = !self->front;
+    SDL_UnlockMutex(self->mutex);
+}
+
+const render_snapshot_t *render_snapshots_acquire(render_snapshots_t *self)
+{
+    SDL_LockMutex(self->mutex);
+    return &self->buffers[self->front];
+}
+
+void render_snapshots_release(render_snapshots_t *self)
+{
+    SDL_UnlockMutex(self->mutex);
+}
+
+void render_snapshot_build(render_snapshot_t *snapshot, world_t *world)
+{
+    PROFILE_FUNCTION();
+
+    // Keeps the capacity from last time, steady state this doesn't allocate.
+    MEMORY_SCOPE(MEMORY_TAG_RENDER);
+    arrsetlen(snapshot->arr_items, 0);
+    snapshot->has_camera = 0;
+
+    arrsetlen(snapshot->arr_tile_edits, 0);
+    if (world->tilemap && arrlenu(world->tilemap->arr_edits))
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TILEMAP);
+        size_t num_edits = arrlenu(world->tilemap->arr_edits);
+        memcpy(arraddnptr(snapshot->arr_tile_edits, num_edits), world->tilemap->arr_edits, num_edits * sizeof(tilemap_edit_t));
+        arrsetlen(world->tilemap->arr_edits, 0);
+    }
+
+    fov_t *fov = world->fov;
+    if (fov && arrlenu(fov->arr_viewers) && snapshot->fog_revision != fov->revision)
+    {
+        MEMORY_SCOPE(MEMORY_TAG_FOV);
+        const fov_viewer_t *player = &fov->arr_viewers[0];
+        size_t num_words = (size_t)player->visible.words_per_row * player->visible.height;
+        arrsetlen(snapshot->arr_fog_words, num_words * 2);
+        memcpy(snapshot->arr_fog_words, player->visible.words, num_words * sizeof(uint64_t));
+        memcpy(snapshot->arr_fog_words + num_words, player->explored.words, num_words * sizeof(uint64_t));
+        snapshot->fog_revision = fov->revision;
+    }
+
+    entity_t **arr_entities = world->entities;
+    for (size_t i = 0; i < arrlen(arr_entities); i++)
+    {
+        entity_t *entity = arr_entities[i];
+
+        // Built straight after update_global_system, so the whole subtree can be skipped in one go.
+        if (entity->is_hidden)
+        {
+            i += world->arr_subtree_sizes[i] - 1;
+            continue;
+        }
+
+        // The last camera in hierarchy order wins.
+        if (entity->has_camera)
+        {
+            snapshot->has_camera = 1;
+            mat4x4_dup(snapshot->view_proj, entity->camera.view_proj);
+        }
+
+        if (entity->render_type == RENDER_TYPE_NONE)
+            continue;
+
+        render_item_t item = {0};
+        item.render_type = entity->render_type;
+        switch (entity->render_type)
+        {
+        case RENDER_TYPE_SPRITE:
+        {
+            item.sprite = entity->sprite;
+            break;
+        }
+        case RENDER_TYPE_TEXT:
+        {
+            item.text = entity->text;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+
+        get_render_transform(&entity->transform, &item.current);
+        item.previous = entity->transform.has_previous ? entity->transform.previous : item.current;
+
+        arrput(snapshot->arr_items, item);
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "vendor/linmath.h"
+#include "render_type.h"
+#include "sprite.h"
+#include "text.h"
+#include "transform.h"
+#include "tilemap.h"
+
+typedef struct world_t world_t;
+
+typedef struct render_item_t
+{
+    render_type_e render_type;
+    union
+    {
+        sprite_t sprite;
+        text_t text;
+    };
+
+    render_transform_t previous;
+    render_transform_t current;
+} render_item_t;
+
+/// @brief Everything the renderer needs from one simulation step, so rendering never touches the entities.
+typedef struct render_snapshot_t
+{
+    render_item_t *arr_items;
+
+    uint8_t has_camera;
+    mat4x4 view_proj;
+
+    // Tiles changed during the step, passed on to the renderer's copy of the map when published.
+    tilemap_edit_t *arr_tile_edits;
+
+    // The first player's visible then explored bitsets, only recopied when fog_revision (the fov_t's) moves on. Every
+    // snapshot carries the whole thing, the renderer may never see the one that changed it. 0 without fog.
+    uint64_t *arr_fog_words;
+    uint32_t fog_revision;
+
+    uint64_t step_number;
+    // End of the step this snapshot was taken at and the step length, in performance counter ticks.
+    uint64_t sim_time;
+    uint64_t step_counter;
+    // CPU time the simulation spent on this step.
+    float tick_ms;
+} render_snapshot_t;
+
+/// @brief Double buffered snapshots, the simulation fills the back buffer while the renderer reads the front.
+/// Publishing swaps the two under a lock the renderer holds while it reads, so the simulation can't reuse the
+/// buffer still being drawn.
+typedef struct render_snapshots_t
+{
+    render_snapshot_t buffers[2];
+    // Only written by render_snapshots_publish, which is only called from the simulation.
+    uint32_t front;
+    SDL_mutex *mutex;
+
+    // Tile edits from every snapshot published since the renderer last took them. Unlike the snapshots these can't be
+    // skipped, so they queue up here rather than being lost when two steps are published in one frame. Only touch
+    // with the lock held.
+    tilemap_edit_t *arr_tile_edits;
+} render_snapshots_t;
+
+render_snapshots_t render_snapshots_new();
+void render_snapshots_free(render_snapshots_t *self);
+
+/// @brief The buffer the simulation may write to, only call from the simulation.
+render_snapshot_t *render_snapshots_back(render_snapshots_t *self);
+void render_snapshots_publish(render_snapshots_t *self);
+
+/// @brief Lock and return the latest published snapshot, must be paired with render_snapshots_release.
+const render_snapshot_t *render_snapshots_acquire(render_snapshots_t *self);
+void render_snapshots_release(render_snapshots_t *self);
+
+/// @brief Capture every renderable entity, the active camera, the tilemap's edits and the fog. Entities spawned since
+/// the last store_previous_transform_system start where they are rather than interpolating in from nothing.
+void render_snapshot_build(render_snapshot_t *snapshot, world_t *world);
+
+#if UNIT_TEST
+#include <assert.h>
+#include <string.h>
+#include "entities.h"
+#include "engine/memory.h"
+
+static int render_snapshot_unit_tests(void)
+{
+    world_t *world = world_new(0, 0, 4096, 1);
+    entity_t *moving = entity_new(world);
+    set_parent(moving, world->root);
+    moving->render_type = RENDER_TYPE_SPRITE;
+
+    // A step as tick runs it, then one that spawns an entity after the previous transforms were stored.
+    store_previous_transform_system(world);
+    world_step(world);
+    store_previous_transform_system(world);
+    set_pos(&moving->transform, (vec3){10, 0, 0});
+    entity_t *spawned = entity_new(world);
+    set_parent(spawned, world->root);
+    spawned->render_type = RENDER_TYPE_SPRITE;
+    set_pos(&spawned->transform, (vec3){100, 50, 0});
+    set_scale(&spawned->transform, (vec2){2, 3});
+    world_step(world);
+
+    render_snapshot_t snapshot = {0};
+    render_snapshot_build(&snapshot, world);
+    assert(arrlenu(snapshot.arr_items) == 2);
+    for (size_t i = 0; i < 2; i++)
+    {
+        const render_item_t *item = &snapshot.arr_items[i];
+        render_transform_t lerped = {0};
+        render_transform_lerp(&lerped, &item->previous, &item->current, 0.5f);
+        if (item->current.pos[0] == 100)
+        {
+            // Halfway through the frame it's already where it was spawned, at full size.
+            assert(memcmp(lerped.pos, item->current.pos, sizeof(vec3)) == 0 && memcmp(lerped.scale, item->current.scale, sizeof(vec2)) == 0);
+        }
+        else
+        {
+            // Anything that was there before still moves.
+            assert(item->current.pos[0] == 10 && lerped.pos[0] == 5);
+        }
+    }
+
+    arrfree(snapshot.arr_items);
+    world_free(world);
+
+    return 1;
+}
+#endif
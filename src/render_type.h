@@ -0,0 +1,9 @@
+#pragma once
+
+// What an entity draws, and which of its components that means.
+typedef enum render_type_e
+{
+    RENDER_TYPE_NONE = 0,
+    RENDER_TYPE_SPRITE,
+    RENDER_TYPE_TEXT,
+} render_type_e;
\ No newline at end of file
@@ -0,0 +1,693 @@
+#include "replication.h"
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "world_snapshot.h"
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+#define REPLICATION_TURNS_PER_ROTATION 65536
+#define REPLICATION_TAU 6.28318530718f
+// Bits for how many bits a value takes, 0 to 32.
+#define REPLICATION_WIDTH_BITS 6
+// The delta payload starts with the turn, the number of entities and the number that changed, a uint32 each.
+#define REPLICATION_DELTA_HEADER_SIZE 12
+// Read from the socket at a time.
+#define REPLICATION_RECEIVE_CHUNK (64 * 1024)
+
+// Bits are packed least significant first, so a field can straddle bytes.
+typedef struct replication_bit_writer_t
+{
+    uint8_t **arr;
+    uint64_t bits;
+    uint32_t num_bits;
+} replication_bit_writer_t;
+
+typedef struct replication_bit_reader_t
+{
+    const uint8_t *at;
+    const uint8_t *end;
+    uint64_t bits;
+    uint32_t num_bits;
+    // Set by reading past the end, everything read from then on is 0.
+    uint8_t is_overrun;
+} replication_bit_reader_t;
+
+static inline void replication_put_bits(replication_bit_writer_t *writer, uint32_t value, uint32_t count)
+{
+    writer->bits |= (uint64_t)value << writer->num_bits;
+    writer->num_bits += count;
+    while (writer->num_bits >= 8)
+    {
+        arrput(*writer->arr, (uint8_t)writer->bits);
+        writer->bits >>= 8;
+        writer->num_bits -= 8;
+    }
+}
+
+static inline void replication_flush_bits(replication_bit_writer_t *writer)
+{
+    if (writer->num_bits)
+        arrput(*writer->arr, (uint8_t)writer->bits);
+
+    writer->bits = 0;
+    writer->num_bits = 0;
+}
+
+static inline uint32_t replication_get_bits(replication_bit_reader_t *reader, uint32_t count)
+{
+    while (reader->num_bits < count)
+    {
+        if (reader->at == reader->end)
+        {
+            reader->is_overrun = 1;
+            return 0;
+        }
+
+        reader->bits |= (uint64_t)*reader->at++ << reader->num_bits;
+        reader->num_bits += 8;
+    }
+
+    uint32_t value = (uint32_t)(reader->bits & ((1ull << count) - 1));
+    reader->bits >>= count;
+    reader->num_bits -= count;
+    return value;
+}
+
+static inline uint32_t replication_bit_width(uint32_t value)
+{
+    uint32_t width = 0;
+    while (width < 32 && value >> width)
+        width++;
+
+    return width;
+}
+
+// Small moves either way come out as small numbers. Wraps rather than overflows, so applying it undoes it exactly.
+static inline uint32_t replication_zigzag(int32_t to, int32_t from)
+{
+    uint32_t delta = (uint32_t)to - (uint32_t)from;
+    return (delta << 1) ^ (uint32_t)-(int32_t)(delta >> 31);
+}
+
+static inline int32_t replication_unzigzag(int32_t from, uint32_t zigzag)
+{
+    uint32_t delta = (zigzag >> 1) ^ (uint32_t)-(int32_t)(zigzag & 1);
+    return (int32_t)((uint32_t)from + delta);
+}
+
+// A vector's deltas share how many bits they need, most moves are along one axis or by the same amount on each.
+static void replication_put_vector(replication_bit_writer_t *writer, const int32_t *to, const int32_t *from, uint32_t count)
+{
+    uint32_t zigzags[3], width = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        zigzags[i] = replication_zigzag(to[i], from[i]);
+        uint32_t zigzag_width = replication_bit_width(zigzags[i]);
+        width = zigzag_width > width ? zigzag_width : width;
+    }
+
+    replication_put_bits(writer, width, REPLICATION_WIDTH_BITS);
+    for (uint32_t i = 0; i < count; i++)
+        replication_put_bits(writer, zigzags[i], width);
+}
+
+static void replication_get_vector(replication_bit_reader_t *reader, int32_t *values, uint32_t count)
+{
+    uint32_t width = replication_get_bits(reader, REPLICATION_WIDTH_BITS);
+    if (width > 32)
+    {
+        reader->is_overrun = 1;
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        values[i] = replication_unzigzag(values[i], replication_get_bits(reader, width));
+}
+
+// Rounds half away from zero. A cast rather than lroundf, this is six times an entity every turn.
+static inline int64_t replication_round(float value)
+{
+    return (int64_t)(value + (value < 0 ? -0.5f : 0.5f));
+}
+
+static inline int32_t replication_quantise(float value, float steps)
+{
+    // Well inside an int32 either way, and NaN ends up as 0.
+    float scaled = value * steps;
+    if (!(scaled > -1e9f))
+        return scaled != scaled ? 0 : -1000000000;
+    if (scaled > 1e9f)
+        return 1000000000;
+
+    return (int32_t)replication_round(scaled);
+}
+
+// A whole number of turns either way is the same rotation, converting to unsigned wraps it.
+static inline uint16_t replication_quantise_rotation(float radians)
+{
+    float turns = radians * (REPLICATION_TURNS_PER_ROTATION / REPLICATION_TAU);
+    if (!(turns > -1e9f && turns < 1e9f))
+        turns = turns != turns ? 0 : fmodf(turns, REPLICATION_TURNS_PER_ROTATION);
+
+    return (uint16_t)replication_round(turns);
+}
+
+static inline uint32_t replication_quantise_color(const float *color)
+{
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        float channel = color[i] < 0 ? 0 : color[i] > 1 ? 1 : color[i];
+        packed |= (uint32_t)(channel * 255 + 0.5f) << (i * 8);
+    }
+
+    return packed;
+}
+
+static inline uint64_t replication_float_bits(float a, float b)
+{
+    uint32_t a_bits, b_bits;
+    memcpy(&a_bits, &a, sizeof(a_bits));
+    memcpy(&b_bits, &b, sizeof(b_bits));
+    return a_bits | (uint64_t)b_bits << 32;
+}
+
+void replication_state_capture(replication_state_t *self, const world_t *world)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MEMORY_TAG_REPLICATION);
+
+    size_t num_entities = arrlenu(world->entities);
+    assert(num_entities && world->entities[0] == world->root && arrlenu(world->arr_parent_indices) == num_entities);
+    arrsetlen(self->arr_entities, num_entities);
+
+    uint64_t structure = rng_hash(num_entities);
+    for (size_t i = 0; i < num_entities; i++)
+    {
+        const entity_t *entity = world->entities[i];
+        const transform_t *transform = &entity->transform;
+        replication_entity_t *replicated = &self->arr_entities[i];
+
+        for (uint32_t axis = 0; axis < 3; axis++)
+            replicated->pos[axis] = replication_quantise(transform->pos[axis], REPLICATION_POSITION_STEPS);
+        for (uint32_t axis = 0; axis < 2; axis++)
+            replicated->scale[axis] = replication_quantise(transform->scale[axis], REPLICATION_SCALE_STEPS);
+
+        replicated->rotation = replication_quantise_rotation(transform->rotation);
+        replicated->flags = (uint8_t)((entity->is_hidden ? 1 : 0) | transform->flip_flags << 1);
+        replicated->color = entity->render_type == RENDER_TYPE_SPRITE ? replication_quantise_color(entity->sprite.color) : 0;
+
+        // Pointers are fine here, this is only ever compared with another capture in the same process.
+        structure = rng_hash_fold(structure, world->arr_parent_indices[i] | (uint64_t)entity->render_type << 32 | (uint64_t)entity->has_camera << 40);
+        if (entity->render_type == RENDER_TYPE_SPRITE)
+        {
+            structure = rng_hash_fold(structure, (uint64_t)(uintptr_t)entity->sprite.texture);
+            structure = rng_hash_fold(structure, replication_float_bits(entity->sprite.anchor[0], entity->sprite.anchor[1]));
+        }
+        else if (entity->render_type == RENDER_TYPE_TEXT)
+        {
+            structure = rng_hash_fold(structure, (uint64_t)(uintptr_t)entity->text.text);
+            structure = rng_hash_fold(structure, (uint64_t)(uintptr_t)entity->text.font);
+            structure = rng_hash_fold(structure, replication_float_bits(entity->text.font_size, 0));
+        }
+
+        if (entity->has_camera)
+        {
+            structure = rng_hash_fold(structure, replication_float_bits(entity->camera.pos[0], entity->camera.pos[1]));
+            structure = rng_hash_fold(structure, replication_float_bits(entity->camera.aspect, entity->camera.size));
+        }
+    }
+
+    self->structure = rng_hash(structure);
+}
+
+void replication_state_free(replication_state_t *self)
+{
+    arrfree(self->arr_entities);
+    *self = (replication_state_t){0};
+}
+
+uint8_t replication_state_can_delta(const replication_state_t *from, const replication_state_t *to)
+{
+    return arrlenu(from->arr_entities) == arrlenu(to->arr_entities) && from->structure == to->structure;
+}
+
+static void replication_put_message_header(uint8_t **arr, uint32_t size, replication_message_type_e type)
+{
+    uint8_t *header = arraddnptr(*arr, REPLICATION_MESSAGE_HEADER_SIZE);
+    memcpy(header, &size, sizeof(size));
+    header[4] = (uint8_t)type;
+}
+
+uint32_t replication_encode_delta(const replication_state_t *from, const replication_state_t *to, uint32_t turn, uint8_t **arr_out)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MEMORY_TAG_REPLICATION);
+    assert(replication_state_can_delta(from, to));
+
+    uint32_t num_entities = (uint32_t)arrlenu(to->arr_entities);
+    arrsetlen(*arr_out, 0);
+    replication_put_message_header(arr_out, 0, REPLICATION_MESSAGE_DELTA);
+
+    replication_bit_writer_t writer = {.arr = arr_out};
+    replication_put_bits(&writer, turn, 32);
+    replication_put_bits(&writer, num_entities, 32);
+    // How many changed, filled in at the end.
+    replication_put_bits(&writer, 0, 32);
+
+    uint32_t num_changed = 0, last_changed = 0;
+    for (uint32_t i = 0; i < num_entities; i++)
+    {
+        const replication_entity_t *before = &from->arr_entities[i], *after = &to->arr_entities[i];
+
+        uint32_t changes = 0;
+        if (before->pos[0] != after->pos[0] || before->pos[1] != after->pos[1] || before->pos[2] != after->pos[2])
+            changes |= REPLICATION_CHANGE_POSITION;
+        if (before->scale[0] != after->scale[0] || before->scale[1] != after->scale[1])
+            changes |= REPLICATION_CHANGE_SCALE;
+        if (before->rotation != after->rotation)
+            changes |= REPLICATION_CHANGE_ROTATION;
+        if (before->color != after->color)
+            changes |= REPLICATION_CHANGE_COLOR;
+        if (before->flags != after->flags)
+            changes |= REPLICATION_CHANGE_FLAGS;
+
+        if (!changes)
+            continue;
+
+        // How far on from the last one that changed, so a cluster of them is a few bits each.
+        uint32_t gap = i - (num_changed ? last_changed + 1 : 0);
+        uint32_t gap_width = replication_bit_width(gap);
+        replication_put_bits(&writer, gap_width, REPLICATION_WIDTH_BITS);
+        replication_put_bits(&writer, gap, gap_width);
+        replication_put_bits(&writer, changes, REPLICATION_CHANGE_BITS);
+
+        if (changes & REPLICATION_CHANGE_POSITION)
+            replication_put_vector(&writer, after->pos, before->pos, 3);
+        if (changes & REPLICATION_CHANGE_SCALE)
+            replication_put_vector(&writer, after->scale, before->scale, 2);
+        if (changes & REPLICATION_CHANGE_ROTATION)
+            replication_put_bits(&writer, after->rotation, 16);
+        if (changes & REPLICATION_CHANGE_COLOR)
+            replication_put_bits(&writer, after->color, 32);
+        if (changes & REPLICATION_CHANGE_FLAGS)
+            replication_put_bits(&writer, after->flags, 3);
+
+        num_changed++;
+        last_changed = i;
+    }
+    replication_flush_bits(&writer);
+
+    uint32_t size = (uint32_t)arrlenu(*arr_out) - REPLICATION_MESSAGE_HEADER_SIZE;
+    memcpy(*arr_out, &size, sizeof(size));
+    memcpy(*arr_out + REPLICATION_MESSAGE_HEADER_SIZE + 8, &num_changed, sizeof(num_changed));
+
+    return num_changed;
+}
+
+static void replication_apply_entity(entity_t *entity, const replication_entity_t *replicated, uint32_t changes)
+{
+    transform_t *transform = &entity->transform;
+
+    if (changes & REPLICATION_CHANGE_POSITION)
+    {
+        vec3 pos;
+        for (uint32_t axis = 0; axis < 3; axis++)
+            pos[axis] = (float)replicated->pos[axis] / REPLICATION_POSITION_STEPS;
+        set_pos(transform, pos);
+    }
+
+    if (changes & REPLICATION_CHANGE_SCALE)
+        set_scale(transform, (vec2){(float)replicated->scale[0] / REPLICATION_SCALE_STEPS, (float)replicated->scale[1] / REPLICATION_SCALE_STEPS});
+
+    if (changes & REPLICATION_CHANGE_ROTATION)
+        set_rotation(transform, (float)replicated->rotation * (REPLICATION_TAU / REPLICATION_TURNS_PER_ROTATION));
+
+    if ((changes & REPLICATION_CHANGE_COLOR) && entity->render_type == RENDER_TYPE_SPRITE)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+            entity->sprite.color[i] = (float)((replicated->color >> (i * 8)) & 0xff) / 255;
+    }
+
+    if (changes & REPLICATION_CHANGE_FLAGS)
+    {
+        entity->is_hidden = replicated->flags & 1;
+        set_flip(transform, replicated->flags >> 1);
+    }
+}
+
+// Once to check the whole delta is there, then again to apply it, so a bad one changes nothing.
+static uint8_t replication_read_delta(replication_state_t *state, world_t *world, const uint8_t *data, size_t size, uint8_t is_applying)
+{
+    if (size < REPLICATION_DELTA_HEADER_SIZE)
+        return 0;
+
+    replication_bit_reader_t reader = {.at = data, .end = data + size};
+    replication_get_bits(&reader, 32);
+    uint32_t num_entities = replication_get_bits(&reader, 32);
+    uint32_t num_changed = replication_get_bits(&reader, 32);
+    if (num_entities != arrlenu(state->arr_entities) || num_entities != arrlenu(world->entities))
+        return 0;
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < num_changed && !reader.is_overrun; i++)
+    {
+        uint32_t gap_width = replication_get_bits(&reader, REPLICATION_WIDTH_BITS);
+        if (gap_width > 32)
+            return 0;
+
+        uint32_t gap = replication_get_bits(&reader, gap_width);
+        if (gap >= num_entities - index)
+            return 0;
+
+        index += gap;
+        uint32_t changes = replication_get_bits(&reader, REPLICATION_CHANGE_BITS);
+
+        // Only written to when it's being applied, checking reads into a copy.
+        replication_entity_t replicated = state->arr_entities[index];
+        if (changes & REPLICATION_CHANGE_POSITION)
+            replication_get_vector(&reader, replicated.pos, 3);
+        if (changes & REPLICATION_CHANGE_SCALE)
+            replication_get_vector(&reader, replicated.scale, 2);
+        if (changes & REPLICATION_CHANGE_ROTATION)
+            replicated.rotation = (uint16_t)replication_get_bits(&reader, 16);
+        if (changes & REPLICATION_CHANGE_COLOR)
+            replicated.color = replication_get_bits(&reader, 32);
+        if (changes & REPLICATION_CHANGE_FLAGS)
+            replicated.flags = (uint8_t)replication_get_bits(&reader, 3);
+
+        if (is_applying)
+        {
+            state->arr_entities[index] = replicated;
+            replication_apply_entity(world->entities[index], &replicated, changes);
+        }
+
+        index++;
+    }
+
+    return !reader.is_overrun;
+}
+
+uint8_t replication_apply_delta(replication_state_t *state, world_t *world, const uint8_t *data, size_t size)
+{
+    PROFILE_FUNCTION();
+
+    if (!replication_read_delta(state, world, data, size, 0))
+        return 0;
+
+    return replication_read_delta(state, world, data, size, 1);
+}
+
+replication_server_t replication_server_new(uint16_t port)
+{
+    replication_server_t result = {0};
+    result.listener = net_listen(port, &result.port);
+    return result;
+}
+
+static void replication_subscriber_free(replication_subscriber_t *subscriber)
+{
+    net_close(subscriber->socket);
+    arrfree(subscriber->arr_pending);
+}
+
+void replication_server_free(replication_server_t *self)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_subscribers); i++)
+        replication_subscriber_free(&self->arr_subscribers[i]);
+    arrfree(self->arr_subscribers);
+    net_close(self->listener);
+
+    replication_state_free(&self->baseline);
+    replication_state_free(&self->current);
+    arrfree(self->arr_keyframe);
+    arrfree(self->arr_delta);
+
+    *self = (replication_server_t){0};
+}
+
+// As much as the socket will take. 0 once the subscriber has gone or fallen too far behind to keep.
+static uint8_t replication_subscriber_flush(replication_subscriber_t *subscriber)
+{
+    size_t num_pending = arrlenu(subscriber->arr_pending) - subscriber->pending_offset;
+    while (num_pending)
+    {
+        int64_t sent = net_send(subscriber->socket, subscriber->arr_pending + subscriber->pending_offset, num_pending);
+        if (sent < 0)
+            return 0;
+        if (!sent)
+            break;
+
+        subscriber->pending_offset += (size_t)sent;
+        num_pending -= (size_t)sent;
+    }
+
+    if (!num_pending)
+    {
+        arrsetlen(subscriber->arr_pending, 0);
+        subscriber->pending_offset = 0;
+    }
+
+    return num_pending <= REPLICATION_MAX_PENDING_BYTES;
+}
+
+static void replication_subscriber_queue(replication_subscriber_t *subscriber, const uint8_t *data, size_t size)
+{
+    MEMORY_SCOPE(MEMORY_TAG_REPLICATION);
+    memcpy(arraddnptr(subscriber->arr_pending, size), data, size);
+}
+
+void replication_server_flush(replication_server_t *self)
+{
+    for (size_t i = 0; i < arrlenu(self->arr_subscribers);)
+    {
+        if (replication_subscriber_flush(&self->arr_subscribers[i]))
+        {
+            i++;
+            continue;
+        }
+
+        replication_subscriber_free(&self->arr_subscribers[i]);
+        arrdelswap(self->arr_subscribers, i);
+    }
+}
+
+static float replication_ms_since(uint64_t start)
+{
+    return (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+void replication_server_publish(replication_server_t *self, const world_t *world)
+{
+    PROFILE_FUNCTION();
+    replication_stats_t *stats = &self->stats;
+
+    for (net_socket_t socket; self->listener != NET_INVALID_SOCKET && (socket = net_accept(self->listener)) != NET_INVALID_SOCKET;)
+    {
+        MEMORY_SCOPE(MEMORY_TAG_REPLICATION);
+        arrput(self->arr_subscribers, ((replication_subscriber_t){.socket = socket, .needs_keyframe = 1}));
+    }
+
+    uint32_t turn = self->turn++;
+    stats->num_subscribers = (uint32_t)arrlenu(self->arr_subscribers);
+    stats->num_changed = 0;
+    stats->delta_bytes = 0;
+    stats->encode_ms = 0;
+    stats->send_ms = 0;
+
+    // Nobody to send it to, whoever connects next starts from a keyframe anyway.
+    if (!stats->num_subscribers)
+    {
+        self->has_baseline = 0;
+        return;
+    }
+
+    uint64_t encode_start = SDL_GetPerformanceCounter();
+    replication_state_capture(&self->current, world);
+
+    uint8_t is_delta = self->has_baseline && replication_state_can_delta(&self->baseline, &self->current);
+    if (is_delta)
+    {
+        stats->num_changed = replication_encode_delta(&self->baseline, &self->current, turn, &self->arr_delta);
+        stats->delta_bytes = (uint32_t)arrlenu(self->arr_delta);
+        stats->total_delta_bytes += stats->delta_bytes;
+        stats->num_deltas++;
+    }
+
+    uint8_t needs_keyframe = !is_delta;
+    for (size_t i = 0; i < arrlenu(self->arr_subscribers); i++)
+    {
+        self->arr_subscribers[i].needs_keyframe |= !is_delta;
+        needs_keyframe |= self->arr_subscribers[i].needs_keyframe;
+    }
+
+    // The snapshot's own bytes, the header and turn in front of it are queued separately rather than copied in.
+    uint8_t keyframe_header[REPLICATION_MESSAGE_HEADER_SIZE + sizeof(uint32_t)];
+    if (needs_keyframe)
+    {
+        world_snapshot_save(world, &self->arr_keyframe);
+
+        uint32_t size = (uint32_t)(arrlenu(self->arr_keyframe) + sizeof(uint32_t));
+        memcpy(keyframe_header, &size, sizeof(size));
+        keyframe_header[4] = REPLICATION_MESSAGE_KEYFRAME;
+        memcpy(keyframe_header + REPLICATION_MESSAGE_HEADER_SIZE, &turn, sizeof(turn));
+
+        stats->num_keyframes++;
+        stats->total_keyframe_bytes += sizeof(keyframe_header) + arrlenu(self->arr_keyframe);
+    }
+
+    stats->encode_ms = replication_ms_since(encode_start);
+    stats->total_encode_ms += stats->encode_ms;
+
+    uint64_t send_start = SDL_GetPerformanceCounter();
+    for (size_t i = 0; i < arrlenu(self->arr_subscribers); i++)
+    {
+        replication_subscriber_t *subscriber = &self->arr_subscribers[i];
+        if (subscriber->needs_keyframe)
+        {
+            replication_subscriber_queue(subscriber, keyframe_header, sizeof(keyframe_header));
+            replication_subscriber_queue(subscriber, self->arr_keyframe, arrlenu(self->arr_keyframe));
+            subscriber->needs_keyframe = 0;
+        }
+        else
+        {
+            replication_subscriber_queue(subscriber, self->arr_delta, arrlenu(self->arr_delta));
+        }
+    }
+    replication_server_flush(self);
+
+    stats->send_ms = replication_ms_since(send_start);
+    stats->total_send_ms += stats->send_ms;
+    stats->num_subscriber_turns += stats->num_subscribers;
+    stats->num_turns++;
+
+    // This turn is what the next one is diffed against.
+    replication_state_t baseline = self->baseline;
+    self->baseline = self->current;
+    self->current = baseline;
+    self->has_baseline = 1;
+}
+
+replication_client_t replication_client_new(const char *host, uint16_t port)
+{
+    return (replication_client_t){.socket = net_connect(host, port)};
+}
+
+void replication_client_free(replication_client_t *self)
+{
+    net_close(self->socket);
+    arrfree(self->arr_received);
+    replication_state_free(&self->state);
+
+    *self = (replication_client_t){0};
+}
+
+static void replication_client_disconnect(replication_client_t *self)
+{
+    net_close(self->socket);
+    self->socket = NET_INVALID_SOCKET;
+    self->is_disconnected = 1;
+}
+
+static uint8_t replication_client_apply(replication_client_t *self, world_t *world, uint8_t type, const uint8_t *payload, uint32_t size)
+{
+    if (size < sizeof(uint32_t))
+        return 0;
+
+    uint32_t turn;
+    memcpy(&turn, payload, sizeof(turn));
+
+    if (type == REPLICATION_MESSAGE_KEYFRAME)
+    {
+        entity_free_all(world);
+        if (!world_snapshot_load(world, payload + sizeof(turn), size - sizeof(turn)))
+            return 0;
+
+        // Flattened so deltas can find entities by the same index as the server.
+        update_global_system(world);
+        replication_state_capture(&self->state, world);
+        self->has_keyframe = 1;
+        self->num_keyframes++;
+    }
+    else if (type == REPLICATION_MESSAGE_DELTA)
+    {
+        if (!self->has_keyframe || !replication_apply_delta(&self->state, world, payload, size))
+            return 0;
+
+        self->num_deltas++;
+    }
+    else
+    {
+        return 0;
+    }
+
+    self->turn = turn;
+    return 1;
+}
+
+uint32_t replication_client_poll(replication_client_t *self, world_t *world)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MEMORY_TAG_REPLICATION);
+
+    if (self->socket == NET_INVALID_SOCKET)
+        return 0;
+
+    for (;;)
+    {
+        size_t num_received = arrlenu(self->arr_received);
+        int64_t received = net_recv(self->socket, arraddnptr(self->arr_received, REPLICATION_RECEIVE_CHUNK), REPLICATION_RECEIVE_CHUNK);
+        arrsetlen(self->arr_received, num_received + (received > 0 ? (size_t)received : 0));
+
+        if (received < 0)
+        {
+            // Whatever arrived before it closed is still applied.
+            replication_client_disconnect(self);
+            break;
+        }
+
+        self->bytes_received += (uint64_t)received;
+        // The rest waits in the socket until what's buffered has been applied.
+        if (received < REPLICATION_RECEIVE_CHUNK || arrlenu(self->arr_received) >= REPLICATION_MAX_PENDING_BYTES)
+            break;
+    }
+
+    uint64_t apply_start = SDL_GetPerformanceCounter();
+    uint32_t num_applied = 0;
+    size_t offset = 0, num_received = arrlenu(self->arr_received);
+    while (num_received - offset >= REPLICATION_MESSAGE_HEADER_SIZE)
+    {
+        const uint8_t *header = self->arr_received + offset;
+        uint32_t size;
+        memcpy(&size, header, sizeof(size));
+        // The size comes off the network, waiting for more than this would buffer whatever the other end sends.
+        if (size > REPLICATION_MAX_PENDING_BYTES)
+        {
+            replication_client_disconnect(self);
+            offset = num_received;
+            break;
+        }
+        if (num_received - offset - REPLICATION_MESSAGE_HEADER_SIZE < size)
+            break;
+
+        // Nothing after a message that can't be applied can be trusted either.
+        if (!replication_client_apply(self, world, header[4], header + REPLICATION_MESSAGE_HEADER_SIZE, size))
+        {
+            replication_client_disconnect(self);
+            offset = num_received;
+            break;
+        }
+
+        offset += REPLICATION_MESSAGE_HEADER_SIZE + size;
+        num_applied++;
+    }
+
+    if (offset)
+        arrdeln(self->arr_received, 0, offset);
+    if (num_applied)
+        self->apply_ms = replication_ms_since(apply_start);
+
+    return num_applied;
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "entities.h"
+#include "engine/net.h"
+
+// Deltas round positions to 1/16 of a unit, scales to 1/256, rotations to 1/65536 of a turn and colours to a byte.
+#define REPLICATION_POSITION_STEPS 16
+#define REPLICATION_SCALE_STEPS 256
+
+// A subscriber this far behind is dropped rather than queued for forever. A spectator drops a server that says a
+// message is any bigger, rather than buffering until it arrives.
+#define REPLICATION_MAX_PENDING_BYTES (64 * 1024 * 1024)
+
+typedef enum replication_message_type_e
+{
+    // A uint32 turn then a whole world snapshot, see world_snapshot.h. Sent to new subscribers, and to everyone when
+    // the hierarchy or what an entity draws changes.
+    REPLICATION_MESSAGE_KEYFRAME = 1,
+    // Bit packed, only the entities whose quantised state changed since the last turn.
+    REPLICATION_MESSAGE_DELTA,
+} replication_message_type_e;
+
+// Every message starts with its size, not counting this header, then its type.
+#define REPLICATION_MESSAGE_HEADER_SIZE 5
+
+// Which parts of a replication_entity_t a delta carries for an entity.
+typedef enum replication_change_e
+{
+    REPLICATION_CHANGE_POSITION = 1 << 0,
+    REPLICATION_CHANGE_SCALE = 1 << 1,
+    REPLICATION_CHANGE_ROTATION = 1 << 2,
+    REPLICATION_CHANGE_COLOR = 1 << 3,
+    REPLICATION_CHANGE_FLAGS = 1 << 4,
+} replication_change_e;
+#define REPLICATION_CHANGE_BITS 5
+
+/// @brief An entity as a spectator sees it, quantised the way deltas send it.
+typedef struct replication_entity_t
+{
+    int32_t pos[3];
+    int32_t scale[2];
+    uint16_t rotation;
+    // is_hidden then the two flip flags.
+    uint8_t flags;
+    uint32_t color;
+} replication_entity_t;
+
+/// @brief Every entity in hierarchy order, as of the last turn sent or received.
+typedef struct replication_state_t
+{
+    replication_entity_t *arr_entities;
+    // Everything only a keyframe can send, every entity's parent, what it draws and its camera, hashed.
+    uint64_t structure;
+} replication_state_t;
+
+/// @brief Quantise every entity, needs the hierarchy flattened like world_snapshot_save.
+void replication_state_capture(replication_state_t *self, const world_t *world);
+void replication_state_free(replication_state_t *self);
+
+/// @brief Whether everything that changed from from to to can go in a delta, the same entities with the same parents
+/// drawing the same things.
+uint8_t replication_state_can_delta(const replication_state_t *from, const replication_state_t *to);
+
+/// @brief The whole message, header included, taking a spectator from from to to. Only valid when
+/// replication_state_can_delta.
+/// @return Entities that changed.
+uint32_t replication_encode_delta(const replication_state_t *from, const replication_state_t *to, uint32_t turn, uint8_t **arr_out);
+
+/// @brief Apply a delta's payload, everything after the message header, to the entities and to state.
+/// @return 0 if it's cut short or for a different number of entities, nothing is applied.
+uint8_t replication_apply_delta(replication_state_t *state, world_t *world, const uint8_t *data, size_t size);
+
+typedef struct replication_subscriber_t
+{
+    net_socket_t socket;
+    // Messages queued for the socket, the first pending_offset bytes already gone.
+    uint8_t *arr_pending;
+    size_t pending_offset;
+    uint8_t needs_keyframe;
+} replication_subscriber_t;
+
+typedef struct replication_stats_t
+{
+    // Turns sent, and how many of them encoded a keyframe or a delta, it can be both when someone joins.
+    uint32_t num_turns;
+    uint32_t num_keyframes;
+    uint32_t num_deltas;
+    // Last turn.
+    uint32_t num_changed;
+    uint32_t delta_bytes;
+    float encode_ms;
+    float send_ms;
+    uint32_t num_subscribers;
+
+    // Totals, every turn's message counted once however many subscribers it went to.
+    uint64_t total_delta_bytes;
+    uint64_t total_keyframe_bytes;
+    double total_encode_ms;
+    // Summed over subscribers, divided by subscriber turns it's the cost of one more spectator.
+    double total_send_ms;
+    uint64_t num_subscriber_turns;
+} replication_stats_t;
+
+/// @brief Streams the world to any number of spectators, a delta each turn after a keyframe to start from.
+typedef struct replication_server_t
+{
+    net_socket_t listener;
+    uint16_t port;
+    replication_subscriber_t *arr_subscribers;
+
+    uint32_t turn;
+    // As of the last turn sent, and this turn's, swapped after every turn.
+    replication_state_t baseline;
+    replication_state_t current;
+    uint8_t has_baseline;
+
+    // This turn's messages, kept for their capacity.
+    uint8_t *arr_keyframe;
+    uint8_t *arr_delta;
+
+    replication_stats_t stats;
+} replication_server_t;
+
+/// @param port 0 for any free one, whichever it got is in port. listener is NET_INVALID_SOCKET if it can't bind.
+replication_server_t replication_server_new(uint16_t port);
+void replication_server_free(replication_server_t *self);
+
+/// @brief One turn. Picks up new subscribers, then sends everyone the changes since the last turn, or a keyframe to
+/// whoever needs one. Needs the hierarchy flattened.
+void replication_server_publish(replication_server_t *self, const world_t *world);
+
+/// @brief Push out whatever the sockets will take without blocking, publish does this too.
+void replication_server_flush(replication_server_t *self);
+
+typedef struct replication_client_t
+{
+    net_socket_t socket;
+    // Bytes received that aren't a whole message yet.
+    uint8_t *arr_received;
+
+    replication_state_t state;
+    uint8_t has_keyframe;
+    uint32_t turn;
+    uint8_t is_disconnected;
+
+    uint64_t bytes_received;
+    uint32_t num_keyframes;
+    uint32_t num_deltas;
+    float apply_ms;
+} replication_client_t;
+
+/// @brief Blocks until connected, socket is NET_INVALID_SOCKET if nothing answers.
+replication_client_t replication_client_new(const char *host, uint16_t port);
+void replication_client_free(replication_client_t *self);
+
+/// @brief Apply every whole message that has arrived. A keyframe replaces everything under world->root, the textures
+/// and fonts it uses have to be in world's cache already.
+/// @return Messages applied.
+uint32_t replication_client_poll(replication_client_t *self, world_t *world);
+
+#if UNIT_TEST
+#include <assert.h>
+#include <string.h>
+#include "asset_cache.h"
+#include "engine/memory.h"
+
+static void replication_unit_tests_sync(replication_server_t *server, replication_client_t *client, world_t *world)
+{
+    for (uint32_t i = 0; i < 100000 && (!client->has_keyframe || client->turn != server->turn - 1); i++)
+    {
+        replication_server_flush(server);
+        replication_client_poll(client, world);
+    }
+    assert(client->has_keyframe && client->turn == server->turn - 1);
+}
+
+static int replication_unit_tests(void)
+{
+    asset_cache_t cache = {0};
+    sh_new_strdup(cache.sh_textures);
+    shput(cache.sh_textures, "a.png", ((texture_t){0}));
+
+    world_t *world = world_new(&cache, 0, FRAME_ARENA_SIZE, 1);
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        entity_t *entity = entity_new(world);
+        set_parent(entity, i ? world->entities[i] : world->root);
+        set_pos(&entity->transform, (vec3){(float)i * 10, 5, 1});
+        entity->render_type = RENDER_TYPE_SPRITE;
+        entity->sprite.texture = &shget(cache.sh_textures, "a.png");
+        memcpy(entity->sprite.color, (vec4){1, 1, 1, 1}, sizeof(vec4));
+    }
+    update_global_system(world);
+
+    // Everything over localhost, a keyframe to start with and then deltas.
+    net_init();
+    replication_server_t server = replication_server_new(0);
+    assert(server.listener != NET_INVALID_SOCKET);
+    replication_client_t client = replication_client_new("127.0.0.1", server.port);
+    assert(client.socket != NET_INVALID_SOCKET);
+
+    world_t *spectator = world_new(&cache, 0, FRAME_ARENA_SIZE, 1);
+    replication_server_publish(&server, world);
+    replication_unit_tests_sync(&server, &client, spectator);
+    update_global_system(spectator);
+    assert(client.num_keyframes == 1 && arrlenu(spectator->entities) == arrlenu(world->entities));
+
+    // Small moves still add up, the server diffs against what it sent rather than what it had.
+    for (uint32_t turn = 0; turn < 20; turn++)
+    {
+        entity_t *moved = world->entities[1 + turn % 10];
+        set_pos(&moved->transform, (vec3){moved->transform.pos[0] + 0.05f, moved->transform.pos[1] - 3.3f, 1});
+        world->entities[40]->is_hidden = turn % 2;
+        replication_server_publish(&server, world);
+        replication_unit_tests_sync(&server, &client, spectator);
+    }
+    assert(client.num_keyframes == 1 && client.num_deltas == 20);
+    assert(server.stats.num_changed == 2 && server.stats.delta_bytes < 32);
+
+    for (size_t i = 0; i < arrlenu(world->entities); i++)
+    {
+        const transform_t *sent = &world->entities[i]->transform, *received = &spectator->entities[i]->transform;
+        assert(fabsf(sent->pos[0] - received->pos[0]) <= 0.5f / REPLICATION_POSITION_STEPS);
+        assert(fabsf(sent->pos[1] - received->pos[1]) <= 0.5f / REPLICATION_POSITION_STEPS);
+        assert(world->entities[i]->is_hidden == spectator->entities[i]->is_hidden);
+    }
+
+    // A new entity can't go in a delta, everyone gets a keyframe.
+    set_parent(entity_new(world), world->root);
+    update_global_system(world);
+    replication_server_publish(&server, world);
+    replication_unit_tests_sync(&server, &client, spectator);
+    update_global_system(spectator);
+    assert(client.num_keyframes == 2 && arrlenu(spectator->entities) == arrlenu(world->entities));
+
+    replication_client_free(&client);
+    replication_server_free(&server);
+    net_shutdown();
+
+    world_free(spectator);
+    world_free(world);
+    shfree(cache.sh_textures);
+
+    return 1;
+}
+#endif
\ No newline at end of file
@@ -2,4 +2,74 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Every setting can be overridden from the command line, eg. -DPROFILER_ENABLED=1.
+
+#ifndef UNIT_TEST
 #define UNIT_TEST false
+#endif
+
+// Record CPU zones with the profiler in engine/profiler.h, press F9 in game to dump ./profile.json.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED false
+#endif
+
+// Account every engine allocation to a subsystem tag, see engine/memory.h. Press F10 in game to dump the stats.
+#ifndef MEMORY_TRACKING
+#define MEMORY_TRACKING true
+#endif
+
+// Starting size of each half of the per-frame and per-step arenas, see engine/arena.h. They grow to fit if it's not enough.
+#ifndef FRAME_ARENA_SIZE
+#define FRAME_ARENA_SIZE (4 * 1024 * 1024)
+#endif
+
+// Threads in the job system besides the one handing out the work, -1 for one per core less one. 0 runs it all inline.
+#ifndef JOB_WORKER_THREADS
+#define JOB_WORKER_THREADS -1
+#endif
+
+// Simulation steps per second, independent of the frame rate.
+#ifndef SIM_TICK_RATE
+#define SIM_TICK_RATE 60
+#endif
+// Most steps run in one go to catch up after a slow frame, beyond that the simulation slows down instead.
+#ifndef SIM_MAX_CATCHUP_STEPS
+#define SIM_MAX_CATCHUP_STEPS 5
+#endif
+// Simulation steps between turns with --players, each turn everyone acts and the fog is uploaded again.
+#ifndef PLAYER_TURN_STEPS
+#define PLAYER_TURN_STEPS SIM_TICK_RATE
+#endif
+// Simulation steps between the world being sent to --serve's spectators, 10 times a second by default.
+#ifndef REPLICATION_STEPS
+#define REPLICATION_STEPS (SIM_TICK_RATE / 10)
+#endif
+// Starting size of each half of a dedicated server match's step arena, small since there are many matches. See ./server.
+#ifndef SERVER_ARENA_SIZE
+#define SERVER_ARENA_SIZE (64 * 1024)
+#endif
+// Turns between the keyframes a match journal keeps, seeking replays at most this many. See src/journal.h.
+#ifndef JOURNAL_KEYFRAME_TURNS
+#define JOURNAL_KEYFRAME_TURNS 64
+#endif
+// Run the simulation on its own thread, rendering draws from double buffered snapshots either way.
+#ifndef THREADED_SIMULATION
+#define THREADED_SIMULATION false
+#endif
+
+// Frame rate cap, 0 for uncapped. Waits sleep for most of the frame rather than spinning.
+#ifndef TARGET_FPS
+#define TARGET_FPS 144
+#endif
+// Frame rate while the window is unfocused or minimised.
+#ifndef BACKGROUND_FPS
+#define BACKGROUND_FPS 15
+#endif
+// -1 adaptive (falls back to on), 0 off, 1 on.
+#ifndef VSYNC_MODE
+#define VSYNC_MODE -1
+#endif
+// Window title and stats overlay text are only rebuilt this often, setting the title is an expensive window manager call.
+#ifndef TITLE_UPDATE_INTERVAL_MS
+#define TITLE_UPDATE_INTERVAL_MS 500
+#endif
@@ -1,7 +1,8 @@
 #pragma once
-#include "texture.h"
 #include "vendor/linmath.h"
 
+typedef struct texture_t texture_t;
+
 typedef struct sprite_t
 {
     vec2 anchor;
@@ -1,18 +1,75 @@
 #include "sprite_batch.h"
 #include "engine/engine.h"
+#include "engine/profiler.h"
 #include "sprite.h"
 #include "camera.h"
 #include "text.h"
 #include "font.h"
 #include <stdlib.h>
-#include "vendor/stb_ds.h"
+#include <string.h>
+#include "engine/memory.h"
+#include "engine/arena.h"
 #include <assert.h>
-#include "entities.h"
+#include "app.h"
+#include "render_snapshot.h"
 
-sprite_batch_t sprite_batch_new(GLuint program, size_t max_batch_size)
+// Both triangles of a quad, as corners of sprite_quad_t.
+static const uint8_t sprite_quad_corners[6] = {0, 1, 2, 0, 2, 3};
+
+static size_t sprite_vertex_size(sprite_vertex_format_e format)
+{
+    return format == SPRITE_VERTEX_FORMAT_COMPACT ? sizeof(compact_vertex_t) : sizeof(vertex_t);
+}
+
+static size_t sprite_index_size(GLenum index_type)
+{
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+GLuint quad_index_buffer_new(size_t num_quads, memory_tag_e tag, GLenum *index_type)
+{
+    size_t num_indices = num_quads * 6;
+    *index_type = num_quads * 4 <= UINT16_MAX + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    size_t index_size = sprite_index_size(*index_type);
+
+    // Only needed until it's uploaded.
+    arena_t *arena = frame_arena_get();
+    size_t mark = arena_mark(arena);
+    uint8_t *indices = arena_alloc(arena, num_indices * index_size, index_size);
+    for (size_t i = 0; i < num_indices; i++)
+    {
+        uint32_t index = (uint32_t)(i / 6 * 4 + sprite_quad_corners[i % 6]);
+        if (*index_type == GL_UNSIGNED_SHORT)
+            ((uint16_t *)indices)[i] = (uint16_t)index;
+        else
+            ((uint32_t *)indices)[i] = index;
+    }
+
+    GLuint result;
+    GL_CALL(glCreateBuffers(1, &result));
+    GL_CALL(glNamedBufferStorage(result, num_indices * index_size, indices, 0));
+    memory_gpu_alloc(tag, num_indices * index_size);
+    glObjectLabel(GL_BUFFER, result, -1, "IndexBuffer(quads)");
+
+    arena_rewind(arena, mark);
+
+    return result;
+}
+
+void quad_index_buffer_free(GLuint buffer, size_t num_quads, memory_tag_e tag, GLenum index_type)
+{
+    glDeleteBuffers(1, &buffer);
+    memory_gpu_free(tag, num_quads * 6 * sprite_index_size(index_type));
+}
+
+sprite_batch_t sprite_batch_new(GLuint program, const sprite_batch_options_t *options)
 {
     sprite_batch_t result = {0};
     result.program = program;
+    result.vertex_format = options->vertex_format;
+    result.vertex_size = sprite_vertex_size(options->vertex_format);
+    result.vertices_per_quad = options->indexed ? 4 : 6;
+    result.max_batch_size = options->max_batch_size;
 
     glCreateVertexArrays(1, &result.vertex_array);
     glBindVertexArray(result.vertex_array);
@@ -20,19 +77,38 @@ sprite_batch_t sprite_batch_new(GLuint program, size_t max_batch_size)
     glCreateBuffers(1, &result.vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, result.vertex_buffer);
 
+    GLsizei stride = (GLsizei)result.vertex_size;
     GL_CALL(glEnableVertexAttribArray(0));
-    GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void *)0));
     GL_CALL(glEnableVertexAttribArray(1));
-    GL_CALL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex_t), (const void *)offsetof(vertex_t, uv)));
     GL_CALL(glEnableVertexAttribArray(2));
-    GL_CALL(glVertexAttribPointer(2, 4, GL_FLOAT, GL_TRUE, sizeof(vertex_t), (const void *)offsetof(vertex_t, color)));
+    if (result.vertex_format == SPRITE_VERTEX_FORMAT_COMPACT)
+    {
+        // z and w of the position come out as 0 and 1 like the float format's.
+        GL_CALL(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(compact_vertex_t, pos)));
+        GL_CALL(glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (const void *)offsetof(compact_vertex_t, uv)));
+        GL_CALL(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (const void *)offsetof(compact_vertex_t, color)));
+    }
+    else
+    {
+        GL_CALL(glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(vertex_t, pos)));
+        GL_CALL(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(vertex_t, uv)));
+        GL_CALL(glVertexAttribPointer(2, 4, GL_FLOAT, GL_TRUE, stride, (const void *)offsetof(vertex_t, color)));
+    }
+
+    if (options->indexed)
+    {
+        result.index_buffer = quad_index_buffer_new(result.max_batch_size, MEMORY_TAG_BATCHER, &result.index_type);
+        // Part of the vertex array's state, drawing it binds this too.
+        GL_CALL(glVertexArrayElementBuffer(result.vertex_array, result.index_buffer));
+    }
     GL_CALL(glBindVertexArray(0));
 
+    size_t buffer_size = options->max_batch_size * result.vertices_per_quad * result.vertex_size;
     result.num_quads = 0;
-    result.quads_vertices = calloc(max_batch_size, sizeof(sprite_quad_t));
-    result.max_batch_size = max_batch_size;
+    result.vertices = mem_calloc(MEMORY_TAG_BATCHER, 1, buffer_size);
 
-    glBufferData(GL_ARRAY_BUFFER, max_batch_size * sizeof(sprite_quad_t), result.quads_vertices, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, buffer_size, result.vertices, GL_DYNAMIC_DRAW);
+    memory_gpu_alloc(MEMORY_TAG_BATCHER, buffer_size);
 
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
     GL_CALL(glCreateSamplers(1, &result.texture_sampler));
@@ -49,63 +125,125 @@ sprite_batch_t sprite_batch_new(GLuint program, size_t max_batch_size)
 
 void sprite_batch_free(sprite_batch_t *self)
 {
-    free(self->quads_vertices);
+    mem_free(self->vertices);
     glDeleteBuffers(1, &self->vertex_buffer);
+    memory_gpu_free(MEMORY_TAG_BATCHER, self->max_batch_size * self->vertices_per_quad * self->vertex_size);
+    if (self->index_buffer)
+        quad_index_buffer_free(self->index_buffer, self->max_batch_size, MEMORY_TAG_BATCHER, self->index_type);
     glDeleteVertexArrays(1, &self->vertex_array);
 
     *self = (sprite_batch_t){0};
 }
 
-uint8_t submit_sprite(sprite_batch_t *self, sprite_t *sprite, transform_t *transform)
+// Callers pass 0..1 already, the clamp is only so a bad value can't wrap around.
+static inline int32_t unorm(float value, float max)
 {
-    float x_anchor = sprite->anchor[0] * transform->scale[0];
-    float y_anchor = sprite->anchor[1] * transform->scale[1];
-    sprite_quad_t vertices = {
-        {
-            {transform->pos[0] - x_anchor, transform->pos[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {0.0, 0.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
-        {
-            {transform->pos[0] - x_anchor, transform->pos[1] + transform->scale[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {0.0, 1.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
-        {
-            {transform->pos[0] + transform->scale[0] - x_anchor, transform->pos[1] + transform->scale[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {1.0, 1.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
-        {
-            {transform->pos[0] - x_anchor, transform->pos[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {0.0, 0.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
+    value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+    return (int32_t)(value * max + 0.5f);
+}
+
+// Straight into the batch in its vertex format, conversions are once per quad rather than per vertex.
+static void sprite_batch_write_quad(sprite_batch_t *self, const sprite_quad_t *quad)
+{
+    uint8_t *dest = self->vertices + self->num_quads * self->vertices_per_quad * self->vertex_size;
+
+    if (self->vertex_format == SPRITE_VERTEX_FORMAT_COMPACT)
+    {
+        uint8_t color[4] = {
+            (uint8_t)unorm(quad->color[0], 255.0f),
+            (uint8_t)unorm(quad->color[1], 255.0f),
+            (uint8_t)unorm(quad->color[2], 255.0f),
+            (uint8_t)unorm(quad->color[3], 255.0f),
+        };
+
+        compact_vertex_t corners[4];
+        for (size_t i = 0; i < 4; i++)
         {
-            {transform->pos[0] + transform->scale[0] - x_anchor, transform->pos[1] + transform->scale[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {1.0, 1.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
+            corners[i].pos[0] = quad->pos[i][0];
+            corners[i].pos[1] = quad->pos[i][1];
+            corners[i].uv[0] = (uint16_t)unorm(quad->uv[i][0], 65535.0f);
+            corners[i].uv[1] = (uint16_t)unorm(quad->uv[i][1], 65535.0f);
+            memcpy(corners[i].color, color, sizeof(color));
+        }
+
+        compact_vertex_t *vertices = (compact_vertex_t *)dest;
+        if (self->vertices_per_quad == 4)
+            memcpy(vertices, corners, sizeof(corners));
+        else
+            for (size_t i = 0; i < 6; i++)
+                vertices[i] = corners[sprite_quad_corners[i]];
+    }
+    else
+    {
+        vertex_t *vertices = (vertex_t *)dest;
+        for (size_t i = 0; i < self->vertices_per_quad; i++)
         {
-            {transform->pos[0] + transform->scale[0] - x_anchor, transform->pos[1] - y_anchor, 0.0 /*-transform->pos[2]*/},
-            {1.0, 0.0},
-            {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
-        },
+            uint8_t corner = self->vertices_per_quad == 4 ? (uint8_t)i : sprite_quad_corners[i];
+            vertices[i] = (vertex_t){
+                .pos = {quad->pos[corner][0], quad->pos[corner][1], 0.0},
+                .uv = {quad->uv[corner][0], quad->uv[corner][1]},
+                .color = {quad->color[0], quad->color[1], quad->color[2], quad->color[3]},
+            };
+        }
+    }
+}
+
+uint8_t submit_sprite(sprite_batch_t *self, const sprite_t *sprite, const render_transform_t *transform)
+{
+    // Corners relative to the anchor, which is also the pivot the sprite rotates around.
+    float x0 = -sprite->anchor[0] * transform->scale[0];
+    float y0 = -sprite->anchor[1] * transform->scale[1];
+    float x1 = x0 + transform->scale[0];
+    float y1 = y0 + transform->scale[1];
+
+    // Same order as sprite_quad_t.
+    vec2 corners[4];
+    if (!transform->is_rotated)
+    {
+        float px = transform->pos[0], py = transform->pos[1];
+        corners[0][0] = px + x0, corners[0][1] = py + y0;
+        corners[1][0] = px + x0, corners[1][1] = py + y1;
+        corners[2][0] = px + x1, corners[2][1] = py + y1;
+        corners[3][0] = px + x1, corners[3][1] = py + y0;
+    }
+    else
+    {
+        // sin/cos were worked out when the transform last changed, this is just the 2x2 multiply.
+        float c = transform->cos_rotation, s = transform->sin_rotation;
+        float px = transform->pos[0], py = transform->pos[1];
+        float cx0 = c * x0, sx0 = s * x0, cx1 = c * x1, sx1 = s * x1;
+        float cy0 = c * y0, sy0 = s * y0, cy1 = c * y1, sy1 = s * y1;
+        corners[0][0] = px + cx0 - sy0, corners[0][1] = py + sx0 + cy0;
+        corners[1][0] = px + cx0 - sy1, corners[1][1] = py + sx0 + cy1;
+        corners[2][0] = px + cx1 - sy1, corners[2][1] = py + sx1 + cy1;
+        corners[3][0] = px + cx1 - sy0, corners[3][1] = py + sx1 + cy0;
+    }
+
+    float u0 = 0, u1 = 1, v0 = 0, v1 = 1;
+    if (transform->flip_flags & TRANSFORM_FLIP_X)
+        u0 = 1, u1 = 0;
+    if (transform->flip_flags & TRANSFORM_FLIP_Y)
+        v0 = 1, v1 = 0;
+
+    sprite_quad_t quad = {
+        .pos = {{corners[0][0], corners[0][1]}, {corners[1][0], corners[1][1]}, {corners[2][0], corners[2][1]}, {corners[3][0], corners[3][1]}},
+        .uv = {{u0, v0}, {u0, v1}, {u1, v1}, {u1, v0}},
+        .color = {sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3]},
     };
 
-    return sprite_batch_submit_quad(self, vertices, sprite->texture->texture);
+    return sprite_batch_submit_quad(self, &quad, sprite->texture->texture);
 }
 
-uint8_t submit_text(sprite_batch_t *batch, text_t *text, transform_t *transform)
+uint8_t submit_text(sprite_batch_t *batch, const text_t *text, const render_transform_t *transform)
 {
     const rendered_font_data_t *const data = get_font_render_data(text->font, (float)text->font_size);
     stbtt_bakedchar *cdata = data->char_data;
 
     float x = transform->pos[0], y = transform->pos[1];
 
-    char *t = text->text;
+    const char *t = text->text;
 
-    uint8_t did_flush;
+    uint8_t did_flush = 0;
 
     while (*t)
     {
@@ -114,16 +252,13 @@ uint8_t submit_text(sprite_batch_t *batch, text_t *text, transform_t *transform)
             stbtt_aligned_quad q;
             stbtt_GetBakedQuad(cdata, data->tex_size, data->tex_size, *t - 32, &x, &y, &q, 1); // 1=opengl & d3d10+,0=d3d9
 
-            sprite_quad_t vertices = {
-                {.uv = {q.s0, q.t0}, .pos = {q.x0, -q.y0, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
-                {.uv = {q.s1, q.t0}, .pos = {q.x1, -q.y0, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
-                {.uv = {q.s1, q.t1}, .pos = {q.x1, -q.y1, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
-                {.uv = {q.s0, q.t0}, .pos = {q.x0, -q.y0, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
-                {.uv = {q.s1, q.t1}, .pos = {q.x1, -q.y1, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
-                {.uv = {q.s0, q.t1}, .pos = {q.x0, -q.y1, 0.0 /*-transform->pos[2]*/}, .color = {1.0, 1.0, 1.0, 1.0}},
+            sprite_quad_t quad = {
+                .pos = {{q.x0, -q.y0}, {q.x0, -q.y1}, {q.x1, -q.y1}, {q.x1, -q.y0}},
+                .uv = {{q.s0, q.t0}, {q.s0, q.t1}, {q.s1, q.t1}, {q.s1, q.t0}},
+                .color = {1.0, 1.0, 1.0, 1.0},
             };
 
-            did_flush = sprite_batch_submit_quad(batch, vertices, data->texture);
+            did_flush = sprite_batch_submit_quad(batch, &quad, data->texture);
         }
 
         ++t;
@@ -134,44 +269,45 @@ uint8_t submit_text(sprite_batch_t *batch, text_t *text, transform_t *transform)
 
 void sprite_batch_render_system(app_t *app)
 {
-    sprite_batch_t *sprite_batch = app->sprite_batch;
+    PROFILE_FUNCTION();
 
-    GL_CALL(glUseProgram(sprite_batch->program));
+    sprite_batch_t *sprite_batch = app->sprite_batch;
 
-    camera_t *camera;
-    entity_t **arr_entities = app->entities;
-    // arr_entities is always sorted by the transform hierarchy, interate backwards to draw back to front.
-    for (size_t i = arrlen(arr_entities) - 1; i >= 0; i--)
+    // Held for the whole submit so the simulation can't start writing into this snapshot.
+    const render_snapshot_t *snapshot = render_snapshots_acquire(&app->render_snapshots);
+    if (!snapshot->has_camera)
     {
-        if (arr_entities[i]->has_camera)
-        {
-            camera = &arr_entities[i]->camera;
-            break;
-        }
+        render_snapshots_release(&app->render_snapshots);
+        return;
     }
 
-    assert(camera);
-
-    glUniformMatrix4fv(glGetUniformLocation(sprite_batch->program, "mat_view_proj"), 1, GL_FALSE, camera->view_proj[0]);
+    GL_CALL(glUseProgram(sprite_batch->program));
+    glUniformMatrix4fv(glGetUniformLocation(sprite_batch->program, "mat_view_proj"), 1, GL_FALSE, snapshot->view_proj[0]);
 
     glDisable(GL_DEPTH_TEST);
 
+    float alpha = fixed_step_alpha(snapshot->sim_time, snapshot->step_counter, app->render_time);
+
     // TODO WT: either sort by depth OR use parent hierarchy to draw back to front.
     size_t did_batcher_flush = 0;
-    for (size_t i = 0; i < arrlen(arr_entities); i++)
+    render_item_t *arr_items = snapshot->arr_items;
+    for (size_t i = 0; i < arrlen(arr_items); i++)
     {
-        entity_t *entity = arr_entities[i];
+        render_item_t *item = &arr_items[i];
+
+        render_transform_t transform;
+        render_transform_lerp(&transform, &item->previous, &item->current, alpha);
 
-        switch (entity->render_type)
+        switch (item->render_type)
         {
         case RENDER_TYPE_SPRITE:
         {
-            did_batcher_flush = submit_sprite(sprite_batch, &entity->sprite, &entity->transform);
+            did_batcher_flush = submit_sprite(sprite_batch, &item->sprite, &transform);
             break;
         }
         case RENDER_TYPE_TEXT:
         {
-            did_batcher_flush = submit_text(sprite_batch, &entity->text, &entity->transform);
+            did_batcher_flush = submit_text(sprite_batch, &item->text, &transform);
             break;
         }
         case RENDER_TYPE_NONE:
@@ -182,13 +318,15 @@ void sprite_batch_render_system(app_t *app)
         }
     }
 
+    render_snapshots_release(&app->render_snapshots);
+
     if (!did_batcher_flush)
     {
         sprite_batch_flush(sprite_batch);
     }
 }
 
-uint8_t sprite_batch_submit_quad(sprite_batch_t *batch, sprite_quad_t quad, GLuint texture)
+uint8_t sprite_batch_submit_quad(sprite_batch_t *batch, const sprite_quad_t *quad, GLuint texture)
 {
     if (texture != batch->current_texture_id)
     {
@@ -197,7 +335,8 @@ uint8_t sprite_batch_submit_quad(sprite_batch_t *batch, sprite_quad_t quad, GLui
 
     batch->current_texture_id = texture;
 
-    memcpy_s(&batch->quads_vertices[batch->num_quads++], sizeof(sprite_quad_t), quad, sizeof(sprite_quad_t));
+    sprite_batch_write_quad(batch, quad);
+    batch->num_quads++;
 
     if (batch->num_quads >= batch->max_batch_size)
     {
@@ -213,10 +352,13 @@ void sprite_batch_flush(sprite_batch_t *self)
     if (self->num_quads == 0)
         return;
 
+    PROFILE_FUNCTION();
+
+    // Started before the upload so the transfer counts towards the batch's GPU time.
+    uint32_t gpu_zone = self->gpu_timer ? gpu_timer_begin(self->gpu_timer, "sprite_batch_flush") : GPU_TIMER_INVALID_ZONE;
+
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, self->vertex_buffer));
-    glBufferSubData(GL_ARRAY_BUFFER, 0, self->num_quads * sizeof(sprite_quad_t), self->quads_vertices);
-    // GL_CALL(glBufferData(GL_ARRAY_BUFFER, self->num_quads * sizeof(sprite_quad_t), self->quads_vertices, GL_DYNAMIC_DRAW));
-    // glNamedBufferData(self->vertex_buffer, self->num_quads * sizeof(sprite_quad_t), self->quads_vertices, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, self->num_quads * self->vertices_per_quad * self->vertex_size, self->vertices);
 
     GL_CALL(glActiveTexture(GL_TEXTURE0));
     GL_CALL(glBindTexture(GL_TEXTURE_2D, self->current_texture_id));
@@ -226,7 +368,19 @@ void sprite_batch_flush(sprite_batch_t *self)
     GL_CALL(glBindVertexArray(self->vertex_array));
     GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, self->vertex_buffer));
     GL_CALL(glBindSampler(0, self->texture_sampler));
-    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, self->num_quads * 6));
+    if (self->index_buffer)
+    {
+        GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)(self->num_quads * 6), self->index_type, 0));
+    }
+    else
+    {
+        GL_CALL(glDrawArrays(GL_TRIANGLES, 0, self->num_quads * 6));
+    }
+    if (self->gpu_timer)
+        gpu_timer_end(self->gpu_timer, gpu_zone);
+
+    self->num_flushes++;
+    self->num_quads_drawn += self->num_quads;
     self->num_quads = 0;
 
     glUseProgram(0);
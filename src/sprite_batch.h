@@ -1,8 +1,22 @@
 #pragma once
 #include <glad/glad.h>
 #include "vendor/linmath.h"
+#include "engine/gpu_timer.h"
+#include "engine/memory.h"
 
 typedef struct app_t app_t;
+typedef struct sprite_t sprite_t;
+typedef struct text_t text_t;
+typedef struct render_transform_t render_transform_t;
+
+// What goes to the GPU per vertex, both are read by the same shader.
+typedef enum sprite_vertex_format_e
+{
+    // 36 bytes, all floats.
+    SPRITE_VERTEX_FORMAT_FLOAT,
+    // 16 bytes, float2 position, unorm16 uv and rgba8 colour.
+    SPRITE_VERTEX_FORMAT_COMPACT,
+} sprite_vertex_format_e;
 
 typedef struct vertex_t
 {
@@ -11,26 +25,71 @@ typedef struct vertex_t
     vec4 color;
 } vertex_t;
 
-typedef vertex_t sprite_quad_t[6];
+typedef struct compact_vertex_t
+{
+    vec2 pos;
+    uint16_t uv[2];
+    uint8_t color[4];
+} compact_vertex_t;
+
+/// @brief One sprite, corners go bottom left, top left, top right, bottom right.
+typedef struct sprite_quad_t
+{
+    vec2 pos[4];
+    vec2 uv[4];
+    vec4 color;
+} sprite_quad_t;
+
+typedef struct sprite_batch_options_t
+{
+    size_t max_batch_size;
+    sprite_vertex_format_e vertex_format;
+    // 4 vertices a quad drawn through a static index buffer, otherwise 6 with glDrawArrays.
+    uint8_t indexed;
+} sprite_batch_options_t;
 
 typedef struct sprite_batch_t
 {
     GLuint vertex_array;
     GLuint vertex_buffer;
-    sprite_quad_t *quads_vertices;
+    // 0 when drawing arrays. Written once, every batch of quads uses the same indices.
+    GLuint index_buffer;
+    GLenum index_type;
+    sprite_vertex_format_e vertex_format;
+    size_t vertex_size;
+    // 4 indexed or 6 for two separate triangles.
+    size_t vertices_per_quad;
+    // max_batch_size quads' worth of vertices in vertex_format.
+    uint8_t *vertices;
     size_t num_quads;
     GLuint program;
     size_t max_batch_size;
     GLuint current_texture_id;
     GLuint texture_sampler;
+
+    // Optional, times every flush on the GPU when set.
+    gpu_timer_t *gpu_timer;
+
+    // Reset by the owner whenever it wants, usually once per frame.
+    uint32_t num_flushes;
+    uint32_t num_quads_drawn;
 } sprite_batch_t;
 
-sprite_batch_t sprite_batch_new(GLuint program, size_t max_batch_size);
+sprite_batch_t sprite_batch_new(GLuint program, const sprite_batch_options_t *options);
 
 void sprite_batch_free(sprite_batch_t *self);
 
 void sprite_batch_render_system(app_t *app);
 
-uint8_t sprite_batch_submit_quad(sprite_batch_t *batch, sprite_quad_t quad, GLuint texture);
+uint8_t submit_sprite(sprite_batch_t *self, const sprite_t *sprite, const render_transform_t *transform);
+uint8_t submit_text(sprite_batch_t *batch, const text_t *text, const render_transform_t *transform);
+
+/// @return 1 if the batch flushed.
+uint8_t sprite_batch_submit_quad(sprite_batch_t *batch, const sprite_quad_t *quad, GLuint texture);
+
+void sprite_batch_flush(sprite_batch_t *self);
 
-void sprite_batch_flush(sprite_batch_t *self);
\ No newline at end of file
+/// @brief Immutable index buffer drawing num_quads quads of 4 vertices (in sprite_quad_t's corner order) as triangles.
+/// 16 bit indices when they fit, index_type says which.
+GLuint quad_index_buffer_new(size_t num_quads, memory_tag_e tag, GLenum *index_type);
+void quad_index_buffer_free(GLuint buffer, size_t num_quads, memory_tag_e tag, GLenum index_type);
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "stats_overlay.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include "engine/engine.h"
+#include "engine/profiler.h"
+#include "engine/memory.h"
+#include "app.h"
+#include "engine/memory.h"
+
+stats_overlay_t stats_overlay_new(const char *font_path, float font_size)
+{
+    stats_overlay_t result = {0};
+    result.font_path = font_path;
+    result.font_size = font_size;
+
+    return result;
+}
+
+static void stats_overlay_add_line(stats_overlay_t *self, const char *format, ...)
+{
+    if (self->num_lines >= STATS_OVERLAY_MAX_LINES)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(self->lines[self->num_lines++], STATS_OVERLAY_LINE_LENGTH, format, args);
+    va_end(args);
+}
+
+void stats_overlay_update(stats_overlay_t *self, const frame_stats_t *stats)
+{
+    self->num_lines = 0;
+
+    float fps = stats->frame_interval_ms > 0 ? 1000.0f / stats->frame_interval_ms : 0;
+    stats_overlay_add_line(self, "Frame %llu | %.1f FPS | waited %.2f ms", (unsigned long long)stats->frame_number, fps, stats->cpu_wait_ms);
+    stats_overlay_add_line(self, "CPU frame %.2f ms | render %.2f ms | swap %.2f ms", stats->cpu_frame_ms, stats->cpu_render_ms, stats->cpu_swap_ms);
+    stats_overlay_add_line(self, "Sim step %llu | tick %.2f ms | %u steps this frame",
+                           (unsigned long long)stats->sim_step_number,
+                           stats->cpu_tick_ms,
+                           stats->num_sim_steps);
+    stats_overlay_add_line(self, "GPU frame %.2f ms | clear %.2f ms (%llu frames behind)",
+                           stats->gpu_frame_ms,
+                           stats->gpu_clear_ms,
+                           (unsigned long long)(stats->frame_number - stats->gpu_frame_number));
+    stats_overlay_add_line(self, "GPU batch %.2f ms over %u flushes", stats->gpu_batch_ms, stats->gpu_num_flushes);
+    stats_overlay_add_line(self, "Batch %u flushes | %u quads", stats->num_flushes, stats->num_quads);
+    if (stats->num_tile_draws)
+        stats_overlay_add_line(self, "Tilemap %u draws | %u quads | %u chunks built | GPU %.2f ms",
+                               stats->num_tile_draws,
+                               stats->num_tile_quads,
+                               stats->num_tile_chunks_built,
+                               stats->gpu_tilemap_ms);
+
+    // Swap blocks on the GPU when it's behind, so leave it out of the CPU side of the comparison.
+    float cpu_work_ms = stats->cpu_frame_ms - stats->cpu_swap_ms;
+    stats_overlay_add_line(self, "%s bound", cpu_work_ms >= stats->gpu_frame_ms ? "CPU" : "GPU");
+
+    stats_overlay_add_line(self, "Heap allocs %u this frame | arenas: frame %.1f KiB, step %.1f KiB",
+                           stats->num_heap_allocs,
+                           stats->frame_arena_bytes / 1024.0,
+                           stats->sim_arena_bytes / 1024.0);
+
+    // Only tags that have ever been used, F10 dumps the full table.
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+    {
+        memory_tag_stats_t memory = memory_get_stats((memory_tag_e)i);
+        if (memory.num_allocs == 0 && memory.gpu_peak_bytes == 0)
+            continue;
+
+        stats_overlay_add_line(self, "%-11s %8.2f MiB (peak %.2f) %7llu allocs | GPU %.2f MiB",
+                               memory_tag_name((memory_tag_e)i),
+                               memory.live_bytes / (1024.0 * 1024.0),
+                               memory.peak_bytes / (1024.0 * 1024.0),
+                               (unsigned long long)(memory.num_allocs - memory.num_frees),
+                               memory.gpu_bytes / (1024.0 * 1024.0));
+    }
+}
+
+void stats_overlay_render_system(app_t *app)
+{
+    stats_overlay_t *self = &app->stats_overlay;
+    if (!self->is_visible || shgeti(app->asset_cache->sh_fonts, self->font_path) == -1)
+        return;
+
+    PROFILE_FUNCTION();
+
+    sprite_batch_t *batch = app->sprite_batch;
+    font_t *font = &shget(app->asset_cache->sh_fonts, self->font_path);
+
+    // Anything still batched belongs to the scene and has to go out with the scene camera.
+    sprite_batch_flush(batch);
+
+    // Screen space, independent of wherever the scene camera is.
+    float hw = app->window_width / 2, hh = app->window_height / 2;
+    mat4x4 view_proj;
+    mat4x4_ortho(view_proj, -hw, hw, -hh, hh, -1, 100);
+
+    GL_CALL(glUseProgram(batch->program));
+    GL_CALL(glUniformMatrix4fv(glGetUniformLocation(batch->program, "mat_view_proj"), 1, GL_FALSE, view_proj[0]));
+    // Screen space, no tile under it to fog. fog_render_system turns it back on next frame.
+    GL_CALL(glUniform1i(glGetUniformLocation(batch->program, "fog_enabled"), 0));
+
+    const float margin = 8.0f;
+    const float line_height = self->font_size * 1.2f;
+    for (size_t i = 0; i < self->num_lines; i++)
+    {
+        text_t text = {
+            .text = self->lines[i],
+            .font = font,
+            .font_size = self->font_size,
+        };
+
+        // Text is drawn with y flipped, see submit_text.
+        render_transform_t transform = {0};
+        transform.pos[0] = -hw + margin;
+        transform.pos[1] = -hh + margin + self->font_size + line_height * i;
+        transform.scale[0] = transform.scale[1] = 1.0f;
+
+        submit_text(batch, &text, &transform);
+    }
+
+    sprite_batch_flush(batch);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "engine/frame_stats.h"
+
+typedef struct app_t app_t;
+
+#define STATS_OVERLAY_MAX_LINES 24
+#define STATS_OVERLAY_LINE_LENGTH 128
+
+/// @brief Screen space text overlay for frame_stats_t, toggled with F3.
+typedef struct stats_overlay_t
+{
+    uint8_t is_visible;
+    // Key into the asset cache fonts, looked up on render as cache entries move when the cache grows.
+    const char *font_path;
+    float font_size;
+
+    // Text is only rebuilt every TITLE_UPDATE_INTERVAL_MS.
+    uint64_t last_update;
+
+    char lines[STATS_OVERLAY_MAX_LINES][STATS_OVERLAY_LINE_LENGTH];
+    size_t num_lines;
+} stats_overlay_t;
+
+stats_overlay_t stats_overlay_new(const char *font_path, float font_size);
+
+/// @brief Rebuild the overlay text from the latest stats.
+void stats_overlay_update(stats_overlay_t *self, const frame_stats_t *stats);
+
+/// @brief Draw the overlay on top of everything already submitted this frame, flushes the sprite batch.
+void stats_overlay_render_system(app_t *app);
@@ -0,0 +1,312 @@
+#include "stress_scene.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "engine/memory.h"
+#include "app.h"
+#include "texture.h"
+#include "font.h"
+#include "engine/frame_stats.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static const char *stress_texture_path = "./images/fruit_banana.png";
+static const char *stress_font_path = "./font/CONSTAN.TTF";
+
+static void stress_texture_name(char *out, size_t size, uint32_t index)
+{
+    snprintf(out, size, "stress_texture_%u", index);
+}
+
+static size_t peak_rss_bytes(void)
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {0};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage = {0};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    // Kilobytes on Linux.
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// Scale is inherited, sizes are picked in pixels and divided by this to come out the same at any depth.
+static float stress_world_scale(const entity_t *entity)
+{
+    float scale = 1;
+    for (; entity; entity = entity->parent)
+        scale *= entity->transform.scale[0];
+
+    return scale;
+}
+
+static entity_t *stress_spawn(stress_scene_t *self, app_t *app, entity_t *parent, uint8_t is_top_level)
+{
+    entity_t *entity = entity_new(app->world);
+    set_parent(entity, parent);
+
+    float parent_scale = stress_world_scale(parent);
+
+    stress_entity_t stress_entity = {.entity = entity, .phase = rng_float(&self->rng_state) * 6.2831853f};
+    stress_entity.radius = 20 / parent_scale;
+    if (is_top_level)
+    {
+        // Spread over the screen, the camera looks at the origin.
+        stress_entity.origin[0] = (rng_float(&self->rng_state) - 0.5f) * app->window_width;
+        stress_entity.origin[1] = (rng_float(&self->rng_state) - 0.5f) * app->window_height;
+    }
+    else
+    {
+        stress_entity.origin[0] = (rng_float(&self->rng_state) - 0.5f) * 100 / parent_scale;
+        stress_entity.origin[1] = (rng_float(&self->rng_state) - 0.5f) * 100 / parent_scale;
+    }
+
+    set_pos(&entity->transform, (vec3){stress_entity.origin[0], stress_entity.origin[1], 1});
+
+    if (rng_float(&self->rng_state) < self->options.text_ratio)
+    {
+        entity->render_type = RENDER_TYPE_TEXT;
+        entity->text.font = &shget(app->asset_cache->sh_fonts, stress_font_path);
+        entity->text.font_size = 16;
+        entity->text.text = "stress";
+        set_scale(&entity->transform, (vec2){1 / parent_scale, 1 / parent_scale});
+    }
+    else
+    {
+        float scale = (16 + rng_float(&self->rng_state) * 32) / parent_scale;
+        char texture_name[64];
+        stress_texture_name(texture_name, sizeof(texture_name), (uint32_t)(rng_next(&self->rng_state) % self->options.num_textures));
+
+        entity->render_type = RENDER_TYPE_SPRITE;
+        entity->sprite.texture = &shget(app->asset_cache->sh_textures, texture_name);
+        memcpy(entity->sprite.anchor, (vec2){0.5f, 0.5f}, sizeof(vec2));
+        memcpy(entity->sprite.color, (vec4){rng_float(&self->rng_state), rng_float(&self->rng_state), 1, 1}, sizeof(vec4));
+        set_scale(&entity->transform, (vec2){scale, scale});
+    }
+
+    arrput(self->arr_entities, stress_entity);
+    self->num_spawned++;
+
+    return entity;
+}
+
+// Depth first so each top level entity gets a whole subtree before the next one starts.
+static void stress_spawn_subtree(stress_scene_t *self, app_t *app, entity_t *parent, uint32_t level, entity_t ***arr_leaves_out)
+{
+    if (arrlenu(self->arr_entities) + arrlenu(*arr_leaves_out) >= self->options.num_entities)
+        return;
+
+    uint8_t is_leaf = level == self->options.depth;
+    if (is_leaf)
+    {
+        // Spawned later, after all the parents, so churn can treat everything past num_parents as a leaf.
+        arrput(*arr_leaves_out, parent);
+        return;
+    }
+
+    entity_t *entity = stress_spawn(self, app, parent, level == 1);
+
+    if (level + 1 == self->options.depth)
+        arrput(self->arr_leaf_parents, entity);
+
+    for (uint32_t i = 0; i < self->options.fan_out; i++)
+        stress_spawn_subtree(self, app, entity, level + 1, arr_leaves_out);
+}
+
+stress_scene_t stress_scene_new(app_t *app, const stress_options_t *options)
+{
+    PROFILE_FUNCTION();
+
+    stress_scene_t result = {0};
+    result.options = *options;
+    result.rng_state = options->seed;
+
+    asset_cache_t *asset_cache = app->asset_cache;
+    {
+        MEMORY_SCOPE(MEMORY_TAG_ASSET_CACHE);
+
+        // Same image, but a separate GL texture for each so they can't share a batch.
+        for (uint32_t i = 0; i < options->num_textures; i++)
+        {
+            char name[64];
+            stress_texture_name(name, sizeof(name), i);
+            shput(asset_cache->sh_textures, name, texture_new_load_entire(stress_texture_path));
+        }
+
+        if (shgeti(asset_cache->sh_fonts, stress_font_path) == -1)
+            shput(asset_cache->sh_fonts, stress_font_path, font_load(stress_font_path));
+    }
+
+    arrsetcap(result.arr_entities, options->num_entities);
+
+    // Parents first, remembering which of them each leaf hangs off.
+    entity_t **arr_leaves = 0;
+    if (options->depth == 1)
+    {
+        arrput(result.arr_leaf_parents, app->world->root);
+        for (uint32_t i = 0; i < options->num_entities; i++)
+            arrput(arr_leaves, app->world->root);
+    }
+    else
+    {
+        while (arrlenu(result.arr_entities) + arrlenu(arr_leaves) < options->num_entities)
+            stress_spawn_subtree(&result, app, app->world->root, 1, &arr_leaves);
+    }
+
+    result.num_parents = arrlenu(result.arr_entities);
+
+    for (size_t i = 0; i < arrlenu(arr_leaves); i++)
+        stress_spawn(&result, app, arr_leaves[i], options->depth == 1);
+
+    arrfree(arr_leaves);
+
+    printf("Stress scene: %zu entities (%zu parents), depth %u, fan out %u, %u textures, seed %llu\n",
+           arrlenu(result.arr_entities),
+           result.num_parents,
+           options->depth,
+           options->fan_out,
+           options->num_textures,
+           (unsigned long long)options->seed);
+
+    return result;
+}
+
+void stress_scene_free(stress_scene_t *self)
+{
+    arrfree(self->arr_entities);
+    arrfree(self->arr_leaf_parents);
+
+    *self = (stress_scene_t){0};
+}
+
+void stress_scene_tick(stress_scene_t *self, app_t *app, float delta_seconds)
+{
+    PROFILE_FUNCTION();
+
+    self->time += delta_seconds;
+
+    // Evenly spread rather than the first N, so movement hits every level of the hierarchy.
+    const float fraction = self->options.moving_fraction;
+    for (size_t i = 0; i < arrlenu(self->arr_entities); i++)
+    {
+        if ((uint64_t)((float)(i + 1) * fraction) == (uint64_t)((float)i * fraction))
+            continue;
+
+        stress_entity_t *stress_entity = &self->arr_entities[i];
+        float angle = self->time * 2 + stress_entity->phase;
+        vec3 pos = {
+            stress_entity->origin[0] + cosf(angle) * stress_entity->radius,
+            stress_entity->origin[1] + sinf(angle) * stress_entity->radius,
+            1,
+        };
+        set_pos(&stress_entity->entity->transform, pos);
+
+        // Half of them spin too, so rotated and axis aligned sprites are mixed in the batches.
+        if (i & 1)
+            set_rotation(&stress_entity->entity->transform, angle);
+    }
+
+    self->churn_accumulator += self->options.churn_per_second * delta_seconds;
+    while (self->churn_accumulator >= 1 && arrlenu(self->arr_entities) > self->num_parents)
+    {
+        self->churn_accumulator -= 1;
+
+        size_t num_leaves = arrlenu(self->arr_entities) - self->num_parents;
+        size_t index = self->num_parents + rng_next(&self->rng_state) % num_leaves;
+        entity_free(app->world, self->arr_entities[index].entity);
+        arrdelswap(self->arr_entities, index);
+        self->num_despawned++;
+
+        entity_t *parent = self->arr_leaf_parents[rng_next(&self->rng_state) % arrlenu(self->arr_leaf_parents)];
+        stress_spawn(self, app, parent, parent == app->world->root);
+    }
+}
+
+static void stress_write_summary(FILE *file, const char *name, const frame_timings_summary_t *summary)
+{
+    fprintf(file,
+            "  \"%s\": {\"frames\": %zu, \"mean_ms\": %.4f, \"min_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f}",
+            name,
+            summary->count,
+            summary->mean_ms,
+            summary->min_ms,
+            summary->p50_ms,
+            summary->p95_ms,
+            summary->p99_ms,
+            summary->max_ms);
+}
+
+uint8_t stress_scene_write_report(const stress_scene_t *self,
+                                  const app_t *app,
+                                  const float *frame_ms,
+                                  size_t num_frames,
+                                  const float *gpu_frame_ms,
+                                  size_t num_gpu_frames,
+                                  float seconds)
+{
+    frame_timings_summary_t cpu_summary = frame_timings_summarise(frame_ms, num_frames);
+    frame_timings_summary_t gpu_summary = frame_timings_summarise(gpu_frame_ms, num_gpu_frames);
+    size_t peak_rss = peak_rss_bytes();
+
+    frame_timings_print("Stress CPU frame", &cpu_summary);
+    if (num_gpu_frames)
+        frame_timings_print("Stress GPU frame", &gpu_summary);
+    printf("Stress peak memory: %.1f MiB\n", (double)peak_rss / (1024.0 * 1024.0));
+
+    const stress_options_t *options = &self->options;
+    FILE *file = fopen(options->report_path, "w");
+    if (!file)
+    {
+        printf("Failed to open %s for writing\n", options->report_path);
+        return 0;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file,
+            "  \"parameters\": {\"entities\": %u, \"depth\": %u, \"fan_out\": %u, \"text_ratio\": %.4f, \"textures\": %u, "
+            "\"moving_fraction\": %.4f, \"churn_per_second\": %.2f, \"duration_seconds\": %.2f, \"seed\": %llu, "
+            "\"width\": %d, \"height\": %d, \"headless\": %d},\n",
+            options->num_entities,
+            options->depth,
+            options->fan_out,
+            options->text_ratio,
+            options->num_textures,
+            options->moving_fraction,
+            options->churn_per_second,
+            options->duration_seconds,
+            (unsigned long long)options->seed,
+            app->window_width,
+            app->window_height,
+            app->is_headless);
+    fprintf(file,
+            "  \"run\": {\"seconds\": %.3f, \"frames\": %llu, \"sim_steps\": %llu, \"live_entities\": %zu, \"spawned\": %llu, \"despawned\": %llu},\n",
+            seconds,
+            (unsigned long long)app->frame_stats.frame_number,
+            (unsigned long long)app->fixed_step.num_steps,
+            arrlenu(app->world->entities),
+            (unsigned long long)self->num_spawned,
+            (unsigned long long)self->num_despawned);
+    stress_write_summary(file, "cpu_frame", &cpu_summary);
+    fprintf(file, ",\n");
+    stress_write_summary(file, "gpu_frame", &gpu_summary);
+    fprintf(file, ",\n");
+    fprintf(file, "  \"peak_rss_bytes\": %zu\n", peak_rss);
+    fprintf(file, "}\n");
+
+    fclose(file);
+    printf("Wrote %s\n", options->report_path);
+
+    return 1;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "vendor/linmath.h"
+#include "options.h"
+
+typedef struct app_t app_t;
+typedef struct entity_t entity_t;
+
+typedef struct stress_entity_t
+{
+    entity_t *entity;
+    // Moving entities orbit around where they spawned, in their parent's space.
+    vec2 origin;
+    float radius;
+    float phase;
+} stress_entity_t;
+
+typedef struct stress_scene_t
+{
+    stress_options_t options;
+    uint64_t rng_state;
+
+    // Parents come first and are never despawned, churn only swaps out leaves from num_parents onwards.
+    stress_entity_t *arr_entities;
+    size_t num_parents;
+    // Where churned leaves get respawned, the level above the leaves or just root.
+    entity_t **arr_leaf_parents;
+
+    float churn_accumulator;
+    uint64_t num_spawned;
+    uint64_t num_despawned;
+    float time;
+} stress_scene_t;
+
+/// @brief Build the scene described by options into app, textures go in app's asset cache.
+stress_scene_t stress_scene_new(app_t *app, const stress_options_t *options);
+
+/// @brief Free before app_free, which reports anything still allocated as a leak.
+void stress_scene_free(stress_scene_t *self);
+
+/// @brief Move and churn entities, run once per simulation step before the transform systems.
+void stress_scene_tick(stress_scene_t *self, app_t *app, float delta_seconds);
+
+/// @brief Write the run's parameters, frame time percentiles and peak memory as JSON.
+/// @return 0 if the file couldn't be written.
+uint8_t stress_scene_write_report(const stress_scene_t *self,
+                                  const app_t *app,
+                                  const float *frame_ms,
+                                  size_t num_frames,
+                                  const float *gpu_frame_ms,
+                                  size_t num_gpu_frames,
+                                  float seconds);
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "vendor/linmath.h"
-#include "font.h"
+#include "text_intern.h"
+
+typedef struct font_t font_t;
 
 typedef struct text_t
 {
@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+
+/// @brief An arena string hashmap's entry, for text that has to live as long as whatever shows it. Arena keys never
+/// move once added, so entities can point straight at them. Apart from text.h so the world can hold them without
+/// reaching the renderer.
+typedef struct text_intern_entry_t
+{
+    char *key;
+    uint8_t value;
+} text_intern_entry_t;
\ No newline at end of file
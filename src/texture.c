@@ -1,9 +1,13 @@
 #include "texture.h"
 #include "vendor/stb_image.h"
 #include "engine/engine.h"
+#include "engine/profiler.h"
+#include "engine/memory.h"
 
 texture_t texture_new_load_entire(const char *path)
 {
+    PROFILE_FUNCTION();
+
     texture_t result = {0};
     result.name = path;
     mat4x4_identity(result.uv_matrix);
@@ -22,6 +26,8 @@ texture_t texture_new_load_entire(const char *path)
 
     GL_CALL(glBindTexture(GL_TEXTURE_2D, result.texture));
     GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes));
+    result.gpu_bytes = memory_texture_bytes(w, h, 4, 1);
+    memory_gpu_alloc(MEMORY_TAG_TEXTURES, result.gpu_bytes);
 
     stbi_image_free(bytes);
 
@@ -46,6 +52,8 @@ texture_t texture_new_load_entire(const char *path)
 void texture_cleanup(texture_t *self)
 {
     glDeleteTextures(1, &self->texture);
+    memory_gpu_free(MEMORY_TAG_TEXTURES, self->gpu_bytes);
+    self->gpu_bytes = 0;
 }
 
 void texture_free(texture_t *self)
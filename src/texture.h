@@ -7,6 +7,8 @@ typedef struct texture_t
     const char *name;
     GLuint texture;
     mat4x4 uv_matrix;
+    // Estimate for memory accounting, including mips.
+    size_t gpu_bytes;
 } texture_t;
 
 texture_t texture_new_load_entire(const char *path);
@@ -0,0 +1,129 @@
+#include "tilemap.h"
+#include <string.h>
+#include <assert.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+tilemap_t tilemap_new(uint32_t width, uint32_t height, float tile_size)
+{
+    tilemap_t result = {0};
+    result.chunks_x = (width + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+    result.chunks_y = (height + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+    result.width = width;
+    result.height = height;
+    result.tile_size = tile_size;
+
+    size_t num_chunks = (size_t)result.chunks_x * result.chunks_y;
+    result.chunks = mem_calloc(MEMORY_TAG_TILEMAP, num_chunks, sizeof(tilemap_chunk_t));
+    assert(!num_chunks || result.chunks);
+
+    // 0 is left for "never built" in whatever builds from them.
+    for (size_t i = 0; i < num_chunks; i++)
+        result.chunks[i].revision = 1;
+
+    return result;
+}
+
+void tilemap_free(tilemap_t *self)
+{
+    mem_free(self->chunks);
+    arrfree(self->arr_edits);
+
+    *self = (tilemap_t){0};
+}
+
+tilemap_t tilemap_clone(const tilemap_t *self)
+{
+    tilemap_t result = *self;
+    result.records_edits = 0;
+    result.arr_edits = 0;
+
+    size_t chunks_bytes = (size_t)self->chunks_x * self->chunks_y * sizeof(tilemap_chunk_t);
+    result.chunks = mem_alloc(MEMORY_TAG_TILEMAP, chunks_bytes);
+    assert(!chunks_bytes || result.chunks);
+    memcpy(result.chunks, self->chunks, chunks_bytes);
+
+    return result;
+}
+
+void tilemap_set(tilemap_t *self, uint32_t x, uint32_t y, tile_id_t tile)
+{
+    assert(x < self->width && y < self->height);
+
+    tilemap_chunk_t *chunk = &self->chunks[tilemap_chunk_index(self, x, y)];
+    tile_id_t *slot = &chunk->tiles[(y % TILEMAP_CHUNK_SIZE) * TILEMAP_CHUNK_SIZE + x % TILEMAP_CHUNK_SIZE];
+    if (*slot == tile)
+        return;
+
+    *slot = tile;
+    chunk->revision++;
+
+    if (self->records_edits)
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TILEMAP);
+        arrput(self->arr_edits, ((tilemap_edit_t){x, y, tile}));
+    }
+}
+
+void tilemap_fill(tilemap_t *self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, tile_id_t tile)
+{
+    uint32_t end_x = x + width > self->width ? self->width : x + width;
+    uint32_t end_y = y + height > self->height ? self->height : y + height;
+
+    for (uint32_t ty = y; ty < end_y; ty++)
+    {
+        for (uint32_t tx = x; tx < end_x; tx++)
+        {
+            tilemap_chunk_t *chunk = &self->chunks[tilemap_chunk_index(self, tx, ty)];
+            chunk->tiles[(ty % TILEMAP_CHUNK_SIZE) * TILEMAP_CHUNK_SIZE + tx % TILEMAP_CHUNK_SIZE] = tile;
+        }
+    }
+
+    // Once per chunk touched rather than per tile.
+    if (end_x <= x || end_y <= y)
+        return;
+
+    for (uint32_t cy = y / TILEMAP_CHUNK_SIZE; cy <= (end_y - 1) / TILEMAP_CHUNK_SIZE; cy++)
+        for (uint32_t cx = x / TILEMAP_CHUNK_SIZE; cx <= (end_x - 1) / TILEMAP_CHUNK_SIZE; cx++)
+            self->chunks[cy * self->chunks_x + cx].revision++;
+}
+
+void tilemap_apply_edits(tilemap_t *self, const tilemap_edit_t *edits, size_t num_edits)
+{
+    for (size_t i = 0; i < num_edits; i++)
+        tilemap_set(self, edits[i].x, edits[i].y, edits[i].tile);
+}
+
+void tilemap_chunk_bounds(const tilemap_t *self, uint32_t chunk_x, uint32_t chunk_y, vec4 bounds)
+{
+    float chunk_world_size = self->tile_size * TILEMAP_CHUNK_SIZE;
+    bounds[0] = self->origin[0] + chunk_x * chunk_world_size;
+    bounds[1] = self->origin[1] + chunk_y * chunk_world_size;
+    bounds[2] = bounds[0] + chunk_world_size;
+    bounds[3] = bounds[1] + chunk_world_size;
+}
+
+void tilemap_generate(tilemap_t *self, uint64_t seed, uint32_t num_tile_types)
+{
+    PROFILE_FUNCTION();
+    assert(num_tile_types > 0);
+
+    // Patches of 8x8 tiles share a terrain type, with every so often a tile of something else in them.
+    for (uint32_t y = 0; y < self->height; y++)
+    {
+        for (uint32_t x = 0; x < self->width; x++)
+        {
+            uint64_t patch = rng_hash(seed ^ (((uint64_t)(y / 8) << 32) | (x / 8)));
+            uint64_t detail = rng_hash(seed + (((uint64_t)y << 32) | x));
+            uint64_t type = detail % 16 == 0 ? detail >> 8 : patch;
+
+            tilemap_chunk_t *chunk = &self->chunks[tilemap_chunk_index(self, x, y)];
+            chunk->tiles[(y % TILEMAP_CHUNK_SIZE) * TILEMAP_CHUNK_SIZE + x % TILEMAP_CHUNK_SIZE] = (tile_id_t)(1 + type % num_tile_types);
+        }
+    }
+
+    size_t num_chunks = (size_t)self->chunks_x * self->chunks_y;
+    for (size_t i = 0; i < num_chunks; i++)
+        self->chunks[i].revision++;
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "vendor/linmath.h"
+
+// Tiles per chunk side, a chunk is the unit the renderer builds and culls.
+#define TILEMAP_CHUNK_SIZE 32
+#define TILEMAP_CHUNK_TILES (TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE)
+
+// Nothing there, never drawn. Anything else is 1 + its cell in the tileset.
+#define TILE_EMPTY 0
+
+typedef uint16_t tile_id_t;
+
+typedef struct tilemap_chunk_t
+{
+    // Row major, y up like the world.
+    tile_id_t tiles[TILEMAP_CHUNK_TILES];
+    // Bumped on every change, anything built from the chunk compares it against the revision it was built from.
+    uint32_t revision;
+} tilemap_chunk_t;
+
+typedef struct tilemap_edit_t
+{
+    uint32_t x, y;
+    tile_id_t tile;
+} tilemap_edit_t;
+
+/// @brief A grid of tile IDs split into fixed size chunks, just the data, see tilemap_renderer.h for drawing it.
+typedef struct tilemap_t
+{
+    // In tiles, as asked for. Chunks on the right and top edges can run past them, the tiles past them are always empty
+    // and nothing outside the tilemap sees them.
+    uint32_t width, height;
+    uint32_t chunks_x, chunks_y;
+    tilemap_chunk_t *chunks;
+
+    // World position of tile (0, 0)'s bottom left corner, and each tile's size.
+    vec2 origin;
+    float tile_size;
+
+    // Every tilemap_set since whoever owns the map last cleared them, for copies kept elsewhere. render_snapshot_build
+    // hands them to the renderer and clears them, a world_scheduler clears them after each step since nothing hosted is
+    // drawn. Only recorded when records_edits is set.
+    uint8_t records_edits;
+    tilemap_edit_t *arr_edits;
+} tilemap_t;
+
+tilemap_t tilemap_new(uint32_t width, uint32_t height, float tile_size);
+void tilemap_free(tilemap_t *self);
+
+/// @brief Same tiles and layout, without the edit log.
+tilemap_t tilemap_clone(const tilemap_t *self);
+
+static inline uint32_t tilemap_chunk_index(const tilemap_t *self, uint32_t x, uint32_t y)
+{
+    return (y / TILEMAP_CHUNK_SIZE) * self->chunks_x + x / TILEMAP_CHUNK_SIZE;
+}
+
+/// @return TILE_EMPTY outside the map.
+static inline tile_id_t tilemap_get(const tilemap_t *self, uint32_t x, uint32_t y)
+{
+    if (x >= self->width || y >= self->height)
+        return TILE_EMPTY;
+
+    const tilemap_chunk_t *chunk = &self->chunks[tilemap_chunk_index(self, x, y)];
+    return chunk->tiles[(y % TILEMAP_CHUNK_SIZE) * TILEMAP_CHUNK_SIZE + x % TILEMAP_CHUNK_SIZE];
+}
+
+/// @brief Change one tile, its chunk's revision only moves if the tile actually changed.
+void tilemap_set(tilemap_t *self, uint32_t x, uint32_t y, tile_id_t tile);
+
+/// @brief Fill [x, x + width) by [y, y + height), clipped to the map. Doesn't go in the edit log, for building maps.
+void tilemap_fill(tilemap_t *self, uint32_t x, uint32_t y, uint32_t width, uint32_t height, tile_id_t tile);
+
+/// @brief Apply edits taken from another tilemap with the same layout.
+void tilemap_apply_edits(tilemap_t *self, const tilemap_edit_t *edits, size_t num_edits);
+
+/// @brief World space bounds of a chunk, min x, min y, max x, max y.
+void tilemap_chunk_bounds(const tilemap_t *self, uint32_t chunk_x, uint32_t chunk_y, vec4 bounds);
+
+/// @brief Random terrain for benchmarks and the --map scene, num_tile_types distinct non-empty tiles.
+void tilemap_generate(tilemap_t *self, uint64_t seed, uint32_t num_tile_types);
+
+#if UNIT_TEST
+#include <assert.h>
+
+static void tilemap_unit_tests_edits()
+{
+    tilemap_t map = tilemap_new(40, 33, 16);
+    assert(map.width == 40 && map.height == 33 && map.chunks_x == 2 && map.chunks_y == 2);
+
+    // Filling the whole map stops at its edges, the rest of the last chunks isn't part of it.
+    tilemap_fill(&map, 0, 0, 64, 64, 3);
+    assert(tilemap_get(&map, 39, 32) == 3);
+    assert(tilemap_get(&map, 40, 0) == TILE_EMPTY && tilemap_get(&map, 0, 33) == TILE_EMPTY);
+    assert(map.chunks[1].tiles[40 % TILEMAP_CHUNK_SIZE] == TILE_EMPTY);
+    assert(map.chunks[2].tiles[TILEMAP_CHUNK_SIZE] == TILE_EMPTY);
+    tilemap_fill(&map, 0, 0, 40, 33, TILE_EMPTY);
+
+    map.records_edits = 1;
+    uint32_t revision = map.chunks[3].revision, other_revision = map.chunks[0].revision;
+    tilemap_set(&map, 33, 32, 7);
+    assert(tilemap_get(&map, 33, 32) == 7);
+    assert(map.chunks[3].revision == revision + 1 && map.chunks[0].revision == other_revision);
+
+    // Setting what's already there is no change.
+    tilemap_set(&map, 33, 32, 7);
+    assert(map.chunks[3].revision == revision + 1);
+
+    tilemap_t copy = tilemap_new(40, 33, 16);
+    tilemap_apply_edits(&copy, map.arr_edits, 1);
+    assert(tilemap_get(&copy, 33, 32) == 7);
+
+    tilemap_free(&copy);
+    tilemap_free(&map);
+}
+
+static int tilemap_unit_tests(void)
+{
+    tilemap_unit_tests_edits();
+
+    return 1;
+}
+#endif
\ No newline at end of file
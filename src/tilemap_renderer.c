@@ -0,0 +1,313 @@
+#include "tilemap_renderer.h"
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+#include "engine/engine.h"
+#include "engine/profiler.h"
+#include "engine/memory.h"
+#include "engine/arena.h"
+#include "util/rng.h"
+#include "app.h"
+
+// Pixels per tileset cell.
+#define TILESET_CELL_SIZE 16
+
+// No art for it yet, a flat colour per tile type with a darker edge so the grid shows.
+static void tilemap_renderer_generate_tileset(tilemap_renderer_t *self, uint32_t num_tile_types)
+{
+    self->tileset_columns = (uint32_t)ceilf(sqrtf((float)num_tile_types));
+    self->tileset_rows = (num_tile_types + self->tileset_columns - 1) / self->tileset_columns;
+
+    uint32_t width = self->tileset_columns * TILESET_CELL_SIZE;
+    uint32_t height = self->tileset_rows * TILESET_CELL_SIZE;
+
+    arena_t *arena = frame_arena_get();
+    size_t mark = arena_mark(arena);
+    uint32_t *pixels = ARENA_ALLOC_ARRAY(arena, uint32_t, (size_t)width * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint32_t cell = (y / TILESET_CELL_SIZE) * self->tileset_columns + x / TILESET_CELL_SIZE;
+            uint32_t colour = (uint32_t)rng_hash(cell + 1) | 0xff000000;
+
+            uint32_t cx = x % TILESET_CELL_SIZE, cy = y % TILESET_CELL_SIZE;
+            if (cx == 0 || cy == 0 || cx == TILESET_CELL_SIZE - 1 || cy == TILESET_CELL_SIZE - 1)
+                colour = (colour >> 1 & 0x007f7f7f) | 0xff000000;
+
+            pixels[(size_t)y * width + x] = colour;
+        }
+    }
+
+    self->tileset.name = "tileset(generated)";
+    mat4x4_identity(self->tileset.uv_matrix);
+    GL_CALL(glCreateTextures(GL_TEXTURE_2D, 1, &self->tileset.texture));
+    GL_CALL(glTextureStorage2D(self->tileset.texture, 1, GL_RGBA8, width, height));
+    GL_CALL(glTextureSubImage2D(self->tileset.texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+    self->tileset.gpu_bytes = memory_texture_bytes(width, height, 4, 0);
+    memory_gpu_alloc(MEMORY_TAG_TILEMAP, self->tileset.gpu_bytes);
+
+    arena_rewind(arena, mark);
+}
+
+tilemap_renderer_t tilemap_renderer_new(GLuint program, const tilemap_t *tilemap, uint32_t num_tile_types)
+{
+    tilemap_renderer_t result = {0};
+    result.program = program;
+    result.tilemap = tilemap_clone(tilemap);
+
+    size_t num_chunks = (size_t)tilemap->chunks_x * tilemap->chunks_y;
+    result.chunk_meshes = mem_calloc(MEMORY_TAG_TILEMAP, num_chunks, sizeof(tilemap_chunk_mesh_t));
+    assert(!num_chunks || result.chunk_meshes);
+
+    GL_CALL(glCreateVertexArrays(1, &result.vertex_array));
+    // Same attributes the sprite shader reads from compact sprite batches, with the buffer bound per chunk.
+    for (GLuint i = 0; i < 3; i++)
+    {
+        GL_CALL(glEnableVertexArrayAttrib(result.vertex_array, i));
+        GL_CALL(glVertexArrayAttribBinding(result.vertex_array, i, 0));
+    }
+    GL_CALL(glVertexArrayAttribFormat(result.vertex_array, 0, 2, GL_FLOAT, GL_FALSE, offsetof(compact_vertex_t, pos)));
+    GL_CALL(glVertexArrayAttribFormat(result.vertex_array, 1, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(compact_vertex_t, uv)));
+    GL_CALL(glVertexArrayAttribFormat(result.vertex_array, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(compact_vertex_t, color)));
+
+    result.index_buffer = quad_index_buffer_new(TILEMAP_CHUNK_TILES, MEMORY_TAG_TILEMAP, &result.index_type);
+    GL_CALL(glVertexArrayElementBuffer(result.vertex_array, result.index_buffer));
+
+    // Nearest so neighbouring cells never bleed into each other.
+    GL_CALL(glCreateSamplers(1, &result.sampler));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CALL(glSamplerParameteri(result.sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    tilemap_renderer_generate_tileset(&result, num_tile_types);
+
+    glObjectLabel(GL_VERTEX_ARRAY, result.vertex_array, -1, "VertexArray(tilemap_renderer_t)");
+
+    return result;
+}
+
+void tilemap_renderer_free(tilemap_renderer_t *self)
+{
+    size_t num_chunks = (size_t)self->tilemap.chunks_x * self->tilemap.chunks_y;
+    for (size_t i = 0; i < num_chunks; i++)
+    {
+        tilemap_chunk_mesh_t *mesh = &self->chunk_meshes[i];
+        if (!mesh->vertex_buffer)
+            continue;
+
+        glDeleteBuffers(1, &mesh->vertex_buffer);
+        memory_gpu_free(MEMORY_TAG_TILEMAP, (size_t)mesh->capacity * 4 * sizeof(compact_vertex_t));
+    }
+    mem_free(self->chunk_meshes);
+
+    quad_index_buffer_free(self->index_buffer, TILEMAP_CHUNK_TILES, MEMORY_TAG_TILEMAP, self->index_type);
+    glDeleteVertexArrays(1, &self->vertex_array);
+    glDeleteSamplers(1, &self->sampler);
+    glDeleteTextures(1, &self->tileset.texture);
+    memory_gpu_free(MEMORY_TAG_TILEMAP, self->tileset.gpu_bytes);
+
+    tilemap_free(&self->tilemap);
+
+    *self = (tilemap_renderer_t){0};
+}
+
+uint32_t tilemap_chunk_write_vertices(const tilemap_t *tilemap,
+                                      uint32_t chunk_x,
+                                      uint32_t chunk_y,
+                                      uint32_t tileset_columns,
+                                      uint32_t tileset_rows,
+                                      compact_vertex_t *vertices)
+{
+    const tilemap_chunk_t *chunk = &tilemap->chunks[chunk_y * tilemap->chunks_x + chunk_x];
+
+    vec4 bounds;
+    tilemap_chunk_bounds(tilemap, chunk_x, chunk_y, bounds);
+    float tile_size = tilemap->tile_size;
+
+    // Half a texel in from each cell's edge, so the nearest sample never lands in the next cell over.
+    float cell_u = 65535.0f / tileset_columns, cell_v = 65535.0f / tileset_rows;
+    float inset_u = 65535.0f / (2.0f * tileset_columns * TILESET_CELL_SIZE);
+    float inset_v = 65535.0f / (2.0f * tileset_rows * TILESET_CELL_SIZE);
+
+    uint32_t num_quads = 0;
+    for (uint32_t y = 0; y < TILEMAP_CHUNK_SIZE; y++)
+    {
+        float y0 = bounds[1] + y * tile_size, y1 = y0 + tile_size;
+        for (uint32_t x = 0; x < TILEMAP_CHUNK_SIZE; x++)
+        {
+            tile_id_t tile = chunk->tiles[y * TILEMAP_CHUNK_SIZE + x];
+            if (tile == TILE_EMPTY)
+                continue;
+
+            uint32_t cell = (uint32_t)(tile - 1) % (tileset_columns * tileset_rows);
+            float u0 = (cell % tileset_columns) * cell_u, v0 = (cell / tileset_columns) * cell_v;
+            uint16_t uv0[2] = {(uint16_t)(u0 + inset_u), (uint16_t)(v0 + inset_v)};
+            uint16_t uv1[2] = {(uint16_t)(u0 + cell_u - inset_u), (uint16_t)(v0 + cell_v - inset_v)};
+
+            float x0 = bounds[0] + x * tile_size, x1 = x0 + tile_size;
+
+            // Same corner order as sprite_quad_t, which the shared index buffer expects.
+            compact_vertex_t *quad = &vertices[num_quads * 4];
+            quad[0] = (compact_vertex_t){{x0, y0}, {uv0[0], uv0[1]}, {255, 255, 255, 255}};
+            quad[1] = (compact_vertex_t){{x0, y1}, {uv0[0], uv1[1]}, {255, 255, 255, 255}};
+            quad[2] = (compact_vertex_t){{x1, y1}, {uv1[0], uv1[1]}, {255, 255, 255, 255}};
+            quad[3] = (compact_vertex_t){{x1, y0}, {uv1[0], uv0[1]}, {255, 255, 255, 255}};
+            num_quads++;
+        }
+    }
+
+    return num_quads;
+}
+
+uint8_t tilemap_visible_chunks(const tilemap_t *tilemap, mat4x4 view_proj, uint32_t range[4])
+{
+    // The corners of clip space back in the world, the camera can rotate so take the box around all four.
+    mat4x4 inverse;
+    mat4x4_invert(inverse, view_proj);
+
+    float min[2] = {INFINITY, INFINITY}, max[2] = {-INFINITY, -INFINITY};
+    for (size_t i = 0; i < 4; i++)
+    {
+        vec4 corner = {i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, 0, 1};
+        vec4 world;
+        mat4x4_mul_vec4(world, inverse, corner);
+        for (size_t axis = 0; axis < 2; axis++)
+        {
+            float value = world[axis] / world[3];
+            min[axis] = fminf(min[axis], value);
+            max[axis] = fmaxf(max[axis], value);
+        }
+    }
+
+    float chunk_world_size = tilemap->tile_size * TILEMAP_CHUNK_SIZE;
+    uint32_t num_chunks[2] = {tilemap->chunks_x, tilemap->chunks_y};
+    for (size_t axis = 0; axis < 2; axis++)
+    {
+        float first = floorf((min[axis] - tilemap->origin[axis]) / chunk_world_size);
+        float last = floorf((max[axis] - tilemap->origin[axis]) / chunk_world_size) + 1;
+        if (last <= 0 || first >= (float)num_chunks[axis])
+            return 0;
+
+        range[axis] = first < 0 ? 0 : (uint32_t)first;
+        range[axis + 2] = last > (float)num_chunks[axis] ? num_chunks[axis] : (uint32_t)last;
+    }
+
+    return 1;
+}
+
+static void tilemap_renderer_build_chunk(tilemap_renderer_t *self, uint32_t chunk_x, uint32_t chunk_y)
+{
+    PROFILE_FUNCTION();
+
+    uint32_t chunk_index = chunk_y * self->tilemap.chunks_x + chunk_x;
+    tilemap_chunk_mesh_t *mesh = &self->chunk_meshes[chunk_index];
+
+    arena_t *arena = frame_arena_get();
+    size_t mark = arena_mark(arena);
+    compact_vertex_t *vertices = ARENA_ALLOC_ARRAY(arena, compact_vertex_t, TILEMAP_CHUNK_TILES * 4);
+
+    uint32_t num_quads = tilemap_chunk_write_vertices(&self->tilemap, chunk_x, chunk_y, self->tileset_columns, self->tileset_rows, vertices);
+    size_t quad_bytes = 4 * sizeof(compact_vertex_t);
+
+    // Sized to what's in it, a mostly empty chunk shouldn't cost a full one. Only grows.
+    if (num_quads > mesh->capacity)
+    {
+        if (mesh->vertex_buffer)
+        {
+            glDeleteBuffers(1, &mesh->vertex_buffer);
+            memory_gpu_free(MEMORY_TAG_TILEMAP, mesh->capacity * quad_bytes);
+        }
+
+        mesh->capacity = num_quads;
+        GL_CALL(glCreateBuffers(1, &mesh->vertex_buffer));
+        GL_CALL(glNamedBufferStorage(mesh->vertex_buffer, mesh->capacity * quad_bytes, vertices, GL_DYNAMIC_STORAGE_BIT));
+        memory_gpu_alloc(MEMORY_TAG_TILEMAP, mesh->capacity * quad_bytes);
+    }
+    else if (num_quads)
+    {
+        GL_CALL(glNamedBufferSubData(mesh->vertex_buffer, 0, num_quads * quad_bytes, vertices));
+    }
+
+    mesh->num_quads = num_quads;
+    mesh->revision = self->tilemap.chunks[chunk_index].revision;
+    self->num_chunks_built++;
+
+    arena_rewind(arena, mark);
+}
+
+void tilemap_renderer_draw(tilemap_renderer_t *self, mat4x4 view_proj)
+{
+    PROFILE_FUNCTION();
+
+    uint32_t range[4];
+    if (!tilemap_visible_chunks(&self->tilemap, view_proj, range))
+        return;
+
+    uint32_t gpu_zone = self->gpu_timer ? gpu_timer_begin(self->gpu_timer, "tilemap") : GPU_TIMER_INVALID_ZONE;
+
+    // Opaque ground, drawn first so there's nothing under it to blend with.
+    GL_CALL(glDisable(GL_BLEND));
+    GL_CALL(glUseProgram(self->program));
+    glUniformMatrix4fv(glGetUniformLocation(self->program, "mat_view_proj"), 1, GL_FALSE, view_proj[0]);
+    GL_CALL(glBindVertexArray(self->vertex_array));
+    GL_CALL(glBindTextureUnit(0, self->tileset.texture));
+    GL_CALL(glBindSampler(0, self->sampler));
+
+    for (uint32_t chunk_y = range[1]; chunk_y < range[3]; chunk_y++)
+    {
+        for (uint32_t chunk_x = range[0]; chunk_x < range[2]; chunk_x++)
+        {
+            uint32_t chunk_index = chunk_y * self->tilemap.chunks_x + chunk_x;
+            tilemap_chunk_mesh_t *mesh = &self->chunk_meshes[chunk_index];
+            if (mesh->revision != self->tilemap.chunks[chunk_index].revision)
+                tilemap_renderer_build_chunk(self, chunk_x, chunk_y);
+
+            if (!mesh->num_quads)
+                continue;
+
+            GL_CALL(glVertexArrayVertexBuffer(self->vertex_array, 0, mesh->vertex_buffer, 0, sizeof(compact_vertex_t)));
+            GL_CALL(glDrawElements(GL_TRIANGLES, (GLsizei)(mesh->num_quads * 6), self->index_type, 0));
+
+            self->num_draw_calls++;
+            self->num_quads_drawn += mesh->num_quads;
+        }
+    }
+
+    if (self->gpu_timer)
+        gpu_timer_end(self->gpu_timer, gpu_zone);
+
+    glBindSampler(0, 0);
+    glBindTextureUnit(0, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+void tilemap_render_system(app_t *app)
+{
+    tilemap_renderer_t *renderer = app->tilemap_renderer;
+    if (!renderer)
+        return;
+
+    PROFILE_FUNCTION();
+
+    render_snapshots_t *snapshots = &app->render_snapshots;
+    const render_snapshot_t *snapshot = render_snapshots_acquire(snapshots);
+
+    // Everything published since the last frame, however many snapshots that was.
+    tilemap_apply_edits(&renderer->tilemap, snapshots->arr_tile_edits, arrlenu(snapshots->arr_tile_edits));
+    arrsetlen(snapshots->arr_tile_edits, 0);
+
+    if (snapshot->has_camera)
+    {
+        mat4x4 view_proj;
+        mat4x4_dup(view_proj, snapshot->view_proj);
+        render_snapshots_release(snapshots);
+
+        tilemap_renderer_draw(renderer, view_proj);
+        return;
+    }
+
+    render_snapshots_release(snapshots);
+}
\ No newline at end of file
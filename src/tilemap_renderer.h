@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <glad/glad.h>
+#include "vendor/linmath.h"
+#include "tilemap.h"
+#include "texture.h"
+#include "sprite_batch.h"
+#include "engine/gpu_timer.h"
+
+typedef struct app_t app_t;
+
+// One chunk's quads, built into a static buffer and only rebuilt when the chunk's revision moves on.
+typedef struct tilemap_chunk_mesh_t
+{
+    GLuint vertex_buffer;
+    // Quads the buffer has room for and how many are in it, empty tiles get no quad.
+    uint32_t capacity;
+    uint32_t num_quads;
+    // Of the chunk it was built from, 0 for never built.
+    uint32_t revision;
+} tilemap_chunk_mesh_t;
+
+/// @brief Draws a tilemap a chunk at a time, one draw call per visible chunk and no vertex work for chunks that
+/// haven't changed. Chunks are built the first time they're seen.
+typedef struct tilemap_renderer_t
+{
+    // The render side's copy of the map, kept in step with the simulation's through the edits in render snapshots.
+    tilemap_t tilemap;
+    // One per chunk, same order.
+    tilemap_chunk_mesh_t *chunk_meshes;
+
+    GLuint program;
+    // compact_vertex_t layout with the vertex buffer swapped per chunk.
+    GLuint vertex_array;
+    // Enough for a full chunk, shared by all of them.
+    GLuint index_buffer;
+    GLenum index_type;
+    GLuint sampler;
+
+    // Generated, num_tile_types cells in a grid.
+    texture_t tileset;
+    uint32_t tileset_columns, tileset_rows;
+
+    // Optional, times every draw on the GPU when set.
+    gpu_timer_t *gpu_timer;
+
+    // Reset by the owner whenever it wants, usually once per frame.
+    uint32_t num_draw_calls;
+    uint32_t num_chunks_built;
+    uint32_t num_quads_drawn;
+} tilemap_renderer_t;
+
+/// @param tilemap Copied, the renderer never reads it again.
+tilemap_renderer_t tilemap_renderer_new(GLuint program, const tilemap_t *tilemap, uint32_t num_tile_types);
+void tilemap_renderer_free(tilemap_renderer_t *self);
+
+/// @brief Draw every chunk view_proj can see, building the ones that are out of date first.
+void tilemap_renderer_draw(tilemap_renderer_t *self, mat4x4 view_proj);
+
+/// @brief Apply published tile edits and draw the map under everything else, no-op without one.
+void tilemap_render_system(app_t *app);
+
+/// @brief The CPU half of building a chunk, a quad per non-empty tile.
+/// @param vertices Room for TILEMAP_CHUNK_TILES * 4.
+/// @return Number of quads written.
+uint32_t tilemap_chunk_write_vertices(const tilemap_t *tilemap,
+                                      uint32_t chunk_x,
+                                      uint32_t chunk_y,
+                                      uint32_t tileset_columns,
+                                      uint32_t tileset_rows,
+                                      compact_vertex_t *vertices);
+
+/// @brief Chunks overlapping what view_proj can see, as [min x, min y, max x, max y) in chunks.
+/// @return 0 if none are.
+uint8_t tilemap_visible_chunks(const tilemap_t *tilemap, mat4x4 view_proj, uint32_t range[4]);
\ No newline at end of file
@@ -1,31 +1,140 @@
 #include "transform.h"
-#include "vendor/stb_ds.h"
+#include "engine/memory.h"
+#include "engine/arena.h"
 #include "entities.h"
-#include "search.h"
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "engine/profiler.h"
+
+void render_transform_lerp(render_transform_t *out, const render_transform_t *a, const render_transform_t *b, float t)
+{
+    for (size_t i = 0; i < 3; i++)
+        out->pos[i] = a->pos[i] + (b->pos[i] - a->pos[i]) * t;
+
+    for (size_t i = 0; i < 2; i++)
+        out->scale[i] = a->scale[i] + (b->scale[i] - a->scale[i]) * t;
+
+    out->flip_flags = b->flip_flags;
+    out->is_rotated = a->is_rotated || b->is_rotated;
+    if (!out->is_rotated)
+        return;
+
+    // Lerp the unit vectors and renormalise, one square root and no trig.
+    float a_cos = a->is_rotated ? a->cos_rotation : 1, a_sin = a->is_rotated ? a->sin_rotation : 0;
+    float b_cos = b->is_rotated ? b->cos_rotation : 1, b_sin = b->is_rotated ? b->sin_rotation : 0;
+    float c = a_cos + (b_cos - a_cos) * t;
+    float s = a_sin + (b_sin - a_sin) * t;
+    float length = sqrtf(c * c + s * s);
+    if (length > 1e-6f)
+    {
+        out->cos_rotation = c / length;
+        out->sin_rotation = s / length;
+    }
+    else
+    {
+        // Exactly half way through a half turn, either end will do.
+        out->cos_rotation = b_cos;
+        out->sin_rotation = b_sin;
+    }
+}
 
 void set_pos(transform_t *transform, vec3 pos)
 {
-    memcpy_s(transform->pos, sizeof(vec3), pos, sizeof(vec3));
+    memcpy(transform->pos, pos, sizeof(vec3));
     transform->is_dirty = 1;
 }
 
 void set_scale(transform_t *transform, vec2 scale)
 {
-    memcpy_s(transform->scale, sizeof(vec2), scale, sizeof(vec2));
+    memcpy(transform->scale, scale, sizeof(vec2));
+    transform->is_dirty = 1;
+}
+
+void set_rotation(transform_t *transform, float radians)
+{
+    transform->rotation = radians;
     transform->is_dirty = 1;
 }
 
+void set_flip(transform_t *transform, uint8_t flip_flags)
+{
+    // Only the texture coordinates change, the matrices don't need rebuilding.
+    transform->flip_flags = flip_flags;
+}
+
 void update_local(transform_t *transform)
 {
     if (!transform->is_dirty)
         return;
 
-    mat4x4_identity(transform->local_matrix);
+    // Most things never rotate, skip the trig for them.
+    if (transform->rotation != 0)
+    {
+        transform->sin_rotation = sinf(transform->rotation);
+        transform->cos_rotation = cosf(transform->rotation);
+    }
+    else
+    {
+        transform->sin_rotation = 0;
+        transform->cos_rotation = 1;
+    }
+
+    // Translate * rotate * scale.
     mat4x4_translate(transform->local_matrix, transform->pos[0], transform->pos[1], transform->pos[2]);
-    transform->local_matrix[0][0] = transform->scale[0];
-    transform->local_matrix[1][1] = transform->scale[1];
+    transform->local_matrix[0][0] = transform->cos_rotation * transform->scale[0];
+    transform->local_matrix[0][1] = transform->sin_rotation * transform->scale[0];
+    transform->local_matrix[1][0] = -transform->sin_rotation * transform->scale[1];
+    transform->local_matrix[1][1] = transform->cos_rotation * transform->scale[1];
 
     transform->is_dirty = 0;
+    transform->is_global_dirty = 1;
+}
+
+void get_render_transform(const transform_t *transform, render_transform_t *out)
+{
+    const vec4 *m = transform->global_matrix;
+    memcpy(out->pos, m[3], sizeof(vec3));
+    out->flip_flags = transform->flip_flags;
+
+    if (m[0][1] == 0 && m[1][0] == 0)
+    {
+        out->scale[0] = m[0][0];
+        out->scale[1] = m[1][1];
+        out->is_rotated = 0;
+        out->cos_rotation = 1;
+        out->sin_rotation = 0;
+        return;
+    }
+
+    // Rotation and scale back out of the x axis, y takes the sign of the determinant so mirroring survives.
+    float scale_x = sqrtf(m[0][0] * m[0][0] + m[0][1] * m[0][1]);
+    float scale_y = sqrtf(m[1][0] * m[1][0] + m[1][1] * m[1][1]);
+    if (m[0][0] * m[1][1] - m[0][1] * m[1][0] < 0)
+        scale_y = -scale_y;
+
+    out->scale[0] = scale_x;
+    out->scale[1] = scale_y;
+    out->is_rotated = 1;
+    out->cos_rotation = scale_x > 0 ? m[0][0] / scale_x : 1;
+    out->sin_rotation = scale_x > 0 ? m[0][1] / scale_x : 0;
+}
+
+// Both are affine, so the bottom row is always 0 0 0 1 and only the top three rows need multiplying.
+static void mat4x4_mul_affine(mat4x4 out, const mat4x4 a, const mat4x4 b)
+{
+    for (size_t c = 0; c < 4; c++)
+    {
+        for (size_t r = 0; r < 3; r++)
+            out[c][r] = a[0][r] * b[c][0] + a[1][r] * b[c][1] + a[2][r] * b[c][2];
+
+        out[c][3] = 0;
+    }
+
+    for (size_t r = 0; r < 3; r++)
+        out[3][r] += a[3][r];
+
+    out[3][3] = 1;
 }
 
 // void sort_transforms(app_t *app)
@@ -37,41 +146,109 @@ void update_local(transform_t *transform)
 //     }
 // }
 
-void update_local_system(app_t *app)
+void update_local_system(world_t *world)
 {
-    for (size_t i = 0; i < arrlen(app->entities); i++)
+    PROFILE_FUNCTION();
+
+    for (size_t i = 0; i < arrlen(world->entities); i++)
     {
-        update_local(&app->entities[i]->transform);
+        update_local(&world->entities[i]->transform);
     }
 }
 
-void traverse_and_push_children(entity_t *node, entity_t **dest)
+// Iterative, the sibling links are enough to find the way back up so there's no stack to overflow on deep trees.
+// Global matrices are updated on the way, parents are always visited first, so it's one pass over the entities.
+static void flatten_hierarchy(world_t *world)
 {
-    arrput(dest, node);
+    size_t num_entities = arrlenu(world->entities);
+
+    // Into last step's list and swap, both keep their capacity so steady state this never allocates.
+    MEMORY_SCOPE(MEMORY_TAG_TRANSFORMS);
+    entity_t **sorted = world->entities_back;
+    arrsetlen(sorted, num_entities);
+    arrsetlen(world->arr_parent_indices, num_entities);
+    arrsetlen(world->arr_subtree_sizes, num_entities);
+    uint32_t *parents = world->arr_parent_indices;
+    uint32_t *sizes = world->arr_subtree_sizes;
 
-    for (size_t i = 0; i < arrlen(node->children); i++)
+    // Whether each entity's global matrix changed this pass, so its children know to follow.
+    arena_t *arena = frame_arena_current(&world->sim_arena);
+    size_t mark = arena_mark(arena);
+    uint8_t *changed = ARENA_ALLOC_ARRAY(arena, uint8_t, num_entities);
+
+    size_t count = 0;
+    entity_t *node = world->root;
+    while (node)
     {
-        traverse_and_push_children(node->children[i], dest);
+        assert(count < num_entities);
+        uint32_t parent = node == world->root ? HIERARCHY_NO_PARENT : node->parent->hierarchy_index;
+        node->hierarchy_index = (uint32_t)count;
+        sorted[count] = node;
+        parents[count] = parent;
+        sizes[count] = 1;
+
+        transform_t *transform = &node->transform;
+        changed[count] = transform->is_global_dirty || (parent != HIERARCHY_NO_PARENT && changed[parent]);
+        if (changed[count])
+        {
+            if (parent == HIERARCHY_NO_PARENT)
+                mat4x4_dup(transform->global_matrix, transform->local_matrix);
+            else
+                mat4x4_mul_affine(transform->global_matrix, node->parent->transform.global_matrix, transform->local_matrix);
+
+            transform->is_global_dirty = 0;
+        }
+
+        count++;
+
+        if (node->first_child)
+        {
+            node = node->first_child;
+            continue;
+        }
+
+        while (node != world->root && !node->next_sibling)
+            node = node->parent;
+
+        node = node == world->root ? 0 : node->next_sibling;
     }
+
+    arena_rewind(arena, mark);
+
+    // Anything not reached isn't under root, which the orphan pass should have made impossible.
+    assert(count == num_entities);
+
+    // Backwards every subtree is complete before it's added to its parent's.
+    for (size_t i = count; i-- > 1;)
+        sizes[parents[i]] += sizes[i];
+
+    world->entities_back = world->entities;
+    world->entities = sorted;
 }
 
-void update_global_system(app_t *app)
+void update_global_system(world_t *world)
 {
+    PROFILE_FUNCTION();
+
     // Make all orphaned entities a direct child of root.
-    for (size_t i = 0; i < arrlen(app->entities); i++)
+    for (size_t i = 0; i < arrlen(world->entities); i++)
     {
-        if (!app->entities[i]->parent && app->entities[i] != app->root)
-            arrput(app->root->children, app->entities[i]);
+        // Parent them properly, this now runs every step and would otherwise push the same orphans again each time.
+        if (!world->entities[i]->parent && world->entities[i] != world->root)
+            set_parent(world->entities[i], world->root);
     }
 
-    entity_t **arr_sorted = 0;
-    arrsetcap(arr_sorted, arrlen(app->entities));
-
-    // Traverse the tree and push all children into arr_sorted.
-    traverse_and_push_children(app->root, arr_sorted);
+    flatten_hierarchy(world);
+}
 
-    arrfree(app->entities);
+void store_previous_transform_system(world_t *world)
+{
+    PROFILE_FUNCTION();
 
-    // Entities list is now a sorted tree.
-    app->entities = arr_sorted;
+    for (size_t i = 0; i < arrlen(world->entities); i++)
+    {
+        transform_t *transform = &world->entities[i]->transform;
+        get_render_transform(transform, &transform->previous);
+        transform->has_previous = 1;
+    }
 }
\ No newline at end of file
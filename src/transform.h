@@ -1,7 +1,31 @@
 #pragma once
+#include <stdint.h>
 #include "vendor/linmath.h"
 
-typedef struct app_t app_t;
+typedef struct world_t world_t;
+
+// Flips mirror the texture, they aren't inherited by children.
+typedef enum transform_flip_e
+{
+    TRANSFORM_FLIP_NONE = 0,
+    TRANSFORM_FLIP_X = 1 << 0,
+    TRANSFORM_FLIP_Y = 1 << 1,
+} transform_flip_e;
+
+/// @brief The part of a transform the renderer needs to place a quad, interpolated between simulation steps.
+typedef struct render_transform_t
+{
+    vec3 pos;
+    vec2 scale;
+
+    // Only read when is_rotated, so a zeroed transform is axis aligned and takes the batcher's fast path.
+    float cos_rotation;
+    float sin_rotation;
+    uint8_t is_rotated;
+    uint8_t flip_flags;
+} render_transform_t;
+
+void render_transform_lerp(render_transform_t *out, const render_transform_t *a, const render_transform_t *b, float t);
 
 typedef struct transform_t
 {
@@ -9,18 +33,49 @@ typedef struct transform_t
     mat4x4 local_matrix;
 
     uint8_t is_dirty;
+    // Set when the local matrix or the parent changes, the global pass then updates this and everything under it.
+    uint8_t is_global_dirty;
 
     vec3 pos;
     vec2 scale;
+    // Radians, counter clockwise around the sprite's anchor.
+    float rotation;
+    // Cached by update_local whenever the transform is dirty, so nothing downstream calls sinf/cosf.
+    float sin_rotation;
+    float cos_rotation;
+    uint8_t flip_flags;
+
+    // State at the start of the current simulation step.
+    render_transform_t previous;
+    // Clear until the first store_previous_transform_system after it's created, an entity spawned during a step has
+    // no previous state and is drawn where it is.
+    uint8_t has_previous;
 } transform_t;
 
 void set_pos(transform_t *transform, vec3 pos);
 
 void set_scale(transform_t *transform, vec2 scale);
 
+void set_rotation(transform_t *transform, float radians);
+
+/// @param flip_flags transform_flip_e flags.
+void set_flip(transform_t *transform, uint8_t flip_flags);
+
 void update_local(transform_t *transform);
 
-typedef struct app_t app_t;
+/// @brief Position, scale and rotation out of the global matrix, as of the last update_global_system.
+void get_render_transform(const transform_t *transform, render_transform_t *out);
+
+// Parent index of root in world->arr_parent_indices.
+#define HIERARCHY_NO_PARENT UINT32_MAX
+
 // void sort_transforms(app_t *app);
-void update_local_system(app_t *app);
-void update_global_system(app_t *app);
\ No newline at end of file
+void update_local_system(world_t *world);
+
+/// @brief Flatten the hierarchy into world->entities in depth first pre-order, with parent indices and subtree sizes
+/// alongside, updating global matrices on the way. Parents always come before their children, so it's one pass and
+/// only subtrees with a changed transform or parent are recomputed.
+void update_global_system(world_t *world);
+
+/// @brief Remember every transform's current state as the previous state, run at the start of each simulation step.
+void store_previous_transform_system(world_t *world);
\ No newline at end of file
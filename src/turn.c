@@ -0,0 +1,621 @@
+#include "turn.h"
+#include <string.h>
+#include <assert.h>
+#include <SDL2/SDL.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+typedef enum turn_move_state_e
+{
+    TURN_MOVE_NONE = 0,
+    // Won the tile it wants, still depends on whoever is on it moving out.
+    TURN_MOVE_PENDING,
+    TURN_MOVE_VISITING,
+    TURN_MOVE_DONE,
+    TURN_MOVE_FAILED,
+} turn_move_state_e;
+
+// The 8 neighbours, always searched in this order.
+static const int8_t turn_directions[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+turn_state_t turn_state_new(uint32_t width, uint32_t height, uint64_t seed)
+{
+    turn_state_t result = {0};
+    result.width = width;
+    result.height = height;
+    result.seed = seed;
+
+    size_t num_tiles = (size_t)width * height;
+    result.blocked = mem_calloc(MEMORY_TAG_TURNS, num_tiles, sizeof(uint8_t));
+    result.occupancy = mem_alloc(MEMORY_TAG_TURNS, num_tiles * sizeof(uint32_t));
+    assert(!num_tiles || (result.blocked && result.occupancy));
+    // Every byte 0xff is TURN_NO_UNIT.
+    memset(result.occupancy, 0xff, num_tiles * sizeof(uint32_t));
+
+    result.regions_x = (width + TURN_REGION_SIZE - 1) / TURN_REGION_SIZE;
+    result.regions_y = (height + TURN_REGION_SIZE - 1) / TURN_REGION_SIZE;
+    result.region_starts = mem_calloc(MEMORY_TAG_TURNS, (size_t)result.regions_x * result.regions_y + 1, sizeof(uint32_t));
+    result.region_num_attackers = mem_calloc(MEMORY_TAG_TURNS, (size_t)result.regions_x * result.regions_y, sizeof(uint32_t));
+    assert(result.region_starts && result.region_num_attackers);
+
+    return result;
+}
+
+turn_state_t turn_state_from_tilemap(const tilemap_t *tilemap, const uint8_t *blocked_tiles, uint32_t num_blocked_tiles, uint64_t seed)
+{
+    PROFILE_FUNCTION();
+
+    turn_state_t result = turn_state_new(tilemap->width, tilemap->height, seed);
+    for (uint32_t y = 0; y < tilemap->height; y++)
+    {
+        for (uint32_t x = 0; x < tilemap->width; x++)
+        {
+            tile_id_t tile = tilemap_get(tilemap, x, y);
+            turn_set_wall(&result, (int32_t)x, (int32_t)y, tile != TILE_EMPTY && tile < num_blocked_tiles && blocked_tiles[tile]);
+        }
+    }
+
+    return result;
+}
+
+void turn_apply_edits(turn_state_t *self, const tilemap_edit_t *edits, size_t num_edits, const uint8_t *blocked_tiles, uint32_t num_blocked_tiles)
+{
+    for (size_t i = 0; i < num_edits; i++)
+    {
+        tile_id_t tile = edits[i].tile;
+        turn_set_wall(self, (int32_t)edits[i].x, (int32_t)edits[i].y, tile != TILE_EMPTY && tile < num_blocked_tiles && blocked_tiles[tile]);
+    }
+}
+
+void turn_set_wall(turn_state_t *self, int32_t x, int32_t y, uint8_t is_wall)
+{
+    assert(x >= 0 && y >= 0 && (uint32_t)x < self->width && (uint32_t)y < self->height);
+    size_t index = (size_t)y * self->width + x;
+    is_wall = is_wall != 0;
+    // XOR adds a wall and takes it away again, in any order. Off by one, rng_hash(0) is 0.
+    if (self->blocked[index] != is_wall)
+        self->walls_hash ^= rng_hash(index + 1);
+    self->blocked[index] = is_wall;
+}
+
+void turn_state_free(turn_state_t *self)
+{
+    mem_free(self->blocked);
+    mem_free(self->occupancy);
+    mem_free(self->region_starts);
+    mem_free(self->region_num_attackers);
+    arrfree(self->arr_units);
+    arrfree(self->arr_actions);
+    arrfree(self->arr_region_units);
+    arrfree(self->arr_region_attackers);
+    arrfree(self->arr_move_states);
+    arrfree(self->arr_chain);
+    arrfree(self->arr_worker_stats);
+
+    *self = (turn_state_t){0};
+}
+
+uint32_t turn_add_unit(turn_state_t *self, int32_t x, int32_t y, uint16_t team, uint8_t is_ai)
+{
+    assert(turn_is_open(self, x, y));
+    uint32_t *tile = &self->occupancy[(size_t)y * self->width + x];
+    assert(*tile == TURN_NO_UNIT);
+
+    turn_unit_t unit = {0};
+    unit.x = x;
+    unit.y = y;
+    unit.hp = TURN_UNIT_HP;
+    unit.team = team;
+    unit.is_ai = is_ai;
+    unit.num_items = TURN_UNIT_ITEMS;
+
+    MEMORY_SCOPE(MEMORY_TAG_TURNS);
+    *tile = (uint32_t)arrlenu(self->arr_units);
+    arrput(self->arr_units, unit);
+    arrput(self->arr_actions, (turn_action_t){0});
+    arrput(self->arr_move_states, TURN_MOVE_NONE);
+
+    return *tile;
+}
+
+void turn_restore(turn_state_t *self, uint32_t turn_number, const turn_unit_t *units, size_t num_units)
+{
+    self->turn_number = turn_number;
+
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TURNS);
+        arrsetlen(self->arr_units, num_units);
+        arrsetlen(self->arr_actions, num_units);
+        arrsetlen(self->arr_move_states, num_units);
+    }
+    memcpy(self->arr_units, units, num_units * sizeof(turn_unit_t));
+    memset(self->arr_actions, 0, num_units * sizeof(turn_action_t));
+    memset(self->arr_move_states, TURN_MOVE_NONE, num_units);
+
+    // The dead are off the map, same as after turn_resolve.
+    memset(self->occupancy, 0xff, (size_t)self->width * self->height * sizeof(uint32_t));
+    for (size_t i = 0; i < num_units; i++)
+    {
+        const turn_unit_t *unit = &self->arr_units[i];
+        if (unit->hp > 0)
+            self->occupancy[(size_t)unit->y * self->width + unit->x] = (uint32_t)i;
+    }
+}
+
+void turn_queue_action(turn_state_t *self, uint32_t unit, turn_action_t action)
+{
+    assert(unit < arrlenu(self->arr_units));
+    self->arr_actions[unit] = action;
+}
+
+static inline uint32_t turn_unit_at(const turn_state_t *self, int32_t x, int32_t y)
+{
+    if (x < 0 || y < 0 || (uint32_t)x >= self->width || (uint32_t)y >= self->height)
+        return TURN_NO_UNIT;
+
+    return self->occupancy[(size_t)y * self->width + x];
+}
+
+// Units on the 8 neighbours of a tile in turn_directions order, TURN_NO_UNIT for none or off the map.
+static inline void turn_neighbours(const turn_state_t *self, int32_t x, int32_t y, uint32_t neighbours[8])
+{
+    int32_t width = (int32_t)self->width;
+    if (x <= 0 || y <= 0 || x + 1 >= width || y + 1 >= (int32_t)self->height)
+    {
+        for (uint32_t i = 0; i < 8; i++)
+            neighbours[i] = turn_unit_at(self, x + turn_directions[i][0], y + turn_directions[i][1]);
+        return;
+    }
+
+    // Nowhere near an edge, straight out of the three rows.
+    const uint32_t *tile = &self->occupancy[(size_t)y * self->width + x];
+    neighbours[0] = tile[1];
+    neighbours[1] = tile[width + 1];
+    neighbours[2] = tile[width];
+    neighbours[3] = tile[width - 1];
+    neighbours[4] = tile[-1];
+    neighbours[5] = tile[-width - 1];
+    neighbours[6] = tile[-width];
+    neighbours[7] = tile[-width + 1];
+}
+
+// Counting sort of the living units by region, stable so each region's units stay in ID order.
+static void turn_bucket_units(turn_state_t *self)
+{
+    uint32_t num_regions = self->regions_x * self->regions_y;
+    uint32_t *starts = self->region_starts;
+    memset(starts, 0, ((size_t)num_regions + 1) * sizeof(uint32_t));
+
+    size_t num_units = arrlenu(self->arr_units);
+    uint32_t num_alive = 0;
+    for (size_t i = 0; i < num_units; i++)
+    {
+        const turn_unit_t *unit = &self->arr_units[i];
+        if (unit->hp <= 0)
+            continue;
+
+        starts[(unit->y / TURN_REGION_SIZE) * self->regions_x + unit->x / TURN_REGION_SIZE]++;
+        num_alive++;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        uint32_t count = starts[i];
+        starts[i] = total;
+        total += count;
+    }
+
+    MEMORY_SCOPE(MEMORY_TAG_TURNS);
+    arrsetlen(self->arr_region_units, num_alive);
+    for (size_t i = 0; i < num_units; i++)
+    {
+        const turn_unit_t *unit = &self->arr_units[i];
+        if (unit->hp > 0)
+            self->arr_region_units[starts[(unit->y / TURN_REGION_SIZE) * self->regions_x + unit->x / TURN_REGION_SIZE]++] = (uint32_t)i;
+    }
+
+    // Each start is now the next one's, shift them back up.
+    memmove(&starts[1], &starts[0], num_regions * sizeof(uint32_t));
+    starts[0] = 0;
+}
+
+typedef struct turn_job_t
+{
+    turn_state_t *self;
+    // Of this turn, moves fought over go to the lowest.
+    uint64_t priority_seed;
+} turn_job_t;
+
+static inline uint64_t turn_priority(const turn_job_t *job, uint32_t unit)
+{
+    return rng_hash_combine(job->priority_seed, unit);
+}
+
+static void turn_run_phase(turn_job_t *job, job_system_t *jobs, job_range_fn_t fn)
+{
+    uint32_t num_regions = job->self->regions_x * job->self->regions_y;
+    if (jobs)
+        job_system_parallel_for(jobs, num_regions, 1, fn, job);
+    else
+        fn(job, 0, num_regions, 0);
+}
+
+static void turn_ai_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    (void)worker_index;
+
+    for (uint32_t unit_index = self->region_starts[begin]; unit_index < self->region_starts[end]; unit_index++)
+    {
+        uint32_t id = self->arr_region_units[unit_index];
+        const turn_unit_t *unit = &self->arr_units[id];
+        if (!unit->is_ai)
+            continue;
+
+        turn_action_t action = {0};
+        uint32_t neighbours[8];
+        turn_neighbours(self, unit->x, unit->y, neighbours);
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            uint32_t other = neighbours[i];
+            if (other != TURN_NO_UNIT && self->arr_units[other].team != unit->team)
+            {
+                action.type = TURN_ACTION_ATTACK;
+                action.target = other;
+                break;
+            }
+        }
+
+        if (!action.type && unit->hp <= TURN_UNIT_HP / 2 && unit->num_items)
+        {
+            action.type = TURN_ACTION_USE_ITEM;
+        }
+        else if (!action.type)
+        {
+            uint32_t direction = (uint32_t)(turn_priority(job, id) >> 32) % 8;
+            action.type = TURN_ACTION_MOVE;
+            action.dx = turn_directions[direction][0];
+            action.dy = turn_directions[direction][1];
+        }
+
+        // Only ever its own slot.
+        self->arr_actions[id] = action;
+    }
+}
+
+void turn_queue_ai_actions(turn_state_t *self, job_system_t *jobs)
+{
+    PROFILE_FUNCTION();
+
+    turn_bucket_units(self);
+
+    // Seeded apart from the priorities, so which way a unit wanders doesn't decide whether it wins a tile.
+    turn_job_t job = {self, rng_hash_combine(rng_hash(self->seed ^ 0xa1), self->turn_number)};
+    turn_run_phase(&job, jobs, turn_ai_range);
+}
+
+// Whether each mover wins the tile it wants, by looking at everyone else who could want it. Only writes the mover's
+// own state.
+static void turn_claim_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    (void)worker_index;
+
+    for (uint32_t unit_index = self->region_starts[begin]; unit_index < self->region_starts[end]; unit_index++)
+    {
+        uint32_t id = self->arr_region_units[unit_index];
+        const turn_action_t *action = &self->arr_actions[id];
+        if (action->type != TURN_ACTION_MOVE)
+            continue;
+
+        const turn_unit_t *unit = &self->arr_units[id];
+        int32_t x = unit->x + action->dx, y = unit->y + action->dy;
+
+        // Standing still, it's not going anywhere.
+        uint32_t occupant = turn_unit_at(self, x, y);
+        if (occupant != TURN_NO_UNIT && self->arr_actions[occupant].type != TURN_ACTION_MOVE)
+        {
+            self->arr_move_states[id] = TURN_MOVE_FAILED;
+            continue;
+        }
+
+        // Anyone else after the same tile is next to it and stepping the opposite way to get there. Most movers have
+        // nobody to beat, their priority isn't worked out unless they do.
+        uint32_t neighbours[8];
+        turn_neighbours(self, x, y, neighbours);
+        uint8_t is_winner = 1;
+        for (uint32_t i = 0; i < 8 && is_winner; i++)
+        {
+            uint32_t other = neighbours[i];
+            if (other == TURN_NO_UNIT || other == id)
+                continue;
+
+            const turn_action_t *other_action = &self->arr_actions[other];
+            if (other_action->type != TURN_ACTION_MOVE || other_action->dx != -turn_directions[i][0] || other_action->dy != -turn_directions[i][1])
+                continue;
+
+            uint64_t priority = turn_priority(job, id), other_priority = turn_priority(job, other);
+            is_winner = priority < other_priority || (priority == other_priority && id < other);
+        }
+
+        // Onto an empty tile it's done already, the chains only need following behind another mover.
+        if (!is_winner)
+            self->arr_move_states[id] = TURN_MOVE_FAILED;
+        else
+            self->arr_move_states[id] = occupant == TURN_NO_UNIT ? TURN_MOVE_DONE : TURN_MOVE_PENDING;
+    }
+}
+
+// Winners still need whoever is on their tile to get out of the way. Follows each chain of movers to its end, an empty
+// tile, a unit that isn't moving, two swapping places or a ring of them all moving round at once.
+// Chains cross regions and settle every unit on them, so it's the one phase left on the caller.
+static void turn_resolve_chains(turn_state_t *self)
+{
+    MEMORY_SCOPE(MEMORY_TAG_TURNS);
+    uint8_t *states = self->arr_move_states;
+    for (size_t unit_index = 0; unit_index < arrlenu(self->arr_region_units); unit_index++)
+    {
+        uint32_t id = self->arr_region_units[unit_index];
+        if (states[id] != TURN_MOVE_PENDING)
+            continue;
+
+        arrsetlen(self->arr_chain, 0);
+        uint8_t is_free = 0;
+        for (;;)
+        {
+            states[id] = TURN_MOVE_VISITING;
+            arrput(self->arr_chain, id);
+
+            const turn_unit_t *unit = &self->arr_units[id];
+            const turn_action_t *action = &self->arr_actions[id];
+            uint32_t occupant = turn_unit_at(self, unit->x + action->dx, unit->y + action->dy);
+            if (occupant == TURN_NO_UNIT)
+            {
+                is_free = 1;
+                break;
+            }
+
+            const turn_unit_t *other = &self->arr_units[occupant];
+            const turn_action_t *other_action = &self->arr_actions[occupant];
+            if (other_action->type != TURN_ACTION_MOVE || (other->x + other_action->dx == unit->x && other->y + other_action->dy == unit->y))
+                break;
+
+            if (states[occupant] == TURN_MOVE_PENDING)
+            {
+                id = occupant;
+                continue;
+            }
+
+            // Back round to the start of a ring, or onto a chain already decided.
+            is_free = states[occupant] == TURN_MOVE_VISITING || states[occupant] == TURN_MOVE_DONE;
+            break;
+        }
+
+        for (size_t i = 0; i < arrlenu(self->arr_chain); i++)
+            states[self->arr_chain[i]] = is_free ? TURN_MOVE_DONE : TURN_MOVE_FAILED;
+    }
+}
+
+// Items, and anything a unit can't do becomes nothing so the later phases can take every action at its word. Only
+// writes the unit's own state, and the region's attackers.
+static void turn_validate_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    turn_stats_t *stats = &self->arr_worker_stats[worker_index];
+    size_t num_units = arrlenu(self->arr_units);
+
+    for (uint32_t region = begin; region < end; region++)
+    {
+        uint32_t *attackers = &self->arr_region_attackers[self->region_starts[region]];
+        uint32_t num_attackers = 0;
+        for (uint32_t unit_index = self->region_starts[region]; unit_index < self->region_starts[region + 1]; unit_index++)
+        {
+            uint32_t id = self->arr_region_units[unit_index];
+            turn_unit_t *unit = &self->arr_units[id];
+            turn_action_t *action = &self->arr_actions[id];
+            self->arr_move_states[id] = TURN_MOVE_NONE;
+
+            uint8_t is_valid = 0;
+            switch (action->type)
+            {
+            case TURN_ACTION_MOVE:
+            {
+                is_valid = action->dx >= -1 && action->dx <= 1 && action->dy >= -1 && action->dy <= 1 && (action->dx || action->dy);
+                is_valid = is_valid && turn_is_open(self, unit->x + action->dx, unit->y + action->dy);
+                stats->num_blocked += !is_valid;
+                break;
+            }
+            case TURN_ACTION_ATTACK:
+            {
+                if (action->target < num_units && action->target != id)
+                {
+                    // Alive if it's still on its tile. Its hp could be healing on another thread, and healing
+                    // never brings anyone back anyway.
+                    const turn_unit_t *target = &self->arr_units[action->target];
+                    int32_t dx = target->x - unit->x, dy = target->y - unit->y;
+                    is_valid = dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && turn_unit_at(self, target->x, target->y) == action->target;
+                }
+                if (is_valid)
+                    attackers[num_attackers++] = id;
+                break;
+            }
+            case TURN_ACTION_USE_ITEM:
+            {
+                is_valid = unit->num_items > 0;
+                if (is_valid)
+                {
+                    unit->hp = unit->hp + TURN_ITEM_HEAL > TURN_UNIT_HP ? TURN_UNIT_HP : unit->hp + TURN_ITEM_HEAL;
+                    unit->num_items--;
+                    stats->num_items_used++;
+                }
+                break;
+            }
+            default:
+                break;
+            }
+
+            if (!is_valid)
+                *action = (turn_action_t){0};
+        }
+        self->region_num_attackers[region] = num_attackers;
+        stats->num_attacks += num_attackers;
+    }
+}
+
+// Attacks all land at once, a unit killed this turn still hits back. Every attacker is next to its target, so the
+// hits on a region's units all come from attackers in it or the regions around it. Only writes units in the region,
+// then the dead among them leave the map and their tiles are free to move onto this turn.
+static void turn_attack_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    turn_stats_t *stats = &self->arr_worker_stats[worker_index];
+
+    for (uint32_t region = begin; region < end; region++)
+    {
+        int32_t region_x = (int32_t)(region % self->regions_x), region_y = (int32_t)(region / self->regions_x);
+        for (int32_t pass = 0; pass < 2; pass++)
+        {
+            for (int32_t y = region_y - 1; y <= region_y + 1; y++)
+            {
+                for (int32_t x = region_x - 1; x <= region_x + 1; x++)
+                {
+                    if (x < 0 || y < 0 || (uint32_t)x >= self->regions_x || (uint32_t)y >= self->regions_y)
+                        continue;
+
+                    uint32_t other_region = (uint32_t)y * self->regions_x + (uint32_t)x;
+                    const uint32_t *attackers = &self->arr_region_attackers[self->region_starts[other_region]];
+                    for (uint32_t i = 0; i < self->region_num_attackers[other_region]; i++)
+                    {
+                        uint32_t id = self->arr_actions[attackers[i]].target;
+                        turn_unit_t *target = &self->arr_units[id];
+                        if (target->x / TURN_REGION_SIZE != region_x || target->y / TURN_REGION_SIZE != region_y)
+                            continue;
+
+                        // Every hit first, then the dead once each however many hit them.
+                        uint32_t *tile = &self->occupancy[(size_t)target->y * self->width + target->x];
+                        if (pass == 0)
+                        {
+                            target->hp -= TURN_ATTACK_DAMAGE;
+                        }
+                        else if (target->hp <= 0 && *tile == id)
+                        {
+                            *tile = TURN_NO_UNIT;
+                            // Its own attack has already landed, it can't move any more.
+                            if (self->arr_actions[id].type == TURN_ACTION_MOVE)
+                                self->arr_actions[id] = (turn_action_t){0};
+                            stats->num_deaths++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Everyone leaves before anyone arrives, a unit can move onto a tile another just left.
+static void turn_leave_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    (void)worker_index;
+
+    for (uint32_t unit_index = self->region_starts[begin]; unit_index < self->region_starts[end]; unit_index++)
+    {
+        uint32_t id = self->arr_region_units[unit_index];
+        const turn_unit_t *unit = &self->arr_units[id];
+        if (self->arr_move_states[id] == TURN_MOVE_DONE)
+            self->occupancy[(size_t)unit->y * self->width + unit->x] = TURN_NO_UNIT;
+    }
+}
+
+// Each tile has one winner at most, so arrivals never write the same tile even across regions.
+static void turn_arrive_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    turn_job_t *job = user_data;
+    turn_state_t *self = job->self;
+    turn_stats_t *stats = &self->arr_worker_stats[worker_index];
+
+    for (uint32_t unit_index = self->region_starts[begin]; unit_index < self->region_starts[end]; unit_index++)
+    {
+        uint32_t id = self->arr_region_units[unit_index];
+        if (self->arr_move_states[id] == TURN_MOVE_DONE)
+        {
+            turn_unit_t *unit = &self->arr_units[id];
+            unit->x += self->arr_actions[id].dx;
+            unit->y += self->arr_actions[id].dy;
+            self->occupancy[(size_t)unit->y * self->width + unit->x] = id;
+            stats->num_moves++;
+        }
+        else if (self->arr_move_states[id] == TURN_MOVE_FAILED)
+        {
+            stats->num_blocked++;
+        }
+    }
+}
+
+void turn_resolve(turn_state_t *self, job_system_t *jobs)
+{
+    PROFILE_FUNCTION();
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    turn_job_t job = {self, rng_hash_combine(rng_hash(self->seed), self->turn_number)};
+    uint32_t num_threads = jobs ? job_system_num_threads(jobs) : 1;
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TURNS);
+        arrsetlen(self->arr_worker_stats, num_threads);
+    }
+    memset(self->arr_worker_stats, 0, num_threads * sizeof(turn_stats_t));
+
+    // Every phase goes by the units alive at the start of the turn. The dead are off the map and whatever was queued
+    // for them is never looked at.
+    turn_bucket_units(self);
+    {
+        MEMORY_SCOPE(MEMORY_TAG_TURNS);
+        arrsetlen(self->arr_region_attackers, arrlenu(self->arr_region_units));
+    }
+    turn_run_phase(&job, jobs, turn_validate_range);
+    turn_run_phase(&job, jobs, turn_attack_range);
+    turn_run_phase(&job, jobs, turn_claim_range);
+    turn_resolve_chains(self);
+    turn_run_phase(&job, jobs, turn_leave_range);
+    turn_run_phase(&job, jobs, turn_arrive_range);
+
+    turn_stats_t stats = {0};
+    for (uint32_t i = 0; i < num_threads; i++)
+    {
+        const turn_stats_t *worker_stats = &self->arr_worker_stats[i];
+        stats.num_moves += worker_stats->num_moves;
+        stats.num_blocked += worker_stats->num_blocked;
+        stats.num_attacks += worker_stats->num_attacks;
+        stats.num_deaths += worker_stats->num_deaths;
+        stats.num_items_used += worker_stats->num_items_used;
+    }
+
+    memset(self->arr_actions, 0, arrlenu(self->arr_units) * sizeof(turn_action_t));
+    self->turn_number++;
+
+    stats.resolve_ms = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    self->stats = stats;
+}
+
+uint64_t turn_state_hash(const turn_state_t *self)
+{
+    PROFILE_FUNCTION();
+
+    uint64_t hash = rng_hash_combine(rng_hash_combine(self->seed, self->turn_number), self->walls_hash);
+    for (size_t i = 0; i < arrlenu(self->arr_units); i++)
+    {
+        const turn_unit_t *unit = &self->arr_units[i];
+        // Field by field, padding never goes in.
+        hash = rng_hash_fold(hash, (uint64_t)(uint32_t)unit->x | (uint64_t)(uint32_t)unit->y << 32);
+        hash = rng_hash_fold(hash, (uint64_t)(uint32_t)unit->hp | (uint64_t)unit->team << 32 | (uint64_t)unit->is_ai << 48 | (uint64_t)unit->num_items << 56);
+    }
+
+    return rng_hash(hash);
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "tilemap.h"
+#include "engine/job_system.h"
+
+#define TURN_NO_UNIT UINT32_MAX
+
+// Tiles a side of the squares the map is cut into for resolving a turn, each one a job.
+#define TURN_REGION_SIZE 64
+
+#define TURN_UNIT_HP 10
+#define TURN_ATTACK_DAMAGE 3
+#define TURN_ITEM_HEAL 4
+#define TURN_UNIT_ITEMS 2
+
+typedef enum turn_action_type_e
+{
+    TURN_ACTION_NONE = 0,
+    // One step to any of the 8 neighbours.
+    TURN_ACTION_MOVE,
+    // A unit on one of the 8 neighbours, whatever team it's on.
+    TURN_ACTION_ATTACK,
+    // Heal, if there are any items left.
+    TURN_ACTION_USE_ITEM,
+} turn_action_type_e;
+
+typedef struct turn_action_t
+{
+    // turn_action_type_e, a byte keeps the action to 8.
+    uint8_t type;
+    int8_t dx, dy;
+    uint32_t target;
+} turn_action_t;
+
+typedef struct turn_unit_t
+{
+    int32_t x, y;
+    // Dead at 0 or less, it stays in the array so unit IDs never move but it's off the map.
+    int32_t hp;
+    uint16_t team;
+    // Given an action by turn_queue_ai_actions, the rest are left to whoever controls them.
+    uint8_t is_ai;
+    uint8_t num_items;
+} turn_unit_t;
+
+typedef struct turn_stats_t
+{
+    uint32_t num_moves;
+    // Moves that lost to another unit wanting the same tile, or were stuck behind one that didn't move.
+    uint32_t num_blocked;
+    uint32_t num_attacks;
+    uint32_t num_deaths;
+    uint32_t num_items_used;
+    float resolve_ms;
+} turn_stats_t;
+
+/// @brief Simultaneous turns. Every unit's action is queued then all of them are resolved at once in phases, items,
+/// then attacks, then moves, each phase only seeing the state from before it. Two units wanting the same tile are
+/// decided by a priority hashed from the seed, the turn and the unit, so the outcome never depends on the order things
+/// were queued in or on how the job system split up the work.
+typedef struct turn_state_t
+{
+    uint32_t width, height;
+    uint64_t seed;
+    uint32_t turn_number;
+
+    // A byte per tile, walls. Only changed through turn_set_wall, which keeps walls_hash up to date.
+    uint8_t *blocked;
+    // Every wall's tile index hashed and XORed together, so turn_state_hash covers the walls without reading the map.
+    uint64_t walls_hash;
+    // The unit on each tile, TURN_NO_UNIT for none. Only one unit to a tile.
+    uint32_t *occupancy;
+
+    turn_unit_t *arr_units;
+    // Parallel to arr_units, what each will do next turn. Cleared by turn_resolve.
+    turn_action_t *arr_actions;
+
+    uint32_t regions_x, regions_y;
+    // Living units bucketed by region, the ones in region i are arr_region_units[region_starts[i] .. region_starts[i + 1]).
+    // Rebuilt by turn_queue_ai_actions and at the start of turn_resolve, in unit order within each region.
+    uint32_t *region_starts;
+    uint32_t *arr_region_units;
+    // Parallel to arr_region_units, the units in each region attacking this turn, region_num_attackers[i] of them from
+    // region i's start.
+    uint32_t *arr_region_attackers;
+    uint32_t *region_num_attackers;
+
+    // Scratch for turn_resolve, parallel to arr_units, and the chain of movers being followed.
+    uint8_t *arr_move_states;
+    uint32_t *arr_chain;
+    // One for each thread of the job system, added up into stats at the end of the turn.
+    turn_stats_t *arr_worker_stats;
+
+    turn_stats_t stats;
+} turn_state_t;
+
+turn_state_t turn_state_new(uint32_t width, uint32_t height, uint64_t seed);
+/// @brief Walls looked up by tile ID, TILE_EMPTY and IDs past the end of blocked_tiles are open.
+turn_state_t turn_state_from_tilemap(const tilemap_t *tilemap, const uint8_t *blocked_tiles, uint32_t num_blocked_tiles, uint64_t seed);
+void turn_state_free(turn_state_t *self);
+/// @brief Tilemap edits into the walls, tile IDs looked up the same way as turn_state_from_tilemap. A unit already on a
+/// tile that becomes a wall can still step off it.
+void turn_apply_edits(turn_state_t *self, const tilemap_edit_t *edits, size_t num_edits, const uint8_t *blocked_tiles, uint32_t num_blocked_tiles);
+
+/// @brief Walls any other way than through the tilemap. A unit already on the tile can still step off it.
+void turn_set_wall(turn_state_t *self, int32_t x, int32_t y, uint8_t is_wall);
+
+/// @param x, y Must be open and free.
+/// @return The unit's ID, stable for as long as the state lives.
+uint32_t turn_add_unit(turn_state_t *self, int32_t x, int32_t y, uint16_t team, uint8_t is_ai);
+
+/// @brief Replace every unit and the turn number, eg. from a saved keyframe. Walls stay as they are and nothing is
+/// left queued.
+void turn_restore(turn_state_t *self, uint32_t turn_number, const turn_unit_t *units, size_t num_units);
+
+static inline uint8_t turn_is_open(const turn_state_t *self, int32_t x, int32_t y)
+{
+    return x >= 0 && y >= 0 && (uint32_t)x < self->width && (uint32_t)y < self->height && !self->blocked[(size_t)y * self->width + x];
+}
+
+/// @brief Replaces anything already queued for the unit this turn.
+void turn_queue_action(turn_state_t *self, uint32_t unit, turn_action_t action);
+
+/// @brief Queue an action for every living AI unit. Attacks a neighbouring enemy if there is one, heals when hurt,
+/// otherwise wanders. Only reads the state, spread over the job system by region.
+void turn_queue_ai_actions(turn_state_t *self, job_system_t *jobs);
+
+/// @brief Resolve every queued action and move on to the next turn. jobs can be null to do it all on the caller.
+void turn_resolve(turn_state_t *self, job_system_t *jobs);
+
+/// @brief Everything that affects what happens next, walls included, the same for the same state on any machine. Two
+/// runs that diverge have different hashes from the turn they diverge on.
+uint64_t turn_state_hash(const turn_state_t *self);
+
+#if UNIT_TEST
+#include <assert.h>
+#include "engine/memory.h"
+#include "util/rng.h"
+
+static void turn_unit_tests_conflicts()
+{
+    turn_state_t state = turn_state_new(16, 16, 7);
+
+    // Two units after the same tile, exactly one gets it.
+    uint32_t a = turn_add_unit(&state, 2, 5, 0, 0);
+    uint32_t b = turn_add_unit(&state, 4, 5, 1, 0);
+    turn_queue_action(&state, a, (turn_action_t){TURN_ACTION_MOVE, 1, 0});
+    turn_queue_action(&state, b, (turn_action_t){TURN_ACTION_MOVE, -1, 0});
+    turn_resolve(&state, 0);
+    assert((state.arr_units[a].x == 3) != (state.arr_units[b].x == 3));
+    assert(state.stats.num_moves == 1 && state.stats.num_blocked == 1);
+
+    // Swapping places is blocked both ways, following one another in a line isn't.
+    uint32_t c = turn_add_unit(&state, 10, 10, 0, 0);
+    uint32_t d = turn_add_unit(&state, 11, 10, 0, 0);
+    uint32_t e = turn_add_unit(&state, 12, 10, 0, 0);
+    turn_queue_action(&state, c, (turn_action_t){TURN_ACTION_MOVE, 1, 0});
+    turn_queue_action(&state, d, (turn_action_t){TURN_ACTION_MOVE, 1, 0});
+    turn_queue_action(&state, e, (turn_action_t){TURN_ACTION_MOVE, 1, 0});
+    turn_resolve(&state, 0);
+    assert(state.arr_units[c].x == 11 && state.arr_units[d].x == 12 && state.arr_units[e].x == 13);
+
+    turn_queue_action(&state, c, (turn_action_t){TURN_ACTION_MOVE, 1, 0});
+    turn_queue_action(&state, d, (turn_action_t){TURN_ACTION_MOVE, -1, 0});
+    turn_resolve(&state, 0);
+    assert(state.arr_units[c].x == 11 && state.arr_units[d].x == 12);
+
+    // Attacks land at the same time, a unit killed this turn still hits back.
+    state.arr_units[c].hp = TURN_ATTACK_DAMAGE;
+    turn_queue_action(&state, c, (turn_action_t){TURN_ACTION_ATTACK, .target = d});
+    turn_queue_action(&state, d, (turn_action_t){TURN_ACTION_ATTACK, .target = c});
+    turn_resolve(&state, 0);
+    assert(state.arr_units[c].hp <= 0 && state.arr_units[d].hp == TURN_UNIT_HP - TURN_ATTACK_DAMAGE);
+    assert(state.occupancy[10 * 16 + 11] == TURN_NO_UNIT);
+
+    // Walls are part of the hash, and taking one away again hashes the same as before.
+    uint64_t hash = turn_state_hash(&state);
+    turn_set_wall(&state, 0, 15, 1);
+    assert(turn_state_hash(&state) != hash);
+    turn_set_wall(&state, 0, 15, 0);
+    assert(turn_state_hash(&state) == hash);
+
+    turn_state_free(&state);
+}
+
+static uint64_t turn_unit_tests_run(uint64_t seed, job_system_t *jobs, uint64_t *hashes, uint32_t num_turns)
+{
+    turn_state_t state = turn_state_new(300, 200, seed);
+    uint64_t rng = 5;
+    for (uint32_t y = 0; y < state.height; y++)
+    {
+        for (uint32_t x = 0; x < state.width; x++)
+        {
+            turn_set_wall(&state, (int32_t)x, (int32_t)y, rng_next(&rng) % 100 < 10);
+        }
+    }
+
+    // Crowded, so plenty of fights and tiles fought over.
+    for (uint32_t i = 0; i < 3000; i++)
+    {
+        uint64_t r = rng_next(&rng);
+        int32_t x = (int32_t)(r % state.width), y = (int32_t)((r >> 32) % state.height);
+        if (turn_is_open(&state, x, y) && state.occupancy[y * state.width + x] == TURN_NO_UNIT)
+            turn_add_unit(&state, x, y, (uint16_t)(i % 7), 1);
+    }
+
+    for (uint32_t turn = 0; turn < num_turns; turn++)
+    {
+        turn_queue_ai_actions(&state, jobs);
+        turn_resolve(&state, jobs);
+        hashes[turn] = turn_state_hash(&state);
+    }
+
+    uint64_t num_deaths = 0;
+    for (size_t i = 0; i < arrlenu(state.arr_units); i++)
+        num_deaths += state.arr_units[i].hp <= 0;
+
+    turn_state_free(&state);
+
+    return num_deaths;
+}
+
+static void turn_unit_tests_determinism()
+{
+    // The same inputs come out the same every time, however many threads, and a different seed doesn't.
+    enum
+    {
+        num_turns = 30
+    };
+    uint64_t serial[num_turns], parallel[num_turns], reseeded[num_turns];
+
+    job_system_t *jobs = job_system_new(3);
+    uint64_t num_deaths = turn_unit_tests_run(1, 0, serial, num_turns);
+    assert(num_deaths > 0);
+    assert(turn_unit_tests_run(1, jobs, parallel, num_turns) == num_deaths);
+    turn_unit_tests_run(2, jobs, reseeded, num_turns);
+    job_system_free(jobs);
+
+    for (uint32_t i = 0; i < num_turns; i++)
+        assert(serial[i] == parallel[i]);
+    assert(serial[num_turns - 1] != reseeded[num_turns - 1]);
+}
+
+static int turn_unit_tests(void)
+{
+    turn_unit_tests_conflicts();
+    turn_unit_tests_determinism();
+
+    return 1;
+}
+#endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "../engine/memory.h"
 
 char *readFileToString(const char *path)
 {
@@ -14,7 +15,8 @@ char *readFileToString(const char *path)
     int64_t numBytes = ftell(file);
     fseek(file, 0, SEEK_SET);
 
-    char *text = calloc(numBytes, sizeof(char));
+    // One more for the terminator, calloc leaves it zeroed.
+    char *text = mem_calloc(MEMORY_TAG_GENERAL, numBytes + 1, sizeof(char));
 
     fread(text, sizeof(char), numBytes, file);
 
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+/// @brief splitmix64, the same sequence for a seed on every platform and thread, unlike rand().
+static inline uint64_t rng_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/// @brief splitmix64's finaliser, for a random looking value from a key without any state to share.
+static inline uint64_t rng_hash(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/// @brief Fold value into a running hash, order matters.
+static inline uint64_t rng_hash_combine(uint64_t hash, uint64_t value)
+{
+    return rng_hash(hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2)));
+}
+
+/// @brief Much cheaper than rng_hash_combine for hashing a lot of values, finish with rng_hash so every bit of the
+/// result depends on every one of them.
+static inline uint64_t rng_hash_fold(uint64_t hash, uint64_t value)
+{
+    return (((hash << 23) | (hash >> 41)) ^ value) * 0x9E3779B97F4A7C15ull;
+}
+
+/// @brief Uniform in [0, 1), the top 24 bits of the next value so every one is exactly representable.
+static inline float rng_float(uint64_t *state)
+{
+    return (float)(rng_next(state) >> 40) / (float)(1 << 24);
+}
\ No newline at end of file
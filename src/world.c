@@ -0,0 +1,174 @@
+#include "world.h"
+#include <assert.h>
+#include "entities.h"
+#include "journal.h"
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+// Same as the pathfinding benchmarks, the last tile type is walls.
+static const uint8_t opaque_tiles[] = {0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+world_t *world_new(asset_cache_t *asset_cache, job_system_t *jobs, size_t arena_size, uint64_t seed)
+{
+    world_t *world = mem_calloc(MEMORY_TAG_ENTITIES, 1, sizeof(world_t));
+    world->asset_cache = asset_cache;
+    world->jobs = jobs;
+    world->sim_arena = frame_arena_new(arena_size, MEMORY_TAG_ARENAS);
+    world->turn_steps = PLAYER_TURN_STEPS;
+    world->rng = seed;
+    world->seed = seed;
+    world->root = entity_new(world);
+
+    return world;
+}
+
+void world_free(world_t *world)
+{
+    if (world->tilemap)
+    {
+        tilemap_free(world->tilemap);
+        mem_free(world->tilemap);
+    }
+
+    if (world->fov)
+    {
+        fov_free(world->fov);
+        mem_free(world->fov);
+        turn_state_free(world->turns);
+        mem_free(world->turns);
+    }
+
+    // Everything goes, no need for entity_free to unlink and search for each one.
+    for (size_t i = 0; i < arrlenu(world->entities); i++)
+        mem_free(world->entities[i]);
+
+    arrfree(world->entities);
+    arrfree(world->entities_back);
+    arrfree(world->arr_parent_indices);
+    arrfree(world->arr_subtree_sizes);
+    shfree(world->sh_interned_text);
+
+    frame_arena_free(&world->sim_arena);
+    mem_free(world);
+}
+
+void world_spawn_tilemap(world_t *world, uint32_t size)
+{
+    const float tile_size = 32;
+
+    world->tilemap = mem_alloc(MEMORY_TAG_TILEMAP, sizeof(tilemap_t));
+    *world->tilemap = tilemap_new(size, size, tile_size);
+    world->tilemap->origin[0] = -(float)world->tilemap->width * tile_size / 2;
+    world->tilemap->origin[1] = -(float)world->tilemap->height * tile_size / 2;
+    tilemap_generate(world->tilemap, rng_next(&world->rng), WORLD_NUM_TILE_TYPES);
+    // Generating doesn't go in the log, a renderer starts from a copy of the finished map.
+    world->tilemap->records_edits = 1;
+}
+
+void world_spawn_players(world_t *world, uint32_t num_players)
+{
+    const uint32_t view_radius = 24;
+    const uint32_t ai_units_per_player = 8;
+    tilemap_t *tilemap = world->tilemap;
+    assert(tilemap);
+
+    world->fov = mem_alloc(MEMORY_TAG_FOV, sizeof(fov_t));
+    *world->fov = fov_from_tilemap(tilemap, opaque_tiles, sizeof(opaque_tiles));
+    world->turns = mem_alloc(MEMORY_TAG_TURNS, sizeof(turn_state_t));
+    *world->turns = turn_state_from_tilemap(tilemap, opaque_tiles, sizeof(opaque_tiles), rng_next(&world->rng));
+
+    // Players first so unit i is player i.
+    uint32_t spread = tilemap->width / 4 + 1;
+    for (uint32_t i = 0; i < num_players * (1 + ai_units_per_player); i++)
+    {
+        int32_t x, y;
+        do
+        {
+            x = (int32_t)(tilemap->width / 2 - spread / 2 + rng_next(&world->rng) % spread);
+            y = (int32_t)(tilemap->height / 2 - spread / 2 + rng_next(&world->rng) % spread);
+        } while (!turn_is_open(world->turns, x, y) || world->turns->occupancy[(size_t)y * world->turns->width + x] != TURN_NO_UNIT);
+
+        turn_add_unit(world->turns, x, y, (uint16_t)(i % num_players), i >= num_players);
+        if (i < num_players)
+            fov_add_viewer(world->fov, x, y, view_radius);
+    }
+    fov_update(world->fov, world->jobs);
+}
+
+void world_queue_player_actions(world_t *world)
+{
+    assert(world->fov && world->turns);
+
+    for (uint32_t i = 0; i < arrlenu(world->fov->arr_viewers); i++)
+    {
+        uint64_t r = rng_next(&world->rng);
+        turn_queue_action(world->turns, i, (turn_action_t){TURN_ACTION_MOVE, (int8_t)(r % 3) - 1, (int8_t)(r / 3 % 3) - 1});
+    }
+}
+
+void world_resolve_turn(world_t *world)
+{
+    PROFILE_FUNCTION();
+
+    fov_t *fov = world->fov;
+    turn_state_t *turns = world->turns;
+    assert(fov && turns);
+
+    // The AI's actions follow from the state, only the players' are needed to play the turn again.
+    if (world->journal)
+        journal_record_turn(world->journal, world);
+
+    turn_queue_ai_actions(turns, world->jobs);
+    turn_resolve(turns, world->jobs);
+
+    for (uint32_t i = 0; i < arrlenu(fov->arr_viewers); i++)
+    {
+        const turn_unit_t *player = &turns->arr_units[i];
+        const fov_viewer_t *viewer = &fov->arr_viewers[i];
+        if (player->x != viewer->x || player->y != viewer->y)
+            fov_move_viewer(fov, i, player->x, player->y);
+    }
+
+    fov_update(fov, world->jobs);
+
+    if (world->journal)
+        journal_record_result(world->journal, world);
+}
+
+void world_turn_system(world_t *world)
+{
+    fov_t *fov = world->fov;
+    if (!fov)
+        return;
+
+    PROFILE_FUNCTION();
+
+    // Walls can change any step, whoever can see them has to find out on their next turn.
+    tilemap_t *tilemap = world->tilemap;
+    fov_apply_edits(fov, tilemap->arr_edits, arrlenu(tilemap->arr_edits), opaque_tiles, sizeof(opaque_tiles));
+    turn_apply_edits(world->turns, tilemap->arr_edits, arrlenu(tilemap->arr_edits), opaque_tiles, sizeof(opaque_tiles));
+
+    if (world->steps_until_turn)
+    {
+        world->steps_until_turn--;
+        return;
+    }
+    world->steps_until_turn = world->turn_steps - 1;
+
+    world_queue_player_actions(world);
+    world_resolve_turn(world);
+}
+
+void world_step(world_t *world)
+{
+    PROFILE_FUNCTION();
+
+    // Systems' scratch from the step before stays readable through this one.
+    frame_arena_begin(&world->sim_arena);
+
+    world_turn_system(world);
+
+    update_local_system(world);
+    update_global_system(world);
+}
\ No newline at end of file
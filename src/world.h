@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "text_intern.h"
+#include "tilemap.h"
+#include "fov.h"
+#include "turn.h"
+#include "engine/arena.h"
+#include "engine/job_system.h"
+
+typedef struct entity_t entity_t;
+typedef struct journal_t journal_t;
+typedef struct asset_cache_t asset_cache_t;
+
+// Tile types a generated map draws with, walls come after them.
+#define WORLD_NUM_TILE_TYPES 8
+
+/// @brief One match, everything the simulation owns and nothing about how it's shown. Runs without a window or GL, a
+/// dedicated server keeps many of them, see ./server.
+typedef struct world_t
+{
+    entity_t *root;
+    // Depth first pre-order as of the last update_global_system, new entities go on the end until then.
+    entity_t **entities;
+    // Parallel to entities, only valid until the hierarchy next changes. Root's parent is HIERARCHY_NO_PARENT and a
+    // subtree is the contiguous range [index, index + size).
+    uint32_t *arr_parent_indices;
+    uint32_t *arr_subtree_sizes;
+    // Last step's order, swapped with entities each time the hierarchy is flattened so neither is reallocated.
+    entity_t **entities_back;
+    // What entities draw, by key. Not owned, shared by every world, and on a server only the keys mean anything.
+    asset_cache_t *asset_cache;
+    // Text for entities that nothing else owns, eg. loaded from a world snapshot. Null until the first string goes in.
+    text_intern_entry_t *sh_interned_text;
+
+    // All null without a map. Viewer i is player i, and so is unit i in turns.
+    tilemap_t *tilemap;
+    fov_t *fov;
+    turn_state_t *turns;
+    // Simulation steps from one turn to the next, and until the next one is resolved.
+    uint32_t turn_steps;
+    uint32_t steps_until_turn;
+    // Everything random a world does draws from here, see util/rng.h. Worlds never share one, so the same seed plays
+    // out the same whichever thread steps it and whatever else runs alongside.
+    uint64_t rng;
+    // What rng started as, the same seed and the same spawns make the same match.
+    uint64_t seed;
+    // Not owned, every turn's player actions go in it when set. Null for none.
+    journal_t *journal;
+
+    // Reset at the top of every simulation step, last step's allocations last one more before they're reused.
+    frame_arena_t sim_arena;
+    // Not owned, every world in a process shares one.
+    job_system_t *jobs;
+} world_t;
+
+/// @brief Just a root, turns every PLAYER_TURN_STEPS.
+/// @param arena_size Starting size of each half of the step arena, it grows to fit. Small for a server's matches.
+world_t *world_new(asset_cache_t *asset_cache, job_system_t *jobs, size_t arena_size, uint64_t seed);
+void world_free(world_t *world);
+
+/// @brief A generated map centred on the origin, under everything else.
+void world_spawn_tilemap(world_t *world, uint32_t size);
+
+/// @brief Players scattered near the middle of the map, each with their own field of view and a few AI units on their
+/// side. Needs the map first.
+void world_spawn_players(world_t *world, uint32_t num_players);
+
+/// @brief Each player steps to a random neighbour from rng, in place of input. Needs players.
+void world_queue_player_actions(world_t *world);
+
+/// @brief Players do whatever they have queued, nothing if they haven't, and the AI does its own thing. Then whoever
+/// moved has their view recomputed. The players' actions go in the journal first if there is one. Needs players.
+void world_resolve_turn(world_t *world);
+
+/// @brief Every turn_steps the players queue their actions and a turn is resolved, and every step whoever can see a
+/// changed wall finds out on their next turn. Nothing without players.
+void world_turn_system(world_t *world);
+
+/// @brief One fixed simulation step of everything a world owns, turns then the transform hierarchy.
+void world_step(world_t *world);
\ No newline at end of file
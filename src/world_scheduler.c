@@ -0,0 +1,125 @@
+#include "world_scheduler.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "engine/memory.h"
+#include "engine/profiler.h"
+
+world_scheduler_t world_scheduler_new(job_system_t *pool)
+{
+    assert(pool);
+    return (world_scheduler_t){.pool = pool};
+}
+
+void world_scheduler_free(world_scheduler_t *self)
+{
+    arrfree(self->arr_worlds);
+    arrfree(self->arr_due);
+    *self = (world_scheduler_t){0};
+}
+
+uint32_t world_scheduler_add(world_scheduler_t *self, world_t *world, uint64_t first_turn, uint64_t turn_period, float budget_ms)
+{
+    assert(world->jobs != self->pool && turn_period > 0);
+
+    MEMORY_SCOPE(MEMORY_TAG_GENERAL);
+    arrput(self->arr_worlds, ((scheduled_world_t){.world = world, .next_turn = first_turn, .turn_period = turn_period, .budget_ms = budget_ms}));
+    return (uint32_t)arrlenu(self->arr_worlds) - 1;
+}
+
+void world_scheduler_remove(world_scheduler_t *self, uint32_t index)
+{
+    assert(index < arrlenu(self->arr_worlds));
+    arrdelswap(self->arr_worlds, index);
+}
+
+static int world_scheduler_compare_due(const void *a, const void *b)
+{
+    const world_scheduler_due_t *x = a, *y = b;
+    if (x->is_in_debt != y->is_in_debt)
+        return x->is_in_debt - y->is_in_debt;
+    if (x->next_turn != y->next_turn)
+        return x->next_turn < y->next_turn ? -1 : 1;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+typedef struct world_scheduler_round_t
+{
+    world_scheduler_t *scheduler;
+    uint64_t start;
+    double ms_per_counter;
+} world_scheduler_round_t;
+
+static void world_scheduler_turn_range(void *user_data, uint32_t begin, uint32_t end, uint32_t worker_index)
+{
+    world_scheduler_round_t *round = user_data;
+    world_scheduler_t *self = round->scheduler;
+    (void)worker_index;
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        scheduled_world_t *scheduled = &self->arr_worlds[self->arr_due[i].index];
+        world_t *world = scheduled->world;
+        uint64_t start = SDL_GetPerformanceCounter();
+
+        world_step(world);
+        // Nothing hosted is drawn, so nothing else takes the map's edits once the simulation has seen them.
+        if (world->tilemap)
+            arrsetlen(world->tilemap->arr_edits, 0);
+
+        uint64_t finish = SDL_GetPerformanceCounter();
+        uint64_t due = scheduled->next_turn < round->start ? scheduled->next_turn : round->start;
+        float turn_ms = (float)((finish - start) * round->ms_per_counter);
+
+        scheduled->last_turn_ms = turn_ms;
+        scheduled->last_latency_ms = finish > due ? (float)((finish - due) * round->ms_per_counter) : 0;
+        scheduled->total_turn_ms += turn_ms;
+        scheduled->total_latency_ms += scheduled->last_latency_ms;
+        scheduled->num_turns++;
+        scheduled->num_over_budget += turn_ms > scheduled->budget_ms;
+        scheduled->debt_ms += turn_ms - scheduled->budget_ms;
+        if (scheduled->debt_ms < 0)
+            scheduled->debt_ms = 0;
+
+        // From when it was due rather than now, so a late turn doesn't push back every one after it.
+        scheduled->next_turn += scheduled->turn_period;
+    }
+}
+
+uint32_t world_scheduler_run_due(world_scheduler_t *self, uint64_t now)
+{
+    PROFILE_FUNCTION();
+
+    {
+        MEMORY_SCOPE(MEMORY_TAG_GENERAL);
+        arrsetlen(self->arr_due, 0);
+        for (uint32_t i = 0; i < arrlenu(self->arr_worlds); i++)
+        {
+            const scheduled_world_t *scheduled = &self->arr_worlds[i];
+            if (scheduled->next_turn <= now)
+                arrput(self->arr_due, ((world_scheduler_due_t){i, scheduled->debt_ms > 0, scheduled->next_turn}));
+        }
+    }
+
+    uint32_t num_due = (uint32_t)arrlenu(self->arr_due);
+    if (!num_due)
+        return 0;
+
+    // The pool hands out work in order, so this is the order turns start in.
+    qsort(self->arr_due, num_due, sizeof(world_scheduler_due_t), world_scheduler_compare_due);
+
+    world_scheduler_round_t round = {self, SDL_GetPerformanceCounter(), 1000.0 / (double)SDL_GetPerformanceFrequency()};
+    job_system_parallel_for(self->pool, num_due, 1, world_scheduler_turn_range, &round);
+
+    return num_due;
+}
+
+uint64_t world_scheduler_next_due(const world_scheduler_t *self)
+{
+    uint64_t result = UINT64_MAX;
+    for (size_t i = 0; i < arrlenu(self->arr_worlds); i++)
+    {
+        if (self->arr_worlds[i].next_turn < result)
+            result = self->arr_worlds[i].next_turn;
+    }
+    return result;
+}
\ No newline at end of file
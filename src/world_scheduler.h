@@ -0,0 +1,118 @@
+#pragma once
+#include <stdint.h>
+#include "world.h"
+#include "engine/job_system.h"
+
+/// @brief A hosted world, its turn timer and what its turns have cost.
+typedef struct scheduled_world_t
+{
+    world_t *world;
+    // Performance counters, when the next turn is due and how far apart turns are.
+    uint64_t next_turn;
+    uint64_t turn_period;
+
+    // CPU time a turn can take without the world going over its budget.
+    float budget_ms;
+    // Overspend not yet made up for by cheaper turns. Worlds in debt go after every world that isn't.
+    float debt_ms;
+    float last_turn_ms;
+    // From when the turn was due, or when the round started if it was run early, to when it finished. Waiting for a
+    // thread counts.
+    float last_latency_ms;
+    double total_turn_ms;
+    double total_latency_ms;
+    uint32_t num_turns;
+    uint32_t num_over_budget;
+} scheduled_world_t;
+
+typedef struct world_scheduler_due_t
+{
+    uint32_t index;
+    uint8_t is_in_debt;
+    uint64_t next_turn;
+} world_scheduler_due_t;
+
+/// @brief Runs many worlds' turns on one pool. Every round takes the worlds that are due, orders them and hands them
+/// to the pool's threads one at a time, so a slow world holds up one thread rather than a batch of worlds.
+typedef struct world_scheduler_t
+{
+    scheduled_world_t *arr_worlds;
+    // The worlds in the last round, in the order they were started.
+    world_scheduler_due_t *arr_due;
+    // Not owned. No world's own job system can be it, a job can't wait on the pool it's running on.
+    job_system_t *pool;
+} world_scheduler_t;
+
+world_scheduler_t world_scheduler_new(job_system_t *pool);
+/// @brief Doesn't free the worlds.
+void world_scheduler_free(world_scheduler_t *self);
+
+/// @param first_turn Performance counter the first turn is due at.
+/// @return The world's index, until a world before it is removed.
+uint32_t world_scheduler_add(world_scheduler_t *self, world_t *world, uint64_t first_turn, uint64_t turn_period, float budget_ms);
+/// @brief Stop running a world, the last world takes its index.
+void world_scheduler_remove(world_scheduler_t *self, uint32_t index);
+
+/// @brief A turn for every world that's due at now, within budget first and then the most overdue first. Returns once
+/// they're all done.
+/// @return Turns run, the worlds are the start of arr_due.
+uint32_t world_scheduler_run_due(world_scheduler_t *self, uint64_t now);
+
+/// @brief When the next world is due, UINT64_MAX without any.
+uint64_t world_scheduler_next_due(const world_scheduler_t *self);
+
+#if UNIT_TEST
+#include <assert.h>
+
+static int world_scheduler_unit_tests(void)
+{
+    job_system_t *pool = job_system_new(0), *jobs = job_system_new(0);
+    world_scheduler_t scheduler = world_scheduler_new(pool);
+
+    world_t *worlds[3];
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        worlds[i] = world_new(0, jobs, 4096, 7);
+        worlds[i]->turn_steps = 1;
+        world_spawn_tilemap(worlds[i], 32);
+        world_spawn_players(worlds[i], 2);
+    }
+
+    // The first has no budget so it's in debt after every turn, the third only wants a turn half as often.
+    world_scheduler_add(&scheduler, worlds[0], 0, 10, 0);
+    world_scheduler_add(&scheduler, worlds[1], 0, 10, 1000);
+    world_scheduler_add(&scheduler, worlds[2], 0, 20, 1000);
+
+    assert(world_scheduler_run_due(&scheduler, 0) == 3);
+    assert(scheduler.arr_worlds[0].debt_ms > 0 && scheduler.arr_worlds[0].num_over_budget == 1);
+    assert(scheduler.arr_worlds[1].debt_ms == 0 && scheduler.arr_worlds[1].num_over_budget == 0);
+    assert(world_scheduler_next_due(&scheduler) == 10);
+
+    assert(world_scheduler_run_due(&scheduler, 5) == 0);
+
+    // The world in debt was due just as soon, but waits for the one within its budget.
+    assert(world_scheduler_run_due(&scheduler, 10) == 2);
+    assert(scheduler.arr_due[0].index == 1 && scheduler.arr_due[1].index == 0);
+
+    // Behind by more than a turn, it catches up a turn a round rather than skipping any.
+    assert(world_scheduler_run_due(&scheduler, 45) == 3 && world_scheduler_run_due(&scheduler, 45) == 3);
+    assert(world_scheduler_run_due(&scheduler, 45) == 2 && world_scheduler_run_due(&scheduler, 45) == 0);
+    assert(scheduler.arr_worlds[0].num_turns == 5 && scheduler.arr_worlds[2].num_turns == 3);
+
+    // Same seed and the same turns, scheduled in a different order, the same game.
+    assert(worlds[0]->rng == worlds[1]->rng);
+    assert(worlds[0]->turns->arr_units[0].x == worlds[1]->turns->arr_units[0].x);
+    assert(worlds[0]->turns->arr_units[0].y == worlds[1]->turns->arr_units[0].y);
+
+    world_scheduler_remove(&scheduler, 0);
+    assert(arrlenu(scheduler.arr_worlds) == 2 && scheduler.arr_worlds[0].world == worlds[2]);
+
+    world_scheduler_free(&scheduler);
+    for (uint32_t i = 0; i < 3; i++)
+        world_free(worlds[i]);
+    job_system_free(jobs);
+    job_system_free(pool);
+
+    return 1;
+}
+#endif
\ No newline at end of file
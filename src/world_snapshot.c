@@ -0,0 +1,636 @@
+#include "world_snapshot.h"
+#include <string.h>
+#include <assert.h>
+#include "asset_cache.h"
+#include "engine/memory.h"
+#include "engine/profiler.h"
+#include "util/rng.h"
+
+#define WORLD_SNAPSHOT_TRANSFORM_FLOATS 6
+#define WORLD_SNAPSHOT_SPRITE_FLOATS 6
+#define WORLD_SNAPSHOT_TEXT_FLOATS 1
+#define WORLD_SNAPSHOT_CAMERA_FLOATS 4
+// Slots in the caches of textures and the like by pointer, there are far fewer of them than entities.
+#define WORLD_SNAPSHOT_RECENT_POINTERS 64
+
+typedef struct world_snapshot_string_t
+{
+    const char *key;
+    uint32_t value;
+} world_snapshot_string_t;
+
+typedef struct world_snapshot_pointer_t
+{
+    const void *key;
+    uint32_t value;
+} world_snapshot_pointer_t;
+
+typedef struct world_snapshot_writer_t
+{
+    uint8_t *arr_sections[WORLD_SNAPSHOT_SECTION_COUNT];
+
+    // Interned strings by content, and by the texture, font or text pointer in front of that since far fewer of those
+    // are different. IDs start at 1, 0 is a null pointer.
+    world_snapshot_string_t *sh_strings;
+    world_snapshot_pointer_t *hm_pointers;
+    // In front of hm_pointers, the last pointer to land in each slot.
+    const void *recent_pointers[WORLD_SNAPSHOT_RECENT_POINTERS];
+    uint32_t recent_ids[WORLD_SNAPSHOT_RECENT_POINTERS];
+    uint32_t *arr_string_offsets;
+    char *arr_chars;
+
+    // Last value written to each float stream, as bits.
+    uint32_t previous_transform[WORLD_SNAPSHOT_TRANSFORM_FLOATS];
+    uint32_t previous_sprite[WORLD_SNAPSHOT_SPRITE_FLOATS];
+    uint32_t previous_text[WORLD_SNAPSHOT_TEXT_FLOATS];
+    uint32_t previous_camera[WORLD_SNAPSHOT_CAMERA_FLOATS];
+} world_snapshot_writer_t;
+
+typedef struct world_snapshot_reader_t
+{
+    const uint8_t *at;
+    const uint8_t *end;
+    // Set by reading past the end, everything read from then on is 0.
+    uint8_t is_overrun;
+} world_snapshot_reader_t;
+
+static inline uint32_t world_snapshot_float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline void world_snapshot_put_varint(uint8_t **arr, uint32_t value)
+{
+    size_t length = arrlenu(*arr);
+    arrsetlen(*arr, length + 5);
+
+    uint8_t *out = *arr + length;
+    while (value >= 0x80)
+    {
+        *out++ = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+
+    arrsetlen(*arr, (size_t)(out - *arr));
+}
+
+static inline void world_snapshot_put_floats(uint8_t **arr, uint32_t *previous, const float *values, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bits = world_snapshot_float_bits(values[i]);
+        world_snapshot_put_varint(arr, bits ^ previous[i]);
+        previous[i] = bits;
+    }
+}
+
+static inline uint32_t world_snapshot_get_varint(world_snapshot_reader_t *reader)
+{
+    uint32_t value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        if (reader->at == reader->end)
+        {
+            reader->is_overrun = 1;
+            return 0;
+        }
+
+        uint8_t byte = *reader->at++;
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    // Too long to be one we wrote.
+    reader->is_overrun = 1;
+    return 0;
+}
+
+static inline void world_snapshot_get_floats(world_snapshot_reader_t *reader, uint32_t *previous, float *values, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        previous[i] ^= world_snapshot_get_varint(reader);
+        memcpy(&values[i], &previous[i], sizeof(float));
+    }
+}
+
+// Assets are saved by their key in the cache, the entry their pointer is inside of.
+static const char *world_snapshot_texture_key(const asset_cache_t *cache, const texture_t *texture)
+{
+    if (!texture)
+        return 0;
+
+    size_t index = (size_t)((const char *)texture - (const char *)&cache->sh_textures[0].value) / sizeof(texture_cache_entry_t);
+    assert(index < shlenu(cache->sh_textures) && &cache->sh_textures[index].value == texture);
+    return cache->sh_textures[index].key;
+}
+
+static const char *world_snapshot_font_key(const asset_cache_t *cache, const font_t *font)
+{
+    if (!font)
+        return 0;
+
+    size_t index = (size_t)((const char *)font - (const char *)&cache->sh_fonts[0].value) / sizeof(baked_font_entry_t);
+    assert(index < shlenu(cache->sh_fonts) && &cache->sh_fonts[index].value == font);
+    return cache->sh_fonts[index].key;
+}
+
+// ID of the string the pointer refers to, looked up by the pointer first so the key or text is only needed once.
+static uint32_t world_snapshot_intern_found(world_snapshot_writer_t *writer, const void *pointer, ptrdiff_t *at)
+{
+    size_t slot = ((uintptr_t)pointer >> 4) % WORLD_SNAPSHOT_RECENT_POINTERS;
+    if (writer->recent_pointers[slot] == pointer && pointer)
+    {
+        *at = 0;
+        return writer->recent_ids[slot];
+    }
+
+    *at = hmgeti(writer->hm_pointers, pointer);
+    if (*at < 0)
+        return 0;
+
+    writer->recent_pointers[slot] = pointer;
+    return writer->recent_ids[slot] = writer->hm_pointers[*at].value;
+}
+
+static uint32_t world_snapshot_intern(world_snapshot_writer_t *writer, const void *pointer, const char *string)
+{
+    if (!string)
+        return 0;
+
+    uint32_t id;
+    ptrdiff_t at = shgeti(writer->sh_strings, string);
+    if (at >= 0)
+    {
+        id = writer->sh_strings[at].value;
+    }
+    else
+    {
+        id = (uint32_t)arrlenu(writer->arr_string_offsets) + 1;
+        arrput(writer->arr_string_offsets, (uint32_t)arrlenu(writer->arr_chars));
+
+        size_t length = strlen(string) + 1;
+        memcpy(arraddnptr(writer->arr_chars, length), string, length);
+        shput(writer->sh_strings, string, id);
+    }
+
+    hmput(writer->hm_pointers, pointer, id);
+    return id;
+}
+
+static uint32_t world_snapshot_intern_texture(world_snapshot_writer_t *writer, const asset_cache_t *cache, const texture_t *texture)
+{
+    ptrdiff_t at;
+    uint32_t id = world_snapshot_intern_found(writer, texture, &at);
+    return at >= 0 || !texture ? id : world_snapshot_intern(writer, texture, world_snapshot_texture_key(cache, texture));
+}
+
+static uint32_t world_snapshot_intern_font(world_snapshot_writer_t *writer, const asset_cache_t *cache, const font_t *font)
+{
+    ptrdiff_t at;
+    uint32_t id = world_snapshot_intern_found(writer, font, &at);
+    return at >= 0 || !font ? id : world_snapshot_intern(writer, font, world_snapshot_font_key(cache, font));
+}
+
+static uint32_t world_snapshot_intern_text(world_snapshot_writer_t *writer, const char *text)
+{
+    ptrdiff_t at;
+    uint32_t id = world_snapshot_intern_found(writer, text, &at);
+    return at >= 0 || !text ? id : world_snapshot_intern(writer, text, text);
+}
+
+static uint64_t world_snapshot_hash_string(uint64_t hash, const char *string)
+{
+    if (!string)
+        return rng_hash_fold(hash, 0);
+
+    size_t length = strlen(string);
+    for (size_t i = 0; i < length; i += 8)
+    {
+        uint64_t chunk = 0;
+        memcpy(&chunk, string + i, length - i < 8 ? length - i : 8);
+        hash = rng_hash_fold(hash, chunk);
+    }
+
+    // The length too, so "ab" then "c" isn't "a" then "bc".
+    return rng_hash_fold(hash, length + 1);
+}
+
+static inline uint64_t world_snapshot_hash_floats(uint64_t hash, float a, float b)
+{
+    return rng_hash_fold(hash, world_snapshot_float_bits(a) | (uint64_t)world_snapshot_float_bits(b) << 32);
+}
+
+typedef struct world_snapshot_hasher_t
+{
+    uint64_t hash;
+    // Hashes of the keys of recently seen textures.
+    const texture_t *textures[WORLD_SNAPSHOT_RECENT_POINTERS];
+    uint64_t texture_hashes[WORLD_SNAPSHOT_RECENT_POINTERS];
+} world_snapshot_hasher_t;
+
+static void world_snapshot_hasher_init(world_snapshot_hasher_t *hasher, size_t num_entities)
+{
+    memset(hasher, 0, sizeof(*hasher));
+    hasher->hash = rng_hash(num_entities);
+}
+
+static inline void world_snapshot_hash_entity(world_snapshot_hasher_t *hasher, const world_t *world, size_t index)
+{
+    const entity_t *entity = world->entities[index];
+    const transform_t *transform = &entity->transform;
+    uint64_t hash = hasher->hash;
+
+    uint64_t flags = (uint64_t)entity->render_type | (uint64_t)entity->is_hidden << 8 | (uint64_t)entity->has_camera << 16 | (uint64_t)transform->flip_flags << 24;
+    hash = rng_hash_fold(hash, flags | (uint64_t)world->arr_parent_indices[index] << 32);
+    hash = world_snapshot_hash_floats(hash, transform->pos[0], transform->pos[1]);
+    hash = world_snapshot_hash_floats(hash, transform->pos[2], transform->rotation);
+    hash = world_snapshot_hash_floats(hash, transform->scale[0], transform->scale[1]);
+
+    if (entity->render_type == RENDER_TYPE_SPRITE)
+    {
+        const sprite_t *sprite = &entity->sprite;
+        size_t slot = ((uintptr_t)sprite->texture >> 4) % WORLD_SNAPSHOT_RECENT_POINTERS;
+        if (hasher->textures[slot] != sprite->texture || !sprite->texture)
+        {
+            hasher->textures[slot] = sprite->texture;
+            hasher->texture_hashes[slot] = world_snapshot_hash_string(0, world_snapshot_texture_key(world->asset_cache, sprite->texture));
+        }
+
+        hash = rng_hash_fold(hash, hasher->texture_hashes[slot]);
+        hash = world_snapshot_hash_floats(hash, sprite->anchor[0], sprite->anchor[1]);
+        hash = world_snapshot_hash_floats(hash, sprite->color[0], sprite->color[1]);
+        hash = world_snapshot_hash_floats(hash, sprite->color[2], sprite->color[3]);
+    }
+    else if (entity->render_type == RENDER_TYPE_TEXT)
+    {
+        const text_t *text = &entity->text;
+        hash = world_snapshot_hash_string(hash, text->text);
+        hash = world_snapshot_hash_string(hash, world_snapshot_font_key(world->asset_cache, text->font));
+        hash = world_snapshot_hash_floats(hash, text->font_size, 0);
+    }
+
+    if (entity->has_camera)
+    {
+        const camera_t *camera = &entity->camera;
+        hash = world_snapshot_hash_floats(hash, camera->pos[0], camera->pos[1]);
+        hash = world_snapshot_hash_floats(hash, camera->aspect, camera->size);
+    }
+
+    hasher->hash = hash;
+}
+
+void world_snapshot_save(const world_t *world, uint8_t **arr_out)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MEMORY_TAG_SNAPSHOTS);
+
+    size_t num_entities = arrlenu(world->entities);
+    assert(num_entities && world->entities[0] == world->root && arrlenu(world->arr_parent_indices) == num_entities);
+
+    // Hashed on the way through rather than walking every entity again after.
+    world_snapshot_hasher_t hasher;
+    world_snapshot_hasher_init(&hasher, num_entities);
+    world_snapshot_writer_t writer = {0};
+    uint8_t **sections = writer.arr_sections;
+    arrsetcap(sections[WORLD_SNAPSHOT_SECTION_FLAGS], num_entities);
+
+    for (size_t i = 0; i < num_entities; i++)
+    {
+        const entity_t *entity = world->entities[i];
+        const transform_t *transform = &entity->transform;
+        world_snapshot_hash_entity(&hasher, world, i);
+
+        uint8_t flags = (uint8_t)(entity->render_type & WORLD_SNAPSHOT_FLAG_RENDER_TYPE_MASK);
+        flags |= entity->is_hidden ? WORLD_SNAPSHOT_FLAG_HIDDEN : 0;
+        flags |= entity->has_camera ? WORLD_SNAPSHOT_FLAG_CAMERA : 0;
+        flags |= (uint8_t)(transform->flip_flags << WORLD_SNAPSHOT_FLAG_FLIP_SHIFT);
+        arrput(sections[WORLD_SNAPSHOT_SECTION_FLAGS], flags);
+
+        // Nearly always the entity before or not far off it.
+        if (i)
+            world_snapshot_put_varint(&sections[WORLD_SNAPSHOT_SECTION_PARENTS], (uint32_t)i - world->arr_parent_indices[i]);
+
+        const float transform_floats[WORLD_SNAPSHOT_TRANSFORM_FLOATS] = {
+            transform->pos[0], transform->pos[1], transform->pos[2], transform->scale[0], transform->scale[1], transform->rotation,
+        };
+        world_snapshot_put_floats(&sections[WORLD_SNAPSHOT_SECTION_TRANSFORMS], writer.previous_transform, transform_floats, WORLD_SNAPSHOT_TRANSFORM_FLOATS);
+
+        if (entity->render_type == RENDER_TYPE_SPRITE)
+        {
+            const sprite_t *sprite = &entity->sprite;
+            world_snapshot_put_varint(&sections[WORLD_SNAPSHOT_SECTION_SPRITES], world_snapshot_intern_texture(&writer, world->asset_cache, sprite->texture));
+
+            const float sprite_floats[WORLD_SNAPSHOT_SPRITE_FLOATS] = {
+                sprite->anchor[0], sprite->anchor[1], sprite->color[0], sprite->color[1], sprite->color[2], sprite->color[3],
+            };
+            world_snapshot_put_floats(&sections[WORLD_SNAPSHOT_SECTION_SPRITES], writer.previous_sprite, sprite_floats, WORLD_SNAPSHOT_SPRITE_FLOATS);
+        }
+        else if (entity->render_type == RENDER_TYPE_TEXT)
+        {
+            const text_t *text = &entity->text;
+            world_snapshot_put_varint(&sections[WORLD_SNAPSHOT_SECTION_TEXTS], world_snapshot_intern_text(&writer, text->text));
+            world_snapshot_put_varint(&sections[WORLD_SNAPSHOT_SECTION_TEXTS], world_snapshot_intern_font(&writer, world->asset_cache, text->font));
+            world_snapshot_put_floats(&sections[WORLD_SNAPSHOT_SECTION_TEXTS], writer.previous_text, &text->font_size, WORLD_SNAPSHOT_TEXT_FLOATS);
+        }
+
+        if (entity->has_camera)
+        {
+            const camera_t *camera = &entity->camera;
+            const float camera_floats[WORLD_SNAPSHOT_CAMERA_FLOATS] = {camera->pos[0], camera->pos[1], camera->aspect, camera->size};
+            world_snapshot_put_floats(&sections[WORLD_SNAPSHOT_SECTION_CAMERAS], writer.previous_camera, camera_floats, WORLD_SNAPSHOT_CAMERA_FLOATS);
+        }
+    }
+
+    // The string table goes in as is, every offset then the strings they point at.
+    uint32_t num_strings = (uint32_t)arrlenu(writer.arr_string_offsets);
+    uint8_t **strings = &sections[WORLD_SNAPSHOT_SECTION_STRINGS];
+    if (num_strings)
+    {
+        size_t offsets_size = num_strings * sizeof(uint32_t), chars_size = arrlenu(writer.arr_chars);
+        memcpy(arraddnptr(*strings, offsets_size), writer.arr_string_offsets, offsets_size);
+        memcpy(arraddnptr(*strings, chars_size), writer.arr_chars, chars_size);
+    }
+
+    world_snapshot_header_t header = {
+        .version = WORLD_SNAPSHOT_VERSION,
+        .num_entities = (uint32_t)num_entities,
+        .num_strings = num_strings,
+        .hash = rng_hash(hasher.hash),
+    };
+    memcpy(header.magic, WORLD_SNAPSHOT_MAGIC, sizeof(header.magic));
+
+    size_t size = sizeof(header);
+    for (uint32_t i = 0; i < WORLD_SNAPSHOT_SECTION_COUNT; i++)
+    {
+        header.section_offsets[i] = (uint32_t)size;
+        header.section_sizes[i] = (uint32_t)arrlenu(sections[i]);
+        size += arrlenu(sections[i]);
+    }
+
+    arrsetlen(*arr_out, size);
+    memcpy(*arr_out, &header, sizeof(header));
+    for (uint32_t i = 0; i < WORLD_SNAPSHOT_SECTION_COUNT; i++)
+    {
+        if (header.section_sizes[i])
+            memcpy(*arr_out + header.section_offsets[i], sections[i], header.section_sizes[i]);
+        arrfree(sections[i]);
+    }
+
+    shfree(writer.sh_strings);
+    hmfree(writer.hm_pointers);
+    arrfree(writer.arr_string_offsets);
+    arrfree(writer.arr_chars);
+}
+
+// What each string turned into the first time something used it.
+typedef struct world_snapshot_resolved_t
+{
+    texture_t *texture;
+    font_t *font;
+    char *text;
+} world_snapshot_resolved_t;
+
+typedef struct world_snapshot_strings_t
+{
+    uint32_t num_strings;
+    const uint8_t *offsets;
+    const char *chars;
+    uint32_t chars_size;
+    world_snapshot_resolved_t *resolved;
+} world_snapshot_strings_t;
+
+// Null for an ID that's out of range or an offset past the end. The last char is a terminator, checked up front.
+static const char *world_snapshot_string(const world_snapshot_strings_t *strings, uint32_t id)
+{
+    if (!id || id > strings->num_strings)
+        return 0;
+
+    uint32_t offset;
+    memcpy(&offset, strings->offsets + (id - 1) * sizeof(uint32_t), sizeof(offset));
+    return offset < strings->chars_size ? strings->chars + offset : 0;
+}
+
+// Each one is 0 for a null reference, and sets is_missing for anything it can't find.
+static texture_t *world_snapshot_resolve_texture(world_t *world, world_snapshot_strings_t *strings, uint32_t id, uint8_t *is_missing)
+{
+    if (!id)
+        return 0;
+
+    world_snapshot_resolved_t *resolved = &strings->resolved[id <= strings->num_strings ? id : 0];
+    if (!resolved->texture)
+    {
+        const char *key = world_snapshot_string(strings, id);
+        ptrdiff_t at = key ? shgeti(world->asset_cache->sh_textures, key) : -1;
+        if (at < 0)
+        {
+            *is_missing = 1;
+            return 0;
+        }
+
+        resolved->texture = &world->asset_cache->sh_textures[at].value;
+    }
+
+    return resolved->texture;
+}
+
+static font_t *world_snapshot_resolve_font(world_t *world, world_snapshot_strings_t *strings, uint32_t id, uint8_t *is_missing)
+{
+    if (!id)
+        return 0;
+
+    world_snapshot_resolved_t *resolved = &strings->resolved[id <= strings->num_strings ? id : 0];
+    if (!resolved->font)
+    {
+        const char *key = world_snapshot_string(strings, id);
+        ptrdiff_t at = key ? shgeti(world->asset_cache->sh_fonts, key) : -1;
+        if (at < 0)
+        {
+            *is_missing = 1;
+            return 0;
+        }
+
+        resolved->font = &world->asset_cache->sh_fonts[at].value;
+    }
+
+    return resolved->font;
+}
+
+static char *world_snapshot_resolve_text(world_t *world, world_snapshot_strings_t *strings, uint32_t id, uint8_t *is_missing)
+{
+    if (!id)
+        return 0;
+
+    world_snapshot_resolved_t *resolved = &strings->resolved[id <= strings->num_strings ? id : 0];
+    if (!resolved->text)
+    {
+        const char *string = world_snapshot_string(strings, id);
+        if (!string)
+        {
+            *is_missing = 1;
+            return 0;
+        }
+
+        MEMORY_SCOPE(MEMORY_TAG_ENTITIES);
+        if (!world->sh_interned_text)
+            sh_new_arena(world->sh_interned_text);
+        shput(world->sh_interned_text, string, 1);
+        resolved->text = world->sh_interned_text[shgeti(world->sh_interned_text, string)].key;
+    }
+
+    return resolved->text;
+}
+
+uint8_t world_snapshot_load(world_t *world, const uint8_t *data, size_t size)
+{
+    PROFILE_FUNCTION();
+    assert(arrlenu(world->entities) == 1 && world->entities[0] == world->root && !world->root->first_child);
+
+    world_snapshot_header_t header;
+    if (size < sizeof(header))
+        return 0;
+
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, WORLD_SNAPSHOT_MAGIC, sizeof(header.magic)) || header.version != WORLD_SNAPSHOT_VERSION || !header.num_entities)
+        return 0;
+
+    world_snapshot_reader_t readers[WORLD_SNAPSHOT_SECTION_COUNT];
+    for (uint32_t i = 0; i < WORLD_SNAPSHOT_SECTION_COUNT; i++)
+    {
+        if (header.section_offsets[i] > size || size - header.section_offsets[i] < header.section_sizes[i])
+            return 0;
+
+        readers[i] = (world_snapshot_reader_t){data + header.section_offsets[i], data + header.section_offsets[i] + header.section_sizes[i]};
+    }
+
+    // Flags are a byte per entity, and the string table is every offset then the strings, the last one terminated.
+    const uint8_t *flags = readers[WORLD_SNAPSHOT_SECTION_FLAGS].at;
+    if (header.section_sizes[WORLD_SNAPSHOT_SECTION_FLAGS] != header.num_entities)
+        return 0;
+
+    world_snapshot_strings_t strings = {.num_strings = header.num_strings, .offsets = readers[WORLD_SNAPSHOT_SECTION_STRINGS].at};
+    if (header.num_strings > header.section_sizes[WORLD_SNAPSHOT_SECTION_STRINGS] / sizeof(uint32_t))
+        return 0;
+
+    strings.chars = (const char *)strings.offsets + header.num_strings * sizeof(uint32_t);
+    strings.chars_size = header.section_sizes[WORLD_SNAPSHOT_SECTION_STRINGS] - header.num_strings * (uint32_t)sizeof(uint32_t);
+    if (strings.chars_size && strings.chars[strings.chars_size - 1])
+        return 0;
+
+    strings.resolved = mem_calloc(MEMORY_TAG_SNAPSHOTS, (size_t)header.num_strings + 1, sizeof(world_snapshot_resolved_t));
+    assert(strings.resolved);
+
+    {
+        MEMORY_SCOPE(MEMORY_TAG_ENTITIES);
+        arrsetcap(world->entities, header.num_entities);
+    }
+
+    // Put back if the snapshot turns out to be bad partway through.
+    entity_t root = *world->root;
+
+    uint32_t previous_transform[WORLD_SNAPSHOT_TRANSFORM_FLOATS] = {0};
+    uint32_t previous_sprite[WORLD_SNAPSHOT_SPRITE_FLOATS] = {0};
+    uint32_t previous_text[WORLD_SNAPSHOT_TEXT_FLOATS] = {0};
+    uint32_t previous_camera[WORLD_SNAPSHOT_CAMERA_FLOATS] = {0};
+    uint8_t is_bad = 0;
+
+    for (uint32_t i = 0; i < header.num_entities && !is_bad; i++)
+    {
+        entity_t *entity = world->root;
+        if (i)
+        {
+            uint32_t parent_distance = world_snapshot_get_varint(&readers[WORLD_SNAPSHOT_SECTION_PARENTS]);
+            if (!parent_distance || parent_distance > i)
+            {
+                is_bad = 1;
+                break;
+            }
+
+            entity = entity_new(world);
+            set_parent(entity, world->entities[i - parent_distance]);
+        }
+
+        uint8_t entity_flags = flags[i];
+        entity->is_hidden = (entity_flags & WORLD_SNAPSHOT_FLAG_HIDDEN) != 0;
+        entity->has_camera = (entity_flags & WORLD_SNAPSHOT_FLAG_CAMERA) != 0;
+        entity->render_type = (render_type_e)(entity_flags & WORLD_SNAPSHOT_FLAG_RENDER_TYPE_MASK);
+
+        transform_t *transform = &entity->transform;
+        float transform_floats[WORLD_SNAPSHOT_TRANSFORM_FLOATS];
+        world_snapshot_get_floats(&readers[WORLD_SNAPSHOT_SECTION_TRANSFORMS], previous_transform, transform_floats, WORLD_SNAPSHOT_TRANSFORM_FLOATS);
+        memcpy(transform->pos, &transform_floats[0], sizeof(vec3));
+        memcpy(transform->scale, &transform_floats[3], sizeof(vec2));
+        transform->rotation = transform_floats[5];
+        transform->flip_flags = entity_flags >> WORLD_SNAPSHOT_FLAG_FLIP_SHIFT;
+        transform->is_dirty = 1;
+        transform->is_global_dirty = 1;
+
+        if (entity->render_type == RENDER_TYPE_SPRITE)
+        {
+            sprite_t *sprite = &entity->sprite;
+            sprite->texture = world_snapshot_resolve_texture(world, &strings, world_snapshot_get_varint(&readers[WORLD_SNAPSHOT_SECTION_SPRITES]), &is_bad);
+
+            float sprite_floats[WORLD_SNAPSHOT_SPRITE_FLOATS];
+            world_snapshot_get_floats(&readers[WORLD_SNAPSHOT_SECTION_SPRITES], previous_sprite, sprite_floats, WORLD_SNAPSHOT_SPRITE_FLOATS);
+            memcpy(sprite->anchor, &sprite_floats[0], sizeof(vec2));
+            memcpy(sprite->color, &sprite_floats[2], sizeof(vec4));
+        }
+        else if (entity->render_type == RENDER_TYPE_TEXT)
+        {
+            text_t *text = &entity->text;
+            text->text = world_snapshot_resolve_text(world, &strings, world_snapshot_get_varint(&readers[WORLD_SNAPSHOT_SECTION_TEXTS]), &is_bad);
+            text->font = world_snapshot_resolve_font(world, &strings, world_snapshot_get_varint(&readers[WORLD_SNAPSHOT_SECTION_TEXTS]), &is_bad);
+            world_snapshot_get_floats(&readers[WORLD_SNAPSHOT_SECTION_TEXTS], previous_text, &text->font_size, WORLD_SNAPSHOT_TEXT_FLOATS);
+        }
+        else if (entity->render_type != RENDER_TYPE_NONE)
+        {
+            is_bad = 1;
+        }
+
+        if (entity->has_camera)
+        {
+            camera_t *camera = &entity->camera;
+            float camera_floats[WORLD_SNAPSHOT_CAMERA_FLOATS];
+            world_snapshot_get_floats(&readers[WORLD_SNAPSHOT_SECTION_CAMERAS], previous_camera, camera_floats, WORLD_SNAPSHOT_CAMERA_FLOATS);
+            memcpy(camera->pos, &camera_floats[0], sizeof(vec2));
+            camera->aspect = camera_floats[2];
+            camera->size = camera_floats[3];
+        }
+    }
+
+    // Every stream has to come out even, anything left over or run out of means it isn't what was written.
+    for (uint32_t i = WORLD_SNAPSHOT_SECTION_PARENTS; i < WORLD_SNAPSHOT_SECTION_COUNT; i++)
+        is_bad |= readers[i].is_overrun || readers[i].at != readers[i].end;
+
+    mem_free(strings.resolved);
+
+    if (is_bad)
+    {
+        for (size_t i = 1; i < arrlenu(world->entities); i++)
+            mem_free(world->entities[i]);
+        arrsetlen(world->entities, 1);
+        *world->root = root;
+        return 0;
+    }
+
+    return 1;
+}
+
+uint64_t world_snapshot_hash(const world_t *world)
+{
+    PROFILE_FUNCTION();
+
+    size_t num_entities = arrlenu(world->entities);
+    assert(num_entities && world->entities[0] == world->root && arrlenu(world->arr_parent_indices) == num_entities);
+
+    world_snapshot_hasher_t hasher;
+    world_snapshot_hasher_init(&hasher, num_entities);
+    for (size_t i = 0; i < num_entities; i++)
+        world_snapshot_hash_entity(&hasher, world, i);
+
+    return rng_hash(hasher.hash);
+}
\ No newline at end of file
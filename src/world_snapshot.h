@@ -0,0 +1,148 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "entities.h"
+
+#define WORLD_SNAPSHOT_MAGIC "BRWS"
+// Bump whenever the layout changes, older snapshots are refused rather than misread.
+#define WORLD_SNAPSHOT_VERSION 1
+
+// Entity i's parent is a handle, its index in depth first pre-order, stored as how far back it is. Floats are XORed
+// with the same field of the entity before, so repeats and near repeats come out as short varints.
+#define FOR_EACH_WORLD_SNAPSHOT_SECTION  \
+    X(WORLD_SNAPSHOT_SECTION_STRINGS)    \
+    X(WORLD_SNAPSHOT_SECTION_FLAGS)      \
+    X(WORLD_SNAPSHOT_SECTION_PARENTS)    \
+    X(WORLD_SNAPSHOT_SECTION_TRANSFORMS) \
+    X(WORLD_SNAPSHOT_SECTION_SPRITES)    \
+    X(WORLD_SNAPSHOT_SECTION_TEXTS)      \
+    X(WORLD_SNAPSHOT_SECTION_CAMERAS)
+
+typedef enum world_snapshot_section_e
+{
+#define X(name) name,
+    FOR_EACH_WORLD_SNAPSHOT_SECTION
+#undef X
+        WORLD_SNAPSHOT_SECTION_COUNT,
+} world_snapshot_section_e;
+
+// A byte per entity in the flags section.
+#define WORLD_SNAPSHOT_FLAG_RENDER_TYPE_MASK 0x3
+#define WORLD_SNAPSHOT_FLAG_HIDDEN (1 << 2)
+#define WORLD_SNAPSHOT_FLAG_CAMERA (1 << 3)
+#define WORLD_SNAPSHOT_FLAG_FLIP_SHIFT 4
+
+/// @brief Starts every snapshot, little endian like everything else in it. Sections are byte offsets from the start
+/// of the header. Strings and flags can be used where they are, the others are varint streams.
+typedef struct world_snapshot_header_t
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t num_entities;
+    // Texture and font keys in the asset cache, and text, each stored once however many entities use it.
+    uint32_t num_strings;
+    // world_snapshot_hash of the world when it was saved, what it should hash to once loaded.
+    uint64_t hash;
+    uint32_t section_offsets[WORLD_SNAPSHOT_SECTION_COUNT];
+    uint32_t section_sizes[WORLD_SNAPSHOT_SECTION_COUNT];
+} world_snapshot_header_t;
+
+/// @brief Everything under world->root, as of the last update_global_system. Anything created, freed or moved since
+/// isn't included. Every texture and font has to be in world->asset_cache, they're saved by key.
+/// @param arr_out Replaced with the snapshot, an stb_ds array so saving again reuses its capacity.
+void world_snapshot_save(const world_t *world, uint8_t **arr_out);
+
+/// @brief Rebuild a saved world under world->root, which must be the only entity. Textures and fonts are looked up by
+/// key so they have to be loaded first, text is interned in world->sh_interned_text. Transforms are dirty, the next
+/// update_local_system and update_global_system fill in their matrices.
+/// @return 0 for anything that isn't a whole snapshot of this version or refers to an asset that isn't loaded, world
+/// is then left with just its root.
+uint8_t world_snapshot_load(world_t *world, const uint8_t *data, size_t size);
+
+/// @brief Everything a snapshot holds, the same on any machine for the same world. Strings by content and entities by
+/// handle, so a world and the one loaded from its snapshot hash the same. Same rules as world_snapshot_save.
+uint64_t world_snapshot_hash(const world_t *world);
+
+#if UNIT_TEST
+#include <assert.h>
+#include <string.h>
+#include "asset_cache.h"
+#include "engine/memory.h"
+
+static int world_snapshot_unit_tests(void)
+{
+    // No GL, so nothing is actually loaded and nothing can be cleaned up by asset_cache_free.
+    asset_cache_t cache = {0};
+    sh_new_strdup(cache.sh_textures);
+    sh_new_strdup(cache.sh_fonts);
+    shput(cache.sh_textures, "a.png", ((texture_t){.name = "a.png"}));
+    shput(cache.sh_textures, "b.png", ((texture_t){.name = "b.png"}));
+    shput(cache.sh_fonts, "font.ttf", ((font_t){0}));
+
+    world_t *world = world_new(&cache, 0, FRAME_ARENA_SIZE, 1);
+    entity_t *parent = 0;
+    for (uint32_t i = 0; i < 40; i++)
+    {
+        entity_t *entity = entity_new(world);
+        set_parent(entity, i % 8 ? parent : world->root);
+        if (i % 8 == 0)
+            parent = entity;
+
+        set_pos(&entity->transform, (vec3){(float)i * 3.5f, -(float)i, 1});
+        set_rotation(&entity->transform, i % 3 ? 0 : 0.25f * (float)i);
+        set_flip(&entity->transform, (uint8_t)(i % 4));
+        entity->is_hidden = i % 5 == 0;
+
+        if (i % 7 == 0)
+        {
+            entity->render_type = RENDER_TYPE_TEXT;
+            entity->text = (text_t){.text = i % 2 ? "odd" : "even", .font = &shget(cache.sh_fonts, "font.ttf"), .font_size = 16};
+        }
+        else
+        {
+            entity->render_type = RENDER_TYPE_SPRITE;
+            entity->sprite.texture = &shget(cache.sh_textures, i % 2 ? "a.png" : "b.png");
+            memcpy(entity->sprite.color, (vec4){1, (float)i / 40, 0.5f, 1}, sizeof(vec4));
+        }
+    }
+    world->root->has_camera = 1;
+    world->root->camera = (camera_t){.pos = {3, 4}, .aspect = 1.5f, .size = 720};
+    update_global_system(world);
+
+    uint8_t *arr_saved = 0;
+    world_snapshot_save(world, &arr_saved);
+    uint64_t hash = world_snapshot_hash(world);
+
+    // Loaded then saved again is the same bytes, and a different world hashes differently.
+    world_t *loaded = world_new(&cache, 0, FRAME_ARENA_SIZE, 1);
+    assert(world_snapshot_load(loaded, arr_saved, arrlenu(arr_saved)));
+    update_global_system(loaded);
+    assert(arrlenu(loaded->entities) == arrlenu(world->entities));
+    assert(world_snapshot_hash(loaded) == hash);
+    assert(loaded->entities[2]->sprite.texture == world->entities[2]->sprite.texture);
+
+    uint8_t *arr_resaved = 0;
+    world_snapshot_save(loaded, &arr_resaved);
+    assert(arrlenu(arr_resaved) == arrlenu(arr_saved) && !memcmp(arr_resaved, arr_saved, arrlenu(arr_saved)));
+
+    loaded->entities[5]->transform.pos[0] += 1;
+    assert(world_snapshot_hash(loaded) != hash);
+    world_free(loaded);
+
+    // Anything cut short or from another version is refused, and leaves nothing behind.
+    loaded = world_new(&cache, 0, FRAME_ARENA_SIZE, 1);
+    assert(!world_snapshot_load(loaded, arr_saved, arrlenu(arr_saved) - 1));
+    arr_saved[4]++;
+    assert(!world_snapshot_load(loaded, arr_saved, arrlenu(arr_saved)));
+    assert(arrlenu(loaded->entities) == 1 && !loaded->root->first_child);
+    world_free(loaded);
+
+    arrfree(arr_saved);
+    arrfree(arr_resaved);
+    world_free(world);
+    shfree(cache.sh_textures);
+    shfree(cache.sh_fonts);
+
+    return 1;
+}
+#endif
\ No newline at end of file